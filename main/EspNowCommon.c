@@ -3,20 +3,29 @@
 #include "esp_netif.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_check.h"
 
 static const char *TAG = "EspNowCommon";
 
 esp_err_t esp_now_wifi_init(void) {
-    ESP_ERROR_CHECK(esp_netif_init()); // Initialize TCP/IP stack (required for Wi-Fi)
-    ESP_ERROR_CHECK(esp_event_loop_create_default()); // Create default event loop
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg)); // Initialize Wi-Fi driver
-    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM)); // Store Wi-Fi config in RAM
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA)); // Station mode is required for ESP-NOW
-    ESP_ERROR_CHECK(esp_wifi_start()); // Start Wi-Fi
+    // TCP/IP stack, event loop and Wi-Fi driver are set up once by RADIO_start()
+    // Failures are returned, RADIO_start() reports them and the LED shows the error pattern
+    ESP_RETURN_ON_ERROR(esp_wifi_set_mode(WIFI_MODE_STA), TAG, "Station mode failed"); // Station mode is required for ESP-NOW
+    ESP_RETURN_ON_ERROR(esp_wifi_start(), TAG, "Wi-Fi start failed"); // Start Wi-Fi
 
     // Optional: Long Range Mode (can help, but also requires receiver support)
-    ESP_ERROR_CHECK(esp_wifi_set_protocol(ESP_IF_WIFI_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N | WIFI_PROTOCOL_LR));
+    ESP_RETURN_ON_ERROR(esp_wifi_set_protocol(ESP_IF_WIFI_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N | WIFI_PROTOCOL_LR),
+                        TAG, "Long Range protocol failed");
 
     return ESP_OK;
-} 
\ No newline at end of file
+}
+
+esp_err_t esp_now_wifi_deinit(void) {
+    // FTM needs the station without Long Range Mode
+    ESP_ERROR_CHECK(esp_wifi_set_protocol(ESP_IF_WIFI_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N));
+    ESP_ERROR_CHECK(esp_wifi_stop());
+
+    ESP_LOGI(TAG, "Wi-Fi stopped");
+
+    return ESP_OK;
+}
@@ -10,4 +10,11 @@
  */
 esp_err_t esp_now_wifi_init(void);
 
+/**
+ * @brief Stop WiFi after ESP-NOW has been deinitialized
+ * 
+ * @return esp_err_t ESP_OK on success, otherwise an error code
+ */
+esp_err_t esp_now_wifi_deinit(void);
+
 #endif /* ESP_NOW_COMMON_H */ 
\ No newline at end of file
@@ -1,5 +1,4 @@
 #include <string.h>
-#include <math.h>
 #include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
@@ -13,16 +12,26 @@
 #include "esp_timer.h" 
 
 #include "bsp/esp-bsp.h"
-#include "gpio.h"
 
-#include "common.h" 
+#include "approach.h"
+#include "fingerprint.h"
+#include "linkmon.h"
+#include "power.h"
+#include "proximity.h"
+#include "ranging.h"
+#include "csi.h"
+#include "report.h"
+#include "reporter.h"
+#include "timesync.h"
+#include "trace.h"
+#include "UiUpdate.h"
 
 #include "EspNowReceiver.h"
 
 // --- CALIBRATION CONSTANTS (PLEASE ADJUST!) ---
 // This is the expected RSSI value at a distance of 1 meter.
 // Measure this in your environment! Typical values range between -40 and -60 dBm.
-static float s_rssi_at_1_meter = -51.0f;
+#define RSSI_AT_1_METER (-51.0f)
 
 // Path Loss Exponent (n).
 // Describes how quickly the signal decreases with distance.
@@ -34,40 +43,101 @@ static float s_rssi_at_1_meter = -51.0f;
 // ---------------------------------------------------
 
 static const char *TAG = "receiver";
+
+// Calibration builds the unused model and swaps the pointer, the callback never sees a half-built table
+static ranging_model_t s_models[2];
+static const ranging_model_t *volatile s_model = NULL;
+
 static float s_arc_value = 100.0f;
 static int16_t s_rssi_value = 0;
 
+// Range rate per peer slot. Only the Wi-Fi task writes, readers copy under the lock
+static const approach_config_t s_approach_config = {
+    .noise_ratio = CONFIG_CUBE_APPROACH_NOISE_PERCENT / 100.0f,
+    .accel_mps2 = CONFIG_CUBE_APPROACH_ACCEL_CMS2 / 100.0f,
+    .min_speed_mps = CONFIG_CUBE_APPROACH_MIN_SPEED_CMS / 100.0f,
+    .closing_ttc_s = CONFIG_CUBE_APPROACH_TTC_S,
+    .timeout_ms = 2000,
+};
+static portMUX_TYPE s_approach_lock = portMUX_INITIALIZER_UNLOCKED;
+static approach_t s_approach[HISTORY_PEERS];
+
+// Senders get a history slot in the order they are first heard
+static uint8_t s_peer_macs[HISTORY_PEERS][ESP_NOW_ETH_ALEN];
+static uint8_t s_peer_count = 0;
+
 // forward declarations
 static esp_err_t RECEIVER_espnow_init(void);
 static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
 
-// Function to estimate distance based on RSSI
-// Uses the simplified log-distance path loss model: RSSI = A - 10*n*log10(d)
-// where A = RSSI_AT_1_METER, n = PATH_LOSS_EXPONENT, d = distance
-// Rearranged for d: d = 10^((A - RSSI) / (10 * n))
-static float estimate_distance(int16_t rssi) {
-    // Avoid division by zero or logarithm of non-positive numbers (theoretical)
-    if (PATH_LOSS_EXPONENT == 0) return -1.0; // Invalid exponent
+// Only called from the main task, on start and by the calibration
+static void receiver_build_model(float rssi_at_1_meter) {
+    ranging_model_t *next = (s_model == &s_models[0]) ? &s_models[1] : &s_models[0];
 
-    float exponent = (s_rssi_at_1_meter - (float)rssi) / (10.0f * PATH_LOSS_EXPONENT);
-    return powf(10.0f, exponent);
+    RANGING_build(next, rssi_at_1_meter, PATH_LOSS_EXPONENT);
+    s_model = next;
 }
 
 float RECEIVER_getRssiAt1Meter(void) {
-    return s_rssi_at_1_meter;
+    return (s_model != NULL) ? s_model->rssi_at_1m : RSSI_AT_1_METER;
 }
 
 void RECEIVER_setRssiAt1Meter(void) {
-    s_rssi_at_1_meter = s_rssi_value;
+    receiver_build_model(s_rssi_value);
+}
+
+// Only called from the receive callback
+static uint8_t receiver_get_peer(const uint8_t *mac_addr) {
+    const uint8_t known = RECEIVER_lookup_peer(mac_addr);
+    if (known != HISTORY_NO_PEER) {
+        return known;
+    }
+
+    if (s_peer_count >= HISTORY_PEERS) {
+        return HISTORY_NO_PEER;
+    }
+
+    memcpy(s_peer_macs[s_peer_count], mac_addr, ESP_NOW_ETH_ALEN);
+    ESP_LOGI(TAG, "History slot %d for " MACSTR, s_peer_count, MAC2STR(mac_addr));
+
+    return s_peer_count++;
+}
+
+uint8_t RECEIVER_lookup_peer(const uint8_t *mac_addr) {
+    for (uint8_t i = 0; i < s_peer_count; i++) {
+        if (memcmp(s_peer_macs[i], mac_addr, ESP_NOW_ETH_ALEN) == 0) {
+            return i;
+        }
+    }
+
+    return HISTORY_NO_PEER;
 }
 
 void RECEIVER_init(void) {
+    // The calibration survives a role switch
+    if (s_model == NULL) {
+        receiver_build_model(RSSI_AT_1_METER);
+    }
+
+    portENTER_CRITICAL(&s_approach_lock);
+    for (uint8_t i = 0; i < HISTORY_PEERS; i++) {
+        APPROACH_init(&s_approach[i]);
+    }
+    portEXIT_CRITICAL(&s_approach_lock);
+
     if (RECEIVER_espnow_init() != ESP_OK) {
         ESP_LOGE(TAG, "ESP-NOW initialization failed");
         return;
     }
 }
 
+void RECEIVER_deinit(void) {
+    esp_now_unregister_recv_cb();
+    ESP_ERROR_CHECK(esp_now_deinit());
+    s_peer_count = 0;
+    ESP_LOGI(TAG, "ESP-NOW Receiver stopped");
+}
+
 // ESP-NOW initialization
 static esp_err_t RECEIVER_espnow_init(void) {
     // Initialize ESP-NOW
@@ -79,6 +149,23 @@ static esp_err_t RECEIVER_espnow_init(void) {
     return ESP_OK;
 }
 
+// Synchronized senders follow the NUL terminated text with the shared send time
+static void receiver_trace_latency(uint8_t peer, int64_t rx_us, const uint8_t *data, int len) {
+    const int stamp_at = len - (int)sizeof(report_stamp_t);
+    int64_t shared_us;
+    uint32_t error_us;
+
+    if (stamp_at < 1 || data[stamp_at - 1] != '\0' || !TIMESYNC_to_shared(rx_us, &shared_us, &error_us)) {
+        return;
+    }
+
+    report_stamp_t stamp;
+    memcpy(&stamp, &data[stamp_at], sizeof(stamp));
+
+    const int64_t latency_us = shared_us - stamp.time_us;
+    TRACE_record(TRACE_ESPNOW_LATENCY, peer, (uint32_t)(int32_t)latency_us, error_us + stamp.error_us);
+}
+
 // Receive Callback
 static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
     if (recv_info == NULL || data == NULL || len <= 0) {
@@ -95,24 +182,60 @@ static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *
         return;
     }
 
-    GPIO_toggle_led();
-    COMMON_callback_called();
+    // Taken for every frame, the rx_ctrl correction needs the steady stream
+    const int64_t rx_us = TIMESYNC_rx_time(recv_info->rx_ctrl->timestamp);
+
+    // Collector beacons and time exchanges are no sender frames
+    if (REPORTER_frame(mac_addr, data, len)) {
+        TIMESYNC_frame(mac_addr, rx_us, data, len);
+        return;
+    }
+
+    const uint8_t peer = receiver_get_peer(mac_addr);
+    LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, peer);
+    POWER_frame_received(peer);
 
-    // Receive and log data
-    char received_data[len + 1];
-    memcpy(received_data, data, len);
-    received_data[len] = '\0'; // Null termination for string output
-    ESP_LOGI(TAG, "Received data from " MACSTR ": %s (RSSI: %d)", MAC2STR(mac_addr), received_data, rssi);
+    // Table lookup, the Wi-Fi task only records a binary trace instead of formatting log lines.
+    // With CONFIG_CUBE_CSI the RSSI is smoothed more while the CSI shows no motion
+    const float distance = RANGING_estimate(s_model, CSI_get_rssi(peer, rssi));
+    s_arc_value = distance;
 
-    // Estimate and output distance
-    float distance = estimate_distance(rssi);
-    if (distance >= 0) {
-        ESP_LOGI(TAG, "Estimated distance: %.2f meters", distance);
-        s_arc_value = distance;
+    TRACE_record(TRACE_ESPNOW_RX, peer | ((uint8_t)rssi << 8), TRACE_mac_tail(mac_addr),
+                 (uint32_t)(distance * 100.0f));
+
+    receiver_trace_latency(peer, rx_us, data, len);
+
+    // The senders double as anchors, fingerprints use the raw RSSI of every one of them
+    FINGERPRINT_frame(mac_addr, (int8_t)rssi, rx_us);
+
+    if (peer < HISTORY_PEERS) {
+        // The filter runs on a copy, the float math stays out of the critical section
+        approach_t next = s_approach[peer];
+        APPROACH_update(&next, &s_approach_config, rx_us, distance);
+        portENTER_CRITICAL(&s_approach_lock);
+        s_approach[peer] = next;
+        portEXIT_CRITICAL(&s_approach_lock);
+
+        // Zones follow the filtered distance, a single noisy frame does not change them
+        PROXIMITY_update(peer, rx_us, next.distance_m);
+    }
+
+    REPORTER_add(mac_addr, (int8_t)rssi, distance, rx_us);
+    UIUPDATE_post(UI_UPDATE_ESPNOW_RX, peer, (int8_t)rssi, s_arc_value);
+}
+
+void RECEIVER_get_approach(uint8_t peer, int64_t now_us, approach_result_t *result) {
+    approach_t approach;
+
+    if (peer >= HISTORY_PEERS) {
+        APPROACH_init(&approach);
     } else {
-        ESP_LOGW(TAG, "Could not estimate distance (invalid parameters or calculation). RSSI was %d", rssi);
-        s_arc_value = 0.0f;
+        portENTER_CRITICAL(&s_approach_lock);
+        approach = s_approach[peer];
+        portEXIT_CRITICAL(&s_approach_lock);
     }
+
+    APPROACH_get(&approach, &s_approach_config, now_us, result);
 }
 
 float RECEIVER_getDistance(void) {
@@ -1,11 +1,28 @@
 #pragma once 
 
 #include <stdio.h>
+#include <stdint.h>
+
+#include "approach.h"
 
 extern int64_t s_last_time_recv_cb_us;
 
 extern void RECEIVER_init(void);
+extern void RECEIVER_deinit(void);
 extern float RECEIVER_getDistance(void);
 extern int16_t RECEIVER_getRSSI(void);
 extern float RECEIVER_getRssiAt1Meter(void);
-extern void RECEIVER_setRssiAt1Meter(void);
\ No newline at end of file
+extern void RECEIVER_setRssiAt1Meter(void);
+
+// Peer slot of a sender that was already heard, HISTORY_NO_PEER otherwise. Only from the Wi-Fi task
+extern uint8_t RECEIVER_lookup_peer(const uint8_t *mac_addr);
+/**
+ * @brief Range rate and time to contact of a peer, safe from any task
+ *
+ * A constant velocity Kalman filter per peer slot runs on every distance in
+ * the receive callback, this only predicts it to now_us.
+ *
+ * @param peer Peer slot, APPROACH_UNKNOWN for a slot without recent frames
+ * @param now_us esp_timer time
+ */
+extern void RECEIVER_get_approach(uint8_t peer, int64_t now_us, approach_result_t *result);
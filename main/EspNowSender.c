@@ -4,6 +4,7 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
@@ -12,12 +13,19 @@
 #include "esp_mac.h" // For ESP_MAC_ADDR_LEN
 #include "esp_timer.h" 
 
-#include "gpio.h"
 
-#include "common.h" 
+#include "linkmon.h"
+#include "dutycycle.h"
+#include "report.h"
+#include "timesync.h"
+#include "trace.h"
+#include "UiUpdate.h"
 #include "EspNowSender.h"
 
-#define ESPNOW_SEND_DELAY_MS 1000 // Send every 1000ms
+// Fixed send grid, power managed receivers only listen around these slots
+static const dutycycle_config_t s_schedule = {
+    .period_us = CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000,
+};
 
 // !!! IMPORTANT: Replace this with the MAC address of the RECEIVER-ESP32 !!!
 static uint8_t s_peer_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}; // Example: Broadcast, replace!
@@ -25,14 +33,43 @@ static uint8_t s_peer_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF
 // static uint8_t s_peer_mac[ESP_NOW_ETH_ALEN] = {0xE4, 0xB0, 0x63, 0x15, 0xF6, 0x24};
 
 static const char *TAG = "sender";
+static TaskHandle_t s_sender_task = NULL;
+static SemaphoreHandle_t s_sender_stopped = NULL;
+
+// The task is created on every role start, a static stack keeps that off the heap
+#define SENDER_TASK_STACK_SIZE 2048
+static StackType_t s_sender_stack[SENDER_TASK_STACK_SIZE];
+static StaticTask_t s_sender_tcb;
 
 // forward declarations
 static void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status);
+#if CONFIG_CUBE_TIMESYNC
+static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+#endif
 static void SENDER_sender_task(void *pvParameter);
 
 void SENDER_init(void) {
+    if (s_sender_stopped == NULL) {
+        s_sender_stopped = xSemaphoreCreateBinary();
+    }
+
     // Start Sender Task
-    xTaskCreate(SENDER_sender_task, "sender_task", 2048, NULL, 5, NULL);
+    s_sender_task = xTaskCreateStatic(SENDER_sender_task, "sender_task", SENDER_TASK_STACK_SIZE, NULL, 5,
+                                      s_sender_stack, &s_sender_tcb);
+}
+
+void SENDER_deinit(void) {
+    if (s_sender_task == NULL) {
+        return;
+    }
+
+    // The task leaves its loop, deinitializes ESP-NOW and reports back
+    xTaskNotifyGive(s_sender_task);
+    xSemaphoreTake(s_sender_stopped, portMAX_DELAY);
+
+    // Deleted from here, a self-deleted task would keep the static TCB until the idle task cleans up
+    vTaskDelete(s_sender_task);
+    s_sender_task = NULL;
 }
 
 // ESP-NOW Initialization
@@ -43,20 +80,19 @@ static esp_err_t sender_espnow_init(void) {
     // Register Send Callback
     ESP_ERROR_CHECK(esp_now_register_send_cb(espnow_send_cb));
 
-    // Add peer
-    esp_now_peer_info_t *peer = malloc(sizeof(esp_now_peer_info_t));
-    if (peer == NULL) {
-        ESP_LOGE(TAG, "Malloc peer info fail");
-        esp_now_deinit();
-        return ESP_FAIL;
-    }
-    memset(peer, 0, sizeof(esp_now_peer_info_t));
-    peer->channel = 0; // 0 means current channel
-    peer->ifidx = ESP_IF_WIFI_STA;
-    peer->encrypt = false; // No encryption for this example
-    memcpy(peer->peer_addr, s_peer_mac, ESP_NOW_ETH_ALEN);
-    ESP_ERROR_CHECK(esp_now_add_peer(peer));
-    free(peer);
+#if CONFIG_CUBE_TIMESYNC
+    // The sender only listens for the collector beacon and the time exchange
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(espnow_recv_cb));
+#endif
+
+    // Add peer, esp_now_add_peer() copies the info
+    esp_now_peer_info_t peer = {
+        .channel = 0, // 0 means current channel
+        .ifidx = ESP_IF_WIFI_STA,
+        .encrypt = false, // No encryption for this example
+    };
+    memcpy(peer.peer_addr, s_peer_mac, ESP_NOW_ETH_ALEN);
+    ESP_ERROR_CHECK(esp_now_add_peer(&peer));
 
     return ESP_OK;
 }
@@ -68,37 +104,73 @@ static void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status
         return;
     }
     if (status == ESP_NOW_SEND_SUCCESS) {
-        ESP_LOGI(TAG, "Send success to " MACSTR, MAC2STR(mac_addr));
-        
-        GPIO_toggle_led();
-        COMMON_callback_called();
+        TRACE_record(TRACE_ESPNOW_TX_OK, 0, TRACE_mac_tail(mac_addr), 0);
+
+        // There is only one destination, it uses the first slot
+        LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_TX_ACK, 0);
+        UIUPDATE_post(UI_UPDATE_ESPNOW_TX_ACK, HISTORY_NO_PEER, 0, 0.0f);
 
     } else {
-        ESP_LOGW(TAG, "Send fail to " MACSTR ", Status: %d", MAC2STR(mac_addr), status);
+        TRACE_record(TRACE_ESPNOW_TX_FAIL, status, TRACE_mac_tail(mac_addr), 0);
     }
 }
 
+#if CONFIG_CUBE_TIMESYNC
+static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (recv_info == NULL || recv_info->src_addr == NULL || data == NULL) {
+        return;
+    }
+
+    TIMESYNC_frame(recv_info->src_addr, TIMESYNC_rx_time(recv_info->rx_ctrl->timestamp), data, len);
+}
+#endif
+
 // Main Sender Task
 static void SENDER_sender_task(void *pvParameter) {
     uint32_t counter = 0;
-    char send_data[32];
+    uint8_t send_data[32];
+    int64_t anchor_us;
+    int64_t delay_us;
 
     if (sender_espnow_init() != ESP_OK) {
         ESP_LOGE(TAG, "ESP-NOW initialization failed");
-        vTaskDelete(NULL);
+        xSemaphoreGive(s_sender_stopped);
+        vTaskSuspend(NULL);
     }
 
     ESP_LOGI(TAG, "ESP-NOW Sender Initialized. Sending data to " MACSTR, MAC2STR(s_peer_mac));
 
-    while (1) {
-        snprintf(send_data, sizeof(send_data), "Ping %lu", counter++);
-        esp_err_t result = esp_now_send(s_peer_mac, (uint8_t *)send_data, strlen(send_data));
+    anchor_us = esp_timer_get_time();
+
+    do {
+        size_t len = snprintf((char *)send_data, sizeof(send_data) - sizeof(report_stamp_t), "Ping %lu", counter++);
+
+        // When synchronized, the text is NUL terminated and followed by the shared send time
+        int64_t shared_us;
+        uint32_t error_us;
+        if (TIMESYNC_to_shared(esp_timer_get_time(), &shared_us, &error_us)) {
+            const report_stamp_t stamp = { .time_us = shared_us, .error_us = error_us };
+            send_data[len++] = '\0';
+            memcpy(&send_data[len], &stamp, sizeof(stamp));
+            len += sizeof(stamp);
+        }
+
+        esp_err_t result = esp_now_send(s_peer_mac, send_data, len);
 
         if (result == ESP_OK) {
             // ESP_LOGI(TAG, "Sent data: %s", send_data); // Logging can be handled by Send Callback
         } else {
             ESP_LOGE(TAG, "Error sending data: %s", esp_err_to_name(result));
         }
-        vTaskDelay(pdMS_TO_TICKS(ESPNOW_SEND_DELAY_MS));
-    }
+
+        // Sleep until the next slot instead of a fixed delay, so the send time does not drift
+        const int64_t now_us = esp_timer_get_time();
+        delay_us = DUTYCYCLE_next_slot(&s_schedule, anchor_us, now_us) - now_us;
+    } while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((delay_us + 999) / 1000)) == 0); // Stop on SENDER_deinit()
+
+    ESP_ERROR_CHECK(esp_now_deinit());
+    ESP_LOGI(TAG, "ESP-NOW Sender stopped");
+
+    xSemaphoreGive(s_sender_stopped);
+    vTaskSuspend(NULL); // SENDER_deinit() deletes the task
 }
\ No newline at end of file
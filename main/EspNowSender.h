@@ -1,3 +1,4 @@
 #pragma once 
 
-extern void SENDER_init(void);
\ No newline at end of file
+extern void SENDER_init(void);
+extern void SENDER_deinit(void);
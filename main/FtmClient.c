@@ -12,11 +12,15 @@
 #include "esp_wifi.h"
 #include "esp_console.h"
 #include "esp_mac.h"
+#include "sdkconfig.h"
 #include "FtmClient.h"
 
 #define DEFAULT_WAIT_TIME_MS        (10 * 1000)
 #define MAX_FTM_BURSTS              (8)
 
+// Scan results are filtered by SSID, more matching APs are counted and dropped
+#define FTM_SCAN_MAX_APS            (CONFIG_CUBE_FTM_SCAN_MAX_APS)
+
 static const char *TAG = "FTM_CLIENT";
 
 wifi_ftm_initiator_cfg_t ftmi_cfg = {
@@ -26,8 +30,9 @@ wifi_ftm_initiator_cfg_t ftmi_cfg = {
 };
 
 const char *ftm_responder_ssid = "FTM";
-uint16_t g_scan_ap_num;
-wifi_ap_record_t *g_ap_list_buffer;
+static uint16_t s_scan_ap_num;
+static wifi_ap_record_t s_ap_list[FTM_SCAN_MAX_APS];
+static uint32_t s_scan_overflow = 0;
 
 //forward declaration
 wifi_ap_record_t *find_ftm_responder_ap(const char *ssid);
@@ -53,6 +58,16 @@ void FTMCLIENT_init(void)
     }
 } 
 
+void FTMCLIENT_deinit(void)
+{
+    // Fails harmlessly when no session is running
+    esp_wifi_ftm_end_session();
+
+    s_scan_ap_num = 0;
+
+    ESP_LOGI(TAG, "FTM Client stopped");
+}
+
 int FTMCLIENT_measure(void)
 {
     ESP_LOGI(TAG, "Requesting FTM session with Frm Count - %d, Burst Period - %dmSec (0: No Preference)",
@@ -75,24 +90,21 @@ wifi_ap_record_t *find_ftm_responder_ap(const char *ssid)
         return NULL;
 
 retry:
-    if (!g_ap_list_buffer || (g_scan_ap_num == 0)) {
+    if (s_scan_ap_num == 0) {
         ESP_LOGI(TAG, "Scanning for %s", ssid);
         if (false == wifi_perform_scan(ssid, true)) {
             return NULL;
         }
     }
 
-    for (i = 0; i < g_scan_ap_num; i++) {
-        if (strcmp((const char *)g_ap_list_buffer[i].ssid, ssid) == 0)
-            return &g_ap_list_buffer[i];
+    for (i = 0; i < s_scan_ap_num; i++) {
+        if (strcmp((const char *)s_ap_list[i].ssid, ssid) == 0)
+            return &s_ap_list[i];
     }
 
     if (!retry_scan) {
         retry_scan = true;
-        if (g_ap_list_buffer) {
-            free(g_ap_list_buffer);
-            g_ap_list_buffer = NULL;
-        }
+        s_scan_ap_num = 0;
         goto retry;
     }
 
@@ -119,28 +131,30 @@ static bool wifi_perform_scan(const char *ssid, bool internal)
         return false;
     }
 
-    esp_wifi_scan_get_ap_num(&g_scan_ap_num);
-    if (g_scan_ap_num == 0) {
+    uint16_t found = 0;
+    esp_wifi_scan_get_ap_num(&found);
+    if (found == 0) {
         ESP_LOGI(TAG, "No matching AP found");
         return false;
     }
 
-    if (g_ap_list_buffer) {
-        free(g_ap_list_buffer);
+    // Fixed pool instead of a buffer per scan, the driver frees the records that do not fit
+    if (found > FTM_SCAN_MAX_APS) {
+        s_scan_overflow += found - FTM_SCAN_MAX_APS;
+        ESP_LOGW(TAG, "%d APs found, only %d kept (%lu dropped so far)", found, FTM_SCAN_MAX_APS,
+                 (unsigned long)s_scan_overflow);
     }
-    g_ap_list_buffer = malloc(g_scan_ap_num * sizeof(wifi_ap_record_t));
-    if (g_ap_list_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to malloc buffer to print scan results");
-        esp_wifi_clear_ap_list();
+
+    s_scan_ap_num = FTM_SCAN_MAX_APS;
+    if (esp_wifi_scan_get_ap_records(&s_scan_ap_num, s_ap_list) != ESP_OK) {
+        s_scan_ap_num = 0;
         return false;
     }
 
-    if (esp_wifi_scan_get_ap_records(&g_scan_ap_num, (wifi_ap_record_t *)g_ap_list_buffer) == ESP_OK) {
-        if (!internal) {
-            for (i = 0; i < g_scan_ap_num; i++) {
-                ESP_LOGI(TAG, "[%s][rssi=%d]""%s", g_ap_list_buffer[i].ssid, g_ap_list_buffer[i].rssi,
-                         g_ap_list_buffer[i].ftm_responder ? "[FTM Responder]" : "");
-            }
+    if (!internal) {
+        for (i = 0; i < s_scan_ap_num; i++) {
+            ESP_LOGI(TAG, "[%s][rssi=%d]""%s", s_ap_list[i].ssid, s_ap_list[i].rssi,
+                     s_ap_list[i].ftm_responder ? "[FTM Responder]" : "");
         }
     }
 
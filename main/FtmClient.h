@@ -2,6 +2,7 @@
 #define FTM_CLIENT_H
 
 void FTMCLIENT_init(void);
+void FTMCLIENT_deinit(void);
 int FTMCLIENT_measure(void);
 
 #endif /* FTM_CLIENT_H */ 
\ No newline at end of file
@@ -3,11 +3,15 @@
 #include "esp_netif.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_check.h"
+
+#include "UiUpdate.h"
+#include "linkmon.h"
+#include "trace.h"
 
 static const char *TAG = "FtmCommon";
 
-static EventGroupHandle_t s_wifi_event_group;
-static EventGroupHandle_t s_ftm_event_group;
+static esp_event_handler_instance_t s_event_instance = NULL;
 static bool s_ap_started;
 static uint8_t s_ftm_report_num_entries;
 static uint32_t s_rtt_est, s_dist_est;
@@ -31,8 +35,11 @@ static void event_handler(void *arg, esp_event_base_t event_base,
         s_dist_est = event->dist_est;
         s_ftm_report_num_entries = event->ftm_report_num_entries;
 
-        ESP_LOGI(TAG, "Estimated RTT - %" PRId32 " nSec, Estimated Distance - %" PRId32 ".%02" PRId32 " meters",
-                          s_rtt_est, s_dist_est / 100, s_dist_est % 100);
+        TRACE_record(TRACE_FTM_REPORT, s_ftm_report_num_entries, s_rtt_est, s_dist_est);
+
+        // There is only one responder, it always uses the first history slot
+        LINKMON_heartbeat(LINKMON_SOURCE_FTM_REPORT, 0);
+        UIUPDATE_post(UI_UPDATE_FTM_REPORT, 0, 0, s_dist_est / 100.0f);
 
     } else if (event_id == WIFI_EVENT_AP_START) {
         s_ap_started = true;
@@ -42,24 +49,39 @@ static void event_handler(void *arg, esp_event_base_t event_base,
 }
 
 esp_err_t ftm_wifi_init(void) {
-    ESP_ERROR_CHECK(esp_netif_init()); // Initialize TCP/IP stack (required for Wi-Fi)
-    
-    s_wifi_event_group = xEventGroupCreate();
-    s_ftm_event_group = xEventGroupCreate();
-    ESP_ERROR_CHECK(esp_event_loop_create_default()); // Create default event loop
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg)); // Initialize Wi-Fi driver
-
-    esp_event_handler_instance_t instance_any_id;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-
-    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM)); // Store Wi-Fi config in RAM
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP)); // AP mode is required for FTM Responder
-    ESP_ERROR_CHECK(esp_wifi_start()); // Start Wi-Fi
+    // TCP/IP stack, event loop and Wi-Fi driver are set up once by RADIO_start()
+    // Failures are returned, RADIO_start() reports them and the LED shows the error pattern
+    ESP_RETURN_ON_ERROR(esp_event_handler_instance_register(WIFI_EVENT,
+                                                            ESP_EVENT_ANY_ID,
+                                                            &event_handler,
+                                                            NULL,
+                                                            &s_event_instance),
+                        TAG, "Event handler registration failed");
+
+    esp_err_t err = esp_wifi_set_mode(WIFI_MODE_AP); // AP mode is required for FTM Responder
+    if (err == ESP_OK) {
+        err = esp_wifi_start(); // Start Wi-Fi
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi start failed: %s", esp_err_to_name(err));
+        esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, s_event_instance);
+        s_event_instance = NULL;
+    }
+
+    return err;
+}
+
+esp_err_t ftm_wifi_deinit(void) {
+    if (s_event_instance != NULL) {
+        ESP_ERROR_CHECK(esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, s_event_instance));
+        s_event_instance = NULL;
+    }
+
+    ESP_ERROR_CHECK(esp_wifi_stop());
+    s_ap_started = false;
+
+    ESP_LOGI(TAG, "Wi-Fi stopped");
 
     return ESP_OK;
-} 
\ No newline at end of file
+}
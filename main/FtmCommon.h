@@ -9,6 +9,13 @@
  * @return esp_err_t ESP_OK on success, otherwise an error code
  */
 extern esp_err_t ftm_wifi_init(void);
+
+/**
+ * @brief Unregister the FTM event handler and stop WiFi
+ * 
+ * @return esp_err_t ESP_OK on success, otherwise an error code
+ */
+extern esp_err_t ftm_wifi_deinit(void);
 extern float FTMCOMMON_getDistance(void);
 
 #endif /* FTM_COMMON_H */ 
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+
+#include "UiUpdate.h"
+
+// The UI drains the queue once per display refresh, so a few slots are enough
+#define UI_UPDATE_QUEUE_LEN 16
+
+static const char *TAG = "ui_update";
+static QueueHandle_t s_queue = NULL;
+
+// Posted from several tasks, the counter is only touched under the lock
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_dropped = 0;
+
+void UIUPDATE_init(void)
+{
+    if (s_queue != NULL) {
+        return;
+    }
+
+    s_queue = xQueueCreate(UI_UPDATE_QUEUE_LEN, sizeof(ui_update_msg_t));
+    if (s_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create UI update queue");
+    }
+}
+
+// Called from the Wi-Fi task and the button task, never blocks
+void UIUPDATE_post(ui_update_type_t type, uint8_t peer, int8_t rssi, float distance_m)
+{
+    if (s_queue == NULL) {
+        return;
+    }
+
+    ui_update_msg_t msg = {
+        .type = (uint8_t)type,
+        .peer = peer,
+        .rssi = rssi,
+        .distance_cm = 0,
+    };
+
+    if (distance_m > 0.0f) {
+        const float distance_cm = distance_m * 100.0f;
+        msg.distance_cm = (distance_cm >= (float)UINT16_MAX) ? UINT16_MAX : (uint16_t)distance_cm;
+    }
+
+    // A full queue means the UI is behind, newer data will follow anyway
+    if (xQueueSend(s_queue, &msg, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_lock);
+        s_dropped++;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+bool UIUPDATE_receive(ui_update_msg_t *msg, TickType_t timeout)
+{
+    if (s_queue == NULL || msg == NULL) {
+        return false;
+    }
+
+    return xQueueReceive(s_queue, msg, timeout) == pdTRUE;
+}
+
+uint32_t UIUPDATE_get_dropped(void)
+{
+    uint32_t dropped;
+
+    portENTER_CRITICAL(&s_lock);
+    dropped = s_dropped;
+    portEXIT_CRITICAL(&s_lock);
+
+    return dropped;
+}
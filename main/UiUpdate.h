@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "history.h"
+
+// Source of a UI update message
+typedef enum {
+    UI_UPDATE_ESPNOW_RX = 0,    // ESP-NOW frame received, rssi and distance are valid
+    UI_UPDATE_ESPNOW_TX_ACK,    // ESP-NOW frame acknowledged by the peer
+    UI_UPDATE_FTM_REPORT,       // FTM session finished, distance is valid
+    UI_UPDATE_INPUT,            // Button changed the mode selection or calibration step
+    UI_UPDATE_LINK,             // Link monitor state change of a source and peer
+    UI_UPDATE_DIAG,             // New diagnostics snapshot
+    UI_UPDATE_ZONE,             // Proximity zone of a peer changed, distance is the filtered one
+} ui_update_type_t;
+
+// Compact message posted by the radio paths, 6 bytes per queue slot
+typedef struct {
+    uint8_t type;
+    uint8_t peer;               // History slot of the sender, HISTORY_NO_PEER if not tracked
+    int8_t rssi;
+    uint16_t distance_cm;
+} ui_update_msg_t;
+
+extern void UIUPDATE_init(void);
+extern void UIUPDATE_post(ui_update_type_t type, uint8_t peer, int8_t rssi, float distance_m);
+extern bool UIUPDATE_receive(ui_update_msg_t *msg, TickType_t timeout);
+extern uint32_t UIUPDATE_get_dropped(void);
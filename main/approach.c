@@ -0,0 +1,112 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "approach.h"
+
+// Range rate uncertainty of a new track, a walking tag moves up to about 2 m/s
+#define APPROACH_INITIAL_RATE_SIGMA     (2.0f)
+
+// Samples until the range rate is trusted
+#define APPROACH_MIN_SAMPLES            (5)
+
+// Distances below this get the noise of this distance, RSSI never reads exactly 0
+#define APPROACH_MIN_NOISE_DISTANCE     (0.5f)
+
+// Sigmas the range rate must be away from 0 to count as closing or receding
+#define APPROACH_RATE_SIGMAS            (1.5f)
+
+void APPROACH_init(approach_t *a)
+{
+    memset(a, 0, sizeof(*a));
+}
+
+static float approach_noise(const approach_config_t *config, float distance_m)
+{
+    const float d = (distance_m > APPROACH_MIN_NOISE_DISTANCE) ? distance_m : APPROACH_MIN_NOISE_DISTANCE;
+    const float sigma = config->noise_ratio * d;
+
+    return sigma * sigma;
+}
+
+void APPROACH_update(approach_t *a, const approach_config_t *config, int64_t time_us, float distance_m)
+{
+    const int64_t gap_us = time_us - a->time_us;
+    const float r = approach_noise(config, distance_m);
+
+    if (a->samples == 0 || gap_us < 0 || gap_us > (int64_t)config->timeout_ms * 1000) {
+        a->time_us = time_us;
+        a->distance_m = distance_m;
+        a->rate_mps = 0.0f;
+        a->p_dd = r;
+        a->p_dr = 0.0f;
+        a->p_rr = APPROACH_INITIAL_RATE_SIGMA * APPROACH_INITIAL_RATE_SIGMA;
+        a->samples = 1;
+        return;
+    }
+
+    // Predict: x = F x, P = F P F' + Q with a white acceleration of accel_mps2
+    const float dt = gap_us * 1e-6f;
+    const float q = config->accel_mps2 * config->accel_mps2;
+    const float dt2 = dt * dt;
+
+    a->distance_m += a->rate_mps * dt;
+    a->p_dd += dt * (2.0f * a->p_dr + dt * a->p_rr) + q * dt2 * dt / 3.0f;
+    a->p_dr += dt * a->p_rr + q * dt2 / 2.0f;
+    a->p_rr += q * dt;
+
+    // Update with the measured distance
+    const float s = a->p_dd + r;
+    const float k_d = a->p_dd / s;
+    const float k_r = a->p_dr / s;
+    const float innovation = distance_m - a->distance_m;
+
+    a->distance_m += k_d * innovation;
+    a->rate_mps += k_r * innovation;
+    a->p_rr -= k_r * a->p_dr;
+    a->p_dr -= k_d * a->p_dr;
+    a->p_dd -= k_d * a->p_dd;
+
+    a->time_us = time_us;
+    if (a->samples < UINT16_MAX) {
+        a->samples++;
+    }
+}
+
+void APPROACH_get(const approach_t *a, const approach_config_t *config, int64_t now_us, approach_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+
+    const int64_t age_us = now_us - a->time_us;
+    if (a->samples == 0 || age_us > (int64_t)config->timeout_ms * 1000) {
+        result->state = APPROACH_UNKNOWN;
+        return;
+    }
+
+    const float dt = (age_us > 0) ? age_us * 1e-6f : 0.0f;
+    result->distance_m = a->distance_m + a->rate_mps * dt;
+    if (result->distance_m < 0.0f) {
+        result->distance_m = 0.0f;
+    }
+    result->rate_mps = a->rate_mps;
+    result->rate_sigma_mps = sqrtf(a->p_rr + config->accel_mps2 * config->accel_mps2 * dt);
+
+    if (a->samples < APPROACH_MIN_SAMPLES) {
+        result->state = APPROACH_UNKNOWN;
+        return;
+    }
+
+    float threshold = APPROACH_RATE_SIGMAS * result->rate_sigma_mps;
+    if (threshold < config->min_speed_mps) {
+        threshold = config->min_speed_mps;
+    }
+
+    if (result->rate_mps < -threshold) {
+        result->ttc_s = result->distance_m / -result->rate_mps;
+        result->state = (result->ttc_s < config->closing_ttc_s) ? APPROACH_CLOSING_FAST : APPROACH_CLOSING;
+    } else if (result->rate_mps > threshold) {
+        result->state = APPROACH_RECEDING;
+    } else {
+        result->state = APPROACH_STEADY;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, the receive callback feeds it one distance per frame
+
+typedef enum {
+    APPROACH_UNKNOWN = 0,       // Too few or too old samples
+    APPROACH_STEADY,            // Range rate within its uncertainty or below the minimum speed
+    APPROACH_RECEDING,
+    APPROACH_CLOSING,
+    APPROACH_CLOSING_FAST,      // Time to contact below closing_ttc_s
+} approach_state_t;
+
+typedef struct {
+    float noise_ratio;          // Standard deviation of a single distance relative to the distance
+    float accel_mps2;           // Expected acceleration of a tag, the process noise
+    float min_speed_mps;        // Slower range rates count as steady
+    float closing_ttc_s;        // Time to contact of APPROACH_CLOSING_FAST
+    uint32_t timeout_ms;        // Without a sample for this long the state is unknown and restarts
+} approach_config_t;
+
+// Constant velocity Kalman filter of the distance, 2 states with a symmetric covariance
+typedef struct {
+    int64_t time_us;            // Of the last sample
+    float distance_m;
+    float rate_mps;             // Negative while approaching
+    float p_dd;                 // Covariance
+    float p_dr;
+    float p_rr;
+    uint16_t samples;
+} approach_t;
+
+typedef struct {
+    approach_state_t state;
+    float distance_m;           // Predicted to the requested time
+    float rate_mps;             // Negative while approaching
+    float rate_sigma_mps;
+    float ttc_s;                // Time to contact while closing, 0 otherwise
+} approach_result_t;
+
+extern void APPROACH_init(approach_t *a);
+
+/**
+ * @brief Add one distance sample, constant time
+ *
+ * @param time_us Reception time of the sample, samples must not go back in time
+ */
+extern void APPROACH_update(approach_t *a, const approach_config_t *config, int64_t time_us, float distance_m);
+
+/**
+ * @brief Range rate and time to contact, predicted to now_us without changing the filter
+ */
+extern void APPROACH_get(const approach_t *a, const approach_config_t *config, int64_t now_us,
+                         approach_result_t *result);
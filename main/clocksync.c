@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "clocksync.h"
+
+// Frames per block of the rx_ctrl minimum, the minimum covers the last one to two blocks
+#define CLOCKSYNC_RX_BLOCK      (32)
+
+// A round trip up to twice the best plus this margin is accepted
+#define CLOCKSYNC_RTT_MARGIN_US (300)
+
+// After this many rejected exchanges in a row the reference round trip is reset
+#define CLOCKSYNC_MAX_REJECTED  (8)
+
+void CLOCKSYNC_rxstamp_init(clocksync_rxstamp_t *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+int64_t CLOCKSYNC_rx_time(clocksync_rxstamp_t *s, uint32_t rx_ts, int64_t now_us)
+{
+    const uint32_t diff = (uint32_t)now_us - rx_ts;
+
+    if (!s->valid) {
+        s->valid = true;
+        s->ref = diff;
+        s->min_cur = 0;
+        s->min_prev = 0;
+        s->count = 0;
+    }
+
+    // Relative to the first difference, so the 32 bit wrap of both clocks cancels
+    const int32_t rel = (int32_t)(diff - s->ref);
+
+    if (s->count == 0 || rel < s->min_cur) {
+        s->min_cur = rel;
+    }
+    if (++s->count >= CLOCKSYNC_RX_BLOCK) {
+        s->min_prev = s->min_cur;
+        s->count = 0;
+    }
+
+    const int32_t min = (s->min_cur < s->min_prev) ? s->min_cur : s->min_prev;
+
+    return now_us - (rel - min);
+}
+
+void CLOCKSYNC_init(clocksync_t *c)
+{
+    memset(c, 0, sizeof(*c));
+}
+
+// Least squares line through the samples, x relative to the newest to keep the doubles small
+static void clocksync_fit(clocksync_t *c)
+{
+    const clocksync_sample_t *newest = &c->samples[(c->next + CLOCKSYNC_SAMPLES - 1) % CLOCKSYNC_SAMPLES];
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    uint32_t best_rtt = UINT32_MAX;
+
+    for (uint8_t i = 0; i < c->count; i++) {
+        const clocksync_sample_t *s = &c->samples[i];
+        const double x = (double)(s->local_us - newest->local_us);
+        const double y = (double)(s->offset_us - newest->offset_us);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        best_rtt = (s->rtt_us < best_rtt) ? s->rtt_us : best_rtt;
+    }
+
+    const double n = c->count;
+    const double den = n * sxx - sx * sx;
+    const double slope = (c->count >= 2 && den > 0) ? (n * sxy - sx * sy) / den : 0.0;
+    const double intercept = (sy - slope * sx) / n;
+
+    c->base_local_us = newest->local_us;
+    c->base_offset_us = newest->offset_us + (int64_t)intercept;
+    c->drift_ppb = (int32_t)(slope * 1e9);
+    c->best_rtt_us = best_rtt;
+
+    c->residual_us = 0;
+    for (uint8_t i = 0; i < c->count; i++) {
+        const clocksync_sample_t *s = &c->samples[i];
+        const double x = (double)(s->local_us - newest->local_us);
+        const double y = (double)(s->offset_us - newest->offset_us);
+        double r = y - (intercept + slope * x);
+        r = (r < 0) ? -r : r;
+        if ((uint32_t)r > c->residual_us) {
+            c->residual_us = (uint32_t)r;
+        }
+    }
+}
+
+bool CLOCKSYNC_exchange(clocksync_t *c, int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+    const int64_t rtt = (t4 - t1) - (t3 - t2);
+
+    if (rtt < 0 || rtt > UINT32_MAX) {
+        return false;
+    }
+
+    // Queueing and retries only ever add delay, the fastest exchanges are the symmetric ones
+    c->min_rtt_us += c->min_rtt_us >> 4;
+    if (c->count > 0 && (uint32_t)rtt > c->min_rtt_us * 2 + CLOCKSYNC_RTT_MARGIN_US) {
+        if (++c->rejected < CLOCKSYNC_MAX_REJECTED) {
+            return false;
+        }
+    }
+    if (c->count == 0 || c->rejected > 0 || (uint32_t)rtt < c->min_rtt_us) {
+        c->min_rtt_us = (uint32_t)rtt;
+    }
+    c->rejected = 0;
+
+    clocksync_sample_t *s = &c->samples[c->next];
+    s->local_us = t4;
+    s->offset_us = ((t2 - t1) + (t3 - t4)) / 2;
+    s->rtt_us = (uint32_t)rtt;
+    c->next = (c->next + 1) % CLOCKSYNC_SAMPLES;
+    if (c->count < CLOCKSYNC_SAMPLES) {
+        c->count++;
+    }
+
+    clocksync_fit(c);
+
+    return true;
+}
+
+bool CLOCKSYNC_to_shared(const clocksync_t *c, int64_t local_us, int64_t *shared_us, uint32_t *error_us)
+{
+    if (c->count == 0) {
+        return false;
+    }
+
+    const int64_t dt = local_us - c->base_local_us;
+    *shared_us = local_us + c->base_offset_us + dt * c->drift_ppb / 1000000000;
+
+    // Half the round trip bounds the asymmetry, the holdover covers the time since the last exchange
+    const int64_t age = (dt < 0) ? -dt : dt;
+    const int64_t bound = c->best_rtt_us / 2 + c->residual_us + age * CLOCKSYNC_HOLDOVER_PPM / 1000000;
+    *error_us = (bound > UINT32_MAX) ? UINT32_MAX : (uint32_t)bound;
+
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, timesync.c feeds it timestamps of the ESP-NOW exchanges
+
+// Exchanges used for the offset and drift fit
+#define CLOCKSYNC_SAMPLES       (8)
+
+// Assumed crystal error for the error bound while there is no drift estimate or no new exchange
+#define CLOCKSYNC_HOLDOVER_PPM  (20)
+
+/**
+ * @brief Reception time of a frame from the rx_ctrl timestamp of the Wi-Fi driver
+ *
+ * The rx_ctrl clock runs with esp_timer but from another epoch, and the
+ * receive callback starts with a varying delay. The smallest difference of
+ * the two clocks over the recent frames is the epoch offset plus the fastest
+ * delivery, subtracting the excess removes the callback jitter.
+ */
+typedef struct {
+    bool valid;
+    uint32_t ref;               // First difference, the others are kept relative to it
+    int32_t min_cur;            // Smallest difference of the running block of frames
+    int32_t min_prev;           // ... and of the previous block
+    uint8_t count;
+} clocksync_rxstamp_t;
+
+typedef struct {
+    int64_t local_us;           // Client clock at the reply
+    int64_t offset_us;          // Shared minus local
+    uint32_t rtt_us;
+} clocksync_sample_t;
+
+// Offset and drift of the local clock against the master
+typedef struct {
+    clocksync_sample_t samples[CLOCKSYNC_SAMPLES];
+    uint8_t count;
+    uint8_t next;
+    uint8_t rejected;           // Exchanges in a row rejected for their round trip
+    uint32_t min_rtt_us;        // Slowly aging best round trip, the acceptance reference
+    int64_t base_local_us;      // Fit: offset = base_offset_us + (local - base_local_us) * drift_ppb / 1e9
+    int64_t base_offset_us;
+    int32_t drift_ppb;
+    uint32_t residual_us;       // Largest deviation of a sample from the fit
+    uint32_t best_rtt_us;       // Smallest round trip of the fitted samples
+} clocksync_t;
+
+extern void CLOCKSYNC_rxstamp_init(clocksync_rxstamp_t *s);
+
+/**
+ * @brief Reception time of a frame on the esp_timer clock
+ *
+ * @param s Per receive path state
+ * @param rx_ts rx_ctrl->timestamp of the frame
+ * @param now_us esp_timer_get_time() in the receive callback
+ * @return now_us minus the delivery delay beyond the fastest one seen recently
+ */
+extern int64_t CLOCKSYNC_rx_time(clocksync_rxstamp_t *s, uint32_t rx_ts, int64_t now_us);
+
+extern void CLOCKSYNC_init(clocksync_t *c);
+
+/**
+ * @brief Add one two-way exchange
+ *
+ * @param t1 Client clock when the request was sent
+ * @param t2 Master clock when the request arrived
+ * @param t3 Master clock when the reply was sent
+ * @param t4 Client clock when the reply arrived
+ * @return false if the exchange was dropped for a slow round trip
+ */
+extern bool CLOCKSYNC_exchange(clocksync_t *c, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+/**
+ * @brief Convert local time to the shared timebase of the master
+ *
+ * @param error_us Bound of the error: half the best round trip, the fit residual and the holdover
+ * @return false if no exchange was accepted yet
+ */
+extern bool CLOCKSYNC_to_shared(const clocksync_t *c, int64_t local_us, int64_t *shared_us, uint32_t *error_us);
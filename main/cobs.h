@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, framing of the collector host stream
+
+// Worst case size of COBS(len bytes), without the delimiters
+#define COBS_MAX_ENCODED(len)   ((len) + (len) / 254 + 1)
+
+/**
+ * @brief Consistent overhead byte stuffing, the output contains no zero byte
+ *
+ * @param in Data, may contain zero bytes
+ * @param len Bytes in in
+ * @param out At least COBS_MAX_ENCODED(len) bytes
+ * @return Bytes written to out
+ */
+extern size_t COBS_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+// CRC-16/CCITT-FALSE, polynomial 0x1021, start 0xFFFF
+extern uint16_t COBS_crc16(const uint8_t *data, size_t len);
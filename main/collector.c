@@ -0,0 +1,335 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/usb_serial_jtag.h"
+#include "driver/usb_serial_jtag_vfs.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_now.h"
+#include "esp_timer.h"
+
+#include "cobs.h"
+#include "linkmon.h"
+#include "report.h"
+#include "timesync.h"
+#include "trace.h"
+#include "collector.h"
+
+#define COLLECTOR_TASK_STACK_SIZE   3072
+#define COLLECTOR_TASK_PRIORITY     3
+
+// Host records waiting for USB, about one second at 500 ranges per second
+#define COLLECTOR_RING              (512)
+#define COLLECTOR_FRAME_RECORDS     (32)
+#define COLLECTOR_FLUSH_MS          (20)
+#define COLLECTOR_STATS_US          (1000 * 1000)
+#define COLLECTOR_BEACON_US         (1000 * 1000)
+#define COLLECTOR_USB_TIMEOUT_MS    (20)
+
+// Receivers with their own repeat window, frames of further receivers are dropped
+#define COLLECTOR_RECEIVERS         (CONFIG_CUBE_COLLECTOR_RECEIVERS)
+#define COLLECTOR_WINDOW            (64)
+
+#define COLLECTOR_MAX_PAYLOAD       (COLLECTOR_FRAME_RECORDS * sizeof(report_host_record_t))
+#define COLLECTOR_MAX_FRAME         (sizeof(report_host_header_t) + COLLECTOR_MAX_PAYLOAD + 2)
+
+typedef struct {
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    uint16_t last_seq;
+    uint64_t window;            // Bit n: batch last_seq - n was received
+} collector_receiver_t;
+
+static const char *TAG = "collector";
+static const uint8_t s_broadcast_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Written by the Wi-Fi task
+static collector_receiver_t s_receivers[COLLECTOR_RECEIVERS];
+static uint8_t s_receiver_count = 0;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static report_host_record_t s_ring[COLLECTOR_RING];
+static uint32_t s_head = 0;
+static uint32_t s_tail = 0;
+static report_host_stats_t s_stats;
+
+static esp_timer_handle_t s_beacon_timer = NULL;
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_task_stopped = NULL;
+
+// Only used by the USB task
+static uint8_t s_frame[COLLECTOR_MAX_FRAME];
+static uint8_t s_encoded[COBS_MAX_ENCODED(COLLECTOR_MAX_FRAME) + 2];
+static uint16_t s_host_seq = 0;
+
+// Slot of a receiver, a new one gets the next free slot, first heard first
+static int collector_get_receiver(const uint8_t *mac)
+{
+    for (uint8_t i = 0; i < s_receiver_count; i++) {
+        if (memcmp(s_receivers[i].mac, mac, ESP_NOW_ETH_ALEN) == 0) {
+            return i;
+        }
+    }
+
+    if (s_receiver_count >= COLLECTOR_RECEIVERS) {
+        return -1;
+    }
+
+    collector_receiver_t *r = &s_receivers[s_receiver_count];
+    memcpy(r->mac, mac, ESP_NOW_ETH_ALEN);
+    r->window = 0;
+
+    return s_receiver_count++;
+}
+
+// Sliding window over the 16 bit batch numbers, returns false for a repeated batch
+static bool collector_accept(collector_receiver_t *r, uint16_t seq)
+{
+    const int16_t ahead = (int16_t)(seq - r->last_seq);
+
+    if (r->window == 0 || ahead >= COLLECTOR_WINDOW || ahead <= -COLLECTOR_WINDOW) {
+        // First batch, or the receiver restarted with a new random number
+        r->last_seq = seq;
+        r->window = 1;
+        return true;
+    }
+
+    if (ahead > 0) {
+        r->window = (r->window << ahead) | 1;
+        r->last_seq = seq;
+        return true;
+    }
+
+    const uint64_t bit = 1ull << (-ahead);
+    if (r->window & bit) {
+        return false;
+    }
+    r->window |= bit;
+
+    return true;
+}
+
+// Wi-Fi task, only copies the records into the host ring
+static void collector_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len)
+{
+    if (recv_info == NULL || data == NULL || len < (int)sizeof(report_header_t)) {
+        return;
+    }
+
+    // Time exchange requests are answered right here, with the reception time from rx_ctrl
+    const int64_t rx_us = TIMESYNC_rx_time(recv_info->rx_ctrl->timestamp);
+    if (TIMESYNC_frame(recv_info->src_addr, rx_us, data, len)) {
+        return;
+    }
+
+    const report_header_t *header = (const report_header_t *)data;
+    const int records_len = (int)(sizeof(report_header_t) + header->count * sizeof(report_record_t));
+    if (header->magic != REPORT_MAGIC || header->version != REPORT_VERSION ||
+        header->type != REPORT_FRAME_RANGES ||
+        (len != records_len && len != records_len + (int)sizeof(report_stamp_t))) {
+        return;
+    }
+
+    const int slot = collector_get_receiver(recv_info->src_addr);
+    if (slot < 0) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.unknown++;
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    if (!collector_accept(&s_receivers[slot], header->seq)) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.duplicates++;
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    LINKMON_heartbeat(LINKMON_SOURCE_REPORT_RX, (uint8_t)slot);
+
+    const report_record_t *records = (const report_record_t *)&data[sizeof(report_header_t)];
+    uint32_t now_ms = (uint32_t)(rx_us / 1000);
+    uint8_t flags = 0;
+
+    // A synchronized receiver stamps the batch, so the air and queueing time do not shift the ranges
+    if (len > records_len) {
+        report_stamp_t stamp;
+        memcpy(&stamp, &data[records_len], sizeof(stamp));
+        now_ms = (uint32_t)(stamp.time_us / 1000);
+        flags = REPORT_HOST_SYNCED;
+    }
+    const uint32_t receiver = TRACE_mac_tail(recv_info->src_addr);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.frames++;
+    for (uint8_t i = 0; i < header->count; i++) {
+        if (s_head - s_tail >= COLLECTOR_RING) {
+            s_stats.ring_full += header->count - i;
+            break;
+        }
+        s_ring[s_head % COLLECTOR_RING] = (report_host_record_t){
+            .time_ms = now_ms - records[i].age_ms,
+            .receiver = receiver,
+            .sender = records[i].sender,
+            .distance_cm = records[i].distance_cm,
+            .rssi = records[i].rssi,
+            .flags = records[i].flags | flags,
+        };
+        s_head++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void collector_beacon_cb(void *arg)
+{
+    const report_header_t beacon = {
+        .magic = REPORT_MAGIC,
+        .version = REPORT_VERSION,
+        .type = REPORT_FRAME_BEACON,
+    };
+
+    esp_now_send(s_broadcast_mac, (const uint8_t *)&beacon, sizeof(beacon));
+}
+
+// Header, payload and CRC in s_frame, written as one call so log lines cannot split it
+static void collector_write_frame(report_host_type_t type, uint8_t count, size_t payload_len)
+{
+    report_host_header_t *header = (report_host_header_t *)s_frame;
+    header->type = type;
+    header->count = count;
+    header->seq = s_host_seq++;
+
+    const size_t len = sizeof(*header) + payload_len;
+    const uint16_t crc = COBS_crc16(s_frame, len);
+    s_frame[len] = crc & 0xFF;
+    s_frame[len + 1] = crc >> 8;
+
+    // Leading delimiter too, so text that came before ends in its own chunk
+    s_encoded[0] = 0;
+    const size_t encoded = COBS_encode(s_frame, len + 2, &s_encoded[1]);
+    s_encoded[encoded + 1] = 0;
+
+    const int written = usb_serial_jtag_write_bytes(s_encoded, encoded + 2, pdMS_TO_TICKS(COLLECTOR_USB_TIMEOUT_MS));
+    if (written != (int)(encoded + 2)) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.usb_short++;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+static uint8_t collector_fill_ranges(void)
+{
+    report_host_record_t *records = (report_host_record_t *)&s_frame[sizeof(report_host_header_t)];
+    uint8_t count = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    while (count < COLLECTOR_FRAME_RECORDS && s_tail != s_head) {
+        records[count++] = s_ring[s_tail % COLLECTOR_RING];
+        s_tail++;
+    }
+    s_stats.records += count;
+    portEXIT_CRITICAL(&s_lock);
+
+    return count;
+}
+
+// Batches the ring into host frames, no text formatting on this path
+static void collector_usb_task(void *pvParameter)
+{
+    int64_t next_stats_us = esp_timer_get_time() + COLLECTOR_STATS_US;
+    uint8_t count;
+
+    while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(COLLECTOR_FLUSH_MS)) == 0) {
+        while ((count = collector_fill_ranges()) > 0) {
+            collector_write_frame(REPORT_HOST_RANGES, count, count * sizeof(report_host_record_t));
+        }
+
+        if (esp_timer_get_time() >= next_stats_us) {
+            next_stats_us += COLLECTOR_STATS_US;
+            portENTER_CRITICAL(&s_lock);
+            memcpy(&s_frame[sizeof(report_host_header_t)], &s_stats, sizeof(s_stats));
+            portEXIT_CRITICAL(&s_lock);
+            collector_write_frame(REPORT_HOST_STATS, 1, sizeof(s_stats));
+        }
+    }
+
+    xSemaphoreGive(s_task_stopped);
+    vTaskDelete(NULL);
+}
+
+static void collector_usb_init(void)
+{
+    if (usb_serial_jtag_is_driver_installed()) {
+        return;
+    }
+
+    usb_serial_jtag_driver_config_t config = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    config.tx_buffer_size = 4096;
+    ESP_ERROR_CHECK(usb_serial_jtag_driver_install(&config));
+
+    // The console goes through the driver as well, so log lines and frames never interleave mid-write
+    usb_serial_jtag_vfs_use_driver();
+}
+
+void COLLECTOR_init(void)
+{
+    collector_usb_init();
+
+    portENTER_CRITICAL(&s_lock);
+    s_head = s_tail = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_lock);
+    s_receiver_count = 0;
+
+    ESP_ERROR_CHECK(esp_now_init());
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(collector_recv_cb));
+
+    esp_now_peer_info_t peer = {
+        .channel = 0,
+        .ifidx = ESP_IF_WIFI_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, s_broadcast_mac, ESP_NOW_ETH_ALEN);
+    ESP_ERROR_CHECK(esp_now_add_peer(&peer));
+
+    if (s_task_stopped == NULL) {
+        s_task_stopped = xSemaphoreCreateBinary();
+    }
+    xTaskCreate(collector_usb_task, "collector_usb", COLLECTOR_TASK_STACK_SIZE, NULL, COLLECTOR_TASK_PRIORITY, &s_task);
+
+    if (s_beacon_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = collector_beacon_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "collector",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_beacon_timer));
+    }
+    esp_timer_start_periodic(s_beacon_timer, COLLECTOR_BEACON_US);
+    collector_beacon_cb(NULL);
+
+    ESP_LOGI(TAG, "Collector started, decode the USB stream with tools/collector_decode.py");
+}
+
+void COLLECTOR_deinit(void)
+{
+    if (s_beacon_timer != NULL && esp_timer_is_active(s_beacon_timer)) {
+        esp_timer_stop(s_beacon_timer);
+    }
+
+    esp_now_unregister_recv_cb();
+
+    if (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+        xSemaphoreTake(s_task_stopped, portMAX_DELAY);
+        s_task = NULL;
+    }
+
+    ESP_ERROR_CHECK(esp_now_deinit());
+    ESP_LOGI(TAG, "Collector stopped, %lu ranges from %d receivers, %lu repeated batches",
+             (unsigned long)s_stats.records, s_receiver_count, (unsigned long)s_stats.duplicates);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * @brief Start the collector role, ESP-NOW has to be up
+ *
+ * Broadcasts a beacon once per second, so receivers start forwarding their
+ * ranges. Batches repeated by the ESP-NOW retries are dropped, the ranges
+ * are streamed as COBS framed binary records over USB-Serial-JTAG, decode
+ * them with tools/collector_decode.py.
+ */
+extern void COLLECTOR_init(void);
+extern void COLLECTOR_deinit(void);
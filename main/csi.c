@@ -0,0 +1,237 @@
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_CSI
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "history.h"
+#include "csifeat.h"
+#include "trace.h"
+#include "EspNowReceiver.h"
+#include "csi.h"
+
+#define CSI_TASK_STACK_SIZE     3072
+#define CSI_TASK_PRIORITY       2
+
+// Frames waiting for the task, more are dropped in the Wi-Fi task
+#define CSI_QUEUE_LEN           (8)
+#define CSI_PEERS               (HISTORY_PEERS)
+
+// The task stops processing for the rest of a second when it used up its budget
+#define CSI_BUDGET_WINDOW_US    (1000 * 1000)
+#define CSI_BUDGET_US           (CONFIG_CUBE_CSI_BUDGET_PERMILLE * 1000)
+
+// Marks a peer without stabilized RSSI
+#define CSI_NO_RSSI             (INT32_MIN)
+
+typedef struct {
+    uint8_t peer;
+    int8_t rssi;
+    int8_t buf[CSIFEAT_LLTF_BYTES];
+} csi_frame_t;
+
+static const char *TAG = "csi";
+
+static const csifeat_config_t s_config = {
+    .motion_permille = CONFIG_CUBE_CSI_MOTION_PERMILLE,
+    .decorrelation_permille = CONFIG_CUBE_CSI_DECORRELATION_PERMILLE,
+};
+
+static QueueHandle_t s_queue = NULL;
+static volatile bool s_reset = false;
+static volatile int32_t s_rssi_q4[CSI_PEERS];
+static volatile uint32_t s_dropped = 0;    // Queue full, counted by the Wi-Fi task
+
+// Only used by the CSI task
+static csifeat_t s_features[CSI_PEERS];
+
+static void csi_clear_rssi(void)
+{
+    for (uint8_t i = 0; i < CSI_PEERS; i++) {
+        s_rssi_q4[i] = CSI_NO_RSSI;
+    }
+}
+
+// Wi-Fi task, copies the L-LTF of known senders and nothing else
+static void csi_rx_cb(void *ctx, wifi_csi_info_t *info)
+{
+    if (info == NULL || info->buf == NULL || info->len < CSIFEAT_LLTF_BYTES) {
+        return;
+    }
+
+    const uint8_t peer = RECEIVER_lookup_peer(info->mac);
+    if (peer >= CSI_PEERS) {
+        return;
+    }
+
+    csi_frame_t frame = {
+        .peer = peer,
+        .rssi = (int8_t)info->rx_ctrl.rssi,
+    };
+    memcpy(frame.buf, info->buf, sizeof(frame.buf));
+
+    if (xQueueSend(s_queue, &frame, 0) != pdTRUE) {
+        s_dropped++;
+    }
+}
+
+#if CONFIG_CUBE_CSI_DUMP
+// One line per frame for tools/csi_replay.py, outside of the budget
+static void csi_dump(const csi_frame_t *frame)
+{
+    static const char digits[] = "0123456789abcdef";
+    char hex[sizeof(frame->buf) * 2 + 1];
+
+    for (size_t i = 0; i < sizeof(frame->buf); i++) {
+        hex[i * 2] = digits[(uint8_t)frame->buf[i] >> 4];
+        hex[i * 2 + 1] = digits[(uint8_t)frame->buf[i] & 0x0F];
+    }
+    hex[sizeof(hex) - 1] = '\0';
+
+    printf("CSI:%d,%d,%s\n", frame->peer, frame->rssi, hex);
+}
+#endif
+
+static void csi_task(void *pvParameter)
+{
+    static csi_frame_t frame;
+    csifeat_result_t result;
+    bool motion[CSI_PEERS] = {0};
+    int64_t window_start_us = esp_timer_get_time();
+    int64_t report_start_us = window_start_us;
+    uint32_t window_busy_us = 0;
+    uint32_t frames = 0, skipped = 0, busy_us = 0, max_us = 0;
+    uint32_t reported_drops = 0;
+
+    while (1) {
+        if (xQueueReceive(s_queue, &frame, pdMS_TO_TICKS(CONFIG_CUBE_CSI_REPORT_S * 1000)) == pdTRUE) {
+            if (s_reset) {
+                s_reset = false;
+                for (uint8_t i = 0; i < CSI_PEERS; i++) {
+                    CSIFEAT_init(&s_features[i], &s_config);
+                    motion[i] = false;
+                }
+                csi_clear_rssi();
+            }
+
+            const int64_t start_us = esp_timer_get_time();
+            if (start_us - window_start_us >= CSI_BUDGET_WINDOW_US) {
+                window_start_us = start_us;
+                window_busy_us = 0;
+            }
+
+            if (window_busy_us >= CSI_BUDGET_US) {
+                skipped++;
+            } else {
+                CSIFEAT_process(&s_features[frame.peer], frame.buf, sizeof(frame.buf), frame.rssi, &result);
+                s_rssi_q4[frame.peer] = result.rssi_q4;
+
+                const uint32_t used_us = (uint32_t)(esp_timer_get_time() - start_us);
+                window_busy_us += used_us;
+                busy_us += used_us;
+                max_us = (used_us > max_us) ? used_us : max_us;
+                frames++;
+
+                if (result.motion != motion[frame.peer]) {
+                    motion[frame.peer] = result.motion;
+                    TRACE_record(TRACE_CSI_MOTION, frame.peer, result.motion, (uint32_t)result.motion_score);
+                }
+
+#if CONFIG_CUBE_CSI_DUMP
+                csi_dump(&frame);
+#endif
+            }
+        }
+
+        const int64_t now_us = esp_timer_get_time();
+        const int64_t period_us = now_us - report_start_us;
+        if (period_us >= CONFIG_CUBE_CSI_REPORT_S * 1000000LL) {
+            const uint32_t dropped = s_dropped;
+            ESP_LOGI(TAG, "%lu frames, %lu over budget, %lu queue full, %lu us mean %lu us max, CPU %lu permille",
+                     (unsigned long)frames, (unsigned long)skipped, (unsigned long)(dropped - reported_drops),
+                     (unsigned long)(frames ? busy_us / frames : 0), (unsigned long)max_us,
+                     (unsigned long)((uint64_t)busy_us * 1000 / period_us));
+            reported_drops = dropped;
+            frames = skipped = busy_us = max_us = 0;
+            report_start_us = now_us;
+        }
+    }
+}
+
+void CSI_init(void)
+{
+    csi_clear_rssi();
+
+    s_queue = xQueueCreate(CSI_QUEUE_LEN, sizeof(csi_frame_t));
+    if (s_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create CSI queue");
+        return;
+    }
+
+    xTaskCreate(csi_task, "csi_task", CSI_TASK_STACK_SIZE, NULL, CSI_TASK_PRIORITY, NULL);
+}
+
+void CSI_start(void)
+{
+    // Only the L-LTF, it is present in every frame including the 11b rates
+    const wifi_csi_config_t config = {
+        .lltf_en = true,
+        .htltf_en = false,
+        .stbc_htltf2_en = false,
+        .ltf_merge_en = false,
+        .channel_filter_en = false,
+        .manu_scale = false,
+        .shift = 0,
+    };
+
+    if (s_queue == NULL) {
+        return;
+    }
+
+    // The peer slots are handed out again, the task forgets the old features before the next frame
+    s_reset = true;
+    xQueueReset(s_queue);
+    csi_clear_rssi();
+
+    ESP_ERROR_CHECK(esp_wifi_set_csi_config(&config));
+    ESP_ERROR_CHECK(esp_wifi_set_csi_rx_cb(csi_rx_cb, NULL));
+    ESP_ERROR_CHECK(esp_wifi_set_csi(true));
+
+    ESP_LOGI(TAG, "CSI capture started, budget %d permille", CONFIG_CUBE_CSI_BUDGET_PERMILLE);
+}
+
+void CSI_stop(void)
+{
+    if (s_queue == NULL) {
+        return;
+    }
+
+    esp_wifi_set_csi(false);
+    csi_clear_rssi();
+}
+
+int16_t CSI_get_rssi(uint8_t peer, int16_t rssi)
+{
+    if (peer >= CSI_PEERS) {
+        return rssi;
+    }
+
+    const int32_t rssi_q4 = s_rssi_q4[peer];
+    if (rssi_q4 == CSI_NO_RSSI) {
+        return rssi;
+    }
+
+    // Round to the nearest dBm, the ranging table has one entry per dBm
+    return (int16_t)((rssi_q4 + ((rssi_q4 < 0) ? -8 : 8)) / 16);
+}
+
+#endif /* CONFIG_CUBE_CSI */
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_CSI
+
+/**
+ * @brief Create the CSI processing task, the CSI itself stays off until CSI_start()
+ */
+extern void CSI_init(void);
+
+/**
+ * @brief Capture the CSI of the ESP-NOW frames of known senders
+ *
+ * The Wi-Fi task only copies the L-LTF into a queue. A low priority task runs
+ * the motion features of csifeat.c and drops frames when it falls behind, so
+ * the CPU time stays bounded at any frame rate. Call after RECEIVER_init().
+ */
+extern void CSI_start(void);
+
+// Stop the capture and forget the per-peer state, called before the receiver is torn down
+extern void CSI_stop(void);
+
+/**
+ * @brief RSSI of a peer smoothed according to its motion state
+ *
+ * Safe from the Wi-Fi task.
+ *
+ * @param peer Peer slot
+ * @param rssi RSSI of the current frame, returned while the peer has no CSI yet
+ * @return Stabilized RSSI in dBm
+ */
+extern int16_t CSI_get_rssi(uint8_t peer, int16_t rssi);
+
+#else
+
+static inline void CSI_init(void) {}
+static inline void CSI_start(void) {}
+static inline void CSI_stop(void) {}
+static inline int16_t CSI_get_rssi(uint8_t peer, int16_t rssi) { (void)peer; return rssi; }
+
+#endif
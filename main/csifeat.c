@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "csifeat.h"
+
+// RSSI filter: 1/2 weight per frame during motion, 1/16 while static
+#define CSIFEAT_RSSI_SHIFT_MOTION   (1)
+#define CSIFEAT_RSSI_SHIFT_STATIC   (4)
+
+void CSIFEAT_init(csifeat_t *f, const csifeat_config_t *config)
+{
+    memset(f, 0, sizeof(*f));
+    f->config = config;
+}
+
+// Byte offset of a used subcarrier in the L-LTF
+static inline uint16_t csifeat_offset(uint8_t i)
+{
+    // 25 subcarriers 2..26, then 26 subcarriers -26..-1 stored at 38..63
+    return (i < 25) ? (uint16_t)(2 + i) * 2 : (uint16_t)(38 + i - 25) * 2;
+}
+
+// |I + jQ| in Q4 without a square root, alpha max plus beta min with 1 and 3/8
+static inline uint16_t csifeat_amplitude(int8_t i, int8_t q)
+{
+    const uint16_t a = (uint16_t)((i < 0) ? -i : i);
+    const uint16_t b = (uint16_t)((q < 0) ? -q : q);
+
+    return (a > b) ? (uint16_t)(a * 16 + b * 6) : (uint16_t)(b * 16 + a * 6);
+}
+
+static uint32_t csifeat_isqrt(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+// Pearson correlation of two amplitude vectors in 1/1000, Q4 >> 2 keeps the products in 64 bits
+static int32_t csifeat_correlation(const uint16_t *a, const uint16_t *b)
+{
+    int64_t sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+
+    for (uint8_t k = 0; k < CSIFEAT_SUBCARRIERS; k++) {
+        const int64_t x = a[k] >> 2;
+        const int64_t y = b[k] >> 2;
+        sa += x;
+        sb += y;
+        saa += x * x;
+        sbb += y * y;
+        sab += x * y;
+    }
+
+    const int64_t n = CSIFEAT_SUBCARRIERS;
+    const int64_t cov = n * sab - sa * sb;
+    const int64_t var_a = n * saa - sa * sa;
+    const int64_t var_b = n * sbb - sb * sb;
+
+    if (var_a <= 0 || var_b <= 0) {
+        return 1000;
+    }
+
+    const uint32_t norm = csifeat_isqrt((uint64_t)var_a * (uint64_t)var_b);
+    return (norm == 0) ? 1000 : (int32_t)(cov * 1000 / (int64_t)norm);
+}
+
+bool CSIFEAT_process(csifeat_t *f, const int8_t *buf, uint16_t len, int8_t rssi, csifeat_result_t *result)
+{
+    uint16_t amp[CSIFEAT_SUBCARRIERS];
+    int64_t sum_var = 0;
+    int64_t sum_power = 0;
+
+    if (len < CSIFEAT_LLTF_BYTES) {
+        return false;
+    }
+
+    for (uint8_t k = 0; k < CSIFEAT_SUBCARRIERS; k++) {
+        const uint16_t o = csifeat_offset(k);
+        amp[k] = csifeat_amplitude(buf[o], buf[o + 1]);
+    }
+
+    if (f->frames == 0) {
+        // Start the moving statistics at the first frame instead of at 0
+        for (uint8_t k = 0; k < CSIFEAT_SUBCARRIERS; k++) {
+            f->mean[k] = (int32_t)amp[k] << 8;
+            f->var[k] = 0;
+        }
+        f->rssi_q4 = (int32_t)rssi * 16;
+        result->correlation = 1000;
+    } else {
+        result->correlation = csifeat_correlation(amp, f->prev);
+    }
+
+    for (uint8_t k = 0; k < CSIFEAT_SUBCARRIERS; k++) {
+        const int32_t x = amp[k];
+        f->mean[k] += ((x << 8) - f->mean[k]) >> CSIFEAT_SHIFT;
+
+        const int32_t d = x - (f->mean[k] >> 8);
+        f->var[k] += (d * d - f->var[k]) >> CSIFEAT_SHIFT;
+
+        const int32_t m = f->mean[k] >> 8;
+        sum_var += f->var[k];
+        sum_power += (int64_t)m * m;
+    }
+    memcpy(f->prev, amp, sizeof(f->prev));
+
+    // The variance relative to the power does not depend on the distance or the gain
+    const bool warm = (f->frames >= (1u << CSIFEAT_SHIFT));
+    result->motion_score = (warm && sum_power > 0) ? (int32_t)(sum_var * 1000 / sum_power) : 0;
+
+    const int32_t decorrelation = 1000 - result->correlation;
+    const int32_t motion_threshold = f->config->motion_permille;
+    const int32_t decorrelation_threshold = f->config->decorrelation_permille;
+
+    if (!f->motion) {
+        f->motion = warm && (result->motion_score > motion_threshold || decorrelation > decorrelation_threshold);
+    } else {
+        f->motion = (result->motion_score > motion_threshold / 2 || decorrelation > decorrelation_threshold / 2);
+    }
+
+    const uint8_t shift = f->motion ? CSIFEAT_RSSI_SHIFT_MOTION : CSIFEAT_RSSI_SHIFT_STATIC;
+    f->rssi_q4 += ((int32_t)rssi * 16 - f->rssi_q4) >> shift;
+
+    f->frames++;
+    result->rssi_q4 = f->rssi_q4;
+    result->motion = f->motion;
+
+    return true;
+}
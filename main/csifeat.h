@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, csi.c feeds it the raw CSI of one peer.
+// Integer only, one frame costs a pass over the subcarriers and one square root.
+
+// L-LTF of a 20 MHz HT frame: 64 I/Q pairs, subcarriers 0..31 then -32..-1
+#define CSIFEAT_LLTF_BYTES      (128)
+
+// Subcarriers 2..26 and -26..-1, skips DC, the guard band and the pair that
+// the first_word_invalid flag of the driver can corrupt
+#define CSIFEAT_SUBCARRIERS     (51)
+
+// Frames per time constant of the moving mean and variance is 2^CSIFEAT_SHIFT
+#define CSIFEAT_SHIFT           (4)
+
+typedef struct {
+    uint16_t motion_permille;       // Relative amplitude variance that counts as motion
+    uint16_t decorrelation_permille; // 1000 - correlation with the previous frame that counts as motion
+} csifeat_config_t;
+
+typedef struct {
+    const csifeat_config_t *config;
+    uint32_t frames;
+    int32_t mean[CSIFEAT_SUBCARRIERS];      // Amplitude in Q4 << 8
+    int32_t var[CSIFEAT_SUBCARRIERS];       // Amplitude variance in Q4^2
+    uint16_t prev[CSIFEAT_SUBCARRIERS];     // Amplitude of the previous frame in Q4
+    int32_t rssi_q4;                        // Stabilized RSSI in dBm * 16
+    bool motion;
+} csifeat_t;
+
+typedef struct {
+    int32_t motion_score;       // Relative amplitude variance in 1/1000, 0 during the warm-up
+    int32_t correlation;        // With the previous frame in 1/1000, 1000 for the first frame
+    int32_t rssi_q4;            // Stabilized RSSI in dBm * 16
+    bool motion;
+} csifeat_result_t;
+
+/**
+ * @brief Forget all history, the next frame starts a new warm-up
+ *
+ * @param f Feature state, owned by the caller
+ * @param config Thresholds, must stay valid
+ */
+extern void CSIFEAT_init(csifeat_t *f, const csifeat_config_t *config);
+
+/**
+ * @brief Process the CSI of one frame
+ *
+ * Motion is reported when the relative amplitude variance over the last
+ * frames or the decorrelation with the previous frame exceeds its threshold,
+ * and ends below half of it. The RSSI is smoothed slowly while nothing moves
+ * and follows quickly during motion.
+ *
+ * @param f Feature state
+ * @param buf Raw CSI as int8 I/Q pairs, starting with the L-LTF
+ * @param len Bytes in buf, shorter buffers are ignored
+ * @param rssi RSSI of the frame in dBm
+ * @param result Features of this frame
+ * @return false if the buffer was too short
+ */
+extern bool CSIFEAT_process(csifeat_t *f, const int8_t *buf, uint16_t len, int8_t rssi, csifeat_result_t *result);
@@ -0,0 +1,236 @@
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_DIAG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "lvgl.h"
+
+#include "bsp/esp-bsp.h"
+#include "UiUpdate.h"
+#include "diag.h"
+
+#define DIAG_TASK_STACK_SIZE    3072
+#define DIAG_TASK_PRIORITY      1
+
+// Slots beyond the current task count, tasks created during a scan must still fit
+#define DIAG_SCAN_HEADROOM      (4)
+
+// Collections until the heap is considered steady, the soak check compares against that point
+#define DIAG_WARMUP_PERIODS     (6)
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t runtime;
+} diag_runtime_t;
+
+static const char *TAG = "diag";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static diag_snapshot_t s_snapshot;
+
+// Only used by the diagnostics task
+static TaskStatus_t *s_status = NULL;
+static diag_runtime_t *s_prev = NULL;
+static UBaseType_t s_capacity = 0;
+static UBaseType_t s_prev_count = 0;
+static uint32_t s_prev_total = 0;
+static uint32_t s_periods = 0;
+static uint32_t s_steady_heap_min = 0;
+
+// Run time of the task in the previous collection, 0 for a new task
+static uint32_t diag_get_prev_runtime(TaskHandle_t handle)
+{
+    for (UBaseType_t i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].handle == handle) {
+            return s_prev[i].runtime;
+        }
+    }
+
+    return 0;
+}
+
+static void diag_insert_task(diag_snapshot_t *snap, const diag_task_t *task)
+{
+    uint8_t pos = snap->task_count;
+
+    // Insertion sort, highest CPU share first
+    while (pos > 0 && snap->tasks[pos - 1].cpu_permille < task->cpu_permille) {
+        if (pos < DIAG_MAX_TASKS) {
+            snap->tasks[pos] = snap->tasks[pos - 1];
+        }
+        pos--;
+    }
+
+    if (pos < DIAG_MAX_TASKS) {
+        snap->tasks[pos] = *task;
+        if (snap->task_count < DIAG_MAX_TASKS) {
+            snap->task_count++;
+        }
+    }
+}
+
+// uxTaskGetSystemState() fills nothing unless every task fits, the buffers grow with the task count
+static bool diag_reserve(UBaseType_t tasks)
+{
+    if (tasks <= s_capacity) {
+        return true;
+    }
+
+    const UBaseType_t capacity = tasks + DIAG_SCAN_HEADROOM;
+    TaskStatus_t *status = realloc(s_status, capacity * sizeof(*status));
+    if (status == NULL) {
+        return false;
+    }
+    s_status = status;
+
+    diag_runtime_t *prev = realloc(s_prev, capacity * sizeof(*prev));
+    if (prev == NULL) {
+        return false;
+    }
+    s_prev = prev;
+    s_capacity = capacity;
+
+    return true;
+}
+
+static void diag_collect_tasks(diag_snapshot_t *snap)
+{
+    uint32_t total = 0;
+
+    snap->task_total = (uint8_t)uxTaskGetNumberOfTasks();
+    if (!diag_reserve(snap->task_total)) {
+        ESP_LOGE(TAG, "No memory to scan %d tasks", snap->task_total);
+        return;
+    }
+
+    const UBaseType_t count = uxTaskGetSystemState(s_status, s_capacity, &total);
+    if (count == 0) {
+        ESP_LOGW(TAG, "Task scan failed, %d tasks for %d slots", (int)uxTaskGetNumberOfTasks(), (int)s_capacity);
+        return;
+    }
+    const uint32_t elapsed = total - s_prev_total;
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *s = &s_status[i];
+        const uint32_t used = s->ulRunTimeCounter - diag_get_prev_runtime(s->xHandle);
+        diag_task_t task = {
+            .priority = (uint8_t)s->uxCurrentPriority,
+            .stack_free = (uint16_t)s->usStackHighWaterMark,
+            .cpu_permille = (elapsed > 0) ? (uint16_t)((uint64_t)used * 1000u / elapsed) : 0,
+        };
+        snprintf(task.name, sizeof(task.name), "%s", s->pcTaskName);
+        diag_insert_task(snap, &task);
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        s_prev[i].handle = s_status[i].xHandle;
+        s_prev[i].runtime = s_status[i].ulRunTimeCounter;
+    }
+    s_prev_count = count;
+    s_prev_total = total;
+}
+
+static void diag_collect(diag_snapshot_t *snap)
+{
+    lv_mem_monitor_t mon;
+
+    memset(snap, 0, sizeof(*snap));
+    snap->period_ms = CONFIG_CUBE_DIAG_PERIOD_S * 1000;
+
+    snap->heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    snap->heap_min = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    snap->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    snap->dma_free = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    snap->dma_min = heap_caps_get_minimum_free_size(MALLOC_CAP_DMA);
+    snap->dma_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+
+    // The LVGL heap belongs to the display task
+    bsp_display_lock(0);
+    lv_mem_monitor(&mon);
+    bsp_display_unlock();
+
+    snap->lv_total = mon.total_size;
+    snap->lv_free = mon.free_size;
+    snap->lv_max_used = mon.max_used;
+    snap->lv_frag_pct = mon.frag_pct;
+
+    diag_collect_tasks(snap);
+}
+
+// Soak check: after the warm-up the lowest free heap must not keep going down
+static void diag_check_soak(diag_snapshot_t *snap)
+{
+    if (++s_periods < DIAG_WARMUP_PERIODS) {
+        return;
+    }
+
+    if (s_periods == DIAG_WARMUP_PERIODS) {
+        s_steady_heap_min = snap->heap_min;
+        ESP_LOGI(TAG, "Heap steady state: minimum free %lu", (unsigned long)s_steady_heap_min);
+        return;
+    }
+
+    snap->heap_min_drift = (int32_t)snap->heap_min - (int32_t)s_steady_heap_min;
+    if (snap->heap_min_drift < 0) {
+        ESP_LOGW(TAG, "Heap minimum %ld bytes below the steady state", (long)snap->heap_min_drift);
+    }
+}
+
+static void diag_log(const diag_snapshot_t *snap)
+{
+    ESP_LOGI(TAG, "Heap internal free %lu min %lu largest %lu, DMA free %lu min %lu largest %lu",
+             (unsigned long)snap->heap_free, (unsigned long)snap->heap_min, (unsigned long)snap->heap_largest,
+             (unsigned long)snap->dma_free, (unsigned long)snap->dma_min, (unsigned long)snap->dma_largest);
+    ESP_LOGI(TAG, "LVGL heap %lu of %lu used, max %lu, frag %d%%",
+             (unsigned long)(snap->lv_total - snap->lv_free), (unsigned long)snap->lv_total,
+             (unsigned long)snap->lv_max_used, snap->lv_frag_pct);
+    ESP_LOGI(TAG, "%-16s %4s %10s %6s  (%d of %d tasks)", "Task", "Prio", "Stack free", "CPU",
+             snap->task_count, snap->task_total);
+
+    for (uint8_t i = 0; i < snap->task_count; i++) {
+        const diag_task_t *t = &snap->tasks[i];
+        ESP_LOGI(TAG, "%-16s %4d %10d %3d.%d%%", t->name, t->priority, t->stack_free,
+                 t->cpu_permille / 10, t->cpu_permille % 10);
+    }
+}
+
+static void diag_task(void *pvParameter)
+{
+    static diag_snapshot_t snap;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_CUBE_DIAG_PERIOD_S * 1000));
+
+        diag_collect(&snap);
+        diag_check_soak(&snap);
+        diag_log(&snap);
+
+        portENTER_CRITICAL(&s_lock);
+        s_snapshot = snap;
+        portEXIT_CRITICAL(&s_lock);
+
+        UIUPDATE_post(UI_UPDATE_DIAG, HISTORY_NO_PEER, 0, 0.0f);
+    }
+}
+
+void DIAG_init(void)
+{
+    xTaskCreate(diag_task, "diag_task", DIAG_TASK_STACK_SIZE, NULL, DIAG_TASK_PRIORITY, NULL);
+}
+
+void DIAG_get_snapshot(diag_snapshot_t *snapshot)
+{
+    portENTER_CRITICAL(&s_lock);
+    *snapshot = s_snapshot;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#endif /* CONFIG_CUBE_DIAG */
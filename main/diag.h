@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+// Tasks kept in a snapshot, the ones with the highest CPU share
+#define DIAG_MAX_TASKS          (8)
+#define DIAG_TASK_NAME_LEN      (16)
+
+typedef struct {
+    char name[DIAG_TASK_NAME_LEN];
+    uint8_t priority;
+    uint16_t stack_free;        // Stack high-water mark in bytes, the least that was ever left
+    uint16_t cpu_permille;      // Share of the last period
+} diag_task_t;
+
+// Plain values, the UI formats them without FreeRTOS or heap headers
+typedef struct {
+    uint32_t period_ms;         // 0 until the first collection
+    uint32_t heap_free;         // Internal RAM
+    uint32_t heap_min;          // Lowest free internal RAM since boot
+    uint32_t heap_largest;      // Largest free internal block
+    int32_t heap_min_drift;     // Change of heap_min since the warm-up, stays 0 without leaks or growth
+    uint32_t dma_free;
+    uint32_t dma_min;
+    uint32_t dma_largest;
+    uint32_t lv_total;          // LVGL heap (CONFIG_LV_MEM_SIZE_KILOBYTES)
+    uint32_t lv_free;
+    uint32_t lv_max_used;
+    uint8_t lv_frag_pct;
+    uint8_t task_count;         // Entries in tasks
+    uint8_t task_total;         // Tasks in the system
+    diag_task_t tasks[DIAG_MAX_TASKS];  // Sorted by CPU share
+} diag_snapshot_t;
+
+#if CONFIG_CUBE_DIAG
+
+/**
+ * @brief Start the diagnostics task
+ *
+ * Every CONFIG_CUBE_DIAG_PERIOD_S seconds it collects stack high-water marks,
+ * internal and DMA heap, the LVGL heap and the CPU share per task, logs them
+ * and posts a UI_UPDATE_DIAG message.
+ */
+extern void DIAG_init(void);
+
+// Copy of the last collection
+extern void DIAG_get_snapshot(diag_snapshot_t *snapshot);
+
+#else
+
+static inline void DIAG_init(void) {}
+static inline void DIAG_get_snapshot(diag_snapshot_t *snapshot) { memset(snapshot, 0, sizeof(*snapshot)); }
+
+#endif
@@ -0,0 +1,77 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "dutycycle.h"
+
+void DUTYCYCLE_init(dutycycle_t *dc, const dutycycle_config_t *config)
+{
+    memset(dc, 0, sizeof(*dc));
+    dc->config = config;
+}
+
+void DUTYCYCLE_frame(dutycycle_t *dc, int64_t now_us)
+{
+    if (!dc->synced) {
+        dc->synced = true;
+        dc->resyncs++;
+    }
+
+    // Anchoring on every frame follows the sender's clock drift
+    dc->missed = 0;
+    dc->expected_us = now_us + dc->config->period_us;
+}
+
+void DUTYCYCLE_window_missed(dutycycle_t *dc)
+{
+    if (!dc->synced) {
+        return;
+    }
+
+    dc->missed++;
+    dc->expected_us += dc->config->period_us;
+
+    if (dc->missed > dc->config->max_missed) {
+        dc->synced = false;
+        dc->missed = 0;
+    }
+}
+
+bool DUTYCYCLE_get_window(const dutycycle_t *dc, int64_t *open_us, int64_t *close_us)
+{
+    if (!dc->synced) {
+        return false;
+    }
+
+    const dutycycle_config_t *c = dc->config;
+    int64_t half_us = c->window_us / 2 + (int64_t)c->guard_us * (dc->missed + 1);
+
+    // Wider than the period means listening all the time anyway
+    if (2 * half_us >= c->period_us) {
+        half_us = c->period_us / 2;
+    }
+
+    *open_us = dc->expected_us - half_us;
+    *close_us = dc->expected_us + half_us;
+    return true;
+}
+
+int64_t DUTYCYCLE_next_slot(const dutycycle_config_t *config, int64_t anchor_us, int64_t now_us)
+{
+    if (now_us < anchor_us) {
+        return anchor_us;
+    }
+
+    const int64_t slots = (now_us - anchor_us) / config->period_us + 1;
+    return anchor_us + slots * config->period_us;
+}
+
+uint32_t DUTYCYCLE_get_duty_permille(const dutycycle_config_t *config)
+{
+    const uint64_t on_us = (uint64_t)config->window_us + 2u * config->guard_us;
+
+    if (config->period_us == 0 || on_us >= config->period_us) {
+        return 1000;
+    }
+
+    return (uint32_t)(on_us * 1000u / config->period_us);
+}
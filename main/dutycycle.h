@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, power.c feeds it frame times and window ends
+
+// Agreed schedule between a sender and a receiver, all times in microseconds
+typedef struct {
+    uint32_t period_us;         // Sender sends once per period
+    uint32_t window_us;         // Radio on time around an expected frame
+    uint32_t guard_us;          // Added on both sides, once more per missed window for clock drift
+    uint8_t max_missed;         // Missed windows before the receiver listens continuously again
+} dutycycle_config_t;
+
+typedef struct {
+    const dutycycle_config_t *config;
+    bool synced;                // Phase known, the receiver only listens in windows
+    uint8_t missed;             // Windows missed in a row
+    int64_t expected_us;        // Time of the next expected frame
+    uint32_t resyncs;           // Times the phase was found again after it was lost
+} dutycycle_t;
+
+/**
+ * @brief Start unsynced, the receiver listens until the first frame arrives
+ *
+ * @param dc Schedule state, owned by the caller
+ * @param config Must stay valid
+ */
+extern void DUTYCYCLE_init(dutycycle_t *dc, const dutycycle_config_t *config);
+
+// A frame of the tracked sender arrived at now_us, anchors the next window on it
+extern void DUTYCYCLE_frame(dutycycle_t *dc, int64_t now_us);
+
+// The window closed without a frame, moves on by one period and drops the sync after max_missed
+extern void DUTYCYCLE_window_missed(dutycycle_t *dc);
+
+/**
+ * @brief Next listen window, widened by the guard for every missed window
+ *
+ * @param dc Schedule state
+ * @param open_us Radio on
+ * @param close_us Radio off if no frame arrived
+ * @return false if not synced, the radio has to stay on
+ */
+extern bool DUTYCYCLE_get_window(const dutycycle_t *dc, int64_t *open_us, int64_t *close_us);
+
+// First send slot after now_us on the grid anchor_us + k * period_us, late calls skip slots instead of bursting
+extern int64_t DUTYCYCLE_next_slot(const dutycycle_config_t *config, int64_t anchor_us, int64_t now_us);
+
+// Receiver radio on time per period while synced, in 1/1000
+extern uint32_t DUTYCYCLE_get_duty_permille(const dutycycle_config_t *config);
@@ -0,0 +1,371 @@
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_FINGERPRINT
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+
+#include "trace.h"
+#include "fpindex.h"
+#include "fingerprint.h"
+
+#define FINGERPRINT_TASK_STACK_SIZE     3072
+#define FINGERPRINT_TASK_PRIORITY       2
+
+// Data partition of partitions.csv
+#define FINGERPRINT_PARTITION_NAME      "fingerprint"
+#define FINGERPRINT_PARTITION_SUBTYPE   ((esp_partition_subtype_t)0x40)
+
+// An anchor missing for three periods counts as not heard
+#define FINGERPRINT_STALE_US            (3LL * CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000)
+
+// RSSI per anchor in 1/16 dB, a new frame weighs 1/4
+#define FINGERPRINT_SMOOTH_SHIFT        (2)
+
+#if CONFIG_CUBE_FINGERPRINT_RECORD
+#define FINGERPRINT_SAMPLES             (CONFIG_CUBE_FINGERPRINT_SAMPLES)
+#else
+#define FINGERPRINT_SAMPLES             (0)
+#endif
+
+static const char *TAG = "fingerprint";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Anchors and their RSSI, written by the Wi-Fi task under s_lock
+static uint32_t s_anchor[FPINDEX_MAX_ANCHORS];     // TRACE_mac_tail() of the sender
+static uint8_t s_anchor_count = 0;
+static bool s_anchors_fixed = false;               // Taken from the index header, no more are learned
+static int32_t s_rssi_q4[FPINDEX_MAX_ANCHORS];
+static int64_t s_seen_us[FPINDEX_MAX_ANCHORS];
+static uint8_t s_heard = 0;                        // Bit per anchor heard since the last recorded fingerprint
+static bool s_running = false;
+static fingerprint_status_t s_status;
+
+static volatile bool s_record_request = false;
+static TaskHandle_t s_task = NULL;
+
+// Only used by the fingerprint task, and by FINGERPRINT_init() before it starts
+static const esp_partition_t *s_partition = NULL;
+static const void *s_map = NULL;
+static esp_partition_mmap_handle_t s_map_handle;
+static fpindex_t s_index;
+static bool s_index_valid = false;
+static uint8_t s_next_spot = 0;
+
+// Opens the index in the mapping and fixes the anchors to the order of its header
+static void fingerprint_open(void)
+{
+    s_index_valid = FPINDEX_open(&s_index, s_map, s_partition->size);
+    if (!s_index_valid) {
+        ESP_LOGI(TAG, "No fingerprint index, record spots to create one");
+        return;
+    }
+
+    // Spots are recorded in ascending order, the next one follows the highest
+    s_next_spot = 0;
+    for (uint32_t n = 0; n < s_index.count; n++) {
+        const uint8_t spot = s_index.entries[(size_t)n * s_index.entry_size];
+        if (spot >= s_next_spot) {
+            s_next_spot = spot + 1;
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_anchor_count = s_index.header->anchors;
+    memcpy(s_anchor, s_index.header->anchor, sizeof(s_anchor));
+    s_anchors_fixed = true;
+    s_status.entries = s_index.count;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Index with %d anchors, %lu of %lu fingerprints, %d spots", s_index.header->anchors,
+             (unsigned long)s_index.count, (unsigned long)s_index.capacity, s_next_spot);
+}
+
+// Quantized RSSI of every anchor, returns true when all of them were heard since the last recorded fingerprint
+static bool fingerprint_get_vector(uint8_t *q, int64_t now_us)
+{
+    bool complete;
+
+    portENTER_CRITICAL(&s_lock);
+    for (uint8_t a = 0; a < FPINDEX_MAX_ANCHORS; a++) {
+        const bool fresh = (a < s_anchor_count) && (s_seen_us[a] != 0) && (now_us - s_seen_us[a] <= FINGERPRINT_STALE_US);
+        q[a] = fresh ? FPINDEX_quantize((s_rssi_q4[a] + 8) >> 4) : 0;
+    }
+    complete = (s_anchor_count > 0) && (s_heard == (uint8_t)((1u << s_anchor_count) - 1));
+    portEXIT_CRITICAL(&s_lock);
+
+    return complete;
+}
+
+// Writes the header with the anchors learned so far, the partition has to be erased
+static bool fingerprint_create_index(void)
+{
+    fpindex_header_t header;
+    const uint8_t *raw = (const uint8_t *)s_map;
+
+    for (size_t i = 0; i < sizeof(header); i++) {
+        if (raw[i] != 0xFF) {
+            ESP_LOGE(TAG, "Partition holds no index and is not erased, see tools/fingerprint.py");
+            return false;
+        }
+    }
+
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = FPINDEX_MAGIC;
+    header.version = FPINDEX_VERSION;
+
+    portENTER_CRITICAL(&s_lock);
+    header.anchors = s_anchor_count;
+    memcpy(header.anchor, s_anchor, sizeof(header.anchor));
+    s_anchors_fixed = (s_anchor_count > 0);
+    portEXIT_CRITICAL(&s_lock);
+
+    if (header.anchors == 0) {
+        ESP_LOGW(TAG, "No anchor heard yet");
+        return false;
+    }
+
+    esp_err_t err = esp_partition_write(s_partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Header write failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    fingerprint_open();
+    return s_index_valid;
+}
+
+static void fingerprint_begin_spot(void)
+{
+    if (FINGERPRINT_SAMPLES == 0 || s_partition == NULL || s_status.recording) {
+        return;
+    }
+    if (!s_index_valid && !fingerprint_create_index()) {
+        return;
+    }
+    if (s_next_spot >= FPINDEX_MAX_SPOTS) {
+        ESP_LOGE(TAG, "All %d spots recorded", FPINDEX_MAX_SPOTS);
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_heard = 0;
+    s_status.recording = true;
+    s_status.record_spot = s_next_spot;
+    s_status.recorded = 0;
+    s_status.record_target = FINGERPRINT_SAMPLES;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Recording spot %d", s_next_spot);
+}
+
+// Appends one fingerprint to the partition, the mapping shows it once the write returns
+static void fingerprint_record(const uint8_t *q)
+{
+    uint8_t entry[1 + FPINDEX_MAX_ANCHORS];
+    const uint8_t spot = s_status.record_spot;
+    uint8_t written = 0;
+    bool done;
+
+    if (s_index.count >= s_index.capacity) {
+        ESP_LOGE(TAG, "Partition full after %lu fingerprints", (unsigned long)s_index.count);
+        done = true;
+    } else {
+        entry[0] = spot;
+        memcpy(&entry[1], q, s_index.entry_size - 1);
+
+        esp_err_t err = esp_partition_write(s_partition, FPINDEX_entry_offset(&s_index, s_index.count),
+                                            entry, s_index.entry_size);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Fingerprint write failed: %s", esp_err_to_name(err));
+            done = true;
+        } else {
+            s_index.count++;
+            s_next_spot = spot + 1;
+            written = 1;
+            done = (s_status.recorded + 1 >= s_status.record_target);
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_heard = 0;
+    s_status.entries = s_index.count;
+    s_status.recorded += written;
+    s_status.recording = !done;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (done) {
+        ESP_LOGI(TAG, "Spot %d recorded, %lu fingerprints", spot, (unsigned long)s_index.count);
+    }
+}
+
+static void fingerprint_locate(const uint8_t *q)
+{
+    fpindex_result_t result;
+
+    const int64_t start_us = esp_timer_get_time();
+    if (!FPINDEX_query(&s_index, q, CONFIG_CUBE_FINGERPRINT_K, &result)) {
+        return;
+    }
+    const uint32_t query_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    const fpindex_spot_t *label = &s_index.spots[result.spot < FPINDEX_MAX_SPOTS ? result.spot : 0];
+    const bool labelled = result.spot < FPINDEX_MAX_SPOTS && (uint8_t)label->name[0] != 0xFF;
+
+    portENTER_CRITICAL(&s_lock);
+    const bool moved = !s_status.located || s_status.spot != result.spot;
+    s_status.located = true;
+    s_status.spot = result.spot;
+    s_status.votes = result.votes;
+    s_status.k = result.k;
+    s_status.has_position = result.has_position;
+    s_status.x_dm = result.x_dm;
+    s_status.y_dm = result.y_dm;
+    s_status.query_us = query_us;
+    if (query_us > s_status.query_max_us) {
+        s_status.query_max_us = query_us;
+    }
+    memset(s_status.name, 0, sizeof(s_status.name));
+    if (labelled) {
+        memcpy(s_status.name, label->name, FPINDEX_SPOT_NAME_LEN);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (moved) {
+        ESP_LOGI(TAG, "At spot %d %.*s, %d of %d votes, %lu us for %lu fingerprints (%lu compared)",
+                 result.spot, labelled ? FPINDEX_SPOT_NAME_LEN : 0, label->name, result.votes, result.k,
+                 (unsigned long)query_us, (unsigned long)s_index.count, (unsigned long)result.scanned);
+    }
+}
+
+// Woken per anchor frame, a query takes far less than the ESP-NOW period
+static void fingerprint_task(void *pvParameter)
+{
+    uint8_t q[FPINDEX_MAX_ANCHORS];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (s_record_request) {
+            s_record_request = false;
+            fingerprint_begin_spot();
+        }
+
+        const bool complete = fingerprint_get_vector(q, esp_timer_get_time());
+        if (!s_index_valid) {
+            continue;
+        }
+
+        if (s_status.recording) {
+            // One fingerprint per round in which every anchor was heard
+            if (complete) {
+                fingerprint_record(q);
+            }
+        } else {
+            fingerprint_locate(q);
+        }
+    }
+}
+
+void FINGERPRINT_init(void)
+{
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, FINGERPRINT_PARTITION_SUBTYPE,
+                                           FINGERPRINT_PARTITION_NAME);
+    if (s_partition == NULL) {
+        ESP_LOGE(TAG, "No \"%s\" partition, check partitions.csv", FINGERPRINT_PARTITION_NAME);
+        return;
+    }
+
+    esp_err_t err = esp_partition_mmap(s_partition, 0, s_partition->size, ESP_PARTITION_MMAP_DATA,
+                                       &s_map, &s_map_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Partition mapping failed: %s", esp_err_to_name(err));
+        s_partition = NULL;
+        return;
+    }
+
+    fingerprint_open();
+
+    xTaskCreate(fingerprint_task, "fingerprint_task", FINGERPRINT_TASK_STACK_SIZE, NULL,
+                FINGERPRINT_TASK_PRIORITY, &s_task);
+}
+
+void FINGERPRINT_start(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(s_seen_us, 0, sizeof(s_seen_us));
+    s_heard = 0;
+    s_status.located = false;
+    s_status.query_max_us = 0;
+    s_running = (s_task != NULL);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void FINGERPRINT_stop(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_running = false;
+    s_status.located = false;
+    s_status.recording = false;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void FINGERPRINT_frame(const uint8_t *mac, int8_t rssi, int64_t rx_us)
+{
+    const uint32_t tail = TRACE_mac_tail(mac);
+    bool wake = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_running) {
+        uint8_t a = 0;
+        while (a < s_anchor_count && s_anchor[a] != tail) {
+            a++;
+        }
+        if (a == s_anchor_count && !s_anchors_fixed && a < FPINDEX_MAX_ANCHORS) {
+            s_anchor[s_anchor_count++] = tail;
+        }
+
+        if (a < s_anchor_count) {
+            if (s_seen_us[a] == 0 || rx_us - s_seen_us[a] > FINGERPRINT_STALE_US) {
+                s_rssi_q4[a] = (int32_t)rssi * 16;
+            } else {
+                s_rssi_q4[a] += ((int32_t)rssi * 16 - s_rssi_q4[a]) >> FINGERPRINT_SMOOTH_SHIFT;
+            }
+            s_seen_us[a] = rx_us;
+            s_heard |= (uint8_t)(1u << a);
+            wake = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (wake) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void FINGERPRINT_record_spot(void)
+{
+    if (FINGERPRINT_SAMPLES == 0 || s_task == NULL) {
+        return;
+    }
+
+    s_record_request = true;
+    xTaskNotifyGive(s_task);
+}
+
+void FINGERPRINT_get_status(fingerprint_status_t *status)
+{
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#endif /* CONFIG_CUBE_FINGERPRINT */
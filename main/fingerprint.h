@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "fpindex.h"
+
+// Plain values, the UI formats them without partition or FreeRTOS headers
+typedef struct {
+    bool located;               // spot is valid, the index answered a query
+    uint8_t spot;               // Nearest spot
+    uint8_t votes;              // Neighbours of that spot
+    uint8_t k;                  // Neighbours found
+    char name[FPINDEX_SPOT_NAME_LEN + 1];   // Label of the spot, empty without one
+    bool has_position;
+    int16_t x_dm;               // Weighted position of the labelled neighbours
+    int16_t y_dm;
+    uint32_t entries;           // Fingerprints in the index
+    uint32_t query_us;          // Duration of the last query
+    uint32_t query_max_us;      // Longest query since the receiver started
+    bool recording;             // A spot is being recorded, only with CONFIG_CUBE_FINGERPRINT_RECORD
+    uint8_t record_spot;
+    uint8_t recorded;           // Fingerprints of record_spot so far
+    uint8_t record_target;
+} fingerprint_status_t;
+
+#if CONFIG_CUBE_FINGERPRINT
+
+/**
+ * @brief Map the fingerprint partition and create the query task
+ *
+ * The index is read through esp_partition_mmap() and never copied. Without a
+ * "fingerprint" partition the receiver runs without localisation.
+ */
+extern void FINGERPRINT_init(void);
+
+// Forget the RSSI of all anchors, called when the receiver role starts
+extern void FINGERPRINT_start(void);
+
+// Stop queries and an unfinished recording, called before the receiver is torn down
+extern void FINGERPRINT_stop(void);
+
+/**
+ * @brief Smooth the RSSI of an anchor and wake the query task, called from the Wi-Fi task
+ *
+ * Frames of senders that are not in the index header are ignored. Before the
+ * first spot is recorded the anchors are learned in the order they are heard.
+ *
+ * @param rx_us Reception time of the frame
+ */
+extern void FINGERPRINT_frame(const uint8_t *mac, int8_t rssi, int64_t rx_us);
+
+/**
+ * @brief Record CONFIG_CUBE_FINGERPRINT_SAMPLES fingerprints for the next spot
+ *
+ * Ignored without CONFIG_CUBE_FINGERPRINT_RECORD or while a spot is recorded.
+ */
+extern void FINGERPRINT_record_spot(void);
+
+extern void FINGERPRINT_get_status(fingerprint_status_t *status);
+
+#else
+
+static inline void FINGERPRINT_init(void) {}
+static inline void FINGERPRINT_start(void) {}
+static inline void FINGERPRINT_stop(void) {}
+static inline void FINGERPRINT_frame(const uint8_t *mac, int8_t rssi, int64_t rx_us) { (void)mac; (void)rssi; (void)rx_us; }
+static inline void FINGERPRINT_record_spot(void) {}
+static inline void FINGERPRINT_get_status(fingerprint_status_t *status) { memset(status, 0, sizeof(*status)); }
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "lvgl.h"
+
+// Fonts of the UI, either glyph subsets generated at build time or the full LVGL fonts.
+// CUBE_FONTS_SUBSET comes from main/CMakeLists.txt once the subset fonts were generated
+#if CUBE_FONTS_SUBSET
+LV_FONT_DECLARE(font_ui_12)
+LV_FONT_DECLARE(font_ui_14)
+#define FONT_UI_12 (&font_ui_12)
+#define FONT_UI_14 (&font_ui_14)
+#else
+#define FONT_UI_12 (&lv_font_montserrat_12)
+#define FONT_UI_14 (&lv_font_montserrat_14)
+#endif
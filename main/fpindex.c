@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fpindex.h"
+
+// Weight of a neighbour is FPINDEX_WEIGHT_ONE / (1 + distance)
+#define FPINDEX_WEIGHT_ONE      (1u << 16)
+
+typedef struct {
+    uint32_t distance;
+    uint8_t spot;
+} fpindex_neighbour_t;
+
+static bool fpindex_is_end(const fpindex_t *index, uint32_t n)
+{
+    return index->entries[(size_t)n * index->entry_size] == FPINDEX_NO_SPOT;
+}
+
+bool FPINDEX_open(fpindex_t *index, const void *base, size_t size)
+{
+    memset(index, 0, sizeof(*index));
+
+    const fpindex_header_t *header = (const fpindex_header_t *)base;
+    if (size <= FPINDEX_ENTRIES_OFFSET || header->magic != FPINDEX_MAGIC || header->version != FPINDEX_VERSION ||
+        header->anchors == 0 || header->anchors > FPINDEX_MAX_ANCHORS) {
+        return false;
+    }
+
+    index->base = (const uint8_t *)base;
+    index->header = header;
+    index->spots = (const fpindex_spot_t *)&index->base[FPINDEX_SPOTS_OFFSET];
+    index->entries = &index->base[FPINDEX_ENTRIES_OFFSET];
+    index->entry_size = 1 + header->anchors;
+    index->capacity = (size - FPINDEX_ENTRIES_OFFSET) / index->entry_size;
+
+    // Entries are written in order, binary search for the first erased one
+    uint32_t lo = 0;
+    uint32_t hi = index->capacity;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (fpindex_is_end(index, mid)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    index->count = lo;
+
+    return true;
+}
+
+static bool fpindex_spot_labelled(const fpindex_t *index, uint8_t spot)
+{
+    return spot < FPINDEX_MAX_SPOTS && (uint8_t)index->spots[spot].name[0] != 0xFF;
+}
+
+// Spot with the highest summed weight, and the weighted position of the labelled ones
+static void fpindex_vote(const fpindex_t *index, const fpindex_neighbour_t *best, uint8_t found,
+                         fpindex_result_t *result)
+{
+    uint32_t best_weight = 0;
+    int64_t sum_x = 0;
+    int64_t sum_y = 0;
+    uint32_t sum_w = 0;
+
+    for (uint8_t i = 0; i < found; i++) {
+        uint32_t weight = 0;
+        uint8_t votes = 0;
+
+        for (uint8_t j = 0; j < found; j++) {
+            if (best[j].spot == best[i].spot) {
+                weight += FPINDEX_WEIGHT_ONE / (1 + best[j].distance);
+                votes++;
+            }
+        }
+        if (weight > best_weight) {
+            best_weight = weight;
+            result->spot = best[i].spot;
+            result->votes = votes;
+        }
+
+        if (fpindex_spot_labelled(index, best[i].spot)) {
+            const fpindex_spot_t *spot = &index->spots[best[i].spot];
+            const uint32_t w = FPINDEX_WEIGHT_ONE / (1 + best[i].distance);
+            sum_x += (int64_t)spot->x_dm * w;
+            sum_y += (int64_t)spot->y_dm * w;
+            sum_w += w;
+        }
+    }
+
+    if (sum_w > 0) {
+        result->has_position = true;
+        result->x_dm = (int16_t)(sum_x / sum_w);
+        result->y_dm = (int16_t)(sum_y / sum_w);
+    }
+}
+
+bool FPINDEX_query(const fpindex_t *index, const uint8_t *q, uint8_t k, fpindex_result_t *result)
+{
+    fpindex_neighbour_t best[FPINDEX_MAX_K];
+    const uint8_t anchors = index->header->anchors;
+    uint8_t found = 0;
+
+    memset(result, 0, sizeof(*result));
+
+    if (index->count == 0 || k == 0) {
+        return false;
+    }
+    if (k > FPINDEX_MAX_K) {
+        k = FPINDEX_MAX_K;
+    }
+
+    const uint8_t *entry = index->entries;
+    for (uint32_t n = 0; n < index->count; n++, entry += index->entry_size) {
+        // Once k neighbours are known, an entry is abandoned as soon as it is farther than the worst
+        const uint32_t limit = (found == k) ? best[k - 1].distance : UINT32_MAX;
+        uint32_t distance = 0;
+        uint8_t a = 0;
+
+        for (; a < anchors && distance < limit; a++) {
+            const int32_t d = (int32_t)entry[1 + a] - q[a];
+            distance += (uint32_t)(d * d);
+        }
+        if (a < anchors || distance >= limit) {
+            continue;
+        }
+        result->scanned++;
+
+        // Insertion into the sorted list of the k nearest
+        uint8_t pos = (found < k) ? found++ : k - 1;
+        while (pos > 0 && best[pos - 1].distance > distance) {
+            best[pos] = best[pos - 1];
+            pos--;
+        }
+        best[pos] = (fpindex_neighbour_t){ .distance = distance, .spot = entry[0] };
+    }
+
+    result->k = found;
+    result->distance = best[0].distance;
+    fpindex_vote(index, best, found, result);
+
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies. The index is searched in place, on the
+// device through esp_partition_mmap() and on the host by tools/fingerprint.py,
+// which has the same layout. All fields are little-endian.
+//
+// Partition layout:
+//   0      fpindex_header_t, erased (0xFF) until the first spot is recorded
+//   64     FPINDEX_MAX_SPOTS fpindex_spot_t, erased for spots without a label
+//   1088   Entries of 1 + anchors bytes: spot, then the quantized RSSI per anchor.
+//          The first entry with spot FPINDEX_NO_SPOT ends the list, so the device
+//          can append to an erased partition.
+
+#define FPINDEX_MAGIC           (0x31585046u)   // "FPX1"
+#define FPINDEX_VERSION         (1)
+
+#define FPINDEX_MAX_ANCHORS     (8)
+#define FPINDEX_MAX_SPOTS       (64)
+#define FPINDEX_MAX_K           (8)
+#define FPINDEX_NO_SPOT         (0xFF)
+#define FPINDEX_SPOT_NAME_LEN   (12)
+
+#define FPINDEX_SPOTS_OFFSET    (64)
+#define FPINDEX_ENTRIES_OFFSET  (FPINDEX_SPOTS_OFFSET + FPINDEX_MAX_SPOTS * sizeof(fpindex_spot_t))
+
+// Quantized RSSI is the dBm above this, 0 means the anchor was not heard
+#define FPINDEX_RSSI_MIN        (-110)
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // FPINDEX_MAGIC
+    uint8_t version;            // FPINDEX_VERSION
+    uint8_t anchors;            // RSSI values per entry, 1 .. FPINDEX_MAX_ANCHORS
+    uint8_t reserved[2];
+    uint32_t anchor[FPINDEX_MAX_ANCHORS];   // Last four bytes of the anchor MACs, in entry order
+    uint8_t reserved2[24];
+} fpindex_header_t;
+
+typedef struct __attribute__((packed)) {
+    int16_t x_dm;               // Position in decimeters, set by the host tool
+    int16_t y_dm;
+    char name[FPINDEX_SPOT_NAME_LEN];   // NUL padded, 0xFF while the spot has no label
+} fpindex_spot_t;
+
+typedef struct {
+    const uint8_t *base;        // Mapped partition, never copied
+    const fpindex_header_t *header;
+    const fpindex_spot_t *spots;
+    const uint8_t *entries;
+    uint32_t count;             // Entries before the end marker
+    uint32_t capacity;          // Entries that fit into the partition
+    uint8_t entry_size;
+} fpindex_t;
+
+typedef struct {
+    uint8_t spot;               // Spot with the highest weight of the k nearest entries
+    uint8_t votes;              // Entries of that spot among the k nearest
+    uint8_t k;                  // Entries found, less than requested in a small index
+    bool has_position;          // x_dm and y_dm are valid, some of the k nearest spots have a label
+    int16_t x_dm;               // Weighted position of the labelled spots among the k nearest
+    int16_t y_dm;
+    uint32_t distance;          // Squared RSSI distance to the nearest entry
+    uint32_t scanned;           // Entries that were compared completely, the others were abandoned early
+} fpindex_result_t;
+
+static inline uint8_t FPINDEX_quantize(int rssi)
+{
+    const int q = rssi - FPINDEX_RSSI_MIN;
+
+    return (q < 1) ? 1 : (q > 255) ? 255 : (uint8_t)q;
+}
+
+/**
+ * @brief Check the header and count the entries, the data stays where it is
+ *
+ * @param base Start of the partition
+ * @param size Partition size
+ * @return false for an erased partition or another format
+ */
+extern bool FPINDEX_open(fpindex_t *index, const void *base, size_t size);
+
+// Byte offset of an entry in the partition, where the device appends the next one
+static inline size_t FPINDEX_entry_offset(const fpindex_t *index, uint32_t n)
+{
+    return FPINDEX_ENTRIES_OFFSET + (size_t)n * index->entry_size;
+}
+
+/**
+ * @brief k-nearest-neighbour search over all entries, O(count * anchors) without allocations
+ *
+ * @param q Quantized RSSI per anchor, 0 for anchors not heard
+ * @param k Neighbours, up to FPINDEX_MAX_K
+ * @return false if the index has no entries
+ */
+extern bool FPINDEX_query(const fpindex_t *index, const uint8_t *q, uint8_t k, fpindex_result_t *result);
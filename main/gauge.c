@@ -0,0 +1,243 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lvgl.h"
+
+#include "gauge.h"
+
+// 28 segments every 10°, starting at 135° (bottom left) and ending at 45° (bottom right)
+#define GAUGE_SEGMENTS          (28)
+#define GAUGE_START_ANGLE       (135)
+#define GAUGE_SWEEP_ANGLE       (270)
+#define GAUGE_SEGMENT_SIZE      (7)
+#define GAUGE_LED_SIZE          (30)
+#define GAUGE_LED_OFF_MIX       (100) // Share of the LED color kept when off, 0..255
+
+#define GAUGE_COLOR_ON          (0x0000FF)
+#define GAUGE_COLOR_OFF         (0xE0E0E0)
+
+typedef struct {
+    lv_obj_t *obj;
+    int16_t seg_x[GAUGE_SEGMENTS];  // Segment centers relative to the gauge center
+    int16_t seg_y[GAUGE_SEGMENTS];
+    int32_t min;
+    int32_t max;
+    int32_t value;
+    uint8_t lit_first;              // Lit segments are [lit_first, lit_end)
+    uint8_t lit_end;
+    bool symmetrical;
+    lv_color_t led_color;
+    bool led_on;
+} gauge_t;
+
+static void gauge_get_center(const gauge_t *gauge, lv_point_t *center)
+{
+    lv_area_t coords;
+
+    lv_obj_get_coords(gauge->obj, &coords);
+    center->x = coords.x1 + lv_area_get_width(&coords) / 2;
+    center->y = coords.y1 + lv_area_get_height(&coords) / 2;
+}
+
+static void gauge_get_segment_area(const gauge_t *gauge, const lv_point_t *center, uint32_t i, lv_area_t *area)
+{
+    area->x1 = center->x + gauge->seg_x[i] - GAUGE_SEGMENT_SIZE / 2;
+    area->y1 = center->y + gauge->seg_y[i] - GAUGE_SEGMENT_SIZE / 2;
+    area->x2 = area->x1 + GAUGE_SEGMENT_SIZE - 1;
+    area->y2 = area->y1 + GAUGE_SEGMENT_SIZE - 1;
+}
+
+static void gauge_get_led_area(const lv_point_t *center, lv_area_t *area)
+{
+    area->x1 = center->x - GAUGE_LED_SIZE / 2;
+    area->y1 = center->y - GAUGE_LED_SIZE / 2;
+    area->x2 = area->x1 + GAUGE_LED_SIZE - 1;
+    area->y2 = area->y1 + GAUGE_LED_SIZE - 1;
+}
+
+// Invalidate the bounding box of the segments [first, end)
+static void gauge_invalidate_segments(const gauge_t *gauge, uint32_t first, uint32_t end)
+{
+    if (first >= end) {
+        return;
+    }
+
+    lv_point_t center;
+    lv_area_t inv;
+    lv_area_t seg;
+
+    gauge_get_center(gauge, &center);
+    gauge_get_segment_area(gauge, &center, first, &inv);
+
+    for (uint32_t i = first + 1; i < end; i++) {
+        gauge_get_segment_area(gauge, &center, i, &seg);
+        inv.x1 = LV_MIN(inv.x1, seg.x1);
+        inv.y1 = LV_MIN(inv.y1, seg.y1);
+        inv.x2 = LV_MAX(inv.x2, seg.x2);
+        inv.y2 = LV_MAX(inv.y2, seg.y2);
+    }
+
+    lv_obj_invalidate_area(gauge->obj, &inv);
+}
+
+// Map the value to the lit segment span and invalidate only the segments that toggled
+static void gauge_update_span(gauge_t *gauge)
+{
+    const int32_t range = gauge->max - gauge->min;
+    int32_t value = LV_CLAMP(gauge->min, gauge->value, gauge->max);
+    uint8_t first;
+    uint8_t end;
+
+    if (range <= 0) {
+        first = 0;
+        end = 0;
+    } else if (gauge->symmetrical) {
+        // Positions are segment boundaries 0..GAUGE_SEGMENTS, the midpoint lies between the two center
+        // segments, so both ends of the range light the same number of segments
+        const int32_t mid = GAUGE_SEGMENTS / 2;
+        const int32_t pos = ((value - gauge->min) * GAUGE_SEGMENTS + range / 2) / range;
+        first = (uint8_t)LV_MIN(mid, pos);
+        end = (uint8_t)LV_MAX(mid, pos);
+    } else {
+        first = 0;
+        end = (uint8_t)(((value - gauge->min) * GAUGE_SEGMENTS + range / 2) / range);
+    }
+
+    if (first == gauge->lit_first && end == gauge->lit_end) {
+        return;
+    }
+
+    // The old and the new span differ at their starts and at their ends
+    gauge_invalidate_segments(gauge, LV_MIN(first, gauge->lit_first), LV_MAX(first, gauge->lit_first));
+    gauge_invalidate_segments(gauge, LV_MIN(end, gauge->lit_end), LV_MAX(end, gauge->lit_end));
+
+    gauge->lit_first = first;
+    gauge->lit_end = end;
+}
+
+static void gauge_event_cb(lv_event_t *e)
+{
+    gauge_t *gauge = lv_event_get_user_data(e);
+
+    if (lv_event_get_code(e) == LV_EVENT_DELETE) {
+        lv_free(gauge);
+        return;
+    }
+
+    lv_layer_t *layer = lv_event_get_layer(e);
+    lv_point_t center;
+    lv_area_t area;
+    lv_draw_rect_dsc_t dsc;
+
+    gauge_get_center(gauge, &center);
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.radius = 1;
+
+    // Segment and LED tasks outside the invalidated area are clipped away by the draw unit
+    for (uint32_t i = 0; i < GAUGE_SEGMENTS; i++) {
+        const bool lit = (i >= gauge->lit_first) && (i < gauge->lit_end);
+
+        dsc.bg_color = lv_color_hex(lit ? GAUGE_COLOR_ON : GAUGE_COLOR_OFF);
+        gauge_get_segment_area(gauge, &center, i, &area);
+        lv_draw_rect(layer, &dsc, &area);
+    }
+
+    dsc.radius = LV_RADIUS_CIRCLE;
+    dsc.bg_color = gauge->led_on ? gauge->led_color
+                                 : lv_color_mix(gauge->led_color, lv_color_black(), GAUGE_LED_OFF_MIX);
+    gauge_get_led_area(&center, &area);
+    lv_draw_rect(layer, &dsc, &area);
+}
+
+lv_obj_t *GAUGE_create(lv_obj_t *parent, int32_t size)
+{
+    gauge_t *gauge = lv_malloc_zeroed(sizeof(gauge_t));
+    if (gauge == NULL) {
+        return NULL;
+    }
+
+    gauge->obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(gauge->obj);
+    lv_obj_remove_flag(gauge->obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_remove_flag(gauge->obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(gauge->obj, size, size);
+    lv_obj_set_user_data(gauge->obj, gauge);
+
+    // Segment centers in fixed point: lv_trigo_cos/sin return Q15
+    const int32_t radius = (size - GAUGE_SEGMENT_SIZE) / 2;
+    for (uint32_t i = 0; i < GAUGE_SEGMENTS; i++) {
+        const int16_t angle = (int16_t)(GAUGE_START_ANGLE + (i * GAUGE_SWEEP_ANGLE) / (GAUGE_SEGMENTS - 1));
+        gauge->seg_x[i] = (int16_t)((radius * lv_trigo_cos(angle)) >> LV_TRIGO_SHIFT);
+        gauge->seg_y[i] = (int16_t)((radius * lv_trigo_sin(angle)) >> LV_TRIGO_SHIFT);
+    }
+
+    gauge->min = 0;
+    gauge->max = 100;
+    gauge->led_color = lv_color_hex(GAUGE_COLOR_ON);
+    gauge->led_on = true;
+
+    lv_obj_add_event_cb(gauge->obj, gauge_event_cb, LV_EVENT_DRAW_MAIN, gauge);
+    lv_obj_add_event_cb(gauge->obj, gauge_event_cb, LV_EVENT_DELETE, gauge);
+
+    return gauge->obj;
+}
+
+static gauge_t *gauge_get(lv_obj_t *obj)
+{
+    return (obj != NULL) ? lv_obj_get_user_data(obj) : NULL;
+}
+
+void GAUGE_set_range(lv_obj_t *obj, int32_t min, int32_t max)
+{
+    gauge_t *gauge = gauge_get(obj);
+    if (gauge == NULL) {
+        return;
+    }
+
+    gauge->min = min;
+    gauge->max = max;
+    gauge_update_span(gauge);
+}
+
+void GAUGE_set_symmetrical(lv_obj_t *obj, bool symmetrical)
+{
+    gauge_t *gauge = gauge_get(obj);
+    if (gauge == NULL) {
+        return;
+    }
+
+    gauge->symmetrical = symmetrical;
+    gauge_update_span(gauge);
+}
+
+void GAUGE_set_value(lv_obj_t *obj, int32_t value)
+{
+    gauge_t *gauge = gauge_get(obj);
+    if (gauge == NULL || gauge->value == value) {
+        return;
+    }
+
+    gauge->value = value;
+    gauge_update_span(gauge);
+}
+
+void GAUGE_set_led(lv_obj_t *obj, lv_color_t color, bool on)
+{
+    gauge_t *gauge = gauge_get(obj);
+    if (gauge == NULL) {
+        return;
+    }
+
+    if (lv_color_eq(gauge->led_color, color) && gauge->led_on == on) {
+        return;
+    }
+
+    gauge->led_color = color;
+    gauge->led_on = on;
+
+    lv_point_t center;
+    lv_area_t area;
+    gauge_get_center(gauge, &center);
+    gauge_get_led_area(&center, &area);
+    lv_obj_invalidate_area(gauge->obj, &area);
+}
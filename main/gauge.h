@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl.h"
+
+/**
+ * @brief Segmented 270° distance gauge with the status LED in its center
+ *
+ * The segment positions are computed once at creation. Value and LED changes
+ * only invalidate the segments or the LED area that actually changed, and the
+ * whole widget is drawn from a single draw callback.
+ *
+ * @param parent Parent object
+ * @param size Width and height in pixels
+ * @return lv_obj_t* The gauge, NULL on failure
+ */
+extern lv_obj_t *GAUGE_create(lv_obj_t *parent, int32_t size);
+extern void GAUGE_set_range(lv_obj_t *gauge, int32_t min, int32_t max);
+extern void GAUGE_set_symmetrical(lv_obj_t *gauge, bool symmetrical);
+extern void GAUGE_set_value(lv_obj_t *gauge, int32_t value);
+extern void GAUGE_set_led(lv_obj_t *gauge, lv_color_t color, bool on);
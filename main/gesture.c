@@ -0,0 +1,157 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "gesture.h"
+
+typedef enum {
+    GESTURE_STATE_IDLE = 0,
+    GESTURE_STATE_PRESSED,      // Down, deadlines for long press and repeat armed
+    GESTURE_STATE_WAIT_SECOND,  // Released, waiting for the second press of a double click
+} gesture_state_t;
+
+// Wrap-safe: deadline reached at now
+static bool gesture_due(uint32_t deadline, uint32_t now)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+static void gesture_emit(gesture_engine_t *engine, uint8_t button, gesture_type_t type)
+{
+    if (engine->emit != NULL) {
+        engine->emit(button, type, engine->ctx);
+    }
+}
+
+static void gesture_press(gesture_engine_t *engine, uint8_t index, uint32_t now)
+{
+    gesture_button_t *b = &engine->buttons[index];
+
+    b->second = (b->state == GESTURE_STATE_WAIT_SECOND);
+    b->held = false;
+    b->state = GESTURE_STATE_PRESSED;
+    b->long_at = now + b->config->long_press_ms;
+    b->repeat_at = now + b->config->repeat_delay_ms;
+
+    gesture_emit(engine, index, GESTURE_PRESS);
+}
+
+static void gesture_release(gesture_engine_t *engine, uint8_t index, uint32_t now)
+{
+    gesture_button_t *b = &engine->buttons[index];
+
+    gesture_emit(engine, index, GESTURE_RELEASE);
+
+    if (b->held) {
+        b->state = GESTURE_STATE_IDLE;
+    } else if (b->second) {
+        b->state = GESTURE_STATE_IDLE;
+        gesture_emit(engine, index, GESTURE_DOUBLE_CLICK);
+    } else if (b->config->double_click_ms > 0) {
+        b->state = GESTURE_STATE_WAIT_SECOND;
+        b->click_at = now + b->config->double_click_ms;
+    } else {
+        b->state = GESTURE_STATE_IDLE;
+        gesture_emit(engine, index, GESTURE_CLICK);
+    }
+}
+
+void GESTURE_init(gesture_engine_t *engine, const gesture_config_t *configs, uint8_t count,
+                  gesture_emit_t emit, void *ctx)
+{
+    memset(engine, 0, sizeof(*engine));
+
+    engine->count = (count > GESTURE_MAX_BUTTONS) ? GESTURE_MAX_BUTTONS : count;
+    engine->emit = emit;
+    engine->ctx = ctx;
+
+    for (uint8_t i = 0; i < engine->count; i++) {
+        engine->buttons[i].config = &configs[i];
+    }
+}
+
+void GESTURE_input(gesture_engine_t *engine, uint8_t button, bool pressed, uint32_t now_ms)
+{
+    if (button >= engine->count) {
+        return;
+    }
+
+    // A deadline that passed before this edge fires first
+    GESTURE_tick(engine, now_ms);
+
+    const bool down = (engine->buttons[button].state == GESTURE_STATE_PRESSED);
+
+    if (pressed && !down) {
+        gesture_press(engine, button, now_ms);
+    } else if (!pressed && down) {
+        gesture_release(engine, button, now_ms);
+    }
+}
+
+void GESTURE_tick(gesture_engine_t *engine, uint32_t now_ms)
+{
+    for (uint8_t i = 0; i < engine->count; i++) {
+        gesture_button_t *b = &engine->buttons[i];
+        const gesture_config_t *c = b->config;
+
+        if (b->state == GESTURE_STATE_WAIT_SECOND) {
+            if (gesture_due(b->click_at, now_ms)) {
+                b->state = GESTURE_STATE_IDLE;
+                gesture_emit(engine, i, GESTURE_CLICK);
+            }
+            continue;
+        }
+
+        if (b->state != GESTURE_STATE_PRESSED) {
+            continue;
+        }
+
+        if (c->long_press_ms > 0 && !b->held && gesture_due(b->long_at, now_ms)) {
+            b->held = true;
+            gesture_emit(engine, i, GESTURE_LONG_PRESS);
+        }
+
+        if (c->repeat_delay_ms > 0 && gesture_due(b->repeat_at, now_ms)) {
+            const uint32_t period = (c->repeat_period_ms > 0) ? c->repeat_period_ms : c->repeat_delay_ms;
+
+            b->held = true;
+            // A late tick must not burst the missed repeats
+            b->repeat_at += period;
+            if (gesture_due(b->repeat_at, now_ms)) {
+                b->repeat_at = now_ms + period;
+            }
+            gesture_emit(engine, i, GESTURE_REPEAT);
+        }
+    }
+}
+
+uint32_t GESTURE_get_timeout(const gesture_engine_t *engine, uint32_t now_ms)
+{
+    uint32_t timeout = GESTURE_NO_TIMEOUT;
+
+    for (uint8_t i = 0; i < engine->count; i++) {
+        const gesture_button_t *b = &engine->buttons[i];
+        const gesture_config_t *c = b->config;
+        uint32_t deadline[2];
+        uint8_t n = 0;
+
+        if (b->state == GESTURE_STATE_WAIT_SECOND) {
+            deadline[n++] = b->click_at;
+        } else if (b->state == GESTURE_STATE_PRESSED) {
+            if (c->long_press_ms > 0 && !b->held) {
+                deadline[n++] = b->long_at;
+            }
+            if (c->repeat_delay_ms > 0) {
+                deadline[n++] = b->repeat_at;
+            }
+        }
+
+        for (uint8_t j = 0; j < n; j++) {
+            const uint32_t left = gesture_due(deadline[j], now_ms) ? 0 : deadline[j] - now_ms;
+            if (left < timeout) {
+                timeout = left;
+            }
+        }
+    }
+
+    return timeout;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, gpio.c feeds it debounced edges and the time
+
+#define GESTURE_MAX_BUTTONS     (4)
+#define GESTURE_NO_TIMEOUT      (UINT32_MAX)
+
+typedef enum {
+    GESTURE_PRESS = 0,          // Debounced press, sent immediately
+    GESTURE_RELEASE,
+    GESTURE_CLICK,              // Short press, delayed by the double click window if enabled
+    GESTURE_DOUBLE_CLICK,
+    GESTURE_LONG_PRESS,         // Held for long_press_ms, no click follows
+    GESTURE_REPEAT,             // Auto-repeat while held, no click follows
+} gesture_type_t;
+
+// Per-button timing, 0 disables the gesture
+typedef struct {
+    uint16_t long_press_ms;
+    uint16_t double_click_ms;
+    uint16_t repeat_delay_ms;
+    uint16_t repeat_period_ms;
+} gesture_config_t;
+
+typedef void (*gesture_emit_t)(uint8_t button, gesture_type_t type, void *ctx);
+
+typedef struct {
+    const gesture_config_t *config;
+    uint8_t state;
+    bool second;                // Second press of a possible double click
+    bool held;                  // Long press or repeat fired, suppresses the click
+    uint32_t long_at;
+    uint32_t repeat_at;
+    uint32_t click_at;
+} gesture_button_t;
+
+typedef struct {
+    gesture_button_t buttons[GESTURE_MAX_BUTTONS];
+    uint8_t count;
+    gesture_emit_t emit;
+    void *ctx;
+} gesture_engine_t;
+
+/**
+ * @brief Set up the state machines from a config table
+ *
+ * @param engine Engine state, owned by the caller
+ * @param configs One entry per button, must stay valid
+ * @param count Number of buttons, at most GESTURE_MAX_BUTTONS
+ * @param emit Called for every detected gesture
+ * @param ctx Passed to emit
+ */
+extern void GESTURE_init(gesture_engine_t *engine, const gesture_config_t *configs, uint8_t count,
+                         gesture_emit_t emit, void *ctx);
+
+// Debounced level change of a button at now_ms
+extern void GESTURE_input(gesture_engine_t *engine, uint8_t button, bool pressed, uint32_t now_ms);
+
+// Fire the gestures whose deadline has passed
+extern void GESTURE_tick(gesture_engine_t *engine, uint32_t now_ms);
+
+// Milliseconds until GESTURE_tick() has something to do, GESTURE_NO_TIMEOUT if nothing is pending
+extern uint32_t GESTURE_get_timeout(const gesture_engine_t *engine, uint32_t now_ms);
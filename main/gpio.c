@@ -2,126 +2,229 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "sdkconfig.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#if CONFIG_CUBE_POWER_SAVE
+#include "esp_sleep.h"
+#endif
 
 #include "gpio.h"
 
-#define BLINK_GPIO 11
 #define GPIO_BUTTON_1 8
 #define GPIO_BUTTON_2 10
 
+typedef struct {
+    gpio_num_t gpio;
+    gesture_config_t gesture;
+} gpio_button_config_t;
+
+// One entry per button, indexed by gpio_button_t
+static const gpio_button_config_t s_buttons[GPIO_BUTTON_COUNT] = {
+    [GPIO_BUTTON_ENTER] = { .gpio = GPIO_BUTTON_1, .gesture = { .long_press_ms = 1000 } },
+    [GPIO_BUTTON_SET]   = { .gpio = GPIO_BUTTON_2, .gesture = { .repeat_delay_ms = 600, .repeat_period_ms = 250 } },
+};
+
 static const char *TAG = "gpio";
-static bool s_button_state[2] = {false}; 
-static gpio_callback_t s_callback[2] = {NULL};
+static bool s_button_state[GPIO_BUTTON_COUNT] = {false};
+
+// Edges restart the timer, the level is sampled once it stayed stable this long
+#define GPIO_DEBOUNCE_US        (30 * 1000)
+#define GPIO_QUEUE_LEN          (8)
+
+// Debounced level change, from the esp_timer task to the button task
+typedef struct {
+    uint8_t button;
+    bool pressed;
+    int64_t time_us;    // First edge of the bounce burst
+} gpio_edge_t;
+
+static esp_timer_handle_t s_debounce_timer[GPIO_BUTTON_COUNT] = {NULL};
+static int64_t s_edge_time_us[GPIO_BUTTON_COUNT] = {0};
+static QueueHandle_t s_edge_queue = NULL;
+static QueueHandle_t s_event_queue = NULL;
+static gesture_engine_t s_gesture;
+static gesture_config_t s_gesture_config[GPIO_BUTTON_COUNT];
+
+#if CONFIG_CUBE_POWER_SAVE
+/*
+ * Edges that arrive in automatic light sleep are lost on the C3, so power save
+ * builds trigger on the level opposite to the debounced state instead. The
+ * same level wakes the chip. The ISR disables the pin until the debounce timer
+ * sampled it, so the level cannot fire again and again. The timer arms the
+ * opposite of the sampled level, a pin that changed again meanwhile fires
+ * right away.
+ */
+static void gpio_arm_level(uint32_t button, int level)
+{
+    const gpio_num_t gpio = s_buttons[button].gpio;
+
+    ESP_ERROR_CHECK(gpio_wakeup_enable(gpio, level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL));
+    ESP_ERROR_CHECK(gpio_intr_enable(gpio));
+}
+#endif
 
-void GPIO_configure_io(void)
+static void IRAM_ATTR gpio_button_isr(void *arg)
 {
-    gpio_reset_pin(BLINK_GPIO);
-    /* Set the GPIO as a push/pull output */
-    gpio_set_direction(BLINK_GPIO, GPIO_MODE_OUTPUT);
+    const uint32_t button = (uint32_t)(uintptr_t)arg;
+
+#if CONFIG_CUBE_POWER_SAVE
+    gpio_intr_disable(s_buttons[button].gpio);
+    s_edge_time_us[button] = esp_timer_get_time();
+    esp_timer_start_once(s_debounce_timer[button], GPIO_DEBOUNCE_US);
+#else
+    if (!esp_timer_is_active(s_debounce_timer[button])) {
+        s_edge_time_us[button] = esp_timer_get_time();
+    }
+
+    esp_timer_stop(s_debounce_timer[button]);
+    esp_timer_start_once(s_debounce_timer[button], GPIO_DEBOUNCE_US);
+#endif
 }
 
-void GPIO_toggle_led(void)
+// Runs in the esp_timer task once the pin is stable
+static void gpio_debounce_timer_cb(void *arg)
 {
-    static uint8_t s_led_state = 0;
+    const uint32_t button = (uint32_t)(uintptr_t)arg;
+    const int level = gpio_get_level(s_buttons[button].gpio);
+    const bool pressed = (level == 0);
+
+#if CONFIG_CUBE_POWER_SAVE
+    gpio_arm_level(button, level);
+#endif
+
+    if (pressed == s_button_state[button]) {
+        return; // Bounced back to the previous state
+    }
 
-    /* Set the GPIO level according to the state (LOW or HIGH)*/
-    gpio_set_level(BLINK_GPIO, s_led_state);
+    s_button_state[button] = pressed;
 
-    s_led_state ^= 1;
+    gpio_edge_t edge = {
+        .button = (uint8_t)button,
+        .pressed = pressed,
+        .time_us = s_edge_time_us[button],
+    };
+    xQueueSend(s_edge_queue, &edge, 0);
+}
+
+static void gpio_gesture_emit(uint8_t button, gesture_type_t type, void *ctx)
+{
+    const gpio_button_event_t event = {
+        .button = button,
+        .gesture = (uint8_t)type,
+    };
+
+    ESP_LOGI(TAG, "Button an GPIO %d: Geste %d", s_buttons[button].gpio, type);
+
+    // A full queue means the application is busy, drop rather than block the gestures
+    xQueueSend(s_event_queue, &event, 0);
+}
+
+static uint32_t gpio_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
 /**
- * @brief Task zur Überwachung des Buttons und Auslösung der Label-Aktualisierung.
+ * @brief Task der Gesten-Erkennung, schläft bis eine Flanke oder eine Gesten-Frist eintrifft.
  */
-void GPIO_button_monitoring_task(void *pvParameter) {
-    ESP_LOGI(TAG, "Button Monitoring Task gestartet");
-
-    gpio_config_t io_conf;
-    // Interrupt für fallende Flanke deaktivieren (wir pollen)
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    // Bitmaske des Pins
-    io_conf.pin_bit_mask = (1ULL << GPIO_BUTTON_1) | (1ULL << GPIO_BUTTON_2);
-    // Als Input setzen
-    io_conf.mode = GPIO_MODE_INPUT;
-    // Pull-up aktivieren
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    gpio_config(&io_conf);
-
-    bool last_button_state[2] = {true}; 
-    TickType_t last_press_time[2] = {0};
-    const TickType_t debounce_delay = pdMS_TO_TICKS(50); // 50ms Entprellzeit
+static void gpio_button_task(void *pvParameter) {
+    gpio_edge_t edge;
 
     while (1) {
-        bool current_button_state[2] = {gpio_get_level(GPIO_BUTTON_1), gpio_get_level(GPIO_BUTTON_2)};
-
-        // Prüfen auf fallende Flanke (Button gedrückt)
-        if (last_button_state[0] == true && current_button_state[0] == false) {
-            // Entprellen
-            if ((xTaskGetTickCount() - last_press_time[0]) > debounce_delay) {
-                last_press_time[0] = xTaskGetTickCount();
-                ESP_LOGI(TAG, "Button an GPIO %d gedrückt!", GPIO_BUTTON_1);
-                s_button_state[0] = true;
-                if(s_callback[0] != NULL) {
-                    s_callback[0]();
-                }
-            }
-        }
-        // Prüfen auf steigende Flanke (Button losgelassen)
-        else if (last_button_state[0] == false && current_button_state[0] == true) {
-            if ((xTaskGetTickCount() - last_press_time[0]) > debounce_delay) {
-                last_press_time[0] = xTaskGetTickCount();
-                ESP_LOGI(TAG, "Button an GPIO %d losgelassen!", GPIO_BUTTON_1);
-                s_button_state[0] = false;
-            }
-        }
+        const uint32_t timeout_ms = GESTURE_get_timeout(&s_gesture, gpio_now_ms());
+        const TickType_t timeout = (timeout_ms == GESTURE_NO_TIMEOUT) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms) + 1;
 
-        // Prüfen auf fallende Flanke (Button gedrückt)
-        if (last_button_state[1] == true && current_button_state[1] == false) {
-            // Entprellen
-            if ((xTaskGetTickCount() - last_press_time[1]) > debounce_delay) {
-                last_press_time[1] = xTaskGetTickCount();
-                ESP_LOGI(TAG, "Button an GPIO %d gedrückt!", GPIO_BUTTON_2);
-                s_button_state[1] = true;
-                if(s_callback[1] != NULL) {
-                    s_callback[1]();
-                }
-            }
+        if (xQueueReceive(s_edge_queue, &edge, timeout) == pdTRUE) {
+            GESTURE_input(&s_gesture, edge.button, edge.pressed, gpio_now_ms());
+            ESP_LOGD(TAG, "Button latency %lld us", esp_timer_get_time() - edge.time_us);
         }
-        // Prüfen auf steigende Flanke (Button losgelassen)
-        else if (last_button_state[1] == false && current_button_state[1] == true) {
-            if ((xTaskGetTickCount() - last_press_time[1]) > debounce_delay) {
-                last_press_time[1] = xTaskGetTickCount();
-                ESP_LOGI(TAG, "Button an GPIO %d losgelassen!", GPIO_BUTTON_2);
-                s_button_state[1] = false;
-            }
+        else {
+            GESTURE_tick(&s_gesture, gpio_now_ms());
         }
-
-        last_button_state[0] = current_button_state[0];
-        last_button_state[1] = current_button_state[1];
-        vTaskDelay(pdMS_TO_TICKS(20)); // Alle 20ms prüfen
     }
 }
 
-bool GPIO_get_button_set(void)
+void GPIO_button_init(void)
 {
-    return s_button_state[1];
+    gpio_config_t io_conf = {
+        // Interrupt on both edges, the debounce timer decides. Power save arms levels below
+#if CONFIG_CUBE_POWER_SAVE
+        .intr_type = GPIO_INTR_DISABLE,
+#else
+        .intr_type = GPIO_INTR_ANYEDGE,
+#endif
+        .pin_bit_mask = 0,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+    };
+
+    s_edge_queue = xQueueCreate(GPIO_QUEUE_LEN, sizeof(gpio_edge_t));
+    s_event_queue = xQueueCreate(GPIO_QUEUE_LEN, sizeof(gpio_button_event_t));
+    if (s_edge_queue == NULL || s_event_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create button queues");
+        return;
+    }
+
+    for (uint32_t i = 0; i < GPIO_BUTTON_COUNT; i++) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = gpio_debounce_timer_cb,
+            .arg = (void *)(uintptr_t)i,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "debounce",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_debounce_timer[i]));
+
+        io_conf.pin_bit_mask |= (1ULL << s_buttons[i].gpio);
+        s_gesture_config[i] = s_buttons[i].gesture;
+    }
+
+    GESTURE_init(&s_gesture, s_gesture_config, GPIO_BUTTON_COUNT, gpio_gesture_emit, NULL);
+
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+
+    // The ISR service may already be installed by another driver
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(ret);
+    }
+
+    for (uint32_t i = 0; i < GPIO_BUTTON_COUNT; i++) {
+        ESP_ERROR_CHECK(gpio_isr_handler_add(s_buttons[i].gpio, gpio_button_isr, (void *)(uintptr_t)i));
+#if CONFIG_CUBE_POWER_SAVE
+        // Released, a button held at boot fires at once like its edge would
+        gpio_arm_level(i, 1);
+#endif
+    }
+
+#if CONFIG_CUBE_POWER_SAVE
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#endif
+
+    xTaskCreate(gpio_button_task, "button_task", 2048, NULL, 10, NULL);
+
+    ESP_LOGI(TAG, "Button interrupts enabled");
 }
 
-bool GPIO_get_button_enter(void)
+bool GPIO_receive_event(gpio_button_event_t *event, TickType_t timeout)
 {
-    return s_button_state[0];
+    if (s_event_queue == NULL || event == NULL) {
+        return false;
+    }
+
+    return xQueueReceive(s_event_queue, event, timeout) == pdTRUE;
 }
 
-void GPIO_register_callback_button_set(gpio_callback_t callback)
+bool GPIO_get_button_set(void)
 {
-    s_callback[1] = callback;
+    return s_button_state[GPIO_BUTTON_SET];
 }
 
-void GPIO_register_callback_button_enter(gpio_callback_t callback)
+bool GPIO_get_button_enter(void)
 {
-    s_callback[0] = callback;
-}
\ No newline at end of file
+    return s_button_state[GPIO_BUTTON_ENTER];
+}
@@ -1,14 +1,33 @@
 #pragma once 
 
-extern void GPIO_configure_io(void);
-extern void GPIO_toggle_led(void);
-extern void GPIO_button_monitoring_task(void *pvParameter);
-extern bool GPIO_get_button_set(void);
-extern bool GPIO_get_button_enter(void);
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "gesture.h"
 
-// Callback function type definition
-typedef void (*gpio_callback_t)(void);
+typedef enum {
+    GPIO_BUTTON_ENTER = 0,  // GPIO 8
+    GPIO_BUTTON_SET,        // GPIO 10
+    GPIO_BUTTON_COUNT
+} gpio_button_t;
 
-// Function to register a callback
-extern void GPIO_register_callback_button_set(gpio_callback_t callback);
-extern void GPIO_register_callback_button_enter(gpio_callback_t callback);
\ No newline at end of file
+// Detected gesture, read with GPIO_receive_event()
+typedef struct {
+    uint8_t button;         // gpio_button_t
+    uint8_t gesture;        // gesture_type_t
+} gpio_button_event_t;
+
+/**
+ * @brief Enable the button edge interrupts and the gesture detection task
+ *
+ * Nothing polls the buttons, the CPU only wakes up on an edge or a pending
+ * long press, double click or repeat deadline. Timings are set per button
+ * in the table in gpio.c. With CONFIG_CUBE_POWER_SAVE the pins trigger on
+ * levels and wake the chip from automatic light sleep.
+ */
+extern void GPIO_button_init(void);
+extern bool GPIO_receive_event(gpio_button_event_t *event, TickType_t timeout);
+extern bool GPIO_get_button_set(void);
+extern bool GPIO_get_button_enter(void);
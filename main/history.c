@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "history.h"
+
+// Weight of a new sample in the exponential filter, RSSI distances jump by meters between frames
+#define HISTORY_FILTER_ALPHA    (0.25f)
+
+typedef struct {
+    uint16_t samples[HISTORY_LENGTH];   // Filtered distance in cm
+    uint32_t total;                     // Samples pushed, the newest one is at (total - 1) % HISTORY_LENGTH
+    float filtered;                     // Filter state in meters
+} history_peer_t;
+
+static history_peer_t s_peers[HISTORY_PEERS];
+
+void HISTORY_push(uint8_t peer, float distance_m)
+{
+    if (peer >= HISTORY_PEERS) {
+        return;
+    }
+
+    history_peer_t *p = &s_peers[peer];
+
+    if (p->total == 0) {
+        p->filtered = distance_m;
+    } else {
+        p->filtered += HISTORY_FILTER_ALPHA * (distance_m - p->filtered);
+    }
+
+    const float distance_cm = p->filtered * 100.0f;
+    uint16_t value = 0;
+    if (distance_cm > 0.0f) {
+        value = (distance_cm >= (float)UINT16_MAX) ? UINT16_MAX : (uint16_t)distance_cm;
+    }
+
+    p->samples[p->total % HISTORY_LENGTH] = value;
+    p->total++;
+}
+
+void HISTORY_reset(void)
+{
+    memset(s_peers, 0, sizeof(s_peers));
+}
+
+uint8_t HISTORY_get_peer_count(void)
+{
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < HISTORY_PEERS; i++) {
+        if (s_peers[i].total > 0) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+uint32_t HISTORY_get_total(uint8_t peer)
+{
+    return (peer < HISTORY_PEERS) ? s_peers[peer].total : 0;
+}
+
+bool HISTORY_get(uint8_t peer, uint32_t age, uint16_t *distance_cm)
+{
+    if (peer >= HISTORY_PEERS) {
+        return false;
+    }
+
+    const history_peer_t *p = &s_peers[peer];
+
+    if (age >= p->total || age >= HISTORY_LENGTH) {
+        return false;
+    }
+
+    *distance_cm = p->samples[(p->total - 1 - age) % HISTORY_LENGTH];
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// Fixed memory: CONFIG_CUBE_HISTORY_PEERS * CONFIG_CUBE_HISTORY_LENGTH * 2 bytes
+#define HISTORY_PEERS           (CONFIG_CUBE_HISTORY_PEERS)
+#define HISTORY_LENGTH          (CONFIG_CUBE_HISTORY_LENGTH)
+#define HISTORY_NO_PEER         (0xFF)
+
+/**
+ * @brief Filter a new distance of a peer and append it to the peer's ring buffer
+ *
+ * Only called from the UI task, the buffers need no locking.
+ *
+ * @param peer Peer slot, 0 .. HISTORY_PEERS - 1
+ * @param distance_m Raw distance in meters
+ */
+extern void HISTORY_push(uint8_t peer, float distance_m);
+extern void HISTORY_reset(void);
+
+// Number of peers with at least one sample
+extern uint8_t HISTORY_get_peer_count(void);
+
+// Samples pushed for a peer since the last reset, keeps counting after the buffer wrapped
+extern uint32_t HISTORY_get_total(uint8_t peer);
+
+/**
+ * @brief Read a filtered sample
+ *
+ * @param peer Peer slot
+ * @param age 0 is the newest sample
+ * @param distance_cm Filtered distance in centimeters
+ * @return true if the sample is still in the buffer
+ */
+extern bool HISTORY_get(uint8_t peer, uint32_t age, uint16_t *distance_cm);
@@ -0,0 +1,98 @@
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "bsp/esp-bsp.h"
+
+#include "lcd.h"
+#include "perf.h"
+
+// Strip height in lines, two of these buffers are allocated
+#define LCD_STRIP_LINES         (CONFIG_BSP_LCD_DRAW_BUF_HEIGHT)
+#define LCD_STRIP_PIXELS        (CONFIG_BSP_DISPLAY_WIDTH * LCD_STRIP_LINES)
+#define LCD_BYTES_PER_PIXEL     (2) // RGB565
+
+// Previous configuration: one full 128x128 frame buffer
+#define LCD_FULL_FRAME_BYTES    (CONFIG_BSP_DISPLAY_WIDTH * CONFIG_BSP_DISPLAY_HEIGHT * LCD_BYTES_PER_PIXEL)
+
+#define LCD_STATS_PERIOD_US     (10 * 1000 * 1000)
+
+static const char *TAG = "lcd";
+
+static int64_t s_render_start_us = 0;
+static int64_t s_stats_start_us = 0;
+static uint32_t s_frames = 0;
+static int64_t s_frame_time_sum_us = 0;
+static int64_t s_frame_time_max_us = 0;
+
+// Runs in the LVGL task, measures render start until the last strip is handed to SPI
+static void lcd_refr_event_cb(lv_event_t *e)
+{
+    const int64_t now = esp_timer_get_time();
+
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        s_render_start_us = now;
+        return;
+    }
+
+    // LV_EVENT_REFR_READY is also sent for refresh cycles that had nothing to draw
+    if (s_render_start_us == 0) {
+        return;
+    }
+
+    const int64_t frame_time_us = now - s_render_start_us;
+    s_render_start_us = 0;
+
+    if (s_stats_start_us == 0) {
+        // Boot-time effect of font and draw buffer changes shows up here
+        ESP_LOGI(TAG, "First frame ready %lld ms after boot", now / 1000);
+        s_stats_start_us = now;
+    }
+
+    s_frames++;
+    s_frame_time_sum_us += frame_time_us;
+    if (frame_time_us > s_frame_time_max_us) {
+        s_frame_time_max_us = frame_time_us;
+    }
+
+    if ((now - s_stats_start_us) >= LCD_STATS_PERIOD_US) {
+        ESP_LOGI(TAG, "%lu frames, frame time avg %lld us, max %lld us",
+                 (unsigned long)s_frames, s_frame_time_sum_us / s_frames, s_frame_time_max_us);
+        s_stats_start_us = now;
+        s_frames = 0;
+        s_frame_time_sum_us = 0;
+        s_frame_time_max_us = 0;
+    }
+}
+
+lv_display_t *LCD_start(void)
+{
+    const bsp_display_cfg_t cfg = {
+        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
+        .buffer_size = LCD_STRIP_PIXELS,
+        .double_buffer = true,
+        .flags = {
+            .buff_dma = true,
+            .buff_spiram = false,
+        },
+    };
+
+    lv_display_t *disp = bsp_display_start_with_config(&cfg);
+    if (disp == NULL) {
+        return NULL;
+    }
+
+    const uint32_t buffer_bytes = 2 * LCD_STRIP_PIXELS * LCD_BYTES_PER_PIXEL;
+    ESP_LOGI(TAG, "2 x %d line strip buffers: %lu bytes DMA RAM, %ld bytes saved against a full frame buffer",
+             LCD_STRIP_LINES, (unsigned long)buffer_bytes, (long)LCD_FULL_FRAME_BYTES - (long)buffer_bytes);
+
+    bsp_display_lock(0);
+    lv_display_add_event_cb(disp, lcd_refr_event_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(disp, lcd_refr_event_cb, LV_EVENT_REFR_READY, NULL);
+    PERF_init(disp);
+    bsp_display_unlock();
+
+    return disp;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "lvgl.h"
+
+/**
+ * @brief Start the ST7735 with two DMA-capable strip buffers
+ *
+ * LVGL renders the next strip into one buffer while the previous strip
+ * is still being sent over SPI from the other one.
+ *
+ * @return lv_display_t* Display handle, NULL on failure
+ */
+extern lv_display_t *LCD_start(void);
@@ -0,0 +1,227 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_LED_STRIP
+#include "led_strip.h"
+#endif
+
+#include "linkmon.h"
+#include "led.h"
+
+// Patterns are 20 steps of 100 ms, bit 0 is played first
+#define LED_STEP_US             (100 * 1000)
+#define LED_PATTERN_STEPS       (20)
+
+#define LED_PATTERN_NONE        (0x00000u)
+#define LED_PATTERN_DOUBLE      (0x00005u)  // Two short flashes per 2 s
+#define LED_PATTERN_SLOW        (0x003FFu)  // 1 s on, 1 s off
+#define LED_PATTERN_FAST        (0x55555u)  // 5 Hz
+#define LED_PATTERN_ERROR       (0x33333u)  // 2.5 Hz with longer pulses
+#define LED_PATTERN_ALARM       (0xFFFFFu)  // Steady on
+
+typedef struct {
+    uint32_t pattern;
+    uint32_t color;             // 0xRRGGBB, only used by the LED strip
+} led_pattern_t;
+
+static const char *TAG = "led";
+
+static volatile uint32_t s_state = LED_STATE_IDLE;
+static volatile bool s_alarm = false;
+static esp_timer_handle_t s_timer = NULL;
+
+// Only used by the timer callback
+static led_pattern_t s_pattern = { LED_PATTERN_NONE, 0 };
+static int64_t s_pattern_start_us = 0;     // Step 0 of the current pattern
+static int64_t s_flash_end_us = 0;         // A packet inverts the blinking pattern until then
+static bool s_toggle = false;              // Packet toggle of the steady patterns
+static uint32_t s_last_heartbeats = 0;
+static bool s_written_on = false;
+static uint32_t s_written_color = 0;
+
+#if CONFIG_CUBE_LED_STRIP
+static led_strip_handle_t s_strip = NULL;
+#endif
+
+static void led_write(bool on, uint32_t color)
+{
+    if (on == s_written_on && (!on || color == s_written_color)) {
+        return;
+    }
+    s_written_on = on;
+    s_written_color = color;
+
+#if CONFIG_CUBE_LED_STRIP
+    if (on) {
+        led_strip_set_pixel(s_strip, 0, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+        led_strip_refresh(s_strip);
+    } else {
+        led_strip_clear(s_strip);
+    }
+#else
+    (void)color;
+    gpio_set_level(CONFIG_CUBE_LED_GPIO, on);
+#endif
+}
+
+static led_pattern_t led_get_pattern(led_state_t state)
+{
+    switch (state) {
+        case LED_STATE_CALIBRATION:
+            return (led_pattern_t){ LED_PATTERN_FAST, 0xFFFFFF };
+        case LED_STATE_ERROR:
+            return (led_pattern_t){ LED_PATTERN_ERROR, 0xFF0000 };
+        case LED_STATE_RUNNING:
+            if (s_alarm) {
+                return (led_pattern_t){ LED_PATTERN_ALARM, 0xFF0000 };
+            }
+            break;
+        default:
+            return (led_pattern_t){ LED_PATTERN_NONE, 0 };
+    }
+
+    // Same link state as the LED in the gauge
+    switch (LINKMON_get_summary()) {
+        case LINKMON_STATE_ALIVE:
+            return (led_pattern_t){ LED_PATTERN_NONE, 0x0000FF };   // Packet toggles only
+        case LINKMON_STATE_DEGRADED:
+            return (led_pattern_t){ LED_PATTERN_DOUBLE, 0xFFFF00 };
+        default:
+            return (led_pattern_t){ LED_PATTERN_SLOW, 0xFF0000 };
+    }
+}
+
+static bool led_is_steady(uint32_t pattern)
+{
+    return pattern == LED_PATTERN_NONE || pattern == LED_PATTERN_ALARM;
+}
+
+static bool led_get_bit(uint32_t pattern, int64_t step)
+{
+    return (pattern >> (step % LED_PATTERN_STEPS)) & 1u;
+}
+
+// Time of the next step whose bit differs from the current one, 0 if the pattern never changes
+static int64_t led_next_edge(int64_t step)
+{
+    const bool current = led_get_bit(s_pattern.pattern, step);
+
+    for (int64_t next = step + 1; next < step + LED_PATTERN_STEPS; next++) {
+        if (led_get_bit(s_pattern.pattern, next) != current) {
+            return s_pattern_start_us + next * LED_STEP_US;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Runs in the esp_timer task, as a one-shot at the next edge of the pattern or
+ * right away when the state, the alarm, the link state or the packets changed.
+ * Steady patterns arm no timer at all.
+ */
+static void led_timer_cb(void *arg)
+{
+    const int64_t now_us = esp_timer_get_time();
+    const led_pattern_t p = led_get_pattern((led_state_t)s_state);
+
+    if (p.pattern != s_pattern.pattern || p.color != s_pattern.color) {
+        s_pattern = p;
+        s_pattern_start_us = now_us;
+        s_flash_end_us = 0;
+        s_toggle = false;
+    }
+
+    // Steady patterns toggle on every packet like the LED in the gauge, blinking ones invert for one step
+    const uint32_t heartbeats = LINKMON_get_heartbeats();
+    if (s_state == LED_STATE_RUNNING && !s_alarm && heartbeats != s_last_heartbeats) {
+        if (led_is_steady(p.pattern)) {
+            s_toggle = !s_toggle;
+        } else {
+            s_flash_end_us = now_us + LED_STEP_US;
+        }
+    }
+    s_last_heartbeats = heartbeats;
+
+    const int64_t step = (now_us - s_pattern_start_us) / LED_STEP_US;
+    const bool flash = (s_flash_end_us > now_us);
+    led_write(led_get_bit(p.pattern, step) ^ flash ^ s_toggle, p.color);
+
+    int64_t next_us = led_is_steady(p.pattern) ? 0 : led_next_edge(step);
+    if (flash && (next_us == 0 || s_flash_end_us < next_us)) {
+        next_us = s_flash_end_us;
+    }
+    if (next_us != 0) {
+        esp_timer_start_once(s_timer, (uint64_t)(next_us - now_us));
+    }
+}
+
+// Evaluates the pattern from the esp_timer task, so only that task writes the LED
+static void led_kick(void)
+{
+    if (s_timer == NULL) {
+        return;
+    }
+
+    esp_timer_stop(s_timer);
+    esp_timer_start_once(s_timer, 0);
+}
+
+void LED_init(void)
+{
+#if CONFIG_CUBE_LED_STRIP
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = CONFIG_CUBE_LED_GPIO,
+        .max_leds = 1,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .resolution_hz = 10 * 1000 * 1000,
+    };
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &s_strip));
+    led_strip_clear(s_strip);
+#else
+    gpio_reset_pin(CONFIG_CUBE_LED_GPIO);
+    /* Set the GPIO as a push/pull output */
+    gpio_set_direction(CONFIG_CUBE_LED_GPIO, GPIO_MODE_OUTPUT);
+    gpio_set_level(CONFIG_CUBE_LED_GPIO, 0);
+#endif
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = led_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+
+    ESP_LOGI(TAG, "Status LED on GPIO %d", CONFIG_CUBE_LED_GPIO);
+}
+
+void LED_set_state(led_state_t state)
+{
+    if (state == (led_state_t)s_state) {
+        return;
+    }
+
+    s_state = state;
+    led_kick();
+}
+
+void LED_set_alarm(bool alarm)
+{
+    if (alarm == s_alarm) {
+        return;
+    }
+
+    s_alarm = alarm;
+    led_kick();
+}
+
+void LED_update(void)
+{
+    led_kick();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+
+// What the status LED shows, the pattern is chosen by the LED timer
+typedef enum {
+    LED_STATE_IDLE = 0,         // No radio role, LED off and timer stopped
+    LED_STATE_RUNNING,          // Pattern follows the link state, each new packet flashes
+    LED_STATE_CALIBRATION,      // Fast blink while waiting for Apply
+    LED_STATE_ERROR,            // Radio role failed to start
+} led_state_t;
+
+/**
+ * @brief Configure the status LED and the pattern timer
+ *
+ * Drives a plain GPIO LED, or a WS2812 through RMT with CONFIG_CUBE_LED_STRIP.
+ */
+extern void LED_init(void);
+
+/**
+ * @brief Select the pattern
+ *
+ * The LED timer is a one-shot armed for the next edge of a blinking pattern.
+ * Steady patterns, including the running state with a live link, arm nothing.
+ */
+extern void LED_set_state(led_state_t state);
+
+/**
+ * @brief Proximity alarm, shown as steady red while the role runs
+ *
+ * Packets do not flash the LED while the alarm is on.
+ */
+extern void LED_set_alarm(bool alarm);
+
+/**
+ * @brief Show new packets and link state changes, called by the UI task
+ *
+ * The LED compares the heartbeat count of the link monitor, so the ESP-NOW and
+ * FTM callbacks do no GPIO work. With a live link each packet toggles the LED,
+ * like the LED in the gauge, otherwise it inverts the pattern for one step.
+ */
+extern void LED_update(void);
@@ -0,0 +1,265 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "linkmon.h"
+
+// A link is degraded after 2.5 missed intervals and lost after 8
+#define LINKMON_DEGRADED_NUM        (5)
+#define LINKMON_DEGRADED_DEN        (2)
+#define LINKMON_LOST_FACTOR         (8)
+#define LINKMON_MIN_INTERVAL_US     (100 * 1000)
+#define LINKMON_MAX_INTERVAL_US     (30 * 1000 * 1000)
+
+// Weight of a new interval sample is 1 / 2^LINKMON_INTERVAL_SHIFT
+#define LINKMON_INTERVAL_SHIFT      (3)
+
+#define LINKMON_ENTRIES             (LINKMON_SOURCE_COUNT * LINKMON_PEERS)
+
+typedef struct {
+    int64_t last_us;                // 0 until the first heartbeat
+    uint32_t interval_us;           // Filtered interval, nominal until two heartbeats were seen
+    uint8_t state;                  // linkmon_state_t, only written by the timer
+} linkmon_entry_t;
+
+static const char *TAG = "linkmon";
+
+// Expected interval before one was observed: the sender period, the FTM measurement period and the batch period
+static const uint32_t s_nominal_interval_us[LINKMON_SOURCE_COUNT] = {
+    [LINKMON_SOURCE_ESPNOW_RX]     = CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000,
+    [LINKMON_SOURCE_ESPNOW_TX_ACK] = CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000,
+    [LINKMON_SOURCE_FTM_REPORT]    = 3000 * 1000,
+    [LINKMON_SOURCE_REPORT_RX]     = CONFIG_CUBE_REPORT_BATCH_MS * 1000,
+};
+
+static linkmon_entry_t s_entries[LINKMON_ENTRIES];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_timer = NULL;
+static linkmon_event_cb_t s_event_cb = NULL;
+static volatile uint8_t s_summary = LINKMON_STATE_NONE;
+static volatile uint32_t s_heartbeats = 0;
+static bool s_kicked = true;        // A check is due now, or the monitor is stopped
+
+// Startup latency, time of the first heartbeat since boot, kept across role switches
+static int64_t s_first_us = 0;
+static uint8_t s_first_source = 0;
+static bool s_first_reported = false;
+
+static inline linkmon_entry_t *linkmon_get_entry(uint8_t source, uint8_t peer)
+{
+    return &s_entries[source * LINKMON_PEERS + peer];
+}
+
+static int64_t linkmon_lost_after_us(const linkmon_entry_t *e)
+{
+    return (int64_t)e->interval_us * LINKMON_LOST_FACTOR;
+}
+
+static int64_t linkmon_degraded_after_us(const linkmon_entry_t *e)
+{
+    return (int64_t)e->interval_us * LINKMON_DEGRADED_NUM / LINKMON_DEGRADED_DEN;
+}
+
+static linkmon_state_t linkmon_eval(const linkmon_entry_t *e, int64_t now_us)
+{
+    if (e->last_us == 0) {
+        return LINKMON_STATE_NONE;
+    }
+
+    const int64_t age_us = now_us - e->last_us;
+
+    if (age_us >= linkmon_lost_after_us(e)) {
+        return LINKMON_STATE_LOST;
+    }
+    if (age_us >= linkmon_degraded_after_us(e)) {
+        return LINKMON_STATE_DEGRADED;
+    }
+    return LINKMON_STATE_ALIVE;
+}
+
+// When the entry changes its state if nothing is heard, 0 never. Only a heartbeat ends NONE and LOST
+static int64_t linkmon_due_us(const linkmon_entry_t *e)
+{
+    switch (e->state) {
+    case LINKMON_STATE_ALIVE:
+        return e->last_us + linkmon_degraded_after_us(e);
+    case LINKMON_STATE_DEGRADED:
+        return e->last_us + linkmon_lost_after_us(e);
+    default:
+        return 0;
+    }
+}
+
+static void linkmon_reset_entries(bool running)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (uint8_t source = 0; source < LINKMON_SOURCE_COUNT; source++) {
+        for (uint8_t peer = 0; peer < LINKMON_PEERS; peer++) {
+            linkmon_entry_t *e = linkmon_get_entry(source, peer);
+            e->last_us = 0;
+            e->interval_us = s_nominal_interval_us[source];
+            e->state = LINKMON_STATE_NONE;
+        }
+    }
+    s_summary = LINKMON_STATE_NONE;
+    s_heartbeats = 0;
+    s_kicked = !running;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// The only place where states change, so every transition is reported exactly once.
+// One-shot, armed for the next deadline of any entry, so a quiet or steady link does
+// not wake the CPU every few hundred ms in light sleep.
+static void linkmon_timer_cb(void *arg)
+{
+    linkmon_event_t events[LINKMON_ENTRIES];
+    uint8_t count = 0;
+    uint8_t summary = LINKMON_STATE_NONE;
+    int64_t next_us = 0;
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    s_kicked = false;
+    for (uint8_t source = 0; source < LINKMON_SOURCE_COUNT; source++) {
+        for (uint8_t peer = 0; peer < LINKMON_PEERS; peer++) {
+            linkmon_entry_t *e = linkmon_get_entry(source, peer);
+            const linkmon_state_t state = linkmon_eval(e, now_us);
+
+            if (state != e->state) {
+                e->state = state;
+                events[count++] = (linkmon_event_t){
+                    .source = source,
+                    .peer = peer,
+                    .state = state,
+                    .interval_ms = e->interval_us / 1000,
+                };
+            }
+            if (state > summary) {
+                summary = state;
+            }
+
+            const int64_t due_us = linkmon_due_us(e);
+            if (due_us != 0 && (next_us == 0 || due_us < next_us)) {
+                next_us = due_us;
+            }
+        }
+    }
+    s_summary = summary;
+    const int64_t first_us = s_first_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    // A heartbeat may have kicked the timer meanwhile, that check comes first anyway
+    if (next_us != 0 && !esp_timer_is_active(s_timer)) {
+        esp_timer_start_once(s_timer, next_us - now_us);
+    }
+
+    if (first_us != 0 && !s_first_reported) {
+        s_first_reported = true;
+        ESP_LOGI(TAG, "Boot to first measurement: %lld ms (source %d)", first_us / 1000, s_first_source);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "Source %d peer %d: state %d (interval %lu ms)", events[i].source, events[i].peer,
+                 events[i].state, (unsigned long)events[i].interval_ms);
+        if (s_event_cb != NULL) {
+            s_event_cb(&events[i]);
+        }
+    }
+}
+
+void LINKMON_init(linkmon_event_cb_t cb)
+{
+    s_event_cb = cb;
+    linkmon_reset_entries(false);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = linkmon_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "linkmon",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+}
+
+// The timer is armed by the first heartbeat
+void LINKMON_start(void)
+{
+    linkmon_reset_entries(s_timer != NULL);
+}
+
+void LINKMON_stop(void)
+{
+    // The next role starts without a link, late heartbeats no longer arm the timer
+    linkmon_reset_entries(false);
+
+    if (s_timer != NULL && esp_timer_is_active(s_timer)) {
+        esp_timer_stop(s_timer);
+    }
+}
+
+void LINKMON_heartbeat(linkmon_source_t source, uint8_t peer)
+{
+    if (source >= LINKMON_SOURCE_COUNT || peer >= LINKMON_PEERS) {
+        return;
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    linkmon_entry_t *e = linkmon_get_entry(source, peer);
+
+    if (e->last_us != 0) {
+        const int64_t gap_us = now_us - e->last_us;
+
+        // A gap after a loss says nothing about the send rate
+        if (gap_us < linkmon_lost_after_us(e)) {
+            uint32_t sample = (uint32_t)gap_us;
+            if (sample < LINKMON_MIN_INTERVAL_US) {
+                sample = LINKMON_MIN_INTERVAL_US;
+            } else if (sample > LINKMON_MAX_INTERVAL_US) {
+                sample = LINKMON_MAX_INTERVAL_US;
+            }
+            e->interval_us = e->interval_us - (e->interval_us >> LINKMON_INTERVAL_SHIFT)
+                             + (sample >> LINKMON_INTERVAL_SHIFT);
+        }
+    }
+
+    e->last_us = now_us;
+    s_heartbeats++;
+    if (s_first_us == 0) {
+        s_first_us = now_us;
+        s_first_source = (uint8_t)source;
+    }
+
+    // A link that is not alive yet is reported at once, an alive one needs no check
+    const bool kick = (e->state != LINKMON_STATE_ALIVE) && !s_kicked;
+    s_kicked |= kick;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (kick) {
+        esp_timer_stop(s_timer);
+        esp_timer_start_once(s_timer, 0);
+    }
+}
+
+linkmon_state_t LINKMON_get_state(linkmon_source_t source, uint8_t peer)
+{
+    if (source >= LINKMON_SOURCE_COUNT || peer >= LINKMON_PEERS) {
+        return LINKMON_STATE_NONE;
+    }
+
+    return (linkmon_state_t)linkmon_get_entry(source, peer)->state;
+}
+
+linkmon_state_t LINKMON_get_summary(void)
+{
+    return (linkmon_state_t)s_summary;
+}
+
+uint32_t LINKMON_get_heartbeats(void)
+{
+    return s_heartbeats;
+}
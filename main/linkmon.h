@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// One entry per source and peer slot, the slots are the same as in history.c
+#define LINKMON_PEERS           (CONFIG_CUBE_HISTORY_PEERS)
+
+typedef enum {
+    LINKMON_SOURCE_ESPNOW_RX = 0,   // Frame received from a sender
+    LINKMON_SOURCE_ESPNOW_TX_ACK,   // Own frame acknowledged
+    LINKMON_SOURCE_FTM_REPORT,      // FTM session finished
+    LINKMON_SOURCE_REPORT_RX,       // Range batch of a receiver arrived at the collector
+    LINKMON_SOURCE_COUNT
+} linkmon_source_t;
+
+// Ordered from worst to best, the summary is the maximum
+typedef enum {
+    LINKMON_STATE_NONE = 0,         // Never heard since the role started
+    LINKMON_STATE_LOST,
+    LINKMON_STATE_DEGRADED,         // Some heartbeats missed
+    LINKMON_STATE_ALIVE,
+} linkmon_state_t;
+
+typedef struct {
+    uint8_t source;                 // linkmon_source_t
+    uint8_t peer;
+    uint8_t state;                  // linkmon_state_t, the new state
+    uint32_t interval_ms;           // Observed heartbeat interval of this entry
+} linkmon_event_t;
+
+// Runs in the esp_timer task, must not block
+typedef void (*linkmon_event_cb_t)(const linkmon_event_t *event);
+
+/**
+ * @brief Create the monitor timer, it only runs between LINKMON_start() and LINKMON_stop()
+ *
+ * @param cb Called on every state change of an entry, may be NULL
+ */
+extern void LINKMON_init(linkmon_event_cb_t cb);
+
+// Forget all entries and start checking, called when a radio role starts
+extern void LINKMON_start(void);
+extern void LINKMON_stop(void);
+
+/**
+ * @brief Record a heartbeat, safe to call from the Wi-Fi task
+ *
+ * Only stores the time and updates the interval estimate. State changes are
+ * detected and reported by the monitor timer. It runs when an entry is due to
+ * degrade or to be lost, and right after a heartbeat of a link that was not
+ * alive, never periodically.
+ *
+ * @param source What was heard
+ * @param peer Peer slot, heartbeats of untracked peers are ignored
+ */
+extern void LINKMON_heartbeat(linkmon_source_t source, uint8_t peer);
+
+extern linkmon_state_t LINKMON_get_state(linkmon_source_t source, uint8_t peer);
+
+// Best state of all entries, what the UI and the status LED show
+extern linkmon_state_t LINKMON_get_summary(void);
+
+// Heartbeats since the role started, a change means a new packet
+extern uint32_t LINKMON_get_heartbeats(void);
@@ -13,10 +13,8 @@
 #include "freertos/task.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
-#include "led_strip.h"
 #include "sdkconfig.h"
 #include "esp_lvgl_port.h"
-#include "nvs_flash.h"
 #include "esp_now.h"
 #include "esp_wifi.h"
 #include "esp_mac.h" // Für ESP_MAC_ADDR_LEN
@@ -24,51 +22,48 @@
 
 #include "bsp/esp-bsp.h"
 #include "gpio.h"
-#include "common.h"
-#include "EspNowSender.h"
+#include "lcd.h"
+#include "ui.h"
+#include "linkmon.h"
 #include "EspNowReceiver.h"
-#include "FtmResponder.h"
-#include "EspNowCommon.h"
-#include "FtmCommon.h"
 #include "FtmClient.h"
+#include "UiUpdate.h"
+#include "history.h"
+#include "radio.h"
+#include "led.h"
+#include "power.h"
+#include "trace.h"
+#include "diag.h"
+#include "csi.h"
+#include "proximity.h"
+#include "fingerprint.h"
+#include "settings.h"
 
 static const char *TAG = "main";
 
-typedef enum {
-    EspNowSender,
-    EspNowReceiver,
-    FtmClient,
-    FtmResponder
-} DeviceMode_t;
-
-/* Global structure to hold all LVGL objects */
+/* Latest radio data as seen by the UI, merged from the update queue */
 typedef struct {
-    /* Screen 0 objects */
-    lv_obj_t *label_selection;
-    lv_obj_t *btn_set;
-    lv_obj_t *label_set;
-    lv_obj_t *btn_enter;
-    lv_obj_t *label_enter;
-    
-    /* Screen 1 objects */
-    lv_obj_t *label_value;
-    lv_obj_t *arc;
-    lv_obj_t *led;
-} lvgl_objects_t;
+    int16_t rssi;
+    float distance;
+    bool valid;
+} ui_radio_state_t;
 
-typedef struct {
-    /* Screen 0 objects */
-    lv_timer_t *screen_0_selection;
-    
-    /* Screen 1 objects */
-    lv_timer_t *screen_1_label;
-    lv_timer_t *screen_1_led;
-    lv_timer_t *screen_1_arc;
-    lv_timer_t *screen_1_calib;
-} lvgl_timers_t;
-
-static lvgl_objects_t g_lvgl_objects = {0};
-static lvgl_timers_t g_lvgl_timers = {0};
+#define UI_UPDATE_TASK_STACK_SIZE   3072
+#define UI_UPDATE_TASK_PRIORITY     4
+
+#define FTM_MEASURE_PERIOD_MS       3000
+
+// Time on the selection screen before the remembered role starts, -1 never
+#if CONFIG_CUBE_AUTOSTART
+#define APP_AUTOSTART_MS            (CONFIG_CUBE_AUTOSTART_S * 1000)
+#else
+#define APP_AUTOSTART_MS            (-1)
+#endif
+
+static ui_radio_state_t s_ui_radio = {0};
+
+/* Set from the stop of a role until the next starts, frames still queued must not refill the radio data */
+static bool s_ui_radio_stopped = false;
 
 /* Mutex for thread safety */
 static SemaphoreHandle_t g_lvgl_mutex = NULL;
@@ -76,8 +71,15 @@ static SemaphoreHandle_t g_lvgl_mutex = NULL;
 static bool s_globSelectionDone = false;
 static DeviceMode_t s_globDeviceMode = EspNowReceiver;
 static uint8_t s_globCalibStep = 0u;
+static bool s_globHistoryView = false;
+static uint8_t s_globHistoryPeer = 0u;
+static bool s_globDiagView = false;
+
+/* Latest diagnostics, only written by the UI task */
+static diag_snapshot_t s_ui_diag = {0};
 
-void button_pressed_set(void) {
+/* Set steps through the modes and peers, holding it repeats */
+static void button_pressed_set(bool repeat) {
     if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
         if( s_globSelectionDone == false ) {
             // Cycle through modes
@@ -92,406 +94,312 @@ void button_pressed_set(void) {
                     s_globDeviceMode = FtmResponder;
                     break;
                 case FtmResponder:
+                    s_globDeviceMode = Collector;
+                    break;
+                case Collector:
                     s_globDeviceMode = EspNowReceiver;
                     break;
             }
         }
-        else {
-            if( s_globCalibStep == 0 ) {
-                if(lv_timer_get_paused(g_lvgl_timers.screen_1_calib)) {
-                    lv_timer_resume(g_lvgl_timers.screen_1_calib);
-                }
-            }
+        else if( s_globHistoryView ) {
+            // Next peer, the UI wraps it around the number of peers heard so far
+            s_globHistoryPeer++;
+        }
+        else if( !repeat ) {
+#if CONFIG_CUBE_FINGERPRINT_RECORD
+            // Survey builds record the next spot instead of calibrating
+            FINGERPRINT_record_spot();
+#else
             s_globCalibStep ^= 1;
+#endif
         }
         xSemaphoreGive(g_lvgl_mutex);
     }
+
+    UIUPDATE_post(UI_UPDATE_INPUT, HISTORY_NO_PEER, 0, 0.0f);
 }
 
-void button_pressed_enter(void) {
+static void button_pressed_enter(void) {
     if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
-        s_globSelectionDone = true;
-
-        if( s_globCalibStep == 1 ) {
+        if( s_globSelectionDone == false ) {
+            s_globSelectionDone = true;
+        }
+        else if( s_globCalibStep == 1 ) {
             RECEIVER_setRssiAt1Meter();
             s_globCalibStep = 0;
         }
+        else if( s_globHistoryView == false ) {
+            s_globHistoryView = true;
+        }
+#if CONFIG_CUBE_DIAG
+        else if( s_globDiagView == false ) {
+            s_globDiagView = true;
+        }
+#endif
+        else {
+            // Back to the mode selection, app_main stops the radio
+            s_globHistoryView = false;
+            s_globDiagView = false;
+            s_globSelectionDone = false;
+        }
 
         xSemaphoreGive(g_lvgl_mutex);
     }
+
+    UIUPDATE_post(UI_UPDATE_INPUT, HISTORY_NO_PEER, 0, 0.0f);
 }
 
-void lv_screen_timer_arc(lv_timer_t* timer)
-{
-    /*Use the user_data*/
-    lv_obj_t* user = lv_timer_get_user_data(timer);
-    
-    if (user == NULL) {
-        return;
+/* Holding Enter leaves any screen for the mode selection */
+static void button_long_pressed_enter(void) {
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        s_globCalibStep = 0;
+        s_globHistoryView = false;
+        s_globDiagView = false;
+        s_globSelectionDone = false;
+        xSemaphoreGive(g_lvgl_mutex);
     }
 
-    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
-        if( s_globDeviceMode == EspNowReceiver ) {
-            if( s_globCalibStep == 0 ) {
-                lv_obj_remove_flag(user, LV_OBJ_FLAG_HIDDEN);
-                lv_arc_set_value(user, (int32_t)RECEIVER_getDistance());
-            }
-            else {
-                lv_obj_add_flag(user, LV_OBJ_FLAG_HIDDEN);
-            }
+    UIUPDATE_post(UI_UPDATE_INPUT, HISTORY_NO_PEER, 0, 0.0f);
+}
+
+static void app_handle_button(const gpio_button_event_t *event)
+{
+    if (event->button == GPIO_BUTTON_SET) {
+        if (event->gesture == GESTURE_PRESS || event->gesture == GESTURE_REPEAT) {
+            button_pressed_set(event->gesture == GESTURE_REPEAT);
         }
-        else if( s_globDeviceMode == FtmClient ) {
-            lv_obj_remove_flag(user, LV_OBJ_FLAG_HIDDEN);
-            lv_arc_set_value(user, (int32_t)FTMCOMMON_getDistance());
+    }
+    else if (event->button == GPIO_BUTTON_ENTER) {
+        // Enter has a long press, so a short press is only known on release
+        if (event->gesture == GESTURE_CLICK) {
+            button_pressed_enter();
         }
-        else {
-            int32_t value = 50.0 * cos((2.0*3.184*xTaskGetTickCount())/400.0);
-            value += 50;
-            lv_arc_set_value(user, value);
+        else if (event->gesture == GESTURE_LONG_PRESS) {
+            button_long_pressed_enter();
         }
-        xSemaphoreGive(g_lvgl_mutex);
     }
 }
 
-void lv_screen_timer_led(lv_timer_t* timer)
+/* Link monitor timer, the UI reads the summary state when it redraws */
+static void app_link_event(const linkmon_event_t *event)
 {
-    /*Use the user_data*/
-    lv_obj_t* user = lv_timer_get_user_data(timer);
-    
-    if (user == NULL) {
-        return;
-    }
+    UIUPDATE_post(UI_UPDATE_LINK, event->peer, 0, 0.0f);
+}
 
-    if( s_globCalibStep == 0 ) {
-        lv_obj_remove_flag(user, LV_OBJ_FLAG_HIDDEN);
+/* Proximity task, the alarm is on while any peer is in the immediate zone */
+static void app_zone_event(const proximity_event_t *event, void *ctx)
+{
+    uint8_t peer;
 
-        lv_led_toggle(user);
+    LED_set_alarm(PROXIMITY_get_nearest(&peer) == ZONE_IMMEDIATE);
+    UIUPDATE_post(UI_UPDATE_ZONE, event->peer, 0, event->distance_cm / 100.0f);
+}
 
-        int64_t time_ms = (esp_timer_get_time() - COMMON_get_time_of_last_callback()) / 1000;
+/* Radio data of a queued message, under g_lvgl_mutex so that a role stop cannot interleave */
+static uint32_t ui_merge_radio(const ui_update_msg_t *msg)
+{
+    uint32_t dirty = 0;
 
-        if( time_ms < 2000 ) {
-            lv_led_set_color(user, lv_color_hex(0x0000FF));
-        } else if ( time_ms < 4000 ) {
-            lv_led_set_color(user, lv_palette_main(LV_PALETTE_YELLOW));
-        } else if ( time_ms < 8000 ) {
-            lv_led_set_color(user, lv_palette_main(LV_PALETTE_ORANGE));
-        } else {
-            lv_led_set_color(user, lv_palette_main(LV_PALETTE_RED));
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        if (!s_ui_radio_stopped) {
+            if (msg->type == UI_UPDATE_ESPNOW_RX) {
+                s_ui_radio.rssi = msg->rssi;
+            }
+            s_ui_radio.distance = msg->distance_cm / 100.0f;
+            s_ui_radio.valid = true;
+            HISTORY_push(msg->peer, s_ui_radio.distance);
+            dirty = UI_DIRTY_RADIO;
         }
+        xSemaphoreGive(g_lvgl_mutex);
     }
-    else {
-        lv_obj_add_flag(user, LV_OBJ_FLAG_HIDDEN);
+
+    return dirty;
+}
+
+/* Merge one queued message into the UI state, returns the dirty flags */
+static uint32_t ui_merge_update(const ui_update_msg_t *msg)
+{
+    switch (msg->type) {
+        case UI_UPDATE_ESPNOW_RX:
+        case UI_UPDATE_FTM_REPORT:
+            return ui_merge_radio(msg);
+        case UI_UPDATE_ESPNOW_TX_ACK:
+            return UI_DIRTY_RADIO;
+        case UI_UPDATE_INPUT:
+            return UI_DIRTY_INPUT;
+        case UI_UPDATE_LINK:
+            return UI_DIRTY_LINK;
+        case UI_UPDATE_ZONE:
+            return UI_DIRTY_ZONE;
+        case UI_UPDATE_DIAG:
+            DIAG_get_snapshot(&s_ui_diag);
+            return UI_DIRTY_DIAG;
+        default:
+            return 0;
     }
 }
 
-void lv_screen_timer_label(lv_timer_t* timer)
+/* Peer that approaches most urgently: closing fast before closing, then the shortest time to contact */
+static void app_get_approach(ui_model_t *model)
 {
-    /*Use the user_data*/
-    lv_obj_t* user = lv_timer_get_user_data(timer);
-    
-    if (user == NULL) {
+    const int64_t now_us = esp_timer_get_time();
+    approach_result_t result;
+
+    memset(&model->approach, 0, sizeof(model->approach));
+    model->approach_peer = HISTORY_NO_PEER;
+
+    if (s_globDeviceMode != EspNowReceiver) {
         return;
     }
 
-    int64_t time_ms = (esp_timer_get_time() - COMMON_get_time_of_last_callback()) / 1000;
-
-    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
-        if( COMMON_get_time_of_last_callback() > 0 ) {
-            if( time_ms < 2000 ) {
-                if( s_globDeviceMode == EspNowReceiver ) {
-                    const float distance = RECEIVER_getDistance();
-                    const int16_t rssi = RECEIVER_getRSSI();
-
-                    if( s_globCalibStep == 0 ) {
-                        char distance_str[32];
-                        snprintf(distance_str, sizeof(distance_str), "< %.0fm (RSSI: %d)", ceilf(distance), rssi);
-                        lv_obj_set_style_text_font(user, &lv_font_montserrat_12, 0);
-                        lv_obj_align(user, LV_ALIGN_BOTTOM_MID, 0, 0);
-                        lv_label_set_text(user, distance_str);
-                    }
-                    else {
-                        char distance_str[64];
-                        snprintf(distance_str, sizeof(distance_str), "Press Apply at exactly 1m. (RSSI: %d)", rssi);
-                        lv_obj_set_style_text_font(user, &lv_font_montserrat_14, 0);
-                        lv_obj_align(user, LV_ALIGN_CENTER, 0, 0);
-                        lv_label_set_text(user, distance_str);
-                    }
-                }
-                else {
-                    lv_label_set_text(user, "Broadcasting...");
-                }
-            } else if ( time_ms < 10000 ) {
-                lv_label_set_text(user, "Waiting...");
-            } else {
-                lv_label_set_text(user, "No connection!");
-            }
+    for (uint8_t peer = 0; peer < HISTORY_PEERS; peer++) {
+        RECEIVER_get_approach(peer, now_us, &result);
+        if (result.state < APPROACH_CLOSING) {
+            continue;
         }
-        else if( s_globDeviceMode == FtmClient ) {
-            const float distance = FTMCOMMON_getDistance();
-
-            char distance_str[32];
-            snprintf(distance_str, sizeof(distance_str), "%.0fm", ceilf(distance));
-            lv_obj_set_style_text_font(user, &lv_font_montserrat_12, 0);
-            lv_obj_align(user, LV_ALIGN_BOTTOM_MID, 0, 0);
-            lv_label_set_text(user, distance_str);                    
+        if (model->approach_peer == HISTORY_NO_PEER || result.state > model->approach.state ||
+            (result.state == model->approach.state && result.ttc_s < model->approach.ttc_s)) {
+            model->approach = result;
+            model->approach_peer = peer;
         }
-        xSemaphoreGive(g_lvgl_mutex);
     }
 }
 
-void lv_screen_timer_calib(lv_timer_t* timer)
+/* Snapshot of the UI state, call with g_lvgl_mutex held */
+static void ui_get_model(ui_model_t *model)
 {
-        /*Use the user_data*/
-    lvgl_objects_t* user = lv_timer_get_user_data(timer);
-    
-    if (user == NULL) {
-        return;
+    model->mode = s_globDeviceMode;
+    model->calib_step = s_globCalibStep;
+    model->link_state = LINKMON_get_summary();
+    model->rssi = s_ui_radio.rssi;
+    model->distance = s_ui_radio.distance;
+    model->distance_valid = s_ui_radio.valid;
+    app_get_approach(model);
+    model->zone = PROXIMITY_get_nearest(&model->zone_peer);
+    FINGERPRINT_get_status(&model->fingerprint);
+    model->time_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    model->history_view = s_globHistoryView;
+    model->history_peer = s_globHistoryPeer;
+    model->diag_view = s_globDiagView;
+    model->diag = &s_ui_diag;
+}
+
+static void ui_apply_updates(uint32_t dirty)
+{
+    ui_model_t model;
+
+    bsp_display_lock(0);
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        ui_get_model(&model);
+        xSemaphoreGive(g_lvgl_mutex);
+        UI_update(dirty, &model);
     }
+    bsp_display_unlock();
+}
 
-    if(s_globCalibStep == 0) {
-        lv_timer_pause(g_lvgl_timers.screen_1_calib);
+/**
+ * @brief Task that redraws the UI only when the radio or the buttons report something new.
+ *
+ * Messages arriving within one display refresh period are merged into a single update,
+ * so a burst of frames costs one redraw. Link state changes come from the link monitor
+ * as messages too, so the task sleeps until something happens.
+ */
+static void ui_update_task(void *pvParameter)
+{
+    const TickType_t refresh_period = pdMS_TO_TICKS(CONFIG_LV_DEF_REFR_PERIOD);
+    TickType_t last_apply = xTaskGetTickCount() - refresh_period;
+    ui_update_msg_t msg;
 
-        if (user->btn_set != NULL) {
-            lv_obj_set_size(user->btn_set, 5, 20);
-        }
-        if (user->label_set != NULL) {
-            lv_label_set_text(user->label_set, "");
-        }
-        if (user->label_enter != NULL) {
-            lv_obj_add_flag(user->btn_enter, LV_OBJ_FLAG_HIDDEN);
+    while (1) {
+        if (!UIUPDATE_receive(&msg, portMAX_DELAY)) {
+            continue;
         }
 
-    }
-    else {
-        if (user->btn_set != NULL) {
-            lv_obj_set_size(user->btn_set, 45, 20);
+        uint32_t dirty = ui_merge_update(&msg);
+
+        // Coalesce everything that arrives before the next refresh slot
+        const TickType_t next_apply = last_apply + refresh_period;
+        TickType_t now = xTaskGetTickCount();
+        while ((int32_t)(next_apply - now) > 0 && UIUPDATE_receive(&msg, next_apply - now)) {
+            dirty |= ui_merge_update(&msg);
+            now = xTaskGetTickCount();
         }
-        if (user->label_set != NULL) {
-            lv_label_set_text(user->label_set, "Abort");
+        while (UIUPDATE_receive(&msg, 0)) {
+            dirty |= ui_merge_update(&msg);
         }
-        if (user->label_enter != NULL) {
-            lv_obj_remove_flag(user->btn_enter, LV_OBJ_FLAG_HIDDEN);
+
+        ui_apply_updates(dirty);
+        last_apply = xTaskGetTickCount();
+
+        // Packets and link changes reach the status LED from here, not from the radio callbacks
+        if (dirty & (UI_DIRTY_RADIO | UI_DIRTY_LINK)) {
+            LED_update();
         }
     }
 }
 
-void lv_screen_timer_label_selection(lv_timer_t* timer)
+void app_lvgl_display(void)
 {
-      /*Use the user_data*/
-    lv_obj_t* user = lv_timer_get_user_data(timer);
+    ui_model_t model;
 
-    if (user == NULL) {
-        return;
-    }
+    bsp_display_lock(0);
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        ui_get_model(&model);
+        xSemaphoreGive(g_lvgl_mutex);
 
-    if (g_lvgl_objects.label_selection == NULL) {
-        return;
-    }
-    
-    switch(s_globDeviceMode) {
-        case EspNowReceiver:
-            lv_label_set_text(user, "ESP-NOW Receiver");
-            break;
-        case EspNowSender:
-            lv_label_set_text(user, "ESP-NOW Sender");
-            break;
-        case FtmClient:
-            lv_label_set_text(user, "FTM Client");
-            break;
-        case FtmResponder:
-            lv_label_set_text(user, "FTM Responder");
-            break;
+        if( s_globSelectionDone ) {
+            UI_show_main(&model);
+        }
+        else {
+            UI_show_selection(&model);
+        }
     }
+    bsp_display_unlock();
 }
 
-void lv_screen_0(void)
+static bool app_get_selection(DeviceMode_t *mode)
 {
-    char label_string[32] = {0};
-
-    switch(s_globDeviceMode) {
-        case EspNowReceiver:
-            snprintf(label_string, sizeof(label_string), "ESP-NOW Receiver");
-            break;
-        case EspNowSender:
-            snprintf(label_string, sizeof(label_string), "ESP-NOW Sender");
-            break;
-        case FtmClient:
-            snprintf(label_string, sizeof(label_string), "FTM Client");
-            break;
-        case FtmResponder:
-            snprintf(label_string, sizeof(label_string), "FTM Responder");
-            break;
+    bool done = false;
+
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        done = s_globSelectionDone;
+        *mode = s_globDeviceMode;
+        xSemaphoreGive(g_lvgl_mutex);
     }
 
-    g_lvgl_objects.label_selection = lv_label_create(lv_screen_active());
-    lv_label_set_text(g_lvgl_objects.label_selection, (const char *)&label_string);
-    lv_obj_set_style_text_font(g_lvgl_objects.label_selection, &lv_font_montserrat_14, 0);
-    lv_obj_align(g_lvgl_objects.label_selection, LV_ALIGN_CENTER, 0, 0);
-    lv_label_set_long_mode(g_lvgl_objects.label_selection, LV_LABEL_LONG_WRAP);     /*Break the long lines*/
-    lv_obj_set_style_text_align(g_lvgl_objects.label_selection, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_width(g_lvgl_objects.label_selection, 120);  /*Set smaller width to make the lines wrap*/
-
-    /*Create Set and Enter buttons*/
-    g_lvgl_objects.btn_set = lv_btn_create(lv_screen_active());
-    lv_obj_set_size(g_lvgl_objects.btn_set, 35, 20);
-    lv_obj_align(g_lvgl_objects.btn_set, LV_ALIGN_TOP_LEFT, 2, 10);
-    g_lvgl_objects.label_set = lv_label_create(g_lvgl_objects.btn_set);
-    lv_obj_set_style_text_font(g_lvgl_objects.label_set, &lv_font_montserrat_12, 0);
-    lv_label_set_text(g_lvgl_objects.label_set, "Set");
-    lv_obj_center(g_lvgl_objects.label_set);
-
-    g_lvgl_objects.btn_enter = lv_btn_create(lv_screen_active());
-    lv_obj_set_size(g_lvgl_objects.btn_enter, 45, 20);
-    lv_obj_align(g_lvgl_objects.btn_enter, LV_ALIGN_BOTTOM_LEFT, 2, -10);
-    g_lvgl_objects.label_enter = lv_label_create(g_lvgl_objects.btn_enter);
-    lv_obj_set_style_text_font(g_lvgl_objects.label_enter, &lv_font_montserrat_12, 0);
-    lv_label_set_text(g_lvgl_objects.label_enter, "Enter");
-    lv_obj_center(g_lvgl_objects.label_enter);
-
-    g_lvgl_timers.screen_0_selection = lv_timer_create(lv_screen_timer_label_selection, 20, g_lvgl_objects.label_selection);
+    return done;
 }
 
-void lv_screen_1(void)
+/* Leaves the selection screen with the current mode, as Enter does */
+static void app_select_mode(void)
 {
-    /*Change the active screen's background color to white*/
-    lv_obj_set_style_bg_color(lv_screen_active(), lv_color_hex(0xFFFFFF), LV_PART_MAIN);
-
-    /*Create a white label, set its text and align it to the center*/
-    uint8_t mac[8] = {0};
-    char mac_string[32] = {0};
-
-    esp_read_mac(&mac[0], ESP_IF_WIFI_STA);
-    snprintf(&mac_string[0], 31, "%02X %02X %02X %02X %02X %02X ", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-
-    g_lvgl_objects.label_value = lv_label_create(lv_screen_active());
-    lv_label_set_text(g_lvgl_objects.label_value, (const char *)&mac_string);
-    lv_obj_set_style_text_color(g_lvgl_objects.label_value, lv_color_hex(0x000000), LV_PART_MAIN);  /* Black text for contrast */
-    lv_obj_set_style_text_font(g_lvgl_objects.label_value, &lv_font_montserrat_12, 0);
-    lv_obj_align(g_lvgl_objects.label_value, LV_ALIGN_BOTTOM_MID, 0, 0);
-    lv_label_set_long_mode(g_lvgl_objects.label_value, LV_LABEL_LONG_WRAP);     /*Break the long lines*/
-    lv_obj_set_style_text_align(g_lvgl_objects.label_value, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_width(g_lvgl_objects.label_value, 120);  /*Set smaller width to make the lines wrap*/
-
-    /*Create an Arc*/
-    g_lvgl_objects.arc = lv_arc_create(lv_screen_active());
-
-    if(     ( s_globDeviceMode == EspNowReceiver ) 
-        ||  ( s_globDeviceMode == FtmClient ) ) {
-        lv_arc_set_mode(g_lvgl_objects.arc, LV_ARC_MODE_NORMAL);
-        lv_arc_set_range(g_lvgl_objects.arc, 0, 50);
-    }
-    else {
-        lv_arc_set_mode(g_lvgl_objects.arc, LV_ARC_MODE_SYMMETRICAL);
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        s_globSelectionDone = true;
+        xSemaphoreGive(g_lvgl_mutex);
     }
-
-    lv_obj_set_size(g_lvgl_objects.arc, 110, 110);
-    lv_arc_set_rotation(g_lvgl_objects.arc, 135);
-    lv_arc_set_bg_angles(g_lvgl_objects.arc, 0, 270);
-    lv_obj_set_style_arc_color(g_lvgl_objects.arc, lv_color_hex(0xE0E0E0), LV_PART_MAIN);  /* Light gray background */
-    lv_obj_set_style_arc_color(g_lvgl_objects.arc, lv_color_hex(0x0000FF), LV_PART_INDICATOR);  /* Blue indicator for contrast */
-    lv_arc_set_value(g_lvgl_objects.arc, 100);
-    lv_obj_center(g_lvgl_objects.arc);
-
-    /*Create a LED*/
-    g_lvgl_objects.led = lv_led_create(lv_screen_active());
-    lv_obj_align(g_lvgl_objects.led, LV_ALIGN_CENTER, 0, 0);
-    lv_led_set_brightness(g_lvgl_objects.led, 200);  /* Increased brightness */
-    lv_led_set_color(g_lvgl_objects.led, lv_color_hex(0x0000FF));  /* Blue LED for contrast */
-    lv_led_on(g_lvgl_objects.led);
-
-    /*Create Set button*/
-    g_lvgl_objects.btn_set = lv_btn_create(lv_screen_active());
-    lv_obj_set_size(g_lvgl_objects.btn_set, 5, 20);
-    lv_obj_align(g_lvgl_objects.btn_set, LV_ALIGN_TOP_LEFT, 2, 10);
-    lv_obj_set_style_bg_color(g_lvgl_objects.btn_set, lv_color_hex(0x0000FF), LV_PART_MAIN);  /* Blue button */
-    g_lvgl_objects.label_set = lv_label_create(g_lvgl_objects.btn_set);
-    lv_obj_set_style_text_font(g_lvgl_objects.label_set, &lv_font_montserrat_12, 0);
-    lv_obj_set_style_text_color(g_lvgl_objects.label_set, lv_color_hex(0xFFFFFF), LV_PART_MAIN);  /* White text */
-    lv_label_set_text(g_lvgl_objects.label_set, "");
-    lv_obj_center(g_lvgl_objects.label_set);
-
-    /*Create Enter button*/
-    g_lvgl_objects.btn_enter = lv_btn_create(lv_screen_active());
-    lv_obj_set_size(g_lvgl_objects.btn_enter, 45, 20);
-    lv_obj_align(g_lvgl_objects.btn_enter, LV_ALIGN_BOTTOM_LEFT, 2, -10);
-    lv_obj_set_style_bg_color(g_lvgl_objects.btn_enter, lv_color_hex(0x0000FF), LV_PART_MAIN);  /* Blue button */
-    g_lvgl_objects.label_enter = lv_label_create(g_lvgl_objects.btn_enter);
-    lv_obj_set_style_text_font(g_lvgl_objects.label_enter, &lv_font_montserrat_12, 0);
-    lv_obj_set_style_text_color(g_lvgl_objects.label_enter, lv_color_hex(0xFFFFFF), LV_PART_MAIN);  /* White text */
-    lv_label_set_text(g_lvgl_objects.label_enter, "Apply");
-    lv_obj_center(g_lvgl_objects.label_enter);
-    lv_obj_add_flag(g_lvgl_objects.btn_enter, LV_OBJ_FLAG_HIDDEN);
-
-    g_lvgl_timers.screen_1_label = lv_timer_create(lv_screen_timer_label, 500, g_lvgl_objects.label_value);
-    g_lvgl_timers.screen_1_led = lv_timer_create(lv_screen_timer_led, 1000, g_lvgl_objects.led);
-    g_lvgl_timers.screen_1_arc = lv_timer_create(lv_screen_timer_arc, 100, g_lvgl_objects.arc);
-
-    g_lvgl_timers.screen_1_calib = lv_timer_create(lv_screen_timer_calib, 100, &g_lvgl_objects);
-    lv_timer_pause(g_lvgl_timers.screen_1_calib);
 }
 
-void cleanup_lvgl_resources(void) {
-    // Delete all timers
-    if (g_lvgl_timers.screen_0_selection != NULL) {
-        lv_timer_del(g_lvgl_timers.screen_0_selection);
-        g_lvgl_timers.screen_0_selection = NULL;
-    }
-    if (g_lvgl_timers.screen_1_label != NULL) {
-        lv_timer_del(g_lvgl_timers.screen_1_label);
-        g_lvgl_timers.screen_1_label = NULL;
-    }
-    if (g_lvgl_timers.screen_1_led != NULL) {
-        lv_timer_del(g_lvgl_timers.screen_1_led);
-        g_lvgl_timers.screen_1_led = NULL;
-    }
-    if (g_lvgl_timers.screen_1_arc != NULL) {
-        lv_timer_del(g_lvgl_timers.screen_1_arc);
-        g_lvgl_timers.screen_1_arc = NULL;
-    }
+/* Calibration overrides the pattern of the running role */
+static void app_update_led(led_state_t running)
+{
+    bool calibrating = false;
 
-    // Delete all objects
-    if (g_lvgl_objects.label_selection != NULL) {
-        lv_obj_delete_async(g_lvgl_objects.label_selection);
-        g_lvgl_objects.label_selection = NULL;
-    }
-    if (g_lvgl_objects.btn_set != NULL) {
-        lv_obj_delete_async(g_lvgl_objects.btn_set);
-        g_lvgl_objects.btn_set = NULL;
-    }
-    if (g_lvgl_objects.btn_enter != NULL) {
-        lv_obj_delete_async(g_lvgl_objects.btn_enter);
-        g_lvgl_objects.btn_enter = NULL;
-    }
-    if (g_lvgl_objects.label_value != NULL) {
-        lv_obj_delete_async(g_lvgl_objects.label_value);
-        g_lvgl_objects.label_value = NULL;
-    }
-    if (g_lvgl_objects.arc != NULL) {
-        lv_obj_delete_async(g_lvgl_objects.arc);
-        g_lvgl_objects.arc = NULL;
-    }
-    if (g_lvgl_objects.led != NULL) {
-        lv_obj_delete_async(g_lvgl_objects.led);
-        g_lvgl_objects.led = NULL;
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        calibrating = (s_globCalibStep == 1);
+        xSemaphoreGive(g_lvgl_mutex);
     }
-}
 
-void app_lvgl_display(void)
-{
-    bsp_display_lock(0);
-    if( s_globSelectionDone ) {
-        // delete screen0
-        cleanup_lvgl_resources();
-        lv_screen_1();    
-    }
-    else {
-        lv_screen_0();
-    }
-    bsp_display_unlock();
+    LED_set_state(calibrating ? LED_STATE_CALIBRATION : running);
 }
 
 void app_main(void)
 {
+    uint8_t mac[8] = {0};
+    char mac_string[32] = {0};
+    DeviceMode_t mode;
+    ui_model_t model;
+    gpio_button_event_t event;
+
     // Create mutex for thread safety
     g_lvgl_mutex = xSemaphoreCreateMutex();
     if (g_lvgl_mutex == NULL) {
@@ -502,83 +410,139 @@ void app_main(void)
     ESP_LOGI(TAG, "Initialize I2C bus");
 
     /* Configure LED  */
-    GPIO_configure_io();
+    LED_init();
 
-    // Initialize NVS
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+    // Frequency scaling and light sleep, only with CONFIG_CUBE_POWER_SAVE
+    POWER_init();
+
+    // Radio callbacks record binary events, a low priority task prints them
+    TRACE_init();
+
+    // NVS holds the Wi-Fi calibration and the last role
+    SETTINGS_init();
+    const bool have_role = SETTINGS_get_role(&s_globDeviceMode);
+    const bool fast_boot = have_role && (APP_AUTOSTART_MS == 0);
+    TickType_t autostart = (have_role && APP_AUTOSTART_MS > 0) ? pdMS_TO_TICKS(APP_AUTOSTART_MS) : portMAX_DELAY;
+    s_globSelectionDone = fast_boot;
 
-    // Set button callback
-    GPIO_register_callback_button_set(&button_pressed_set);
-    GPIO_register_callback_button_enter(&button_pressed_enter);
+    UIUPDATE_init();
 
-    // Start button monitoring task
-    xTaskCreate(GPIO_button_monitoring_task, "button_task", 2048, NULL, 10, NULL);
+    // Liveness per source and peer, state changes arrive as UI_UPDATE_LINK messages
+    LINKMON_init(app_link_event);
+
+    // Zone changes of the receiver drive the status LED and the main screen
+    PROXIMITY_register(app_zone_event, NULL);
+    PROXIMITY_init();
+
+    // Motion features from the CSI of received frames, only with CONFIG_CUBE_CSI.
+    // Before the radio, a fast boot starts the receiver while the display is set up
+    CSI_init();
+
+    // Nearest recorded spot from the RSSI of all senders, only with CONFIG_CUBE_FINGERPRINT
+    FINGERPRINT_init();
+
+    // Button edge interrupts, debounced by a one-shot timer, gestures are read below
+    GPIO_button_init();
+
+    // The Wi-Fi driver, and on a fast boot the remembered role, start while the display is set up
+    RADIO_boot(fast_boot ? &s_globDeviceMode : NULL);
 
     /* Configure Display  */
-    if (bsp_display_start() == NULL) {
+    if (LCD_start() == NULL) {
         ESP_LOGE(TAG, "display start failed!");
         abort();
     }
-    app_lvgl_display();
 
-    while(!s_globSelectionDone) {
-        vTaskDelay(pdMS_TO_TICKS(500)); // Prevent app_main from ending
+    // Both screens are built once, mode changes only switch between them
+    esp_read_mac(&mac[0], ESP_IF_WIFI_STA);
+    snprintf(&mac_string[0], 31, "%02X %02X %02X %02X %02X %02X ", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    bsp_display_lock(0);
+    if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+        ui_get_model(&model);
+        xSemaphoreGive(g_lvgl_mutex);
+        UI_create(&model, mac_string);
     }
+    bsp_display_unlock();
 
-    app_lvgl_display();
+    // Redraw on radio and button messages instead of polling timers
+    xTaskCreate(ui_update_task, "ui_update_task", UI_UPDATE_TASK_STACK_SIZE, NULL, UI_UPDATE_TASK_PRIORITY, NULL);
 
-    if( s_globDeviceMode == EspNowReceiver ) {
-        // Initialize WiFi
-        ESP_ERROR_CHECK(esp_now_wifi_init());
+    // Stack, heap and CPU statistics, only with CONFIG_CUBE_DIAG
+    DIAG_init();
 
-        RECEIVER_init();
-        
-        ESP_LOGI(TAG, "ESP-NOW Receiver Initialized. Waiting for data...");
-        // Main task can simply wait here or perform other tasks
-        // The actual work happens in the ESP-NOW Receive Callback
-        while(1) {
-            vTaskDelay(pdMS_TO_TICKS(5000)); // Prevent app_main from ending
-        }
+    // A fast boot goes straight to the main screen of the remembered role
+    if (fast_boot) {
+        app_lvgl_display();
     }
-    else if( s_globDeviceMode == EspNowSender ) {
-        // Initialize WiFi
-        ESP_ERROR_CHECK(esp_now_wifi_init());
+    esp_err_t started = RADIO_boot_wait();
 
-        SENDER_init();
-    }
-    else if( s_globDeviceMode == FtmResponder) {
-        // Initialize WiFi
-        ESP_ERROR_CHECK(ftm_wifi_init());
+    while(1) {
+        if (!app_get_selection(&mode)) {
+            // Wait for Enter on the selection screen, any button cancels the autostart
+            while(!app_get_selection(&mode)) {
+                if (GPIO_receive_event(&event, autostart)) {
+                    autostart = portMAX_DELAY;
+                    app_handle_button(&event);
+                }
+                else if (autostart != portMAX_DELAY) {
+                    ESP_LOGI(TAG, "Autostart of role %d", (int)mode);
+                    autostart = portMAX_DELAY;
+                    app_select_mode();
+                }
+            }
 
-        FTMRESPONDER_init();
+            if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+                s_ui_radio_stopped = false;
+                xSemaphoreGive(g_lvgl_mutex);
+            }
 
-        // Main task can simply wait here or perform other tasks
-        // The actual work happens in the ESP-NOW Receive Callback
-        while(1) {
-            vTaskDelay(pdMS_TO_TICKS(5000)); // Prevent app_main from ending
+            app_lvgl_display();
+            started = RADIO_start(mode);
+            if (started == ESP_OK) {
+                SETTINGS_set_role(mode);
+            }
         }
-    }
-    else if( s_globDeviceMode == FtmClient) {
-        // Initialize WiFi
-        ESP_ERROR_CHECK(ftm_wifi_init());
 
-        FTMCLIENT_init();
+        const led_state_t led_running = (started == ESP_OK) ? LED_STATE_RUNNING : LED_STATE_ERROR;
+        app_update_led(led_running);
+        TickType_t next_measure = xTaskGetTickCount() + pdMS_TO_TICKS(FTM_MEASURE_PERIOD_MS);
+
+        // Run the role until Enter returns to the selection screen
+        while(app_get_selection(&mode)) {
+            // The actual work happens in the ESP-NOW and FTM callbacks, only the FTM client polls
+            TickType_t timeout = portMAX_DELAY;
+            if( mode == FtmClient ) {
+                const TickType_t now = xTaskGetTickCount();
+                timeout = ((int32_t)(next_measure - now) > 0) ? next_measure - now : 0;
+            }
 
-        // Main task can simply wait here or perform other tasks
-        while(1) {
-            vTaskDelay(pdMS_TO_TICKS(3000)); // Prevent app_main from ending
-            FTMCLIENT_measure();
+            if (GPIO_receive_event(&event, timeout)) {
+                app_handle_button(&event);
+                app_update_led(led_running);
+            }
+            else if( mode == FtmClient ) {
+                FTMCLIENT_measure();
+                next_measure = xTaskGetTickCount() + pdMS_TO_TICKS(FTM_MEASURE_PERIOD_MS);
+            }
         }
-    }
-    else {
-        ESP_LOGI(TAG, "Mode not implemented yet");
-        while(1) {
-            vTaskDelay(pdMS_TO_TICKS(5000)); // Prevent app_main from ending
+
+        RADIO_stop();
+        LED_set_state(LED_STATE_IDLE);
+
+        // Drop the radio data and the history right here, a full UI queue must not keep them.
+        // The display lock keeps UI_update() from reading the history meanwhile
+        bsp_display_lock(0);
+        if (xSemaphoreTake(g_lvgl_mutex, portMAX_DELAY) == pdTRUE) {
+            memset(&s_ui_radio, 0, sizeof(s_ui_radio));
+            HISTORY_reset();
+            s_ui_radio_stopped = true;
+            s_globCalibStep = 0;
+            s_globHistoryPeer = 0;
+            xSemaphoreGive(g_lvgl_mutex);
         }
+        bsp_display_unlock();
+
+        app_lvgl_display();
     }
 }
@@ -0,0 +1,218 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_PERF
+
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+#include "perf.h"
+
+// Quarter-octave buckets from 2^PERF_MIN_OCTAVE cycles up to 2^32, bucket 0 holds everything below
+#define PERF_MIN_OCTAVE         (8)
+#define PERF_SUB_BUCKETS        (4)
+#define PERF_BUCKETS            ((32 - PERF_MIN_OCTAVE) * PERF_SUB_BUCKETS + 1)
+
+#define PERF_CPU_MHZ            (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#define PERF_TIMER_PERIOD_MS    (1000)
+
+typedef struct {
+    uint32_t buckets[PERF_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+} perf_histogram_t;
+
+static const char *TAG = "perf";
+static const char *s_probe_names[PERF_PROBE_COUNT] = {
+    "render", "flush", "flush_wait", "gauge", "led", "label", "calib", "selection", "history"
+};
+
+static perf_histogram_t s_histograms[PERF_PROBE_COUNT];
+static uint32_t s_start[PERF_PROBE_COUNT];
+
+// One-second window for the FPS/CPU figures
+static uint32_t s_window_frames = 0;
+static uint64_t s_window_busy_cycles = 0;
+static int64_t s_window_start_us = 0;
+static uint32_t s_seconds_since_dump = 0;
+
+#if CONFIG_CUBE_PERF_OVERLAY
+static lv_obj_t *s_overlay = NULL;
+#endif
+
+static uint32_t perf_bucket_index(uint32_t cycles)
+{
+    if (cycles < (1u << PERF_MIN_OCTAVE)) {
+        return 0;
+    }
+
+    const uint32_t msb = 31 - __builtin_clz(cycles);
+    const uint32_t sub = (cycles >> (msb - 2)) & (PERF_SUB_BUCKETS - 1);
+
+    return (msb - PERF_MIN_OCTAVE) * PERF_SUB_BUCKETS + sub + 1;
+}
+
+// Exclusive upper bound of a bucket in cycles
+static uint64_t perf_bucket_limit(uint32_t index)
+{
+    if (index == 0) {
+        return 1u << PERF_MIN_OCTAVE;
+    }
+
+    const uint32_t octave = (index - 1) / PERF_SUB_BUCKETS + PERF_MIN_OCTAVE;
+    const uint32_t sub = (index - 1) % PERF_SUB_BUCKETS;
+
+    return (uint64_t)(PERF_SUB_BUCKETS + sub + 1) << (octave - 2);
+}
+
+void PERF_record(perf_probe_t probe, uint32_t cycles)
+{
+    perf_histogram_t *h = &s_histograms[probe];
+
+    h->buckets[perf_bucket_index(cycles)]++;
+    h->count++;
+    h->sum += cycles;
+    if (cycles > h->max) {
+        h->max = cycles;
+    }
+
+    // Flushes run inside the render probe, only count them once
+    if (probe != PERF_PROBE_FLUSH && probe != PERF_PROBE_FLUSH_WAIT) {
+        s_window_busy_cycles += cycles;
+    }
+}
+
+static uint32_t perf_percentile(const perf_histogram_t *h, uint32_t percent)
+{
+    const uint32_t target = (h->count * percent + 99) / 100;
+    uint32_t seen = 0;
+
+    for (uint32_t i = 0; i < PERF_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= target) {
+            const uint64_t limit = perf_bucket_limit(i);
+            return (limit < h->max) ? (uint32_t)limit : h->max;
+        }
+    }
+
+    return h->max;
+}
+
+// Prints "<us>.<tenth>" into buf
+static const char *perf_format_us(char *buf, size_t len, uint64_t cycles)
+{
+    const uint64_t tenths = (cycles * 10) / PERF_CPU_MHZ;
+
+    snprintf(buf, len, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+    return buf;
+}
+
+static void perf_dump(void)
+{
+    char mean[16], p50[16], p90[16], p99[16], max[16];
+
+    ESP_LOGI(TAG, "Cycle histograms of the last %d s (us, %d MHz):", CONFIG_CUBE_PERF_DUMP_PERIOD_S, PERF_CPU_MHZ);
+
+    for (uint32_t i = 0; i < PERF_PROBE_COUNT; i++) {
+        perf_histogram_t *h = &s_histograms[i];
+        if (h->count == 0) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "%-10s n=%-6lu mean=%-8s p50=%-8s p90=%-8s p99=%-8s max=%s",
+                 s_probe_names[i], (unsigned long)h->count,
+                 perf_format_us(mean, sizeof(mean), h->sum / h->count),
+                 perf_format_us(p50, sizeof(p50), perf_percentile(h, 50)),
+                 perf_format_us(p90, sizeof(p90), perf_percentile(h, 90)),
+                 perf_format_us(p99, sizeof(p99), perf_percentile(h, 99)),
+                 perf_format_us(max, sizeof(max), h->max));
+
+        memset(h, 0, sizeof(*h));
+    }
+}
+
+static void perf_timer_cb(lv_timer_t *timer)
+{
+    const int64_t now = esp_timer_get_time();
+    const uint64_t window_cycles = (uint64_t)(now - s_window_start_us) * PERF_CPU_MHZ;
+    const uint32_t cpu_percent = (window_cycles > 0) ? (uint32_t)((s_window_busy_cycles * 100) / window_cycles) : 0;
+
+#if CONFIG_CUBE_PERF_OVERLAY
+    if (s_overlay != NULL) {
+        lv_label_set_text_fmt(s_overlay, "%lu fps %lu%%", (unsigned long)s_window_frames, (unsigned long)cpu_percent);
+    }
+#else
+    (void)cpu_percent;
+#endif
+
+    s_window_frames = 0;
+    s_window_busy_cycles = 0;
+    s_window_start_us = now;
+
+    if (++s_seconds_since_dump >= CONFIG_CUBE_PERF_DUMP_PERIOD_S) {
+        s_seconds_since_dump = 0;
+        perf_dump();
+    }
+}
+
+static void perf_display_event_cb(lv_event_t *e)
+{
+    const uint32_t now = esp_cpu_get_cycle_count();
+
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_RENDER_START:
+            s_start[PERF_PROBE_RENDER] = now;
+            break;
+        case LV_EVENT_RENDER_READY:
+            s_window_frames++;
+            PERF_record(PERF_PROBE_RENDER, now - s_start[PERF_PROBE_RENDER]);
+            break;
+        case LV_EVENT_FLUSH_START:
+            s_start[PERF_PROBE_FLUSH] = now;
+            break;
+        case LV_EVENT_FLUSH_FINISH:
+            PERF_record(PERF_PROBE_FLUSH, now - s_start[PERF_PROBE_FLUSH]);
+            break;
+        case LV_EVENT_FLUSH_WAIT_START:
+            s_start[PERF_PROBE_FLUSH_WAIT] = now;
+            break;
+        case LV_EVENT_FLUSH_WAIT_FINISH:
+            PERF_record(PERF_PROBE_FLUSH_WAIT, now - s_start[PERF_PROBE_FLUSH_WAIT]);
+            break;
+        default:
+            break;
+    }
+}
+
+void PERF_init(lv_display_t *disp)
+{
+    static const lv_event_code_t codes[] = {
+        LV_EVENT_RENDER_START, LV_EVENT_RENDER_READY,
+        LV_EVENT_FLUSH_START, LV_EVENT_FLUSH_FINISH,
+        LV_EVENT_FLUSH_WAIT_START, LV_EVENT_FLUSH_WAIT_FINISH,
+    };
+
+    for (uint32_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+        lv_display_add_event_cb(disp, perf_display_event_cb, codes[i], NULL);
+    }
+
+#if CONFIG_CUBE_PERF_OVERLAY
+    // The top layer stays in front of every screen
+    s_overlay = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_color(s_overlay, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(s_overlay, LV_OPA_COVER, 0);
+    lv_obj_set_style_text_color(s_overlay, lv_color_white(), 0);
+    lv_obj_align(s_overlay, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_label_set_text(s_overlay, "");
+#endif
+
+    s_window_start_us = esp_timer_get_time();
+    lv_timer_create(perf_timer_cb, PERF_TIMER_PERIOD_MS, NULL);
+}
+
+#endif /* CONFIG_CUBE_PERF */
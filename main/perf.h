@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "lvgl.h"
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_PERF
+#include "esp_cpu.h"
+#endif
+
+// Measured code paths
+typedef enum {
+    PERF_PROBE_RENDER = 0,      // LV_EVENT_RENDER_START .. LV_EVENT_RENDER_READY, includes the flushes
+    PERF_PROBE_FLUSH,           // Flush callback, hands one strip to the SPI driver
+    PERF_PROBE_FLUSH_WAIT,      // LVGL blocked until the previous strip left the SPI bus
+    PERF_PROBE_UPDATE_GAUGE,
+    PERF_PROBE_UPDATE_LED,
+    PERF_PROBE_UPDATE_LABEL,
+    PERF_PROBE_UPDATE_CALIB,
+    PERF_PROBE_UPDATE_SELECTION,
+    PERF_PROBE_UPDATE_HISTORY,
+    PERF_PROBE_COUNT
+} perf_probe_t;
+
+#if CONFIG_CUBE_PERF
+
+/**
+ * @brief Hook the render and flush probes into the display
+ *
+ * Must be called with the LVGL lock held. All probes are recorded from code
+ * that holds the LVGL lock, so the histograms need no further locking.
+ */
+extern void PERF_init(lv_display_t *disp);
+extern void PERF_record(perf_probe_t probe, uint32_t cycles);
+
+// Measure the cycles of one statement
+#define PERF_MEASURE(probe, call) do { \
+        const uint32_t perf_start_ = esp_cpu_get_cycle_count(); \
+        call; \
+        PERF_record((probe), esp_cpu_get_cycle_count() - perf_start_); \
+    } while (0)
+
+#else
+
+static inline void PERF_init(lv_display_t *disp) { (void)disp; }
+#define PERF_MEASURE(probe, call) do { call; } while (0)
+
+#endif
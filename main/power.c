@@ -0,0 +1,326 @@
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_POWER_SAVE
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+
+#include "dutycycle.h"
+#include "power.h"
+
+#define POWER_REPORT_PERIOD_US  ((int64_t)CONFIG_CUBE_POWER_SAVE_REPORT_S * 1000 * 1000)
+
+#define POWER_TASK_STACK_SIZE   3072
+#define POWER_TASK_PRIORITY     6
+
+static const char *TAG = "power";
+
+// Agreed with the sender, which sends on a grid of the same period
+static const dutycycle_config_t s_schedule = {
+    .period_us = CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000,
+    .window_us = CONFIG_CUBE_POWER_SAVE_WINDOW_MS * 1000,
+    .guard_us = CONFIG_CUBE_POWER_SAVE_GUARD_MS * 1000,
+    .max_missed = CONFIG_CUBE_POWER_SAVE_MAX_MISSED,
+};
+
+typedef enum {
+    POWER_REQUEST_NONE = 0,
+    POWER_REQUEST_RECEIVE,
+    POWER_REQUEST_STOP,
+} power_request_t;
+
+// Requests of the other tasks, the Wi-Fi task only stores the frame time and wakes the power task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static power_request_t s_request = POWER_REQUEST_NONE;
+static bool s_frame_pending = false;
+static int64_t s_frame_us = 0;
+static int64_t s_listen_until_us = 0;
+
+// Only the power task drives the schedule, the timer and the radio
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_stopped = NULL;
+static esp_timer_handle_t s_timer = NULL;
+static dutycycle_t s_dc;
+static bool s_receiving = false;
+static bool s_window_open = false;
+static int64_t s_close_us = 0;
+static bool s_radio_on = false;
+
+// Actual duty cycle since the last report
+static int64_t s_radio_on_since_us = 0;
+static int64_t s_radio_on_us = 0;
+static int64_t s_report_start_us = 0;
+static uint32_t s_windows = 0;
+static uint32_t s_misses = 0;
+
+static void power_set_radio(bool on, int64_t now_us)
+{
+    if (on == s_radio_on) {
+        return;
+    }
+
+    if (on) {
+        esp_wifi_force_wakeup_acquire();
+        s_radio_on_since_us = now_us;
+    } else {
+        esp_wifi_force_wakeup_release();
+        s_radio_on_us += now_us - s_radio_on_since_us;
+    }
+    s_radio_on = on;
+}
+
+static void power_report(int64_t now_us)
+{
+    if (now_us - s_report_start_us < POWER_REPORT_PERIOD_US) {
+        return;
+    }
+
+    int64_t on_us = s_radio_on_us;
+    if (s_radio_on) {
+        on_us += now_us - s_radio_on_since_us;
+    }
+
+    const uint32_t duty = (uint32_t)(on_us * 1000 / (now_us - s_report_start_us));
+    const uint32_t projected = DUTYCYCLE_get_duty_permille(&s_schedule);
+
+    ESP_LOGI(TAG, "Radio on %lu.%lu%% (projected %lu.%lu%%), %lu windows, %lu missed, %lu resyncs",
+             (unsigned long)(duty / 10), (unsigned long)(duty % 10),
+             (unsigned long)(projected / 10), (unsigned long)(projected % 10),
+             (unsigned long)s_windows, (unsigned long)s_misses, (unsigned long)s_dc.resyncs);
+
+    s_report_start_us = now_us;
+    s_radio_on_since_us = now_us;
+    s_radio_on_us = 0;
+    s_windows = 0;
+    s_misses = 0;
+}
+
+// Radio on inside a window, without sync or while a listen request runs, off otherwise
+static void power_schedule(int64_t now_us, int64_t listen_until_us)
+{
+    int64_t open_us;
+    int64_t close_us;
+    int64_t wake_us = 0;
+    bool on = false;
+
+    // Other wake ups while a window is open must not count it twice
+    const bool was_open = s_window_open;
+    const int64_t was_close_us = s_close_us;
+
+    esp_timer_stop(s_timer);
+    s_window_open = false;
+
+    if (s_receiving) {
+        if (!DUTYCYCLE_get_window(&s_dc, &open_us, &close_us)) {
+            // Wait for the next frame with the radio on
+            on = true;
+        } else if (now_us < open_us) {
+            wake_us = open_us;
+        } else {
+            if (!was_open || close_us != was_close_us) {
+                s_windows++;
+            }
+            s_window_open = true;
+            s_close_us = close_us;
+            on = true;
+            wake_us = close_us;
+        }
+    }
+
+    if (now_us < listen_until_us) {
+        on = true;
+        if (wake_us == 0 || listen_until_us < wake_us) {
+            wake_us = listen_until_us;
+        }
+    }
+
+    power_set_radio(on, now_us);
+
+    if (wake_us != 0) {
+        esp_timer_start_once(s_timer, (wake_us > now_us) ? wake_us - now_us : 0);
+    }
+}
+
+// Window edges and the end of a listen request, the task sorts out which one it was
+static void power_timer_cb(void *arg)
+{
+    xTaskNotifyGive(s_task);
+}
+
+static void power_task(void *pvParameter)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        portENTER_CRITICAL(&s_lock);
+        const power_request_t request = s_request;
+        const bool frame = s_frame_pending;
+        const int64_t frame_us = s_frame_us;
+        const int64_t listen_until_us = s_listen_until_us;
+        s_request = POWER_REQUEST_NONE;
+        s_frame_pending = false;
+        portEXIT_CRITICAL(&s_lock);
+
+        const int64_t now_us = esp_timer_get_time();
+
+        if (request == POWER_REQUEST_STOP) {
+            esp_timer_stop(s_timer);
+            s_receiving = false;
+            s_window_open = false;
+            power_set_radio(false, now_us);
+            xSemaphoreGive(s_stopped);
+            continue;
+        }
+
+        if (request == POWER_REQUEST_RECEIVE) {
+            DUTYCYCLE_init(&s_dc, &s_schedule);
+            s_receiving = true;
+            s_report_start_us = now_us;
+            s_radio_on_since_us = now_us;
+            s_radio_on_us = 0;
+            s_windows = 0;
+            s_misses = 0;
+        }
+
+        if (s_receiving) {
+            if (frame) {
+                const bool was_synced = s_dc.synced;
+
+                DUTYCYCLE_frame(&s_dc, frame_us);
+                if (!was_synced) {
+                    ESP_LOGI(TAG, "Synced to the sender, listening %d ms per %d ms",
+                             CONFIG_CUBE_POWER_SAVE_WINDOW_MS + 2 * CONFIG_CUBE_POWER_SAVE_GUARD_MS,
+                             CONFIG_CUBE_ESPNOW_PERIOD_MS);
+                }
+            } else if (s_window_open && now_us >= s_close_us) {
+                s_misses++;
+                DUTYCYCLE_window_missed(&s_dc);
+                if (!s_dc.synced) {
+                    ESP_LOGW(TAG, "Sender lost, listening continuously");
+                }
+            }
+        }
+
+        // A frame or a window still open only moves the timer, the schedule is recomputed on every wake up
+        power_schedule(now_us, listen_until_us);
+        if (s_receiving) {
+            power_report(now_us);
+        }
+    }
+}
+
+static void power_request(power_request_t request)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_request = request;
+    s_frame_pending = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    xTaskNotifyGive(s_task);
+}
+
+void POWER_init(void)
+{
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+
+    s_stopped = xSemaphoreCreateBinary();
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = power_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "power",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+
+    xTaskCreate(power_task, "power_task", POWER_TASK_STACK_SIZE, NULL, POWER_TASK_PRIORITY, &s_task);
+
+    const uint32_t projected = DUTYCYCLE_get_duty_permille(&s_schedule);
+    ESP_LOGI(TAG, "DFS %d..%d MHz with light sleep, receiver window %d ms + 2x %d ms guard per %d ms: %lu.%lu%% radio on",
+             CONFIG_XTAL_FREQ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, CONFIG_CUBE_POWER_SAVE_WINDOW_MS,
+             CONFIG_CUBE_POWER_SAVE_GUARD_MS, CONFIG_CUBE_ESPNOW_PERIOD_MS,
+             (unsigned long)(projected / 10), (unsigned long)(projected % 10));
+}
+
+void POWER_sender_start(void)
+{
+    // Transmitting wakes the modem by itself, replies are only heard in POWER_listen() windows
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
+    ESP_ERROR_CHECK(esp_now_set_wake_window(0));
+}
+
+void POWER_receiver_start(void)
+{
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
+    // The connectionless wake window stays closed, the schedule holds the radio on instead
+    ESP_ERROR_CHECK(esp_now_set_wake_window(0));
+
+    power_request(POWER_REQUEST_RECEIVE);
+}
+
+void POWER_frame_received(uint8_t peer)
+{
+    // Only the first sender is tracked, others are heard when they fall into its windows
+    if (peer != 0 || s_task == NULL) {
+        return;
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    s_frame_us = now_us;
+    s_frame_pending = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    xTaskNotifyGive(s_task);
+}
+
+void POWER_listen(uint32_t duration_us)
+{
+    if (s_task == NULL) {
+        return;
+    }
+
+    const int64_t until_us = esp_timer_get_time() + duration_us;
+
+    portENTER_CRITICAL(&s_lock);
+    if (until_us > s_listen_until_us) {
+        s_listen_until_us = until_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    xTaskNotifyGive(s_task);
+}
+
+void POWER_stop(void)
+{
+    if (s_task == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_listen_until_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    // The task releases the radio, the next role starts without a wake lock
+    power_request(POWER_REQUEST_STOP);
+    xSemaphoreTake(s_stopped, portMAX_DELAY);
+
+    // Other roles expect the radio always on
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
+}
+
+#endif /* CONFIG_CUBE_POWER_SAVE */
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_POWER_SAVE
+
+/**
+ * @brief Enable dynamic frequency scaling and automatic light sleep
+ *
+ * Logs the projected receiver duty cycle of the configured wake window.
+ */
+extern void POWER_init(void);
+
+/**
+ * @brief Modem sleep for the sender, the radio only wakes up to transmit
+ *
+ * The sender task sends on a fixed grid of CONFIG_CUBE_ESPNOW_PERIOD_MS, so
+ * the CPU light sleeps between the slots. Frames are only received in
+ * POWER_listen() windows, timesync.c opens them around its time exchange.
+ */
+extern void POWER_sender_start(void);
+
+/**
+ * @brief Duty-cycled listening for the receiver
+ *
+ * Listens continuously until the tracked sender is heard, then only keeps the
+ * radio on in a window around each expected frame. After too many missed
+ * windows it listens continuously again until the sender is found. A power
+ * task drives the windows, the receive callback only hands it the frame time.
+ */
+extern void POWER_receiver_start(void);
+
+// A frame of a peer arrived, peer slot 0 is the tracked sender. Called from the Wi-Fi task, never blocks
+extern void POWER_frame_received(uint8_t peer);
+
+/**
+ * @brief Keep the radio on for a while on top of the schedule, e.g. for the reply of a time exchange
+ *
+ * Only stores the request, the power task turns the radio on. Safe from any task.
+ *
+ * @param duration_us From now, overlapping requests extend each other
+ */
+extern void POWER_listen(uint32_t duration_us);
+
+// Radio back to always on, called before the role is torn down
+extern void POWER_stop(void);
+
+#else
+
+static inline void POWER_init(void) {}
+static inline void POWER_sender_start(void) {}
+static inline void POWER_receiver_start(void) {}
+static inline void POWER_frame_received(uint8_t peer) { (void)peer; }
+static inline void POWER_listen(uint32_t duration_us) { (void)duration_us; }
+static inline void POWER_stop(void) {}
+
+#endif
@@ -0,0 +1,241 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "history.h"
+#include "trace.h"
+#include "proximity.h"
+
+#define PROXIMITY_TASK_STACK_SIZE   3072
+#define PROXIMITY_TASK_PRIORITY     4
+
+#define PROXIMITY_MAX_HOOKS         (4)
+#define PROXIMITY_QUEUE_LEN         (8)
+
+// A peer leaves its zone after three missed frames, checked at this period while any peer is in one
+#define PROXIMITY_TIMEOUT_MS        (3 * CONFIG_CUBE_ESPNOW_PERIOD_MS)
+#define PROXIMITY_CHECK_MS          (250)
+
+typedef struct {
+    proximity_cb_t cb;
+    void *ctx;
+} proximity_hook_t;
+
+static const char *TAG = "proximity";
+
+static const zone_config_t s_default_config = {
+    .edge_cm = { CONFIG_CUBE_ZONE_IMMEDIATE_CM, CONFIG_CUBE_ZONE_NEAR_CM },
+    .hysteresis_cm = CONFIG_CUBE_ZONE_HYSTERESIS_CM,
+    .dwell_ms = CONFIG_CUBE_ZONE_DWELL_MS,
+};
+
+// Registered before the task starts, read-only afterwards
+static proximity_hook_t s_hooks[PROXIMITY_MAX_HOOKS];
+static uint8_t s_hook_count = 0;
+
+static QueueHandle_t s_queue = NULL;
+static volatile uint32_t s_dropped = 0;    // Queue full, counted by the Wi-Fi task
+
+// Written by the Wi-Fi task and the proximity task, a few comparisons under the lock
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static zone_config_t s_config[HISTORY_PEERS];
+static zone_tracker_t s_trackers[HISTORY_PEERS];
+
+static void proximity_post(const proximity_event_t *event)
+{
+    TRACE_record(TRACE_ZONE, event->peer | (event->zone << 8), event->previous, event->distance_cm);
+
+    if (xQueueSend(s_queue, event, 0) != pdTRUE) {
+        s_dropped++;
+    }
+}
+
+// Peers that went silent leave their zone, the receive callback cannot notice that.
+// A timeout of 0 makes every peer leave, for the role stop. Returns true if a peer
+// is still in a zone.
+static bool proximity_expire(uint32_t timeout_ms)
+{
+    const int64_t now_us = esp_timer_get_time();
+    bool in_zone = false;
+
+    for (uint8_t peer = 0; peer < HISTORY_PEERS; peer++) {
+        zone_t previous;
+
+        portENTER_CRITICAL(&s_lock);
+        const bool changed = ZONE_expire(&s_trackers[peer], now_us, timeout_ms, &previous);
+        in_zone |= (s_trackers[peer].zone != ZONE_UNKNOWN);
+        portEXIT_CRITICAL(&s_lock);
+
+        if (changed) {
+            const proximity_event_t event = {
+                .peer = peer,
+                .zone = ZONE_UNKNOWN,
+                .previous = previous,
+                .time_us = now_us,
+            };
+            proximity_post(&event);
+        }
+    }
+
+    return in_zone;
+}
+
+static void proximity_task(void *pvParameter)
+{
+    proximity_event_t event;
+    uint32_t reported_dropped = 0;
+    TickType_t last_check = xTaskGetTickCount();
+    bool in_zone = false;
+
+    while (1) {
+        // Without a peer in a zone nothing can expire, the next zone change posts an event.
+        // So a sender or a receiver without peers nearby does not wake the CPU here.
+        const TickType_t wait = in_zone ? pdMS_TO_TICKS(PROXIMITY_CHECK_MS) : portMAX_DELAY;
+
+        if (xQueueReceive(s_queue, &event, wait) == pdTRUE) {
+            ESP_LOGI(TAG, "Peer %d zone %d -> %d at %d cm", event.peer, event.previous, event.zone, event.distance_cm);
+            for (uint8_t i = 0; i < s_hook_count; i++) {
+                s_hooks[i].cb(&event, s_hooks[i].ctx);
+            }
+            if (event.zone != ZONE_UNKNOWN) {
+                in_zone = true;
+            }
+        }
+
+        if (xTaskGetTickCount() - last_check >= pdMS_TO_TICKS(PROXIMITY_CHECK_MS)) {
+            last_check = xTaskGetTickCount();
+            in_zone = proximity_expire(PROXIMITY_TIMEOUT_MS);
+        }
+
+        if (s_dropped != reported_dropped) {
+            reported_dropped = s_dropped;
+            ESP_LOGW(TAG, "%lu zone changes dropped, the hooks are too slow", (unsigned long)reported_dropped);
+            in_zone = true;     // A dropped change may have been an entry, check again
+        }
+    }
+}
+
+// Default bands and no zone for every peer slot
+static void proximity_reset(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (uint8_t peer = 0; peer < HISTORY_PEERS; peer++) {
+        s_config[peer] = s_default_config;
+        ZONE_init(&s_trackers[peer]);
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool PROXIMITY_register(proximity_cb_t cb, void *ctx)
+{
+    if (s_queue != NULL || s_hook_count >= PROXIMITY_MAX_HOOKS) {
+        return false;
+    }
+
+    s_hooks[s_hook_count++] = (proximity_hook_t){ .cb = cb, .ctx = ctx };
+    return true;
+}
+
+void PROXIMITY_init(void)
+{
+    s_queue = xQueueCreate(PROXIMITY_QUEUE_LEN, sizeof(proximity_event_t));
+    if (s_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create the queue");
+        return;
+    }
+
+    proximity_reset();
+
+    xTaskCreate(proximity_task, "proximity", PROXIMITY_TASK_STACK_SIZE, NULL, PROXIMITY_TASK_PRIORITY, NULL);
+}
+
+void PROXIMITY_start(void)
+{
+    proximity_reset();
+}
+
+void PROXIMITY_stop(void)
+{
+    if (s_queue == NULL) {
+        return;
+    }
+
+    // The hooks see every peer leave, so an alarm does not outlive the role
+    proximity_expire(0);
+    proximity_reset();
+}
+
+void PROXIMITY_set_bands(uint8_t peer, const zone_config_t *config)
+{
+    if (peer >= HISTORY_PEERS) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_config[peer] = *config;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void PROXIMITY_update(uint8_t peer, int64_t time_us, float distance_m)
+{
+    if (peer >= HISTORY_PEERS || s_queue == NULL) {
+        return;
+    }
+
+    const float distance_cm = distance_m * 100.0f;
+    proximity_event_t event = {
+        .peer = peer,
+        .distance_cm = (distance_cm > UINT16_MAX) ? UINT16_MAX : (uint16_t)distance_cm,
+        .time_us = time_us,
+    };
+    zone_t previous;
+
+    portENTER_CRITICAL(&s_lock);
+    const bool changed = ZONE_update(&s_trackers[peer], &s_config[peer], time_us, event.distance_cm, &previous);
+    event.zone = s_trackers[peer].zone;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (changed) {
+        event.previous = previous;
+        proximity_post(&event);
+    }
+}
+
+zone_t PROXIMITY_get_zone(uint8_t peer)
+{
+    if (peer >= HISTORY_PEERS) {
+        return ZONE_UNKNOWN;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    const zone_t zone = (zone_t)s_trackers[peer].zone;
+    portEXIT_CRITICAL(&s_lock);
+
+    return zone;
+}
+
+zone_t PROXIMITY_get_nearest(uint8_t *peer)
+{
+    zone_t nearest = ZONE_UNKNOWN;
+
+    *peer = HISTORY_NO_PEER;
+
+    portENTER_CRITICAL(&s_lock);
+    for (uint8_t i = 0; i < HISTORY_PEERS; i++) {
+        const zone_t zone = (zone_t)s_trackers[i].zone;
+        if (zone != ZONE_UNKNOWN && (nearest == ZONE_UNKNOWN || zone < nearest)) {
+            nearest = zone;
+            *peer = i;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return nearest;
+}
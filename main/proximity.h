@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zone.h"
+
+typedef struct {
+    uint8_t peer;               // Peer slot of the receiver
+    uint8_t zone;               // zone_t, the entered zone, ZONE_UNKNOWN when the peer went silent
+    uint8_t previous;           // zone_t, the zone that was left
+    uint16_t distance_cm;       // Filtered distance that caused the change, 0 on silence
+    int64_t time_us;            // Reception time of that frame
+} proximity_event_t;
+
+// Runs in the proximity task, may block briefly but delays the following events
+typedef void (*proximity_cb_t)(const proximity_event_t *event, void *ctx);
+
+/**
+ * @brief Add a hook for zone changes, call before PROXIMITY_init()
+ *
+ * @return false if all PROXIMITY_MAX_HOOKS slots are taken
+ */
+extern bool PROXIMITY_register(proximity_cb_t cb, void *ctx);
+
+/**
+ * @brief Create the task that runs the hooks
+ *
+ * The zones are tracked in the receive callback on every frame, the task only
+ * delivers the changes and leaves the zone of peers that went silent.
+ */
+extern void PROXIMITY_init(void);
+
+// Forget the zones of all peers and the per-peer bands, called when the receiver role starts
+extern void PROXIMITY_start(void);
+
+// Report every peer in a zone as leaving it, then forget them, called when the receiver role stops
+extern void PROXIMITY_stop(void);
+
+// Replace the bands of one peer slot, the defaults come from the CUBE_ZONE options
+extern void PROXIMITY_set_bands(uint8_t peer, const zone_config_t *config);
+
+/**
+ * @brief Track the filtered distance of a peer, called from the Wi-Fi task, never blocks
+ *
+ * @param time_us Reception time of the frame
+ */
+extern void PROXIMITY_update(uint8_t peer, int64_t time_us, float distance_m);
+
+extern zone_t PROXIMITY_get_zone(uint8_t peer);
+
+/**
+ * @brief Nearest zone of all peers, safe from any task
+ *
+ * @param peer Its slot, HISTORY_NO_PEER if no peer is in a zone
+ */
+extern zone_t PROXIMITY_get_nearest(uint8_t *peer);
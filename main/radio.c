@@ -0,0 +1,233 @@
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+
+#include "linkmon.h"
+#include "EspNowCommon.h"
+#include "EspNowSender.h"
+#include "EspNowReceiver.h"
+#include "FtmCommon.h"
+#include "FtmClient.h"
+#include "FtmResponder.h"
+#include "reporter.h"
+#include "collector.h"
+#include "power.h"
+#include "proximity.h"
+#include "csi.h"
+#include "fingerprint.h"
+#include "timesync.h"
+
+#include "radio.h"
+
+#define RADIO_BOOT_TASK_STACK_SIZE  4096
+#define RADIO_BOOT_TASK_PRIORITY    2
+
+static const char *TAG = "radio";
+
+static bool s_wifi_ready = false;
+static bool s_running = false;
+static DeviceMode_t s_mode = EspNowReceiver;
+
+// Boot task state, only touched before the task starts and after s_boot_done was taken
+static SemaphoreHandle_t s_boot_done = NULL;
+static bool s_boot_start = false;
+static DeviceMode_t s_boot_mode = EspNowReceiver;
+static esp_err_t s_boot_result = ESP_OK;
+
+// Parts that survive a role switch, both ESP-NOW and FTM used to create them on every start
+static void radio_wifi_base_init(void)
+{
+    if (s_wifi_ready) {
+        return;
+    }
+
+    ESP_ERROR_CHECK(esp_netif_init()); // Initialize TCP/IP stack (required for Wi-Fi)
+    ESP_ERROR_CHECK(esp_event_loop_create_default()); // Create default event loop
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg)); // Initialize Wi-Fi driver
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM)); // Store Wi-Fi config in RAM
+
+    s_wifi_ready = true;
+}
+
+// Wi-Fi mode of the role, a failure leaves the radio stopped and main.c shows the error pattern
+static esp_err_t radio_wifi_start(DeviceMode_t mode)
+{
+    switch (mode) {
+        case EspNowReceiver:
+        case EspNowSender:
+        case Collector:
+            return esp_now_wifi_init();
+        case FtmResponder:
+        case FtmClient:
+            return ftm_wifi_init();
+        default:
+            ESP_LOGI(TAG, "Mode not implemented yet");
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+static esp_err_t radio_start_role(DeviceMode_t mode)
+{
+    const int64_t start_us = esp_timer_get_time();
+
+    if (s_running) {
+        RADIO_stop();
+    }
+
+    radio_wifi_base_init();
+
+    // Before the callbacks are registered, so no heartbeat is lost
+    LINKMON_start();
+
+    const esp_err_t err = radio_wifi_start(mode);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Role %d not started: %s", (int)mode, esp_err_to_name(err));
+        LINKMON_stop();
+        return err;
+    }
+
+    switch (mode) {
+        case EspNowReceiver:
+            RECEIVER_init();
+            PROXIMITY_start();
+            TIMESYNC_start(false);
+            REPORTER_start();
+            CSI_start();
+            FINGERPRINT_start();
+            POWER_receiver_start();
+            ESP_LOGI(TAG, "ESP-NOW Receiver Initialized. Waiting for data...");
+            break;
+        case EspNowSender:
+            SENDER_init();
+            TIMESYNC_start(false);
+            POWER_sender_start();
+            break;
+        case FtmResponder:
+            FTMRESPONDER_init();
+            break;
+        case FtmClient:
+            FTMCLIENT_init();
+            break;
+        case Collector:
+            COLLECTOR_init();
+            TIMESYNC_start(true);
+            break;
+        default:
+            break;
+    }
+
+    s_mode = mode;
+    s_running = true;
+
+    const int64_t now_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Role %d started in %lld ms, %lld ms after boot", (int)mode, (now_us - start_us) / 1000,
+             now_us / 1000);
+
+    return ESP_OK;
+}
+
+static void radio_boot_task(void *pvParameter)
+{
+    radio_wifi_base_init();
+
+    if (s_boot_start) {
+        s_boot_result = radio_start_role(s_boot_mode);
+    }
+
+    xSemaphoreGive(s_boot_done);
+    vTaskDelete(NULL);
+}
+
+void RADIO_boot(const DeviceMode_t *mode)
+{
+    s_boot_start = (mode != NULL);
+    if (mode != NULL) {
+        s_boot_mode = *mode;
+    }
+
+    s_boot_done = xSemaphoreCreateBinary();
+    if (s_boot_done == NULL ||
+        xTaskCreate(radio_boot_task, "radio_boot", RADIO_BOOT_TASK_STACK_SIZE, NULL,
+                    RADIO_BOOT_TASK_PRIORITY, NULL) != pdPASS) {
+        // Fall back to a sequential start
+        ESP_LOGW(TAG, "No boot task, the radio starts after the display");
+        if (s_boot_done != NULL) {
+            vSemaphoreDelete(s_boot_done);
+            s_boot_done = NULL;
+        }
+        s_boot_result = s_boot_start ? radio_start_role(s_boot_mode) : ESP_OK;
+    }
+}
+
+esp_err_t RADIO_boot_wait(void)
+{
+    if (s_boot_done != NULL) {
+        xSemaphoreTake(s_boot_done, portMAX_DELAY);
+        vSemaphoreDelete(s_boot_done);
+        s_boot_done = NULL;
+    }
+
+    return s_boot_result;
+}
+
+esp_err_t RADIO_start(DeviceMode_t mode)
+{
+    RADIO_boot_wait();
+
+    return radio_start_role(mode);
+}
+
+void RADIO_stop(void)
+{
+    const int64_t start_us = esp_timer_get_time();
+
+    RADIO_boot_wait();
+
+    if (!s_running) {
+        return;
+    }
+
+    switch (s_mode) {
+        case EspNowReceiver:
+            POWER_stop();
+            FINGERPRINT_stop();
+            CSI_stop();
+            REPORTER_stop();
+            TIMESYNC_stop();
+            PROXIMITY_stop();
+            RECEIVER_deinit();
+            esp_now_wifi_deinit();
+            break;
+        case EspNowSender:
+            POWER_stop();
+            TIMESYNC_stop();
+            SENDER_deinit();
+            esp_now_wifi_deinit();
+            break;
+        case FtmResponder:
+            ftm_wifi_deinit();
+            break;
+        case FtmClient:
+            FTMCLIENT_deinit();
+            ftm_wifi_deinit();
+            break;
+        case Collector:
+            TIMESYNC_stop();
+            COLLECTOR_deinit();
+            esp_now_wifi_deinit();
+            break;
+    }
+
+    LINKMON_stop();
+    s_running = false;
+
+    ESP_LOGI(TAG, "Role %d stopped in %lld ms", (int)s_mode, (esp_timer_get_time() - start_us) / 1000);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "esp_err.h"
+
+#include "ui.h"
+
+/**
+ * @brief Start the radio role of the given mode
+ *
+ * The TCP/IP stack, the default event loop and the Wi-Fi driver are set up on the
+ * first call and reused afterwards, so switching roles only restarts Wi-Fi.
+ *
+ * @param mode Role to start, a running role has to be stopped first
+ * @return esp_err_t ESP_OK on success, otherwise an error code
+ */
+extern esp_err_t RADIO_start(DeviceMode_t mode);
+
+/**
+ * @brief Set up Wi-Fi in a separate task, so it overlaps with the display start
+ *
+ * Call once at boot. RADIO_start() and RADIO_stop() wait for the task to finish.
+ *
+ * @param mode Role to start right away, NULL to only initialize the Wi-Fi driver
+ */
+extern void RADIO_boot(const DeviceMode_t *mode);
+
+/**
+ * @brief Wait for the task started by RADIO_boot()
+ *
+ * @return esp_err_t Result of starting the boot role, ESP_OK if there was none
+ */
+extern esp_err_t RADIO_boot_wait(void);
+
+/**
+ * @brief Tear down the running role and stop Wi-Fi
+ */
+extern void RADIO_stop(void);
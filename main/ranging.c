@@ -0,0 +1,15 @@
+#include <math.h>
+
+#include "ranging.h"
+
+void RANGING_build(ranging_model_t *model, float rssi_at_1m, float path_loss_exponent)
+{
+    model->rssi_at_1m = rssi_at_1m;
+    model->path_loss_exponent = path_loss_exponent;
+
+    // d = 10^((A - RSSI) / (10 * n))
+    for (int i = 0; i < RANGING_TABLE_SIZE; i++) {
+        const float rssi = (float)(RANGING_RSSI_MIN + i);
+        model->distance_m[i] = powf(10.0f, (rssi_at_1m - rssi) / (10.0f * path_loss_exponent));
+    }
+}
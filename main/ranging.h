@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, the receive callback only does a table lookup
+
+// Every RSSI a frame can report, -128 to 0 dBm
+#define RANGING_RSSI_MIN        (-128)
+#define RANGING_RSSI_MAX        (0)
+#define RANGING_TABLE_SIZE      (RANGING_RSSI_MAX - RANGING_RSSI_MIN + 1)
+
+// Log-distance path loss model RSSI = A - 10 * n * log10(d), solved for d per RSSI
+typedef struct {
+    float rssi_at_1m;           // A, measured with the calibration step
+    float path_loss_exponent;   // n, about 2 in free space, 1.6 to 4 indoors
+    float distance_m[RANGING_TABLE_SIZE];
+} ranging_model_t;
+
+/**
+ * @brief Precompute the distance for every RSSI, powf runs here instead of per frame
+ *
+ * @param model Filled completely, a model in use by a reader has to be swapped, not rebuilt
+ * @param rssi_at_1m Expected RSSI at one meter
+ * @param path_loss_exponent Must not be 0
+ */
+extern void RANGING_build(ranging_model_t *model, float rssi_at_1m, float path_loss_exponent);
+
+// Distance in meters, an RSSI outside the table is clamped to its ends
+static inline float RANGING_estimate(const ranging_model_t *model, int rssi)
+{
+    if (rssi < RANGING_RSSI_MIN) {
+        rssi = RANGING_RSSI_MIN;
+    } else if (rssi > RANGING_RSSI_MAX) {
+        rssi = RANGING_RSSI_MAX;
+    }
+
+    return model->distance_m[rssi - RANGING_RSSI_MIN];
+}
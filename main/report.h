@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+
+// Range reports from receivers to a collector over ESP-NOW, and from the
+// collector to the host over USB. All structs are packed little-endian and
+// tools/collector_decode.py has the same layouts. Only append fields.
+
+// First byte of every report frame. Sender frames start with ASCII text, so
+// receivers can tell the two apart.
+#define REPORT_MAGIC            (0xC5)
+#define REPORT_VERSION          (1)
+
+typedef enum {
+    REPORT_FRAME_BEACON = 1,    // Collector announces itself, broadcast once per second
+    REPORT_FRAME_RANGES,        // Receiver to collector, a batch of report_record_t, optionally a report_stamp_t
+    REPORT_FRAME_SYNC_REQ,      // Node to collector, report_sync_req_t, broadcast
+    REPORT_FRAME_SYNC_RESP,     // Collector to node, report_sync_resp_t, broadcast
+} report_frame_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;              // REPORT_MAGIC
+    uint8_t version;            // REPORT_VERSION
+    uint8_t type;               // report_frame_type_t
+    uint8_t count;              // Records after the header
+    uint16_t seq;               // Per receiver, the collector drops repeated batches
+} report_header_t;
+
+// One received sender frame as seen by a receiver, 10 bytes
+typedef struct __attribute__((packed)) {
+    uint32_t sender;            // Last four bytes of the sender MAC
+    uint16_t age_ms;            // From reception to the batch send
+    uint16_t distance_cm;
+    int8_t rssi;
+    uint8_t flags;              // Reserved, 0
+} report_record_t;
+
+// Time on the shared timebase of the collector clock, see timesync.h. Follows the
+// records of a batch, and the NUL terminated text of a sender frame.
+typedef struct __attribute__((packed)) {
+    int64_t time_us;            // Batch: at the send, ages count back from it. Sender frame: at esp_now_send()
+    uint32_t error_us;          // Bound of the clock error of the node
+} report_stamp_t;
+
+// Records in one ESP-NOW frame of at most 250 bytes, with room for the stamp
+#define REPORT_MAX_RECORDS      ((250 - sizeof(report_header_t) - sizeof(report_stamp_t)) / sizeof(report_record_t))
+
+// Two-way time exchange, the collector clock is the master. Times are esp_timer
+// microseconds of the named side, reception times come from rx_ctrl.
+typedef struct __attribute__((packed)) {
+    report_header_t header;     // count 0
+    uint8_t master[6];          // Collector the request is for
+    int64_t t1;                 // Node clock at the send
+} report_sync_req_t;
+
+typedef struct __attribute__((packed)) {
+    report_header_t header;     // count 0
+    uint8_t node[6];            // Node that sent the request
+    int64_t t1;                 // Copied from the request
+    int64_t t2;                 // Collector clock at the reception of the request
+    int64_t t3;                 // Collector clock at the send of the reply
+} report_sync_resp_t;
+
+// Host stream: each frame is 0x00, COBS(host_header, payload, CRC-16/CCITT-FALSE), 0x00
+typedef enum {
+    REPORT_HOST_RANGES = 1,     // host_record_t array
+    REPORT_HOST_STATS,          // One report_host_stats_t
+} report_host_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;               // report_host_type_t
+    uint8_t count;              // Records, 1 for stats
+    uint16_t seq;               // Per host frame, gaps mean lost frames
+} report_host_header_t;
+
+// One range on the host, 16 bytes
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;           // Collector clock at reception by the receiver, see REPORT_HOST_SYNCED
+    uint32_t receiver;          // Last four bytes of the receiver MAC
+    uint32_t sender;            // Last four bytes of the sender MAC
+    uint16_t distance_cm;
+    int8_t rssi;
+    uint8_t flags;              // report_host_flags_t
+} report_host_record_t;
+
+typedef enum {
+    // time_ms comes from the synchronized receiver clock. Without it the collector
+    // took its own reception of the batch, later by the air and queueing time.
+    REPORT_HOST_SYNCED = 0x01,
+} report_host_flags_t;
+
+// Counters since the collector role started
+typedef struct __attribute__((packed)) {
+    uint32_t frames;            // Report frames received
+    uint32_t records;           // Records forwarded to the host
+    uint32_t duplicates;        // Batches received more than once
+    uint32_t unknown;           // Frames of receivers beyond the tracked number
+    uint32_t ring_full;         // Records lost because the host did not keep up
+    uint32_t usb_short;         // Host frames the USB driver did not take completely
+} report_host_stats_t;
@@ -0,0 +1,229 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_now.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+#include "report.h"
+#include "timesync.h"
+#include "trace.h"
+#include "reporter.h"
+
+// Ranges waiting for the next batch, a full ring drops new ones
+#define REPORTER_RING           (64)
+
+// Forwarding stops when the collector has not been heard for this long
+#define REPORTER_COLLECTOR_TIMEOUT_US   (5 * 1000 * 1000)
+
+typedef struct {
+    uint32_t time_ms;
+    report_record_t record;
+} reporter_entry_t;
+
+static const char *TAG = "reporter";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static reporter_entry_t s_ring[REPORTER_RING];
+static uint32_t s_head = 0;
+static uint32_t s_tail = 0;
+static uint32_t s_dropped = 0;
+
+// Written by the Wi-Fi task under s_lock, read by the flush timer
+static uint8_t s_collector_mac[ESP_NOW_ETH_ALEN];
+static int64_t s_collector_seen_us = 0;
+
+// Only used by the flush timer
+static esp_timer_handle_t s_timer = NULL;
+static uint8_t s_peer_mac[ESP_NOW_ETH_ALEN];
+static bool s_peer_added = false;
+static uint16_t s_seq = 0;
+static uint8_t s_frame[sizeof(report_header_t) + REPORT_MAX_RECORDS * sizeof(report_record_t) +
+                       sizeof(report_stamp_t)];
+
+static void reporter_forget_collector(void)
+{
+    if (s_peer_added) {
+        esp_now_del_peer(s_peer_mac);
+        s_peer_added = false;
+        ESP_LOGI(TAG, "Collector " MACSTR " lost", MAC2STR(s_peer_mac));
+    }
+}
+
+// Registers the collector as unicast peer, so lost batches are retried by the MAC
+static bool reporter_use_collector(const uint8_t *mac)
+{
+    if (s_peer_added && memcmp(s_peer_mac, mac, ESP_NOW_ETH_ALEN) == 0) {
+        return true;
+    }
+
+    reporter_forget_collector();
+
+    esp_now_peer_info_t peer = {
+        .channel = 0,
+        .ifidx = ESP_IF_WIFI_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, mac, ESP_NOW_ETH_ALEN);
+
+    if (esp_now_add_peer(&peer) != ESP_OK) {
+        return false;
+    }
+
+    memcpy(s_peer_mac, mac, ESP_NOW_ETH_ALEN);
+    s_peer_added = true;
+    ESP_LOGI(TAG, "Forwarding ranges to collector " MACSTR, MAC2STR(mac));
+
+    return true;
+}
+
+// Takes up to one frame of records out of the ring, returns the count
+static uint8_t reporter_fill_frame(uint32_t now_ms)
+{
+    report_record_t *records = (report_record_t *)&s_frame[sizeof(report_header_t)];
+    uint8_t count = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    while (count < REPORT_MAX_RECORDS && s_tail != s_head) {
+        const reporter_entry_t *e = &s_ring[s_tail % REPORTER_RING];
+        const uint32_t age_ms = now_ms - e->time_ms;
+        records[count] = e->record;
+        records[count].age_ms = (age_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)age_ms;
+        count++;
+        s_tail++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return count;
+}
+
+// esp_timer task
+static void reporter_flush_cb(void *arg)
+{
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    const int64_t seen_us = s_collector_seen_us;
+    memcpy(mac, s_collector_mac, sizeof(mac));
+    portEXIT_CRITICAL(&s_lock);
+
+    if (seen_us == 0 || now_us - seen_us > REPORTER_COLLECTOR_TIMEOUT_US || !reporter_use_collector(mac)) {
+        // No one to send to, keep the ring empty instead of sending stale ranges later
+        portENTER_CRITICAL(&s_lock);
+        s_tail = s_head;
+        portEXIT_CRITICAL(&s_lock);
+        reporter_forget_collector();
+        return;
+    }
+
+    uint8_t count;
+    while ((count = reporter_fill_frame((uint32_t)(now_us / 1000))) > 0) {
+        report_header_t *header = (report_header_t *)s_frame;
+        header->magic = REPORT_MAGIC;
+        header->version = REPORT_VERSION;
+        header->type = REPORT_FRAME_RANGES;
+        header->count = count;
+        header->seq = s_seq++;
+
+        size_t len = sizeof(report_header_t) + count * sizeof(report_record_t);
+
+        // The ages count back from now_us, the same instant on the shared timebase
+        int64_t shared_us;
+        uint32_t error_us;
+        if (TIMESYNC_to_shared(now_us, &shared_us, &error_us)) {
+            const report_stamp_t stamp = { .time_us = shared_us, .error_us = error_us };
+            memcpy(&s_frame[len], &stamp, sizeof(stamp));
+            len += sizeof(stamp);
+        }
+
+        if (esp_now_send(s_peer_mac, s_frame, len) != ESP_OK) {
+            // Wi-Fi queue full, the records of this frame are lost
+            portENTER_CRITICAL(&s_lock);
+            s_dropped += count;
+            portEXIT_CRITICAL(&s_lock);
+            break;
+        }
+    }
+}
+
+void REPORTER_start(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_head = s_tail = 0;
+    s_collector_seen_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    // A random start keeps the collector from taking the first batches after a reboot for repeats
+    s_seq = (uint16_t)esp_random();
+    s_dropped = 0;
+
+    if (s_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = reporter_flush_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "reporter",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+    }
+    esp_timer_start_periodic(s_timer, CONFIG_CUBE_REPORT_BATCH_MS * 1000);
+}
+
+void REPORTER_stop(void)
+{
+    if (s_timer != NULL && esp_timer_is_active(s_timer)) {
+        esp_timer_stop(s_timer);
+    }
+
+    reporter_forget_collector();
+
+    if (s_dropped > 0) {
+        ESP_LOGW(TAG, "%lu ranges not forwarded", (unsigned long)s_dropped);
+    }
+}
+
+bool REPORTER_frame(const uint8_t *mac_addr, const uint8_t *data, int len)
+{
+    if (len < 1 || data[0] != REPORT_MAGIC) {
+        return false;
+    }
+
+    const report_header_t *header = (const report_header_t *)data;
+    if (len >= (int)sizeof(report_header_t) && header->version == REPORT_VERSION &&
+        header->type == REPORT_FRAME_BEACON) {
+        portENTER_CRITICAL(&s_lock);
+        memcpy(s_collector_mac, mac_addr, ESP_NOW_ETH_ALEN);
+        s_collector_seen_us = esp_timer_get_time();
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    return true;
+}
+
+void REPORTER_add(const uint8_t *sender_mac, int8_t rssi, float distance_m, int64_t rx_us)
+{
+    const uint32_t time_ms = (uint32_t)(rx_us / 1000);
+    const float distance_cm = distance_m * 100.0f;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_collector_seen_us == 0) {
+        // No collector heard yet, nothing is batched
+    } else if (s_head - s_tail < REPORTER_RING) {
+        reporter_entry_t *e = &s_ring[s_head % REPORTER_RING];
+        e->time_ms = time_ms;
+        e->record = (report_record_t){
+            .sender = TRACE_mac_tail(sender_mac),
+            .distance_cm = (distance_cm > UINT16_MAX) ? UINT16_MAX : (uint16_t)distance_cm,
+            .rssi = rssi,
+        };
+        s_head++;
+    } else {
+        s_dropped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
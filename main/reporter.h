@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Forward the ranges of the receiver to a collector
+ *
+ * Nothing is sent until a collector beacon was heard. Then the ranges are
+ * batched and sent every CONFIG_CUBE_REPORT_BATCH_MS from an esp_timer.
+ * While synchronized to the collector each batch carries the shared send time.
+ * Call after RECEIVER_init().
+ */
+extern void REPORTER_start(void);
+extern void REPORTER_stop(void);
+
+/**
+ * @brief Take report frames out of the receive path, called from the Wi-Fi task
+ *
+ * @return true if the frame belongs to the collector protocol and is no sender frame
+ */
+extern bool REPORTER_frame(const uint8_t *mac_addr, const uint8_t *data, int len);
+
+/**
+ * @brief Queue one range for the next batch, called from the Wi-Fi task, never blocks
+ *
+ * @param rx_us Reception time from TIMESYNC_rx_time()
+ */
+extern void REPORTER_add(const uint8_t *sender_mac, int8_t rssi, float distance_m, int64_t rx_us);
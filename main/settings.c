@@ -0,0 +1,73 @@
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#include "settings.h"
+
+#define SETTINGS_NAMESPACE      "cube"
+#define SETTINGS_KEY_ROLE       "role"
+
+static const char *TAG = "settings";
+
+void SETTINGS_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+}
+
+bool SETTINGS_get_role(DeviceMode_t *mode)
+{
+    nvs_handle_t handle;
+    uint8_t value = 0;
+
+    if (nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        // Namespace does not exist before the first role was stored
+        return false;
+    }
+
+    const esp_err_t ret = nvs_get_u8(handle, SETTINGS_KEY_ROLE, &value);
+    nvs_close(handle);
+
+    if (ret != ESP_OK || value > Collector) {
+        return false;
+    }
+
+    *mode = (DeviceMode_t)value;
+    return true;
+}
+
+esp_err_t SETTINGS_set_role(DeviceMode_t mode)
+{
+    nvs_handle_t handle;
+    DeviceMode_t stored;
+
+    if (SETTINGS_get_role(&stored) && stored == mode) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_u8(handle, SETTINGS_KEY_ROLE, (uint8_t)mode);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Storing role %d failed: %s", (int)mode, esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(TAG, "Role %d stored", (int)mode);
+    }
+
+    return ret;
+}
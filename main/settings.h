@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "ui.h"
+
+/**
+ * @brief Initialize NVS, erasing it when the partition is full or from a newer IDF
+ *
+ * Must run before Wi-Fi, which keeps its calibration data in NVS.
+ */
+extern void SETTINGS_init(void);
+
+/**
+ * @brief Read the role that was last started from the selection screen
+ *
+ * @param mode Set to the stored role, unchanged when there is none
+ * @return true if a valid role was stored
+ */
+extern bool SETTINGS_get_role(DeviceMode_t *mode);
+
+/**
+ * @brief Remember the role for the next boot, flash is only written when it changed
+ *
+ * @return esp_err_t ESP_OK on success, otherwise an NVS error code
+ */
+extern esp_err_t SETTINGS_set_role(DeviceMode_t mode);
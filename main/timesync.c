@@ -0,0 +1,314 @@
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_TIMESYNC
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_now.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "clocksync.h"
+#include "power.h"
+#include "report.h"
+#include "timesync.h"
+
+// Exchanges stop when the collector beacon has not been heard for this long
+#define TIMESYNC_MASTER_TIMEOUT_US      (5 * 1000 * 1000)
+
+// With power save the radio of a node is off between its sends. It listens this long for the reply
+#define TIMESYNC_REPLY_LISTEN_US        (20 * 1000)
+
+// While no collector is heard, it listens a bit longer than the collector beacon period every few periods
+#define TIMESYNC_SEARCH_LISTEN_US       (1200 * 1000)
+#define TIMESYNC_SEARCH_PERIODS         (30)
+
+// Exchanges between two log lines of the estimate
+#define TIMESYNC_LOG_EXCHANGES          (30)
+
+static const char *TAG = "timesync";
+
+static const uint8_t s_broadcast_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Only used by the Wi-Fi task
+static clocksync_rxstamp_t s_rxstamp;
+
+// Written by the Wi-Fi task and the exchange timer, read from any task, all under s_lock.
+// s_sync is only written by the Wi-Fi task.
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static clocksync_t s_sync;
+static uint8_t s_master_mac[ESP_NOW_ETH_ALEN];
+static int64_t s_master_seen_us = 0;
+static int64_t s_pending_t1 = 0;
+static uint32_t s_accepted = 0;
+static uint32_t s_rejected = 0;
+
+// Set before the callbacks can run
+static bool s_master = false;
+static bool s_running = false;
+static uint8_t s_own_mac[ESP_NOW_ETH_ALEN];
+static esp_timer_handle_t s_timer = NULL;
+
+// Only used by the exchange timer
+static uint32_t s_search_wait = 0;
+
+// The requests and replies are broadcast, so no peer per node is needed
+static bool timesync_send(const void *frame, size_t len)
+{
+    if (!esp_now_is_peer_exist(s_broadcast_mac)) {
+        esp_now_peer_info_t peer = {
+            .channel = 0,
+            .ifidx = ESP_IF_WIFI_STA,
+            .encrypt = false,
+        };
+        memcpy(peer.peer_addr, s_broadcast_mac, ESP_NOW_ETH_ALEN);
+        if (esp_now_add_peer(&peer) != ESP_OK) {
+            return false;
+        }
+    }
+
+    return esp_now_send(s_broadcast_mac, frame, len) == ESP_OK;
+}
+
+static void timesync_log(void)
+{
+    int64_t shared_us;
+    uint32_t error_us;
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    const clocksync_t sync = s_sync;
+    const uint32_t accepted = s_accepted;
+    const uint32_t rejected = s_rejected;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (CLOCKSYNC_to_shared(&sync, now_us, &shared_us, &error_us)) {
+        ESP_LOGI(TAG, "Offset %lld us, drift %ld ppb, error %lu us, best RTT %lu us, %lu of %lu exchanges used",
+                 shared_us - now_us, (long)sync.drift_ppb, (unsigned long)error_us,
+                 (unsigned long)sync.best_rtt_us, (unsigned long)accepted, (unsigned long)(accepted + rejected));
+    }
+}
+
+// esp_timer task, one request per period while the collector is heard
+static void timesync_exchange_cb(void *arg)
+{
+    report_sync_req_t req = {
+        .header = {
+            .magic = REPORT_MAGIC,
+            .version = REPORT_VERSION,
+            .type = REPORT_FRAME_SYNC_REQ,
+        },
+    };
+
+    portENTER_CRITICAL(&s_lock);
+    const int64_t seen_us = s_master_seen_us;
+    memcpy(req.master, s_master_mac, sizeof(req.master));
+    portEXIT_CRITICAL(&s_lock);
+
+    if (seen_us == 0 || esp_timer_get_time() - seen_us > TIMESYNC_MASTER_TIMEOUT_US) {
+        if (s_search_wait == 0) {
+            POWER_listen(TIMESYNC_SEARCH_LISTEN_US);
+            s_search_wait = TIMESYNC_SEARCH_PERIODS;
+        }
+        s_search_wait--;
+        return;
+    }
+
+    // The radio has to be on when the reply arrives
+    POWER_listen(TIMESYNC_REPLY_LISTEN_US);
+
+    // Taken last, everything before the send adds to the round trip
+    req.t1 = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_pending_t1 = req.t1;
+    portEXIT_CRITICAL(&s_lock);
+
+    timesync_send(&req, sizeof(req));
+}
+
+// Collector side, answered from the Wi-Fi task so the turnaround stays short
+static void timesync_answer(const uint8_t *mac_addr, int64_t rx_us, const report_sync_req_t *req)
+{
+    if (memcmp(req->master, s_own_mac, ESP_NOW_ETH_ALEN) != 0) {
+        return;
+    }
+
+    report_sync_resp_t resp = {
+        .header = {
+            .magic = REPORT_MAGIC,
+            .version = REPORT_VERSION,
+            .type = REPORT_FRAME_SYNC_RESP,
+        },
+        .t1 = req->t1,
+        .t2 = rx_us,
+    };
+    memcpy(resp.node, mac_addr, ESP_NOW_ETH_ALEN);
+    resp.t3 = esp_timer_get_time();
+
+    timesync_send(&resp, sizeof(resp));
+}
+
+// Node side, the reply to the last request completes an exchange
+static void timesync_complete(const uint8_t *mac_addr, int64_t rx_us, const report_sync_resp_t *resp)
+{
+    if (memcmp(resp->node, s_own_mac, ESP_NOW_ETH_ALEN) != 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    const bool expected = resp->t1 == s_pending_t1 && memcmp(mac_addr, s_master_mac, ESP_NOW_ETH_ALEN) == 0;
+    if (expected) {
+        // The reply shows the collector as well as its beacon, a node that only listens for replies stays synchronized
+        s_pending_t1 = 0;
+        s_master_seen_us = rx_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!expected) {
+        return;
+    }
+
+    // Only the Wi-Fi task writes s_sync, the fit runs on a copy outside the critical section
+    clocksync_t next = s_sync;
+    const bool accepted = CLOCKSYNC_exchange(&next, resp->t1, resp->t2, resp->t3, rx_us);
+
+    portENTER_CRITICAL(&s_lock);
+    s_sync = next;
+    if (accepted) {
+        s_accepted++;
+    } else {
+        s_rejected++;
+    }
+    const uint32_t count = s_accepted;
+    portEXIT_CRITICAL(&s_lock);
+
+    const bool first = accepted && count == 1;
+    const bool log = accepted && (count % TIMESYNC_LOG_EXCHANGES) == 0;
+
+    if (first) {
+        ESP_LOGI(TAG, "Synchronized to " MACSTR, MAC2STR(mac_addr));
+    }
+    if (first || log) {
+        timesync_log();
+    }
+}
+
+void TIMESYNC_start(bool master)
+{
+    ESP_ERROR_CHECK(esp_wifi_get_mac(WIFI_IF_STA, s_own_mac));
+    CLOCKSYNC_rxstamp_init(&s_rxstamp);
+
+    portENTER_CRITICAL(&s_lock);
+    CLOCKSYNC_init(&s_sync);
+    s_master_seen_us = 0;
+    s_pending_t1 = 0;
+    s_accepted = 0;
+    s_rejected = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    s_search_wait = 0;
+    s_master = master;
+    s_running = true;
+
+    if (master) {
+        return;
+    }
+
+    if (s_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = timesync_exchange_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "timesync",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_timer));
+    }
+    esp_timer_start_periodic(s_timer, CONFIG_CUBE_TIMESYNC_PERIOD_MS * 1000);
+}
+
+void TIMESYNC_stop(void)
+{
+    if (s_timer != NULL && esp_timer_is_active(s_timer)) {
+        esp_timer_stop(s_timer);
+    }
+
+    if (s_running && !s_master) {
+        timesync_log();
+    }
+    s_running = false;
+    s_master = false;
+}
+
+int64_t TIMESYNC_rx_time(uint32_t rx_timestamp)
+{
+    return CLOCKSYNC_rx_time(&s_rxstamp, rx_timestamp, esp_timer_get_time());
+}
+
+bool TIMESYNC_frame(const uint8_t *mac_addr, int64_t rx_us, const uint8_t *data, int len)
+{
+    if (!s_running || len < (int)sizeof(report_header_t) || data[0] != REPORT_MAGIC) {
+        return false;
+    }
+
+    const report_header_t *header = (const report_header_t *)data;
+    if (header->version != REPORT_VERSION) {
+        return false;
+    }
+
+    switch (header->type) {
+        case REPORT_FRAME_BEACON:
+            if (!s_master) {
+                portENTER_CRITICAL(&s_lock);
+                if (memcmp(s_master_mac, mac_addr, ESP_NOW_ETH_ALEN) != 0) {
+                    // Another collector, its clock has nothing to do with the old estimate
+                    memcpy(s_master_mac, mac_addr, ESP_NOW_ETH_ALEN);
+                    CLOCKSYNC_init(&s_sync);
+                    s_accepted = 0;
+                }
+                s_master_seen_us = rx_us;
+                portEXIT_CRITICAL(&s_lock);
+            }
+            return false;
+
+        case REPORT_FRAME_SYNC_REQ:
+            if (s_master && len == (int)sizeof(report_sync_req_t)) {
+                timesync_answer(mac_addr, rx_us, (const report_sync_req_t *)data);
+            }
+            return true;
+
+        case REPORT_FRAME_SYNC_RESP:
+            if (!s_master && len == (int)sizeof(report_sync_resp_t)) {
+                timesync_complete(mac_addr, rx_us, (const report_sync_resp_t *)data);
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool TIMESYNC_to_shared(int64_t local_us, int64_t *shared_us, uint32_t *error_us)
+{
+    if (!s_running) {
+        return false;
+    }
+
+    if (s_master) {
+        *shared_us = local_us;
+        *error_us = 0;
+        return true;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    const bool synced = CLOCKSYNC_to_shared(&s_sync, local_us, shared_us, error_us);
+    portEXIT_CRITICAL(&s_lock);
+
+    return synced;
+}
+
+#endif /* CONFIG_CUBE_TIMESYNC */
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_TIMESYNC
+
+/**
+ * @brief Synchronize to the collector clock, or serve it on the collector
+ *
+ * Nodes learn the collector from its beacons and send a two-way exchange
+ * every CONFIG_CUBE_TIMESYNC_PERIOD_MS. clocksync.c fits offset and drift to
+ * the fastest exchanges. Call after ESP-NOW is initialized for the role.
+ *
+ * @param master true on the collector, which only answers requests
+ */
+extern void TIMESYNC_start(bool master);
+extern void TIMESYNC_stop(void);
+
+/**
+ * @brief Reception time of a frame, called from the receive callback for every frame
+ *
+ * @param rx_timestamp rx_ctrl->timestamp of the frame
+ * @return esp_timer time without the delivery jitter of the callback
+ */
+extern int64_t TIMESYNC_rx_time(uint32_t rx_timestamp);
+
+/**
+ * @brief Handle time exchange frames and collector beacons, called from the Wi-Fi task
+ *
+ * @param rx_us Reception time from TIMESYNC_rx_time()
+ * @return true if the frame was a time exchange and needs no further handling
+ */
+extern bool TIMESYNC_frame(const uint8_t *mac_addr, int64_t rx_us, const uint8_t *data, int len);
+
+/**
+ * @brief Convert local esp_timer time to the shared timebase, safe from any task
+ *
+ * @param error_us Bound of the error of the result
+ * @return false while not synchronized, the collector itself is always synchronized
+ */
+extern bool TIMESYNC_to_shared(int64_t local_us, int64_t *shared_us, uint32_t *error_us);
+
+#else
+
+static inline void TIMESYNC_start(bool master) { (void)master; }
+static inline void TIMESYNC_stop(void) {}
+static inline int64_t TIMESYNC_rx_time(uint32_t rx_timestamp) { (void)rx_timestamp; return esp_timer_get_time(); }
+static inline bool TIMESYNC_frame(const uint8_t *mac_addr, int64_t rx_us, const uint8_t *data, int len)
+{
+    (void)mac_addr; (void)rx_us; (void)data; (void)len;
+    return false;
+}
+static inline bool TIMESYNC_to_shared(int64_t local_us, int64_t *shared_us, uint32_t *error_us)
+{
+    (void)local_us; (void)shared_us; (void)error_us;
+    return false;
+}
+
+#endif
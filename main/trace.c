@@ -0,0 +1,129 @@
+#include "sdkconfig.h"
+
+#if CONFIG_CUBE_TRACE
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "trace.h"
+
+#define TRACE_TASK_STACK_SIZE   2048
+#define TRACE_TASK_PRIORITY     1
+
+// Records per console line, 32 hex characters each
+#define TRACE_LINE_RECORDS      8
+
+static const char *TAG = "trace";
+
+static trace_record_t s_ring[CONFIG_CUBE_TRACE_RECORDS];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_head = 0;     // Written by TRACE_record()
+static uint32_t s_tail = 0;     // Written by the drain task
+static uint32_t s_dropped = 0;
+static TaskHandle_t s_task = NULL;
+
+void TRACE_record(trace_event_t id, uint16_t a, uint32_t b, uint32_t c)
+{
+    const uint32_t time_us = (uint32_t)esp_timer_get_time();
+    bool was_empty;
+
+    portENTER_CRITICAL(&s_lock);
+    was_empty = (s_head == s_tail);
+    if (s_head - s_tail < CONFIG_CUBE_TRACE_RECORDS) {
+        trace_record_t *r = &s_ring[s_head % CONFIG_CUBE_TRACE_RECORDS];
+        r->time_us = time_us;
+        r->id = (uint16_t)id;
+        r->a = a;
+        r->b = b;
+        r->c = c;
+        s_head++;
+    } else {
+        s_dropped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    // Only the first record wakes the drain task, the rest of a burst waits for the same flush
+    if (was_empty && s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+static char *trace_hex(char *out, const trace_record_t *r)
+{
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t *bytes = (const uint8_t *)r;
+
+    for (size_t i = 0; i < sizeof(*r); i++) {
+        *out++ = digits[bytes[i] >> 4];
+        *out++ = digits[bytes[i] & 0x0F];
+    }
+
+    return out;
+}
+
+// Fills one line from the ring, returns the number of records
+static uint32_t trace_fill_line(char *line, uint32_t *reported_drops)
+{
+    trace_record_t batch[TRACE_LINE_RECORDS];
+    uint32_t count = 0;
+    uint32_t dropped;
+
+    portENTER_CRITICAL(&s_lock);
+    while (count < TRACE_LINE_RECORDS && s_tail != s_head) {
+        batch[count++] = s_ring[s_tail % CONFIG_CUBE_TRACE_RECORDS];
+        s_tail++;
+    }
+    dropped = s_dropped;
+    portEXIT_CRITICAL(&s_lock);
+
+    // Losses are reported in the stream itself, after the records that made it
+    if (dropped != *reported_drops && count < TRACE_LINE_RECORDS) {
+        batch[count++] = (trace_record_t){
+            .time_us = (uint32_t)esp_timer_get_time(),
+            .id = TRACE_DROPPED,
+            .b = dropped - *reported_drops,
+        };
+        *reported_drops = dropped;
+    }
+
+    char *p = line;
+    for (uint32_t i = 0; i < count; i++) {
+        p = trace_hex(p, &batch[i]);
+    }
+    *p = '\0';
+
+    return count;
+}
+
+// Formatting and console output happen here, at the lowest priority above idle.
+// Sleeps while the ring is empty, so an idle role is not woken every flush period.
+static void trace_task(void *pvParameter)
+{
+    static char line[TRACE_LINE_RECORDS * sizeof(trace_record_t) * 2 + 1];
+    uint32_t reported_drops = 0;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_CUBE_TRACE_FLUSH_MS));
+
+        while (trace_fill_line(line, &reported_drops) > 0) {
+            printf("TRC:%s\n", line);
+        }
+        fflush(stdout);
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void TRACE_init(void)
+{
+    xTaskCreate(trace_task, "trace_task", TRACE_TASK_STACK_SIZE, NULL, TRACE_TASK_PRIORITY, &s_task);
+
+    ESP_LOGI(TAG, "Binary trace, %d records, decode with tools/trace_decode.py", CONFIG_CUBE_TRACE_RECORDS);
+}
+
+#endif /* CONFIG_CUBE_TRACE */
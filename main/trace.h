@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// Event ids, tools/trace_decode.py has the same table. Only append, the ids are in captured logs
+typedef enum {
+    TRACE_ESPNOW_RX = 1,        // a: peer | rssi << 8, b: MAC tail, c: distance in cm or TRACE_NO_VALUE
+    TRACE_ESPNOW_TX_OK,         // b: MAC tail
+    TRACE_ESPNOW_TX_FAIL,       // a: esp_now_send_status_t, b: MAC tail
+    TRACE_FTM_REPORT,           // a: report entries, b: RTT in ns, c: distance in cm
+    TRACE_DROPPED,              // b: records lost because the ring was full, added by the drain task
+    TRACE_CSI_MOTION,           // a: peer, b: 1 motion started, 0 ended, c: motion score in 1/1000
+    TRACE_ESPNOW_LATENCY,       // a: peer, b: one-way latency in us (signed), c: error bound in us of both clocks
+    TRACE_ZONE,                 // a: peer | zone << 8, b: previous zone, c: distance in cm
+} trace_event_t;
+
+#define TRACE_NO_VALUE          (UINT32_MAX)
+
+// 16 bytes, printed as raw little-endian hex by the drain task
+typedef struct {
+    uint32_t time_us;           // Low 32 bits of esp_timer_get_time(), the decoder unwraps it
+    uint16_t id;                // trace_event_t
+    uint16_t a;
+    uint32_t b;
+    uint32_t c;
+} trace_record_t;
+
+// Last four bytes of a MAC address, enough to tell the peers apart
+static inline uint32_t TRACE_mac_tail(const uint8_t *mac)
+{
+    return ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+}
+
+#if CONFIG_CUBE_TRACE
+
+/**
+ * @brief Start the low priority task that drains the ring to the console
+ *
+ * Each batch is one "TRC:" line of hex records, decode a captured log with
+ * tools/trace_decode.py. The task sleeps while the ring is empty and prints
+ * CONFIG_CUBE_TRACE_FLUSH_MS after the first new record.
+ */
+extern void TRACE_init(void);
+
+/**
+ * @brief Copy one record into the ring, no formatting and no blocking
+ *
+ * Safe from any task. When the ring is full the record is dropped and counted.
+ */
+extern void TRACE_record(trace_event_t id, uint16_t a, uint32_t b, uint32_t c);
+
+#else
+
+static inline void TRACE_init(void) {}
+static inline void TRACE_record(trace_event_t id, uint16_t a, uint32_t b, uint32_t c)
+{
+    (void)id; (void)a; (void)b; (void)c;
+}
+
+#endif
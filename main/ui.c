@@ -0,0 +1,565 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "lvgl.h"
+
+#include "ui.h"
+#include "history.h"
+#include "gauge.h"
+#include "fonts.h"
+#include "perf.h"
+
+/* Global structure to hold all LVGL objects, both screens are built once */
+typedef struct {
+    /* Screen 0 objects */
+    lv_obj_t *screen_selection;
+    lv_obj_t *label_selection;
+
+    /* Screen 1 objects */
+    lv_obj_t *screen_main;
+    lv_obj_t *label_value;
+    lv_obj_t *gauge;
+    lv_obj_t *btn_set;
+    lv_obj_t *label_set;
+    lv_obj_t *btn_enter;
+    lv_obj_t *label_enter;
+
+    /* Screen 2 objects */
+    lv_obj_t *screen_history;
+    lv_obj_t *label_history;
+    lv_obj_t *chart;
+    lv_chart_series_t *series;
+
+    /* Screen 3 objects, only with CONFIG_CUBE_DIAG */
+    lv_obj_t *screen_diag;
+    lv_obj_t *label_diag;
+} lvgl_objects_t;
+
+/* Chart values are decimeters, the y range grows in steps of 5 m */
+#define UI_HISTORY_RANGE_STEP_DM    50
+
+/* Task lines below the three memory lines, fills the 128 px screen */
+#define UI_DIAG_TASK_LINES          5
+
+static lvgl_objects_t g_lvgl_objects = {0};
+static uint8_t s_ui_screen = 0u;
+static bool s_ui_led_on = true;
+static char s_mac_string[32] = {0};
+
+/* What the chart currently shows */
+static uint8_t s_history_peer = HISTORY_NO_PEER;
+static uint32_t s_history_total = 0;
+static int32_t s_history_range_dm = 0;
+
+static const char *ui_mode_name(DeviceMode_t mode)
+{
+    switch(mode) {
+        case EspNowReceiver:
+            return "ESP-NOW Receiver";
+        case EspNowSender:
+            return "ESP-NOW Sender";
+        case FtmClient:
+            return "FTM Client";
+        case FtmResponder:
+            return "FTM Responder";
+        case Collector:
+            return "Collector";
+    }
+
+    return "";
+}
+
+static void lv_screen_update_gauge(lv_obj_t* gauge, const ui_model_t *model)
+{
+    if (gauge == NULL) {
+        return;
+    }
+
+    if( model->calib_step != 0 ) {
+        lv_obj_add_flag(gauge, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    lv_obj_remove_flag(gauge, LV_OBJ_FLAG_HIDDEN);
+
+    if(     ( model->mode == EspNowReceiver )
+        ||  ( model->mode == FtmClient ) ) {
+        GAUGE_set_value(gauge, (int32_t)model->distance);
+    }
+    else {
+        // Sweep once per acknowledged frame instead of animating continuously
+        int32_t value = 50.0 * cos((2.0*3.184*model->time_ms)/4000.0);
+        value += 50;
+        GAUGE_set_value(gauge, value);
+    }
+}
+
+static void lv_screen_update_led(lv_obj_t* gauge, const ui_model_t *model, bool packet)
+{
+    lv_color_t color;
+
+    if (gauge == NULL) {
+        return;
+    }
+
+    if (packet) {
+        s_ui_led_on = !s_ui_led_on;
+    }
+
+    if( model->link_state == LINKMON_STATE_ALIVE ) {
+        color = lv_color_hex(0x0000FF);
+    } else if ( model->link_state == LINKMON_STATE_DEGRADED ) {
+        color = lv_palette_main(LV_PALETTE_YELLOW);
+    } else {
+        color = lv_palette_main(LV_PALETTE_RED);
+    }
+
+    GAUGE_set_led(gauge, color, s_ui_led_on);
+}
+
+static void lv_screen_show_ftm_distance(lv_obj_t* label, const ui_model_t *model)
+{
+    char distance_str[32];
+    snprintf(distance_str, sizeof(distance_str), "%.0fm", ceilf(model->distance));
+    lv_obj_set_style_text_font(label, FONT_UI_12, 0);
+    lv_obj_align(label, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_label_set_text(label, distance_str);
+}
+
+static void lv_screen_update_label(lv_obj_t* label, const ui_model_t *model)
+{
+    // Set on every update, a red alert or blue recording must not color the next text
+    lv_color_t color = lv_color_hex(0x000000);
+
+    if (label == NULL) {
+        return;
+    }
+
+    if( model->link_state != LINKMON_STATE_NONE ) {
+        if( model->link_state == LINKMON_STATE_ALIVE ) {
+            if( model->mode == EspNowReceiver ) {
+                if( model->calib_step == 0 ) {
+                    char distance_str[32];
+                    if( model->zone == ZONE_IMMEDIATE ) {
+                        snprintf(distance_str, sizeof(distance_str), "P%d too close!", model->zone_peer + 1);
+                        color = lv_palette_main(LV_PALETTE_RED);
+                    }
+                    else if( model->approach.state == APPROACH_CLOSING_FAST ) {
+                        snprintf(distance_str, sizeof(distance_str), "P%d closing! %.1fs",
+                                 model->approach_peer + 1, model->approach.ttc_s);
+                        color = lv_palette_main(LV_PALETTE_RED);
+                    }
+                    else if( model->approach.state == APPROACH_CLOSING ) {
+                        snprintf(distance_str, sizeof(distance_str), "P%d closing %.1fm/s",
+                                 model->approach_peer + 1, -model->approach.rate_mps);
+                    }
+                    else if( model->fingerprint.recording ) {
+                        snprintf(distance_str, sizeof(distance_str), "Rec S%d %d/%d", model->fingerprint.record_spot,
+                                 model->fingerprint.recorded, model->fingerprint.record_target);
+                        color = lv_palette_main(LV_PALETTE_BLUE);
+                    }
+                    else if( model->fingerprint.located && model->fingerprint.name[0] != '\0' ) {
+                        snprintf(distance_str, sizeof(distance_str), "At %s", model->fingerprint.name);
+                    }
+                    else if( model->fingerprint.located ) {
+                        snprintf(distance_str, sizeof(distance_str), "Spot %d (%d/%d)", model->fingerprint.spot,
+                                 model->fingerprint.votes, model->fingerprint.k);
+                    }
+                    else {
+                        snprintf(distance_str, sizeof(distance_str), "< %.0fm (RSSI: %d)", ceilf(model->distance), model->rssi);
+                    }
+                    lv_obj_set_style_text_font(label, FONT_UI_12, 0);
+                    lv_obj_align(label, LV_ALIGN_BOTTOM_MID, 0, 0);
+                    lv_label_set_text(label, distance_str);
+                }
+                else {
+                    char distance_str[64];
+                    snprintf(distance_str, sizeof(distance_str), "Press Apply at exactly 1m. (RSSI: %d)", model->rssi);
+                    lv_obj_set_style_text_font(label, FONT_UI_14, 0);
+                    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+                    lv_label_set_text(label, distance_str);
+                }
+            }
+            else if( model->mode == Collector ) {
+                lv_label_set_text(label, "Collecting...");
+            }
+            else if( ( model->mode == FtmClient ) && model->distance_valid ) {
+                // FTM reports feed the link monitor too, the client keeps showing its distance
+                lv_screen_show_ftm_distance(label, model);
+            }
+            else {
+                lv_label_set_text(label, "Broadcasting...");
+            }
+        } else if ( model->link_state == LINKMON_STATE_DEGRADED ) {
+            lv_label_set_text(label, "Waiting...");
+        } else {
+            lv_label_set_text(label, "No connection!");
+        }
+    }
+    else if( ( model->mode == FtmClient ) && model->distance_valid ) {
+        lv_screen_show_ftm_distance(label, model);
+    }
+
+    lv_obj_set_style_text_color(label, color, LV_PART_MAIN);
+}
+
+static void lv_screen_update_calib(lvgl_objects_t* objects, const ui_model_t *model)
+{
+    if (objects == NULL) {
+        return;
+    }
+
+    if(model->calib_step == 0) {
+        if (objects->btn_set != NULL) {
+            lv_obj_set_size(objects->btn_set, 5, 20);
+        }
+        if (objects->label_set != NULL) {
+            lv_label_set_text(objects->label_set, "");
+        }
+        if (objects->btn_enter != NULL) {
+            lv_obj_add_flag(objects->btn_enter, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+    else {
+        if (objects->btn_set != NULL) {
+            lv_obj_set_size(objects->btn_set, 45, 20);
+        }
+        if (objects->label_set != NULL) {
+            lv_label_set_text(objects->label_set, "Abort");
+        }
+        if (objects->btn_enter != NULL) {
+            lv_obj_remove_flag(objects->btn_enter, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+}
+
+static void lv_screen_update_label_selection(lv_obj_t* label, const ui_model_t *model)
+{
+    if (label == NULL) {
+        return;
+    }
+
+    lv_label_set_text(label, ui_mode_name(model->mode));
+}
+
+static void ui_history_update_range(void)
+{
+    uint16_t distance_cm;
+    int32_t max_dm = 0;
+
+    for (uint32_t age = 0; HISTORY_get(s_history_peer, age, &distance_cm); age++) {
+        max_dm = LV_MAX(max_dm, distance_cm / 10);
+    }
+
+    const int32_t range_dm = LV_MAX(1, (max_dm + UI_HISTORY_RANGE_STEP_DM - 1) / UI_HISTORY_RANGE_STEP_DM) * UI_HISTORY_RANGE_STEP_DM;
+    if (range_dm != s_history_range_dm) {
+        s_history_range_dm = range_dm;
+        lv_chart_set_range(g_lvgl_objects.chart, LV_CHART_AXIS_PRIMARY_Y, 0, range_dm);
+    }
+}
+
+static void lv_screen_update_history(const ui_model_t *model)
+{
+    lv_obj_t *chart = g_lvgl_objects.chart;
+    uint16_t distance_cm;
+
+    if (chart == NULL) {
+        return;
+    }
+
+    const uint8_t count = HISTORY_get_peer_count();
+    const uint8_t peer = (count > 0) ? model->history_peer % count : 0;
+    const uint32_t total = HISTORY_get_total(peer);
+    bool reload = false;
+
+    if (peer != s_history_peer || total < s_history_total || total - s_history_total > HISTORY_LENGTH) {
+        // Other peer, history reset or too far behind: load the whole buffer once
+        reload = true;
+        s_history_peer = peer;
+        s_history_total = (total > HISTORY_LENGTH) ? total - HISTORY_LENGTH : 0;
+        lv_chart_set_all_value(chart, g_lvgl_objects.series, LV_CHART_POINT_NONE);
+    }
+
+    if (total == s_history_total && !reload) {
+        return;
+    }
+
+    // Shift mode: each new sample scrolls the series by one point
+    for (uint32_t age = total - s_history_total; age-- > 0;) {
+        if (HISTORY_get(peer, age, &distance_cm)) {
+            lv_chart_set_next_value(chart, g_lvgl_objects.series, distance_cm / 10);
+        }
+    }
+    s_history_total = total;
+
+    ui_history_update_range();
+
+    if (HISTORY_get(peer, 0, &distance_cm)) {
+        lv_label_set_text_fmt(g_lvgl_objects.label_history, "Peer %d: %d.%dm", peer + 1, distance_cm / 100, (distance_cm / 10) % 10);
+    }
+    else {
+        lv_label_set_text(g_lvgl_objects.label_history, "No data yet");
+    }
+}
+
+static void lv_screen_update_diag(const ui_model_t *model)
+{
+    const diag_snapshot_t *d = model->diag;
+    char text[256];
+    int len;
+
+    if (g_lvgl_objects.label_diag == NULL || d == NULL) {
+        return;
+    }
+
+    if (d->period_ms == 0) {
+        lv_label_set_text(g_lvgl_objects.label_diag, "Collecting...");
+        return;
+    }
+
+    len = snprintf(text, sizeof(text), "Heap %luk min %luk\nDMA %luk max %luk\nLVGL %lu/%luk fr %d%%",
+                   (unsigned long)(d->heap_free / 1024), (unsigned long)(d->heap_min / 1024),
+                   (unsigned long)(d->dma_free / 1024), (unsigned long)(d->dma_largest / 1024),
+                   (unsigned long)((d->lv_total - d->lv_free) / 1024), (unsigned long)(d->lv_total / 1024),
+                   d->lv_frag_pct);
+
+    // Name, stack bytes never used, CPU share of the last period
+    for (uint8_t i = 0; i < d->task_count && i < UI_DIAG_TASK_LINES && len < (int)sizeof(text); i++) {
+        const diag_task_t *t = &d->tasks[i];
+        len += snprintf(&text[len], sizeof(text) - len, "\n%.10s %d %d.%d%%",
+                        t->name, t->stack_free, t->cpu_permille / 10, t->cpu_permille % 10);
+    }
+
+    lv_label_set_text(g_lvgl_objects.label_diag, text);
+}
+
+static void ui_update_view(const ui_model_t *model)
+{
+    // Leaving the history or the diagnostics goes to the mode selection, main.c loads that screen
+    if (s_ui_screen == 1 && model->history_view) {
+        s_history_peer = HISTORY_NO_PEER;
+        lv_screen_load(g_lvgl_objects.screen_history);
+        s_ui_screen = 2u;
+    }
+    if (s_ui_screen == 2 && model->diag_view && g_lvgl_objects.screen_diag != NULL) {
+        lv_screen_update_diag(model);
+        lv_screen_load(g_lvgl_objects.screen_diag);
+        s_ui_screen = 3u;
+    }
+}
+
+static void ui_create_screen_selection(const ui_model_t *model)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *btn;
+    lv_obj_t *label;
+
+    g_lvgl_objects.screen_selection = screen;
+
+    g_lvgl_objects.label_selection = lv_label_create(screen);
+    lv_label_set_text(g_lvgl_objects.label_selection, ui_mode_name(model->mode));
+    lv_obj_set_style_text_font(g_lvgl_objects.label_selection, FONT_UI_14, 0);
+    lv_obj_align(g_lvgl_objects.label_selection, LV_ALIGN_CENTER, 0, 0);
+    lv_label_set_long_mode(g_lvgl_objects.label_selection, LV_LABEL_LONG_WRAP);     /*Break the long lines*/
+    lv_obj_set_style_text_align(g_lvgl_objects.label_selection, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_set_width(g_lvgl_objects.label_selection, 120);  /*Set smaller width to make the lines wrap*/
+
+    /*Create Set and Enter buttons*/
+    btn = lv_btn_create(screen);
+    lv_obj_set_size(btn, 35, 20);
+    lv_obj_align(btn, LV_ALIGN_TOP_LEFT, 2, 10);
+    label = lv_label_create(btn);
+    lv_obj_set_style_text_font(label, FONT_UI_12, 0);
+    lv_label_set_text(label, "Set");
+    lv_obj_center(label);
+
+    btn = lv_btn_create(screen);
+    lv_obj_set_size(btn, 45, 20);
+    lv_obj_align(btn, LV_ALIGN_BOTTOM_LEFT, 2, -10);
+    label = lv_label_create(btn);
+    lv_obj_set_style_text_font(label, FONT_UI_12, 0);
+    lv_label_set_text(label, "Enter");
+    lv_obj_center(label);
+}
+
+static void ui_create_screen_main(void)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+
+    g_lvgl_objects.screen_main = screen;
+
+    /*Change the screen's background color to white*/
+    lv_obj_set_style_bg_color(screen, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+
+    /*Create a black label with the MAC address until the first radio data arrives*/
+    g_lvgl_objects.label_value = lv_label_create(screen);
+    lv_label_set_text(g_lvgl_objects.label_value, s_mac_string);
+    lv_obj_set_style_text_color(g_lvgl_objects.label_value, lv_color_hex(0x000000), LV_PART_MAIN);  /* Black text for contrast */
+    lv_obj_set_style_text_font(g_lvgl_objects.label_value, FONT_UI_12, 0);
+    lv_obj_align(g_lvgl_objects.label_value, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_label_set_long_mode(g_lvgl_objects.label_value, LV_LABEL_LONG_WRAP);     /*Break the long lines*/
+    lv_obj_set_style_text_align(g_lvgl_objects.label_value, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_set_width(g_lvgl_objects.label_value, 120);  /*Set smaller width to make the lines wrap*/
+
+    /*Create the distance gauge with the status LED in its center, the range is set per mode*/
+    g_lvgl_objects.gauge = GAUGE_create(screen, 110);
+    lv_obj_center(g_lvgl_objects.gauge);
+
+    /*Create Set button*/
+    g_lvgl_objects.btn_set = lv_btn_create(screen);
+    lv_obj_set_size(g_lvgl_objects.btn_set, 5, 20);
+    lv_obj_align(g_lvgl_objects.btn_set, LV_ALIGN_TOP_LEFT, 2, 10);
+    lv_obj_set_style_bg_color(g_lvgl_objects.btn_set, lv_color_hex(0x0000FF), LV_PART_MAIN);  /* Blue button */
+    g_lvgl_objects.label_set = lv_label_create(g_lvgl_objects.btn_set);
+    lv_obj_set_style_text_font(g_lvgl_objects.label_set, FONT_UI_12, 0);
+    lv_obj_set_style_text_color(g_lvgl_objects.label_set, lv_color_hex(0xFFFFFF), LV_PART_MAIN);  /* White text */
+    lv_label_set_text(g_lvgl_objects.label_set, "");
+    lv_obj_center(g_lvgl_objects.label_set);
+
+    /*Create Enter button*/
+    g_lvgl_objects.btn_enter = lv_btn_create(screen);
+    lv_obj_set_size(g_lvgl_objects.btn_enter, 45, 20);
+    lv_obj_align(g_lvgl_objects.btn_enter, LV_ALIGN_BOTTOM_LEFT, 2, -10);
+    lv_obj_set_style_bg_color(g_lvgl_objects.btn_enter, lv_color_hex(0x0000FF), LV_PART_MAIN);  /* Blue button */
+    g_lvgl_objects.label_enter = lv_label_create(g_lvgl_objects.btn_enter);
+    lv_obj_set_style_text_font(g_lvgl_objects.label_enter, FONT_UI_12, 0);
+    lv_obj_set_style_text_color(g_lvgl_objects.label_enter, lv_color_hex(0xFFFFFF), LV_PART_MAIN);  /* White text */
+    lv_label_set_text(g_lvgl_objects.label_enter, "Apply");
+    lv_obj_center(g_lvgl_objects.label_enter);
+    lv_obj_add_flag(g_lvgl_objects.btn_enter, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void ui_create_screen_history(void)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+
+    g_lvgl_objects.screen_history = screen;
+    lv_obj_set_style_bg_color(screen, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+
+    g_lvgl_objects.label_history = lv_label_create(screen);
+    lv_obj_set_style_text_color(g_lvgl_objects.label_history, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_text_font(g_lvgl_objects.label_history, FONT_UI_12, 0);
+    lv_label_set_text(g_lvgl_objects.label_history, "No data yet");
+    lv_obj_align(g_lvgl_objects.label_history, LV_ALIGN_TOP_MID, 0, 2);
+
+    /*Line chart in shift mode, one point per filtered sample*/
+    g_lvgl_objects.chart = lv_chart_create(screen);
+    lv_obj_set_size(g_lvgl_objects.chart, 120, 100);
+    lv_obj_align(g_lvgl_objects.chart, LV_ALIGN_BOTTOM_MID, 0, -4);
+    lv_chart_set_type(g_lvgl_objects.chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_update_mode(g_lvgl_objects.chart, LV_CHART_UPDATE_MODE_SHIFT);
+    lv_chart_set_point_count(g_lvgl_objects.chart, HISTORY_LENGTH);
+    lv_chart_set_div_line_count(g_lvgl_objects.chart, 5, 0);
+    lv_obj_set_style_size(g_lvgl_objects.chart, 0, 0, LV_PART_INDICATOR);  /* No point markers */
+    lv_obj_set_style_pad_all(g_lvgl_objects.chart, 2, LV_PART_MAIN);
+    g_lvgl_objects.series = lv_chart_add_series(g_lvgl_objects.chart, lv_color_hex(0x0000FF), LV_CHART_AXIS_PRIMARY_Y);
+
+    s_history_range_dm = UI_HISTORY_RANGE_STEP_DM;
+    lv_chart_set_range(g_lvgl_objects.chart, LV_CHART_AXIS_PRIMARY_Y, 0, s_history_range_dm);
+}
+
+#if CONFIG_CUBE_DIAG
+static void ui_create_screen_diag(void)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+
+    g_lvgl_objects.screen_diag = screen;
+    lv_obj_set_style_bg_color(screen, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+
+    g_lvgl_objects.label_diag = lv_label_create(screen);
+    lv_obj_set_style_text_color(g_lvgl_objects.label_diag, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_set_style_text_font(g_lvgl_objects.label_diag, FONT_UI_12, 0);
+    lv_label_set_long_mode(g_lvgl_objects.label_diag, LV_LABEL_LONG_CLIP);
+    lv_obj_set_width(g_lvgl_objects.label_diag, 124);
+    lv_label_set_text(g_lvgl_objects.label_diag, "Collecting...");
+    lv_obj_align(g_lvgl_objects.label_diag, LV_ALIGN_TOP_LEFT, 2, 2);
+}
+#endif
+
+void UI_create(const ui_model_t *model, const char *mac_string)
+{
+    snprintf(s_mac_string, sizeof(s_mac_string), "%s", mac_string);
+
+    ui_create_screen_selection(model);
+    ui_create_screen_main();
+    ui_create_screen_history();
+#if CONFIG_CUBE_DIAG
+    ui_create_screen_diag();
+#endif
+
+    lv_screen_load(g_lvgl_objects.screen_selection);
+    s_ui_screen = 0u;
+}
+
+void UI_show_selection(const ui_model_t *model)
+{
+    lv_screen_update_label_selection(g_lvgl_objects.label_selection, model);
+
+    lv_screen_load(g_lvgl_objects.screen_selection);
+    s_ui_screen = 0u;
+}
+
+void UI_show_main(const ui_model_t *model)
+{
+    lv_obj_t *gauge = g_lvgl_objects.gauge;
+
+    // Reset what the previous mode left behind
+    if(     ( model->mode == EspNowReceiver )
+        ||  ( model->mode == FtmClient ) ) {
+        GAUGE_set_symmetrical(gauge, false);
+        GAUGE_set_range(gauge, 0, 50);
+    }
+    else {
+        GAUGE_set_range(gauge, 0, 100);
+        GAUGE_set_symmetrical(gauge, true);
+    }
+
+    GAUGE_set_value(gauge, 100);
+    s_ui_led_on = true;
+    GAUGE_set_led(gauge, lv_color_hex(0x0000FF), s_ui_led_on);
+
+    lv_obj_set_style_text_font(g_lvgl_objects.label_value, FONT_UI_12, 0);
+    lv_obj_set_style_text_color(g_lvgl_objects.label_value, lv_color_hex(0x000000), LV_PART_MAIN);
+    lv_obj_align(g_lvgl_objects.label_value, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_label_set_text(g_lvgl_objects.label_value, s_mac_string);
+
+    lv_screen_update_calib(&g_lvgl_objects, model);
+    lv_screen_update_gauge(gauge, model);
+
+    lv_screen_load(g_lvgl_objects.screen_main);
+    s_ui_screen = 1u;
+}
+
+void UI_update(uint32_t dirty, const ui_model_t *model)
+{
+    if (dirty & UI_DIRTY_INPUT) {
+        ui_update_view(model);
+    }
+
+    if (s_ui_screen == 0) {
+        if (dirty & UI_DIRTY_INPUT) {
+            PERF_MEASURE(PERF_PROBE_UPDATE_SELECTION, lv_screen_update_label_selection(g_lvgl_objects.label_selection, model));
+        }
+    }
+    else if (s_ui_screen == 3) {
+        if (dirty & UI_DIRTY_DIAG) {
+            lv_screen_update_diag(model);
+        }
+    }
+    else if (s_ui_screen == 2) {
+        if (dirty & (UI_DIRTY_RADIO | UI_DIRTY_INPUT)) {
+            PERF_MEASURE(PERF_PROBE_UPDATE_HISTORY, lv_screen_update_history(model));
+        }
+    }
+    else {
+        if (dirty & UI_DIRTY_INPUT) {
+            PERF_MEASURE(PERF_PROBE_UPDATE_CALIB, lv_screen_update_calib(&g_lvgl_objects, model));
+        }
+        if (dirty & (UI_DIRTY_RADIO | UI_DIRTY_INPUT)) {
+            PERF_MEASURE(PERF_PROBE_UPDATE_GAUGE, lv_screen_update_gauge(g_lvgl_objects.gauge, model));
+        }
+        PERF_MEASURE(PERF_PROBE_UPDATE_LED, lv_screen_update_led(g_lvgl_objects.gauge, model, (dirty & UI_DIRTY_RADIO) != 0));
+        PERF_MEASURE(PERF_PROBE_UPDATE_LABEL, lv_screen_update_label(g_lvgl_objects.label_value, model));
+    }
+}
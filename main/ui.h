@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "approach.h"
+#include "zone.h"
+#include "fingerprint.h"
+#include "linkmon.h"
+#include "diag.h"
+
+// The UI only depends on LVGL. Everything it shows is passed in through ui_model_t,
+// so the screens can be built and updated without the BSP, the radio or FreeRTOS.
+
+typedef enum {
+    EspNowSender,
+    EspNowReceiver,
+    FtmClient,
+    FtmResponder,
+    Collector
+} DeviceMode_t;
+
+/* What has to be redrawn */
+#define UI_DIRTY_RADIO  (1u << 0)   // New radio data, toggles the status LED
+#define UI_DIRTY_INPUT  (1u << 1)   // Mode selection or calibration step changed
+#define UI_DIRTY_LINK   (1u << 2)   // Link monitor reported a state change
+#define UI_DIRTY_DIAG   (1u << 3)   // New diagnostics snapshot
+#define UI_DIRTY_ZONE   (1u << 4)   // Proximity zone of a peer changed
+
+/* Snapshot of everything the screens display */
+typedef struct {
+    DeviceMode_t mode;
+    uint8_t calib_step;
+    linkmon_state_t link_state; // Best link of all sources and peers, sets LED color and label
+    int16_t rssi;
+    float distance;             // Meters
+    bool distance_valid;
+    approach_result_t approach; // Most urgent approaching peer of the receiver
+    uint8_t approach_peer;      // Its slot, HISTORY_NO_PEER if none
+    zone_t zone;                // Nearest proximity zone of all peers of the receiver
+    uint8_t zone_peer;          // Peer in that zone, HISTORY_NO_PEER if none
+    fingerprint_status_t fingerprint;   // Nearest spot, only with CONFIG_CUBE_FINGERPRINT
+    uint32_t time_ms;           // Monotonic time, drives the broadcast sweep
+    bool history_view;          // Distance history instead of the gauge
+    uint8_t history_peer;       // Shown peer, wrapped around the number of peers heard
+    bool diag_view;             // Diagnostics instead of the history, only with CONFIG_CUBE_DIAG
+    const diag_snapshot_t *diag;
+} ui_model_t;
+
+/**
+ * @brief Build the mode selection and the main screen once and show the selection
+ *
+ * Both screens stay alive, switching modes only loads the other screen.
+ *
+ * @param model Current UI state
+ * @param mac_string Own MAC address, shown on the main screen until radio data arrives
+ */
+extern void UI_create(const ui_model_t *model, const char *mac_string);
+extern void UI_show_selection(const ui_model_t *model);
+extern void UI_show_main(const ui_model_t *model);
+extern void UI_update(uint32_t dirty, const ui_model_t *model);
@@ -0,0 +1,70 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "zone.h"
+
+void ZONE_init(zone_tracker_t *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+// Leaving the current zone needs half the hysteresis beyond the edge, entering the next one too
+static zone_t zone_classify(const zone_config_t *config, zone_t current, uint16_t distance_cm)
+{
+    const int32_t half = config->hysteresis_cm / 2;
+    zone_t zone = ZONE_IMMEDIATE;
+
+    for (uint8_t i = 0; i < ZONE_EDGES; i++) {
+        int32_t edge = config->edge_cm[i];
+
+        // Edge i lies between zone i + 1 and zone i + 2
+        if (current != ZONE_UNKNOWN) {
+            edge += ((int32_t)current <= i + 1) ? half : -half;
+        }
+        if (distance_cm >= edge) {
+            zone = (zone_t)(i + 2);
+        }
+    }
+
+    return zone;
+}
+
+bool ZONE_update(zone_tracker_t *t, const zone_config_t *config, int64_t time_us, uint16_t distance_cm,
+                 zone_t *previous)
+{
+    const zone_t next = zone_classify(config, (zone_t)t->zone, distance_cm);
+
+    t->last_us = time_us;
+
+    if (next == t->zone) {
+        t->candidate = t->zone;
+        return false;
+    }
+
+    if (next != t->candidate) {
+        t->candidate = next;
+        t->candidate_us = time_us;
+    }
+
+    if (time_us - t->candidate_us < (int64_t)config->dwell_ms * 1000) {
+        return false;
+    }
+
+    *previous = (zone_t)t->zone;
+    t->zone = next;
+
+    return true;
+}
+
+bool ZONE_expire(zone_tracker_t *t, int64_t now_us, uint32_t timeout_ms, zone_t *previous)
+{
+    if (t->zone == ZONE_UNKNOWN || now_us - t->last_us < (int64_t)timeout_ms * 1000) {
+        return false;
+    }
+
+    *previous = (zone_t)t->zone;
+    t->zone = ZONE_UNKNOWN;
+    t->candidate = ZONE_UNKNOWN;
+
+    return true;
+}
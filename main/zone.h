@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Plain C without ESP-IDF dependencies, proximity.c feeds it one distance per frame
+
+// Distance edges between the zones, ZONE_EDGES + 1 zones
+#define ZONE_EDGES              (2)
+
+// Ordered from near to far
+typedef enum {
+    ZONE_UNKNOWN = 0,           // No sample yet, or the peer went silent
+    ZONE_IMMEDIATE,             // Closer than edge_cm[0]
+    ZONE_NEAR,                  // Up to edge_cm[1]
+    ZONE_FAR,
+} zone_t;
+
+typedef struct {
+    uint16_t edge_cm[ZONE_EDGES];   // Ascending
+    uint16_t hysteresis_cm;     // Width of the band around each edge that keeps the current zone
+    uint16_t dwell_ms;          // Time a new zone has to persist before it is entered, 0 enters at once
+} zone_config_t;
+
+typedef struct {
+    uint8_t zone;               // zone_t, the confirmed zone
+    uint8_t candidate;          // zone_t, the zone of the recent samples waiting for the dwell time
+    int64_t candidate_us;       // Since when the samples are in the candidate zone
+    int64_t last_us;            // Time of the last sample
+} zone_tracker_t;
+
+extern void ZONE_init(zone_tracker_t *t);
+
+/**
+ * @brief Classify one distance, a few comparisons
+ *
+ * @param previous Zone that was left, only set on a change
+ * @return true if the confirmed zone changed
+ */
+extern bool ZONE_update(zone_tracker_t *t, const zone_config_t *config, int64_t time_us, uint16_t distance_cm,
+                        zone_t *previous);
+
+/**
+ * @brief Leave the zone of a peer that sent nothing for timeout_ms, 0 leaves it in any case
+ *
+ * @return true if the zone changed to ZONE_UNKNOWN
+ */
+extern bool ZONE_expire(zone_tracker_t *t, int64_t now_us, uint32_t timeout_ms, zone_t *previous);
@@ -0,0 +1,118 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_now.h"
+
+#include "fake.h"
+
+#include "EspNowCommon.h"
+#include "EspNowReceiver.h"
+#include "UiUpdate.h"
+#include "linkmon.h"
+#include "proximity.h"
+#include "ranging.h"
+
+/*
+ * Receive path benchmarks on the host, relative numbers only, the ESP32-C3
+ * is an order of magnitude slower. Usage: bench_radio [frames] [estimates]
+ */
+
+#define BENCH_PEERS     (4)
+
+static volatile float s_sink;
+
+static int64_t wall_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Receive callbacks per second, the UI queue is drained outside the measured time
+static void bench_recv_cb(uint32_t frames)
+{
+    uint8_t macs[BENCH_PEERS][ESP_NOW_ETH_ALEN];
+    const char text[] = "Ping 1";
+    ui_update_msg_t msg;
+    int64_t busy_ns = 0;
+    uint32_t done = 0;
+
+    for (uint8_t i = 0; i < BENCH_PEERS; i++) {
+        const uint8_t mac[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x01, i};
+        memcpy(macs[i], mac, ESP_NOW_ETH_ALEN);
+    }
+
+    while (done < frames) {
+        const int64_t start_ns = wall_ns();
+        for (uint8_t i = 0; i < BENCH_PEERS; i++) {
+            FAKE_esp_now_deliver(macs[i], (int8_t)(-40 - (int)(done % 40)), text, (int)strlen(text));
+        }
+        busy_ns += wall_ns() - start_ns;
+        done += BENCH_PEERS;
+
+        while (UIUPDATE_receive(&msg, 0)) {
+        }
+        FAKE_clock_advance(10 * 1000);
+    }
+
+    printf("recv_cb: %lu frames, %.0f ns per frame, %.0f callbacks per second\n", (unsigned long)done,
+           (double)busy_ns / done, done * 1e9 / (double)busy_ns);
+}
+
+// Table lookup against the powf it replaced
+static void bench_estimate(uint32_t count)
+{
+    static ranging_model_t model;
+    float sum = 0.0f;
+
+    RANGING_build(&model, -51.0f, 1.64f);
+
+    int64_t start_ns = wall_ns();
+    for (uint32_t i = 0; i < count; i++) {
+        sum += RANGING_estimate(&model, -30 - (int)(i % 64));
+    }
+    const int64_t table_ns = wall_ns() - start_ns;
+    s_sink = sum;
+
+    sum = 0.0f;
+    start_ns = wall_ns();
+    for (uint32_t i = 0; i < count; i++) {
+        const int rssi = -30 - (int)(i % 64);
+        sum += powf(10.0f, (-51.0f - rssi) / (10.0f * 1.64f));
+    }
+    const int64_t pow_ns = wall_ns() - start_ns;
+    s_sink = sum;
+
+    printf("estimate: %.2f ns per table lookup, %.2f ns per powf\n", (double)table_ns / count,
+           (double)pow_ns / count);
+}
+
+int main(int argc, char **argv)
+{
+    const uint8_t own_mac[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x10};
+    const uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200000;
+    const uint32_t estimates = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 10000000;
+
+    FAKE_log_set_level(ESP_LOG_ERROR);
+    FAKE_wifi_set_mac(own_mac);
+
+    UIUPDATE_init();
+    LINKMON_init(NULL);
+    PROXIMITY_init();
+    ESP_ERROR_CHECK(esp_now_wifi_init());
+    LINKMON_start();
+    PROXIMITY_start();
+    RECEIVER_init();
+
+    bench_recv_cb(frames);
+    bench_estimate(estimates);
+
+    RECEIVER_deinit();
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl.h"
+
+#include "fb.h"
+#include "history.h"
+#include "ui.h"
+
+/*
+ * Render time and pixels redrawn per frame of typical UI updates on the
+ * in-memory display, relative numbers only, the ESP32-C3 renders an order of
+ * magnitude slower and the SPI transfer is not included.
+ * Usage: bench_ui [frames]
+ */
+
+#define BENCH_REFRESH_MS    (33)    // CONFIG_LV_DEF_REFR_PERIOD
+
+typedef void (*bench_step_t)(ui_model_t *model, uint32_t frame);
+
+static int compare_i64(const void *a, const void *b)
+{
+    const int64_t x = *(const int64_t *)a;
+    const int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_run(const char *name, bench_step_t step, ui_model_t *model, uint32_t frames)
+{
+    int64_t *render_ns = malloc(frames * sizeof(int64_t));
+    uint64_t pixels = 0;
+    uint64_t flushes = 0;
+    fb_frame_t frame;
+
+    if (render_ns == NULL) {
+        return;
+    }
+
+    // Settle the screen switch before measuring
+    FB_render(NULL);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        FB_advance(BENCH_REFRESH_MS);
+        model->time_ms += BENCH_REFRESH_MS;
+        step(model, i);
+        FB_render(&frame);
+        render_ns[i] = frame.render_ns;
+        pixels += frame.pixels;
+        flushes += frame.flushes;
+    }
+
+    qsort(render_ns, frames, sizeof(int64_t), compare_i64);
+    int64_t sum_ns = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        sum_ns += render_ns[i];
+    }
+
+    printf("%-20s render avg %6.1f us p50 %6.1f us p99 %6.1f us max %6.1f us, "
+           "%6.0f px %4.1f %% of the screen, %.1f strips per frame\n",
+           name, sum_ns / 1000.0 / frames, render_ns[frames / 2] / 1000.0, render_ns[(frames * 99) / 100] / 1000.0,
+           render_ns[frames - 1] / 1000.0, (double)pixels / frames,
+           100.0 * pixels / frames / (FB_WIDTH * FB_HEIGHT), (double)flushes / frames);
+
+    free(render_ns);
+}
+
+// Reference: what every frame cost before the partial redraws
+static void step_full(ui_model_t *model, uint32_t frame)
+{
+    lv_obj_invalidate(lv_screen_active());
+}
+
+// New distance and LED toggle per frame, as with a 20 Hz sender
+static void step_receiver(ui_model_t *model, uint32_t frame)
+{
+    model->distance = 2.0f + (float)(frame % 40) * 0.25f;
+    model->rssi = (int16_t)(-50 - (int16_t)(frame % 30));
+    UI_update(UI_DIRTY_RADIO, model);
+}
+
+// Acknowledged frames sweep the gauge
+static void step_sender(ui_model_t *model, uint32_t frame)
+{
+    UI_update(UI_DIRTY_RADIO, model);
+}
+
+// LED only, the link state changes but the distance does not
+static void step_led(ui_model_t *model, uint32_t frame)
+{
+    model->link_state = (frame % 2) ? LINKMON_STATE_ALIVE : LINKMON_STATE_DEGRADED;
+    UI_update(UI_DIRTY_LINK, model);
+}
+
+// One new sample scrolls the chart
+static void step_history(ui_model_t *model, uint32_t frame)
+{
+    HISTORY_push(0, 2.0f + (float)(frame % 16) * 0.5f);
+    UI_update(UI_DIRTY_RADIO, model);
+}
+
+static void model_init(ui_model_t *model, DeviceMode_t mode)
+{
+    memset(model, 0, sizeof(*model));
+    model->mode = mode;
+    model->link_state = LINKMON_STATE_ALIVE;
+    model->rssi = -60;
+    model->distance = 3.0f;
+    model->distance_valid = true;
+    model->approach_peer = HISTORY_NO_PEER;
+    model->zone_peer = HISTORY_NO_PEER;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000;
+    ui_model_t model;
+
+    if (frames == 0) {
+        return 1;
+    }
+
+    FB_start();
+    model_init(&model, EspNowReceiver);
+    UI_create(&model, "02:00:00:00:00:01");
+
+    UI_show_main(&model);
+    bench_run("full screen", step_full, &model, frames);
+
+    model_init(&model, EspNowReceiver);
+    UI_show_main(&model);
+    bench_run("receiver", step_receiver, &model, frames);
+
+    model_init(&model, EspNowReceiver);
+    UI_show_main(&model);
+    bench_run("link LED", step_led, &model, frames);
+
+    model_init(&model, EspNowSender);
+    UI_show_main(&model);
+    bench_run("sender sweep", step_sender, &model, frames);
+
+    HISTORY_reset();
+    model_init(&model, EspNowReceiver);
+    UI_show_main(&model);
+    model.history_view = true;
+    UI_update(UI_DIRTY_INPUT, &model);
+    bench_run("history", step_history, &model, frames);
+
+    return 0;
+}
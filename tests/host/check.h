@@ -0,0 +1,42 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+// Minimal checks for the host tests, a failed check is printed and fails the executable
+
+static int s_check_failures = 0;
+
+#define CHECK(cond) do {                                                                        \
+        if (!(cond)) {                                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);            \
+            s_check_failures++;                                                                 \
+        }                                                                                       \
+    } while (0)
+
+#define CHECK_INT(actual, expected) do {                                                        \
+        const long long a_ = (long long)(actual);                                               \
+        const long long e_ = (long long)(expected);                                             \
+        if (a_ != e_) {                                                                         \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+            s_check_failures++;                                                                 \
+        }                                                                                       \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) do {                                            \
+        const double a_ = (double)(actual);                                                     \
+        const double e_ = (double)(expected);                                                   \
+        if (!(fabs(a_ - e_) <= (double)(tolerance))) {                                          \
+            fprintf(stderr, "%s:%d: %s is %g, expected %g +- %g\n", __FILE__, __LINE__, #actual, \
+                    a_, e_, (double)(tolerance));                                               \
+            s_check_failures++;                                                                 \
+        }                                                                                       \
+    } while (0)
+
+#define RUN_TEST(fn) do {                                                                       \
+        const int before_ = s_check_failures;                                                   \
+        fn();                                                                                   \
+        printf("%s %s\n", (s_check_failures == before_) ? "PASS" : "FAIL", #fn);                \
+    } while (0)
+
+#define CHECK_RESULT()  ((s_check_failures == 0) ? 0 : 1)
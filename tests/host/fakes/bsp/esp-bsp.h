@@ -0,0 +1,3 @@
+#pragma once
+
+// The radio paths include the BSP header without using it, the display has its own host build
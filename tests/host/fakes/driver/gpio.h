@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_MAX            (22)
+
+typedef enum {
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+typedef enum {
+    GPIO_MODE_DISABLE = 0,
+    GPIO_MODE_INPUT,
+    GPIO_MODE_OUTPUT,
+    GPIO_MODE_INPUT_OUTPUT,
+} gpio_mode_t;
+
+typedef enum {
+    GPIO_PULLUP_DISABLE = 0,
+    GPIO_PULLUP_ENABLE,
+} gpio_pullup_t;
+
+typedef enum {
+    GPIO_PULLDOWN_DISABLE = 0,
+    GPIO_PULLDOWN_ENABLE,
+} gpio_pulldown_t;
+
+typedef struct {
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+typedef void (*gpio_isr_t)(void *arg);
+
+extern esp_err_t gpio_config(const gpio_config_t *config);
+extern esp_err_t gpio_reset_pin(gpio_num_t gpio);
+extern esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode);
+extern esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level);
+extern int gpio_get_level(gpio_num_t gpio);
+extern esp_err_t gpio_install_isr_service(int flags);
+extern esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg);
+extern esp_err_t gpio_isr_handler_remove(gpio_num_t gpio);
+extern esp_err_t gpio_intr_enable(gpio_num_t gpio);
+extern esp_err_t gpio_intr_disable(gpio_num_t gpio);
+extern esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t intr_type);
+extern esp_err_t gpio_wakeup_disable(gpio_num_t gpio);
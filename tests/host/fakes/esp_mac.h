@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define ESP_MAC_ADDR_LEN    (6)
+
+#define MACSTR              "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a)          (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
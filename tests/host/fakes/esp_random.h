@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fixed sequence, the tests stay repeatable
+extern uint32_t esp_random(void);
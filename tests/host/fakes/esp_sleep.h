@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Implemented in fake_gpio.c, read back with FAKE_gpio_get_wakeup()
+extern esp_err_t esp_sleep_enable_gpio_wakeup(void);
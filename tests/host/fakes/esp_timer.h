@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Runs on the virtual clock, timers fire in FAKE_clock_advance()
+
+typedef struct fake_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+extern esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+extern esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+extern esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+extern esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+extern esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+extern bool esp_timer_is_active(esp_timer_handle_t timer);
+extern int64_t esp_timer_get_time(void);
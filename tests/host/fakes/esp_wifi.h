@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+#define ESP_IF_WIFI_STA         WIFI_IF_STA
+#define ESP_IF_WIFI_AP          WIFI_IF_AP
+
+typedef enum {
+    WIFI_PS_NONE = 0,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+#define WIFI_PROTOCOL_11B       (1)
+#define WIFI_PROTOCOL_11G       (2)
+#define WIFI_PROTOCOL_11N       (4)
+#define WIFI_PROTOCOL_LR        (8)
+
+typedef struct {
+    signed rssi : 8;
+    unsigned channel : 4;
+    uint32_t timestamp;         // Microseconds of the MAC clock, its own epoch
+    unsigned sig_len : 12;
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;
+    int8_t rssi;
+    uint32_t ftm_responder : 1;
+    uint32_t ftm_initiator : 1;
+} wifi_ap_record_t;
+
+typedef struct {
+    uint8_t *ssid;
+    uint8_t *bssid;
+    uint8_t channel;
+    bool show_hidden;
+} wifi_scan_config_t;
+
+typedef struct {
+    uint8_t resp_mac[6];
+    uint8_t channel;
+    uint8_t frm_count;
+    uint16_t burst_period;
+    bool use_get_report_api;
+} wifi_ftm_initiator_cfg_t;
+
+typedef enum {
+    WIFI_EVENT_WIFI_READY = 0,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+    WIFI_EVENT_AP_START,
+    WIFI_EVENT_AP_STOP,
+    WIFI_EVENT_FTM_REPORT,
+} wifi_event_t;
+
+typedef enum {
+    FTM_STATUS_SUCCESS = 0,
+    FTM_STATUS_UNSUPPORTED,
+    FTM_STATUS_CONF_REJECTED,
+    FTM_STATUS_NO_RESPONSE,
+    FTM_STATUS_FAIL,
+} wifi_ftm_status_t;
+
+typedef struct {
+    uint8_t peer_mac[6];
+    wifi_ftm_status_t status;
+    uint32_t rtt_raw;
+    uint32_t rtt_est;
+    uint32_t dist_est;
+    void *ftm_report_data;
+    uint8_t ftm_report_num_entries;
+} wifi_event_ftm_report_t;
+
+extern esp_event_base_t const WIFI_EVENT;
+
+extern esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+extern esp_err_t esp_wifi_get_mode(wifi_mode_t *mode);
+extern esp_err_t esp_wifi_start(void);
+extern esp_err_t esp_wifi_stop(void);
+extern esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol);
+extern esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+extern esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+extern esp_err_t esp_wifi_force_wakeup_acquire(void);
+extern esp_err_t esp_wifi_force_wakeup_release(void);
+extern esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block);
+extern esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number);
+extern esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *records);
+extern esp_err_t esp_wifi_ftm_initiate_session(wifi_ftm_initiator_cfg_t *cfg);
+extern esp_err_t esp_wifi_ftm_end_session(void);
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "driver/gpio.h"
+
+/*
+ * Control side of the host fakes, for the tests, the benchmarks and the radio simulator.
+ *
+ * Every FreeRTOS task is a thread, but time is virtual and only moves in
+ * FAKE_clock_advance(). It waits until all tasks are blocked, moves the clock
+ * to the next task timeout or esp_timer deadline, runs the due timer callbacks
+ * on the calling thread, which stands in for the esp_timer task, and repeats
+ * up to the target time. The result does not depend on the host speed.
+ *
+ * The calling thread is no task. It may block on a queue or semaphore that a
+ * task gives, but it never moves the clock while blocked, and a finite timeout
+ * fails at once when the tasks are settled and nothing arrived.
+ */
+
+// The clock starts here, firmware treats a time of 0 as never
+#define FAKE_CLOCK_START_US     (1000 * 1000)
+
+// rx_ctrl timestamps run on their own epoch like the MAC clock
+#define FAKE_RX_EPOCH_US        (123456789)
+
+// --- Clock and scheduler, shared by all nodes ---
+
+extern void FAKE_clock_advance(int64_t us);
+
+// Wait until every task is blocked
+extern void FAKE_settle(void);
+
+// Timer callbacks run and task timeouts expired so far, what wakes a tickless idle CPU
+extern uint32_t FAKE_clock_get_wakeups(void);
+
+// Tasks alive, blocked ones included
+extern uint32_t FAKE_get_task_count(void);
+
+extern void FAKE_log_set_level(esp_log_level_t level);
+
+// --- ESP-NOW, one instance per node ---
+
+/**
+ * @brief Hand sent frames to a radio model instead of completing them at once
+ *
+ * Without an air the send callback reports success from inside esp_now_send().
+ * With one, the model has to call FAKE_esp_now_send_done() for every frame.
+ */
+typedef void (*fake_air_send_t)(void *ctx, const uint8_t *dst, const uint8_t *data, int len);
+extern void FAKE_esp_now_set_air(fake_air_send_t send, void *ctx);
+
+// Run the receive callback on the calling thread, as the Wi-Fi task would
+extern void FAKE_esp_now_deliver(const uint8_t *src, int8_t rssi, const void *data, int len);
+
+// Run the send callback of a frame
+extern void FAKE_esp_now_send_done(const uint8_t *dst, bool success);
+
+extern bool FAKE_esp_now_is_init(void);
+extern uint32_t FAKE_esp_now_get_sent(void);
+
+// Copy of the last sent frame, returns its length, 0 if nothing was sent
+extern int FAKE_esp_now_get_last(uint8_t *dst, uint8_t *data, int size);
+
+extern uint16_t FAKE_esp_now_get_wake_window(void);
+
+// --- Wi-Fi and events, one instance per node ---
+
+extern void FAKE_wifi_set_mac(const uint8_t *mac);
+
+// Returned by the next esp_wifi_start() calls, ESP_OK to clear
+extern void FAKE_wifi_set_start_error(esp_err_t err);
+
+// APs found by esp_wifi_scan_start()
+extern void FAKE_wifi_set_scan(const wifi_ap_record_t *records, uint16_t count);
+
+/**
+ * @brief Hand started FTM sessions to a radio model
+ *
+ * The model answers with a WIFI_EVENT_FTM_REPORT through FAKE_event_post().
+ * Without one, sessions are only counted.
+ */
+typedef void (*fake_ftm_session_t)(void *ctx, const wifi_ftm_initiator_cfg_t *cfg);
+extern void FAKE_wifi_set_ftm(fake_ftm_session_t session, void *ctx);
+
+extern bool FAKE_wifi_is_started(void);
+extern wifi_mode_t FAKE_wifi_get_mode(void);
+extern wifi_ps_type_t FAKE_wifi_get_ps(void);
+extern uint32_t FAKE_wifi_get_ftm_sessions(void);
+
+// esp_wifi_force_wakeup_acquire() calls minus releases
+extern int32_t FAKE_wifi_get_wakeups(void);
+
+// Call the registered handlers on the calling thread, as the event loop task would
+extern void FAKE_event_post(esp_event_base_t base, int32_t id, void *data);
+extern uint32_t FAKE_event_get_handlers(void);
+
+// --- Power management ---
+
+extern bool FAKE_pm_get_light_sleep(void);
+
+// --- GPIO, one instance per node ---
+
+// Set an input level, an ISR handler of the pin runs on the calling thread on every change
+extern void FAKE_gpio_input(gpio_num_t gpio, int level);
+
+extern int FAKE_gpio_get_output(gpio_num_t gpio);
+
+/**
+ * @brief Enter or leave automatic light sleep as seen by the pins
+ *
+ * In light sleep edge interrupts are lost, as on the C3. A level interrupt
+ * of a pin with gpio_wakeup_enable() wakes the chip once
+ * esp_sleep_enable_gpio_wakeup() was called, other level interrupts wait for
+ * the wakeup.
+ */
+extern void FAKE_gpio_set_sleep(bool sleep);
+
+// Level that wakes the chip from light sleep, GPIO_INTR_DISABLE if none
+extern gpio_int_type_t FAKE_gpio_get_wakeup(gpio_num_t gpio);
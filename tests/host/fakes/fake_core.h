@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+// Scheduler internals shared by fake_freertos.c and fake_esp_timer.c, not for the tests
+
+#define FAKE_FOREVER            INT64_MAX
+
+extern void fake_core_lock(void);
+extern void fake_core_unlock(void);
+
+// The following are called with the core lock held
+
+// Wait until every task is blocked
+extern void fake_core_settle(void);
+
+// Earliest timeout of a blocked task, FAKE_FOREVER if none
+extern int64_t fake_core_next_timeout(void);
+
+// Move the clock forward and wake the tasks whose timeout passed, returns how many
+extern uint32_t fake_core_set_time(int64_t now_us);
+
+extern int64_t fake_core_now(void);
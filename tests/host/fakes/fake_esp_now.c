@@ -0,0 +1,265 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_now.h"
+#include "esp_timer.h"
+
+#include "fake.h"
+
+// One instance per node, the radio simulator loads a copy of the firmware and these fakes per node.
+// The driver is called from several tasks, the peer table and the counters are under the lock
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool s_init = false;
+static esp_now_recv_cb_t s_recv_cb = NULL;
+static esp_now_send_cb_t s_send_cb = NULL;
+static uint8_t s_peers[ESP_NOW_MAX_TOTAL_PEER_NUM][ESP_NOW_ETH_ALEN];
+static uint8_t s_peer_count = 0;
+static uint16_t s_wake_window = UINT16_MAX;
+
+static fake_air_send_t s_air = NULL;
+static void *s_air_ctx = NULL;
+
+static uint32_t s_sent = 0;
+static uint8_t s_last_dst[ESP_NOW_ETH_ALEN];
+static uint8_t s_last_data[ESP_NOW_MAX_DATA_LEN];
+static int s_last_len = 0;
+
+static int fake_find_peer(const uint8_t *mac)
+{
+    for (uint8_t i = 0; i < s_peer_count; i++) {
+        if (memcmp(s_peers[i], mac, ESP_NOW_ETH_ALEN) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+esp_err_t esp_now_init(void)
+{
+    if (!FAKE_wifi_is_started()) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+
+    s_init = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_init = false;
+    s_recv_cb = NULL;
+    s_send_cb = NULL;
+    s_peer_count = 0;
+    pthread_mutex_unlock(&s_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+
+    s_recv_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+
+    s_recv_cb = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+
+    s_send_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_send_cb(void)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+
+    s_send_cb = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (peer == NULL) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    if (fake_find_peer(peer->peer_addr) >= 0) {
+        err = ESP_ERR_ESPNOW_EXIST;
+    } else if (s_peer_count >= ESP_NOW_MAX_TOTAL_PEER_NUM) {
+        err = ESP_ERR_ESPNOW_FULL;
+    } else {
+        memcpy(s_peers[s_peer_count++], peer->peer_addr, ESP_NOW_ETH_ALEN);
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    return err;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    const int i = fake_find_peer(peer_addr);
+    if (i < 0) {
+        err = ESP_ERR_ESPNOW_NOT_FOUND;
+    } else {
+        s_peer_count--;
+        memmove(s_peers[i], s_peers[i + 1], (size_t)(s_peer_count - i) * ESP_NOW_ETH_ALEN);
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    return err;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr)
+{
+    pthread_mutex_lock(&s_lock);
+    const bool exists = s_init && fake_find_peer(peer_addr) >= 0;
+    pthread_mutex_unlock(&s_lock);
+
+    return exists;
+}
+
+esp_err_t esp_now_set_wake_window(uint16_t window_ms)
+{
+    s_wake_window = window_ms;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    if (!s_init) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (peer_addr == NULL || data == NULL || len == 0 || len > ESP_NOW_MAX_DATA_LEN) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    const bool known = fake_find_peer(peer_addr) >= 0;
+    if (known) {
+        s_sent++;
+        memcpy(s_last_dst, peer_addr, ESP_NOW_ETH_ALEN);
+        memcpy(s_last_data, data, len);
+        s_last_len = (int)len;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (!known) {
+        return ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+
+    if (s_air != NULL) {
+        s_air(s_air_ctx, peer_addr, data, (int)len);
+    } else {
+        FAKE_esp_now_send_done(peer_addr, true);
+    }
+
+    return ESP_OK;
+}
+
+void FAKE_esp_now_set_air(fake_air_send_t send, void *ctx)
+{
+    s_air = send;
+    s_air_ctx = ctx;
+}
+
+void FAKE_esp_now_deliver(const uint8_t *src, int8_t rssi, const void *data, int len)
+{
+    const esp_now_recv_cb_t cb = s_recv_cb;
+    uint8_t src_addr[ESP_NOW_ETH_ALEN];
+    uint8_t des_addr[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    wifi_pkt_rx_ctrl_t rx_ctrl = {
+        .rssi = rssi,
+        .channel = 1,
+        .timestamp = (uint32_t)(esp_timer_get_time() + FAKE_RX_EPOCH_US),
+        .sig_len = (unsigned)len,
+    };
+
+    if (!s_init || cb == NULL) {
+        return;
+    }
+
+    memcpy(src_addr, src, ESP_NOW_ETH_ALEN);
+    const esp_now_recv_info_t info = {
+        .src_addr = src_addr,
+        .des_addr = des_addr,
+        .rx_ctrl = &rx_ctrl,
+    };
+
+    cb(&info, data, len);
+}
+
+void FAKE_esp_now_send_done(const uint8_t *dst, bool success)
+{
+    const esp_now_send_cb_t cb = s_send_cb;
+
+    if (s_init && cb != NULL) {
+        cb(dst, success ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL);
+    }
+}
+
+bool FAKE_esp_now_is_init(void)
+{
+    return s_init;
+}
+
+uint32_t FAKE_esp_now_get_sent(void)
+{
+    pthread_mutex_lock(&s_lock);
+    const uint32_t sent = s_sent;
+    pthread_mutex_unlock(&s_lock);
+
+    return sent;
+}
+
+int FAKE_esp_now_get_last(uint8_t *dst, uint8_t *data, int size)
+{
+    pthread_mutex_lock(&s_lock);
+    const int len = s_last_len;
+    if (dst != NULL && len > 0) {
+        memcpy(dst, s_last_dst, ESP_NOW_ETH_ALEN);
+    }
+    if (data != NULL && len > 0) {
+        memcpy(data, s_last_data, (size_t)((len < size) ? len : size));
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    return len;
+}
+
+uint16_t FAKE_esp_now_get_wake_window(void)
+{
+    return s_wake_window;
+}
@@ -0,0 +1,208 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esp_timer.h"
+
+#include "fake.h"
+#include "fake_core.h"
+
+struct fake_timer {
+    esp_timer_create_args_t args;
+    bool active;
+    int64_t due_us;
+    uint64_t period_us;         // 0 for a one-shot timer
+    uint64_t order;             // Start order, equal deadlines fire first come first served
+    struct fake_timer *next;
+};
+
+// All timers of all nodes, under the core lock
+static struct fake_timer *s_timers = NULL;
+static uint64_t s_order = 0;
+static uint32_t s_wakeups = 0;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    if (args == NULL || args->callback == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct fake_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->args = *args;
+
+    fake_core_lock();
+    t->next = s_timers;
+    s_timers = t;
+    fake_core_unlock();
+
+    *out = t;
+    return ESP_OK;
+}
+
+static esp_err_t fake_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    esp_err_t err = ESP_OK;
+
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fake_core_lock();
+    if (timer->active) {
+        err = ESP_ERR_INVALID_STATE;
+    } else {
+        timer->active = true;
+        timer->due_us = fake_core_now() + (int64_t)timeout_us;
+        timer->period_us = period_us;
+        timer->order = s_order++;
+    }
+    fake_core_unlock();
+
+    return err;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return fake_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (period_us == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return fake_timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    esp_err_t err = ESP_OK;
+
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fake_core_lock();
+    if (!timer->active) {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    fake_core_unlock();
+
+    return err;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fake_core_lock();
+    if (timer->active) {
+        fake_core_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct fake_timer **p = &s_timers; *p != NULL; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    fake_core_unlock();
+
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    fake_core_lock();
+    const bool active = (timer != NULL) && timer->active;
+    fake_core_unlock();
+
+    return active;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return fake_core_now();
+}
+
+// Earliest active timer, with the core lock held
+static struct fake_timer *fake_timer_next(void)
+{
+    struct fake_timer *next = NULL;
+
+    for (struct fake_timer *t = s_timers; t != NULL; t = t->next) {
+        if (t->active && (next == NULL || t->due_us < next->due_us ||
+                          (t->due_us == next->due_us && t->order < next->order))) {
+            next = t;
+        }
+    }
+
+    return next;
+}
+
+void FAKE_clock_advance(int64_t us)
+{
+    fake_core_lock();
+    const int64_t target_us = fake_core_now() + ((us > 0) ? us : 0);
+
+    while (1) {
+        fake_core_settle();
+
+        const int64_t now_us = fake_core_now();
+        struct fake_timer *timer = fake_timer_next();
+
+        if (timer != NULL && timer->due_us <= now_us) {
+            const esp_timer_cb_t cb = timer->args.callback;
+            void *arg = timer->args.arg;
+
+            if (timer->period_us > 0) {
+                timer->due_us += (int64_t)timer->period_us;
+                if (timer->args.skip_unhandled_events && timer->due_us <= now_us) {
+                    timer->due_us = now_us + (int64_t)timer->period_us;
+                }
+                timer->order = s_order++;
+            } else {
+                timer->active = false;
+            }
+
+            // The calling thread is the esp_timer task
+            s_wakeups++;
+            fake_core_unlock();
+            cb(arg);
+            fake_core_lock();
+            continue;
+        }
+
+        if (now_us >= target_us) {
+            break;
+        }
+
+        int64_t next_us = fake_core_next_timeout();
+        if (timer != NULL && timer->due_us < next_us) {
+            next_us = timer->due_us;
+        }
+        if (next_us > target_us) {
+            next_us = target_us;
+        }
+        s_wakeups += fake_core_set_time(next_us);
+    }
+
+    fake_core_unlock();
+}
+
+uint32_t FAKE_clock_get_wakeups(void)
+{
+    fake_core_lock();
+    const uint32_t wakeups = s_wakeups;
+    fake_core_unlock();
+
+    return wakeups;
+}
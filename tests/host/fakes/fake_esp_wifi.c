@@ -0,0 +1,295 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_event.h"
+#include "esp_pm.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+
+#include "fake.h"
+
+// One instance per node, like fake_esp_now.c
+
+#define FAKE_EVENT_HANDLERS     (8)
+#define FAKE_SCAN_APS           (16)
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} fake_handler_t;
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+
+static uint8_t s_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static wifi_mode_t s_mode = WIFI_MODE_NULL;
+static bool s_started = false;
+static esp_err_t s_start_error = ESP_OK;
+static wifi_ps_type_t s_ps = WIFI_PS_MIN_MODEM;
+static uint8_t s_protocol = WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N;
+static int32_t s_wakeups = 0;
+static uint32_t s_ftm_sessions = 0;
+
+static wifi_ap_record_t s_scan[FAKE_SCAN_APS];
+static uint16_t s_scan_count = 0;
+static uint16_t s_scan_found = 0;
+static bool s_scan_match[FAKE_SCAN_APS];
+
+static fake_handler_t s_handlers[FAKE_EVENT_HANDLERS];
+
+static esp_pm_config_t s_pm_config;
+
+static uint32_t s_random = 0x2545F491;
+
+static fake_ftm_session_t s_ftm = NULL;
+static void *s_ftm_ctx = NULL;
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    s_mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode)
+{
+    *mode = s_mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    if (s_start_error != ESP_OK) {
+        return s_start_error;
+    }
+
+    s_started = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    s_started = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol)
+{
+    (void)ifx;
+    s_protocol = protocol;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    s_ps = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    memcpy(mac, s_mac, sizeof(s_mac));
+    if (ifx == WIFI_IF_AP) {
+        mac[5]++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_force_wakeup_acquire(void)
+{
+    __atomic_add_fetch(&s_wakeups, 1, __ATOMIC_SEQ_CST);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_force_wakeup_release(void)
+{
+    __atomic_sub_fetch(&s_wakeups, 1, __ATOMIC_SEQ_CST);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block)
+{
+    (void)block;
+
+    if (!s_started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+
+    // The driver filters by SSID when one is given
+    s_scan_found = 0;
+    for (uint16_t i = 0; i < s_scan_count; i++) {
+        s_scan_match[i] = config == NULL || config->ssid == NULL ||
+                          strcmp((const char *)s_scan[i].ssid, (const char *)config->ssid) == 0;
+        if (s_scan_match[i]) {
+            s_scan_found++;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number)
+{
+    *number = s_scan_found;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *records)
+{
+    uint16_t count = 0;
+
+    for (uint16_t i = 0; i < s_scan_count && count < *number; i++) {
+        if (s_scan_match[i]) {
+            records[count++] = s_scan[i];
+        }
+    }
+    *number = count;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_ftm_initiate_session(wifi_ftm_initiator_cfg_t *cfg)
+{
+    if (!s_started || cfg == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_ftm_sessions++;
+    if (s_ftm != NULL) {
+        s_ftm(s_ftm_ctx, cfg);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_ftm_end_session(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler,
+                                              void *arg, esp_event_handler_instance_t *instance)
+{
+    for (uint8_t i = 0; i < FAKE_EVENT_HANDLERS; i++) {
+        if (s_handlers[i].handler == NULL) {
+            s_handlers[i] = (fake_handler_t){ .base = base, .id = id, .handler = handler, .arg = arg };
+            if (instance != NULL) {
+                *instance = &s_handlers[i];
+            }
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_event_handler_instance_unregister(esp_event_base_t base, int32_t id,
+                                                esp_event_handler_instance_t instance)
+{
+    fake_handler_t *h = instance;
+
+    if (h == NULL || h->handler == NULL || h->base != base || h->id != id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(h, 0, sizeof(*h));
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_configure(const void *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_pm_config = *(const esp_pm_config_t *)config;
+    return ESP_OK;
+}
+
+uint32_t esp_random(void)
+{
+    // xorshift32
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+    return s_random;
+}
+
+void FAKE_wifi_set_mac(const uint8_t *mac)
+{
+    memcpy(s_mac, mac, sizeof(s_mac));
+    s_random ^= ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+}
+
+void FAKE_wifi_set_ftm(fake_ftm_session_t session, void *ctx)
+{
+    s_ftm = session;
+    s_ftm_ctx = ctx;
+}
+
+void FAKE_wifi_set_start_error(esp_err_t err)
+{
+    s_start_error = err;
+}
+
+void FAKE_wifi_set_scan(const wifi_ap_record_t *records, uint16_t count)
+{
+    s_scan_count = (count > FAKE_SCAN_APS) ? FAKE_SCAN_APS : count;
+    memcpy(s_scan, records, s_scan_count * sizeof(wifi_ap_record_t));
+}
+
+bool FAKE_wifi_is_started(void)
+{
+    return s_started;
+}
+
+wifi_mode_t FAKE_wifi_get_mode(void)
+{
+    return s_mode;
+}
+
+wifi_ps_type_t FAKE_wifi_get_ps(void)
+{
+    return s_ps;
+}
+
+uint32_t FAKE_wifi_get_ftm_sessions(void)
+{
+    return s_ftm_sessions;
+}
+
+int32_t FAKE_wifi_get_wakeups(void)
+{
+    return __atomic_load_n(&s_wakeups, __ATOMIC_SEQ_CST);
+}
+
+void FAKE_event_post(esp_event_base_t base, int32_t id, void *data)
+{
+    for (uint8_t i = 0; i < FAKE_EVENT_HANDLERS; i++) {
+        const fake_handler_t h = s_handlers[i];
+        if (h.handler != NULL && h.base == base && (h.id == ESP_EVENT_ANY_ID || h.id == id)) {
+            h.handler(h.arg, base, id, data);
+        }
+    }
+}
+
+uint32_t FAKE_event_get_handlers(void)
+{
+    uint32_t count = 0;
+
+    for (uint8_t i = 0; i < FAKE_EVENT_HANDLERS; i++) {
+        count += (s_handlers[i].handler != NULL);
+    }
+
+    return count;
+}
+
+bool FAKE_pm_get_light_sleep(void)
+{
+    return s_pm_config.light_sleep_enable;
+}
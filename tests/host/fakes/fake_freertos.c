@@ -0,0 +1,544 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "fake.h"
+#include "fake_core.h"
+
+#define TICK_US                 (1000000 / configTICK_RATE_HZ)
+
+// A task, or a thread that is no task while it blocks
+struct fake_task {
+    pthread_t thread;
+    pthread_cond_t cond;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    bool is_task;
+    bool blocked;
+    bool timed_out;
+    bool deleted;
+    const void *wait_obj;       // Woken by fake_wake() of this object
+    int64_t wait_until_us;      // Woken by the clock, FAKE_FOREVER for no timeout
+    uint32_t notify;
+    struct fake_task *next;
+};
+
+struct fake_queue {
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_idle = PTHREAD_COND_INITIALIZER;
+
+// Every task, and the other threads while they block
+static struct fake_task *s_tasks = NULL;
+static uint32_t s_task_count = 0;
+static uint32_t s_running = 0;          // Tasks that are not blocked
+static int64_t s_now_us = FAKE_CLOCK_START_US;
+
+static __thread struct fake_task *s_self = NULL;
+static __thread struct fake_task s_foreign;
+static __thread bool s_foreign_ready = false;
+
+// Objects that are only woken by the clock
+static const uint8_t s_delay_obj;
+static const uint8_t s_suspend_obj;
+
+void fake_core_lock(void)
+{
+    pthread_mutex_lock(&s_lock);
+}
+
+void fake_core_unlock(void)
+{
+    pthread_mutex_unlock(&s_lock);
+}
+
+void fake_core_settle(void)
+{
+    while (s_running > 0) {
+        pthread_cond_wait(&s_idle, &s_lock);
+    }
+}
+
+int64_t fake_core_next_timeout(void)
+{
+    int64_t next = FAKE_FOREVER;
+
+    for (const struct fake_task *t = s_tasks; t != NULL; t = t->next) {
+        if (t->blocked && t->wait_until_us < next) {
+            next = t->wait_until_us;
+        }
+    }
+
+    return next;
+}
+
+static void fake_resume(struct fake_task *t, bool timed_out)
+{
+    t->blocked = false;
+    t->timed_out = timed_out;
+    if (t->is_task) {
+        s_running++;
+    }
+    pthread_cond_signal(&t->cond);
+}
+
+uint32_t fake_core_set_time(int64_t now_us)
+{
+    uint32_t timeouts = 0;
+
+    __atomic_store_n(&s_now_us, now_us, __ATOMIC_SEQ_CST);
+
+    for (struct fake_task *t = s_tasks; t != NULL; t = t->next) {
+        if (t->blocked && t->wait_until_us <= now_us) {
+            fake_resume(t, true);
+            timeouts++;
+        }
+    }
+
+    return timeouts;
+}
+
+int64_t fake_core_now(void)
+{
+    return __atomic_load_n(&s_now_us, __ATOMIC_SEQ_CST);
+}
+
+void FAKE_settle(void)
+{
+    fake_core_lock();
+    fake_core_settle();
+    fake_core_unlock();
+}
+
+uint32_t FAKE_get_task_count(void)
+{
+    fake_core_lock();
+    const uint32_t count = s_task_count;
+    fake_core_unlock();
+
+    return count;
+}
+
+static void fake_list_add(struct fake_task *t)
+{
+    t->next = s_tasks;
+    s_tasks = t;
+}
+
+static void fake_list_remove(struct fake_task *t)
+{
+    for (struct fake_task **p = &s_tasks; *p != NULL; p = &(*p)->next) {
+        if (*p == t) {
+            *p = t->next;
+            return;
+        }
+    }
+}
+
+static void fake_wake(const void *obj)
+{
+    for (struct fake_task *t = s_tasks; t != NULL; t = t->next) {
+        if (t->blocked && t->wait_obj == obj) {
+            fake_resume(t, false);
+        }
+    }
+}
+
+static void fake_stop_running(void)
+{
+    if (--s_running == 0) {
+        pthread_cond_broadcast(&s_idle);
+    }
+}
+
+// Timeout of a wait, a thread that is no task only waits for the tasks to settle
+static int64_t fake_deadline(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return FAKE_FOREVER;
+    }
+    if (s_self == NULL && ticks > 0) {
+        fake_core_settle();
+        return s_now_us;
+    }
+
+    return s_now_us + (int64_t)ticks * TICK_US;
+}
+
+/**
+ * @brief Block the calling thread on obj, with the core lock held
+ *
+ * @return false on timeout, true when woken. The caller checks its condition again either way
+ */
+static bool fake_block(const void *obj, int64_t until_us)
+{
+    struct fake_task *t = s_self;
+
+    if (until_us <= s_now_us) {
+        return false;
+    }
+
+    if (t == NULL) {
+        if (!s_foreign_ready) {
+            pthread_cond_init(&s_foreign.cond, NULL);
+            s_foreign_ready = true;
+        }
+        t = &s_foreign;
+        fake_list_add(t);
+    }
+
+    if (t->deleted) {
+        // Deleted by another task while it was running
+        fake_stop_running();
+        fake_core_unlock();
+        pthread_exit(NULL);
+    }
+
+    t->wait_obj = obj;
+    t->wait_until_us = until_us;
+    t->blocked = true;
+    if (t->is_task) {
+        fake_stop_running();
+    }
+
+    while (t->blocked) {
+        pthread_cond_wait(&t->cond, &s_lock);
+    }
+
+    if (!t->is_task) {
+        fake_list_remove(t);
+    }
+
+    return !t->timed_out;
+}
+
+static void *fake_task_main(void *p)
+{
+    struct fake_task *t = p;
+
+    s_self = t;
+    t->fn(t->arg);
+
+    // A FreeRTOS task must not return, the fake treats it like vTaskDelete(NULL)
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    struct fake_task *t = calloc(1, sizeof(*t));
+    pthread_attr_t attr;
+
+    (void)stack_depth;
+    (void)priority;
+
+    if (t == NULL) {
+        return pdFAIL;
+    }
+
+    pthread_cond_init(&t->cond, NULL);
+    t->fn = fn;
+    t->arg = arg;
+    t->is_task = true;
+    strncpy(t->name, (name != NULL) ? name : "", sizeof(t->name) - 1);
+
+    fake_core_lock();
+    fake_list_add(t);
+    s_task_count++;
+    s_running++;
+    fake_core_unlock();
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    if (pthread_create(&t->thread, &attr, fake_task_main, t) != 0) {
+        abort();
+    }
+    pthread_attr_destroy(&attr);
+
+    if (handle != NULL) {
+        *handle = t;
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stack_depth, arg, priority, handle);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb)
+{
+    TaskHandle_t handle = NULL;
+
+    (void)stack;
+    (void)tcb;
+    xTaskCreate(fn, name, stack_depth, arg, priority, &handle);
+
+    return handle;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    fake_core_lock();
+
+    struct fake_task *t = (task != NULL) ? task : s_self;
+    if (t == NULL || t->deleted) {
+        fake_core_unlock();
+        return;
+    }
+
+    t->deleted = true;
+    fake_list_remove(t);
+    s_task_count--;
+
+    if (t == s_self) {
+        fake_stop_running();
+        fake_core_unlock();
+        pthread_exit(NULL);
+    }
+
+    // A blocked task is out of the list and never wakes up again, its thread stays parked.
+    // A running one leaves at its next blocking call
+    fake_core_unlock();
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    // Only self-suspension is used, the task waits for its deletion
+    if (task != NULL && task != s_self) {
+        abort();
+    }
+
+    fake_core_lock();
+    while (1) {
+        fake_block(&s_suspend_obj, FAKE_FOREVER);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (s_self == NULL) {
+        // The thread driving the clock sleeps by moving it
+        FAKE_clock_advance((int64_t)ticks * TICK_US);
+        return;
+    }
+
+    fake_core_lock();
+    const int64_t until_us = s_now_us + (int64_t)ticks * TICK_US;
+    while (fake_block(&s_delay_obj, until_us)) {
+    }
+    fake_core_unlock();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(fake_core_now() / TICK_US);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_self;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct fake_task *t = s_self;
+
+    if (t == NULL) {
+        abort();
+    }
+
+    fake_core_lock();
+    const int64_t until_us = fake_deadline(ticks);
+    while (t->notify == 0 && fake_block(&t->notify, until_us)) {
+    }
+
+    const uint32_t value = t->notify;
+    if (value > 0) {
+        t->notify = clear ? 0 : value - 1;
+    }
+    fake_core_unlock();
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    fake_core_lock();
+    task->notify++;
+    fake_wake(&task->notify);
+    fake_core_unlock();
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct fake_queue *q = calloc(1, sizeof(*q));
+
+    if (q == NULL || length == 0) {
+        free(q);
+        return NULL;
+    }
+
+    q->items = calloc(length, (item_size > 0) ? item_size : 1);
+    if (q->items == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue != NULL) {
+        free(queue->items);
+        free(queue);
+    }
+}
+
+static void fake_queue_put(struct fake_queue *q, const void *item)
+{
+    if (q->item_size > 0) {
+        memcpy(&q->items[((q->head + q->count) % q->length) * q->item_size], item, q->item_size);
+    }
+    q->count++;
+    fake_wake(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    fake_core_lock();
+    const int64_t until_us = fake_deadline(ticks);
+    while (queue->count == queue->length) {
+        if (!fake_block(queue, until_us)) {
+            fake_core_unlock();
+            return pdFALSE;
+        }
+    }
+    fake_queue_put(queue, item);
+    fake_core_unlock();
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    fake_core_lock();
+    if (queue->count == queue->length) {
+        queue->count--;
+    }
+    fake_queue_put(queue, item);
+    fake_core_unlock();
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    fake_core_lock();
+    const int64_t until_us = fake_deadline(ticks);
+    while (queue->count == 0) {
+        if (!fake_block(queue, until_us)) {
+            fake_core_unlock();
+            return pdFALSE;
+        }
+    }
+
+    if (queue->item_size > 0) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    fake_wake(queue);
+    fake_core_unlock();
+
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    fake_core_lock();
+    const UBaseType_t count = queue->count;
+    fake_core_unlock();
+
+    return count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    fake_core_lock();
+    queue->head = 0;
+    queue->count = 0;
+    fake_wake(queue);
+    fake_core_unlock();
+
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+
+    if (sem != NULL) {
+        sem->count = 1;
+    }
+
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    SemaphoreHandle_t sem = xQueueCreate(max, 0);
+
+    if (sem != NULL) {
+        sem->count = initial;
+    }
+
+    return sem;
+}
@@ -0,0 +1,228 @@
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+
+#include "fake.h"
+
+// One instance per node. Inputs idle high like the button pull-ups
+static int s_level[GPIO_NUM_MAX];
+static bool s_level_set[GPIO_NUM_MAX];
+static gpio_int_type_t s_intr[GPIO_NUM_MAX];
+static gpio_isr_t s_isr[GPIO_NUM_MAX];
+static void *s_isr_arg[GPIO_NUM_MAX];
+static bool s_intr_enabled[GPIO_NUM_MAX];
+static bool s_wakeup[GPIO_NUM_MAX];
+static bool s_isr_service = false;
+static bool s_gpio_wakeup = false;
+static bool s_sleep = false;
+
+static bool fake_gpio_valid(gpio_num_t gpio)
+{
+    return gpio >= 0 && gpio < GPIO_NUM_MAX;
+}
+
+static int fake_gpio_level(gpio_num_t gpio)
+{
+    return s_level_set[gpio] ? s_level[gpio] : 1;
+}
+
+// Level interrupts fire as long as the level holds, the ISR has to disable or rearm them
+static void fake_gpio_check_level(gpio_num_t gpio)
+{
+    const gpio_int_type_t intr = s_intr[gpio];
+    const int level = fake_gpio_level(gpio);
+
+    if (s_isr[gpio] == NULL || !s_intr_enabled[gpio]) {
+        return;
+    }
+    if (!((intr == GPIO_INTR_LOW_LEVEL && !level) || (intr == GPIO_INTR_HIGH_LEVEL && level))) {
+        return;
+    }
+    if (s_sleep && !(s_wakeup[gpio] && s_gpio_wakeup)) {
+        return;
+    }
+
+    // A wakeup ends the light sleep for all pins
+    s_sleep = false;
+    s_isr[gpio](s_isr_arg[gpio]);
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    for (gpio_num_t gpio = 0; gpio < GPIO_NUM_MAX; gpio++) {
+        if (config->pin_bit_mask & (1ULL << gpio)) {
+            s_intr[gpio] = config->intr_type;
+            s_intr_enabled[gpio] = (config->intr_type != GPIO_INTR_DISABLE);
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_intr[gpio] = GPIO_INTR_DISABLE;
+    s_intr_enabled[gpio] = false;
+    s_wakeup[gpio] = false;
+    s_level_set[gpio] = false;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode)
+{
+    (void)mode;
+    return fake_gpio_valid(gpio) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_level[gpio] = (level != 0);
+    s_level_set[gpio] = true;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    return fake_gpio_valid(gpio) ? fake_gpio_level(gpio) : 0;
+}
+
+esp_err_t gpio_install_isr_service(int flags)
+{
+    (void)flags;
+
+    if (s_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg)
+{
+    if (!s_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_isr[gpio] = handler;
+    s_isr_arg[gpio] = arg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_isr[gpio] = NULL;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_intr_enabled[gpio] = true;
+    fake_gpio_check_level(gpio);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_intr_enabled[gpio] = false;
+    return ESP_OK;
+}
+
+// Sets the interrupt type like the driver does, only levels can wake the chip
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t intr_type)
+{
+    if (!fake_gpio_valid(gpio) || (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_intr[gpio] = intr_type;
+    s_wakeup[gpio] = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_wakeup[gpio] = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void)
+{
+    s_gpio_wakeup = true;
+    return ESP_OK;
+}
+
+void FAKE_gpio_input(gpio_num_t gpio, int level)
+{
+    if (!fake_gpio_valid(gpio)) {
+        return;
+    }
+
+    const int previous = fake_gpio_level(gpio);
+    level = (level != 0);
+    s_level[gpio] = level;
+    s_level_set[gpio] = true;
+
+    if (level == previous || s_isr[gpio] == NULL || !s_intr_enabled[gpio]) {
+        return;
+    }
+
+    const gpio_int_type_t intr = s_intr[gpio];
+    if (intr == GPIO_INTR_ANYEDGE || (intr == GPIO_INTR_POSEDGE && level) || (intr == GPIO_INTR_NEGEDGE && !level)) {
+        if (!s_sleep) {
+            s_isr[gpio](s_isr_arg[gpio]);
+        }
+        return;
+    }
+
+    fake_gpio_check_level(gpio);
+}
+
+int FAKE_gpio_get_output(gpio_num_t gpio)
+{
+    return fake_gpio_valid(gpio) ? fake_gpio_level(gpio) : 0;
+}
+
+void FAKE_gpio_set_sleep(bool sleep)
+{
+    s_sleep = sleep;
+
+    if (!sleep) {
+        for (gpio_num_t gpio = 0; gpio < GPIO_NUM_MAX; gpio++) {
+            fake_gpio_check_level(gpio);
+        }
+    }
+}
+
+gpio_int_type_t FAKE_gpio_get_wakeup(gpio_num_t gpio)
+{
+    return (fake_gpio_valid(gpio) && s_wakeup[gpio]) ? s_intr[gpio] : GPIO_INTR_DISABLE;
+}
@@ -0,0 +1,59 @@
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_now.h"
+#include "esp_timer.h"
+
+#include "fake.h"
+
+static esp_log_level_t s_level = ESP_LOG_WARN;
+
+void FAKE_log_set_level(esp_log_level_t level)
+{
+    s_level = level;
+}
+
+void FAKE_log(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    va_list args;
+
+    if (level > s_level) {
+        return;
+    }
+
+    flockfile(stderr);
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    funlockfile(stderr);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_WIFI_NOT_INIT:     return "ESP_ERR_WIFI_NOT_INIT";
+        case ESP_ERR_WIFI_NOT_STARTED:  return "ESP_ERR_WIFI_NOT_STARTED";
+        case ESP_ERR_ESPNOW_NOT_INIT:   return "ESP_ERR_ESPNOW_NOT_INIT";
+        case ESP_ERR_ESPNOW_ARG:        return "ESP_ERR_ESPNOW_ARG";
+        case ESP_ERR_ESPNOW_NO_MEM:     return "ESP_ERR_ESPNOW_NO_MEM";
+        case ESP_ERR_ESPNOW_FULL:       return "ESP_ERR_ESPNOW_FULL";
+        case ESP_ERR_ESPNOW_NOT_FOUND:  return "ESP_ERR_ESPNOW_NOT_FOUND";
+        case ESP_ERR_ESPNOW_INTERNAL:   return "ESP_ERR_ESPNOW_INTERNAL";
+        case ESP_ERR_ESPNOW_EXIST:      return "ESP_ERR_ESPNOW_EXIST";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
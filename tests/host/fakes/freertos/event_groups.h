@@ -0,0 +1,6 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_event_group *EventGroupHandle_t;
+typedef TickType_t EventBits_t;
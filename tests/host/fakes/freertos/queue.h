@@ -0,0 +1,16 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_queue *QueueHandle_t;
+
+extern QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+extern void vQueueDelete(QueueHandle_t queue);
+extern BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+extern BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken);
+extern BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+extern BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+extern UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+extern BaseType_t xQueueReset(QueueHandle_t queue);
+
+#define xQueueSendToBack(queue, item, ticks)    xQueueSend(queue, item, ticks)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// A semaphore is a queue of empty items, like in FreeRTOS
+typedef QueueHandle_t SemaphoreHandle_t;
+
+extern SemaphoreHandle_t xSemaphoreCreateBinary(void);
+extern SemaphoreHandle_t xSemaphoreCreateMutex(void);
+extern SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+
+#define xSemaphoreTake(sem, ticks)          xQueueReceive(sem, NULL, ticks)
+#define xSemaphoreGive(sem)                 xQueueSend(sem, NULL, 0)
+#define xSemaphoreGiveFromISR(sem, woken)   xQueueSendFromISR(sem, NULL, woken)
+#define vSemaphoreDelete(sem)               vQueueDelete(sem)
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+// The stack and TCB buffers are ignored, every task is a detached thread
+typedef struct {
+    uint8_t unused;
+} StaticTask_t;
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+} eTaskState;
+
+extern BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                              UBaseType_t priority, TaskHandle_t *handle);
+extern BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                          UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+extern TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                      UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb);
+extern void vTaskDelete(TaskHandle_t task);
+extern void vTaskSuspend(TaskHandle_t task);
+extern void vTaskDelay(TickType_t ticks);
+extern TickType_t xTaskGetTickCount(void);
+extern TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+extern uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+extern BaseType_t xTaskNotifyGive(TaskHandle_t task);
+extern void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "esp_err.h"
+
+static inline esp_err_t nvs_flash_init(void) { return ESP_OK; }
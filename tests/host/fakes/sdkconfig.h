@@ -0,0 +1,109 @@
+#pragma once
+
+// Host build configuration, the Kconfig defaults of main/Kconfig.projbuild.
+// A test target overrides single options with target_compile_definitions().
+
+#ifndef CONFIG_FREERTOS_HZ
+#define CONFIG_FREERTOS_HZ 100
+#endif
+#ifndef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 160
+#endif
+#ifndef CONFIG_XTAL_FREQ
+#define CONFIG_XTAL_FREQ 40
+#endif
+
+#ifndef CONFIG_CUBE_HISTORY_LENGTH
+#define CONFIG_CUBE_HISTORY_LENGTH 64
+#endif
+#ifndef CONFIG_CUBE_HISTORY_PEERS
+#define CONFIG_CUBE_HISTORY_PEERS 4
+#endif
+#ifndef CONFIG_CUBE_ESPNOW_PERIOD_MS
+#define CONFIG_CUBE_ESPNOW_PERIOD_MS 1000
+#endif
+#ifndef CONFIG_CUBE_REPORT_BATCH_MS
+#define CONFIG_CUBE_REPORT_BATCH_MS 100
+#endif
+#ifndef CONFIG_CUBE_COLLECTOR_RECEIVERS
+#define CONFIG_CUBE_COLLECTOR_RECEIVERS 16
+#endif
+
+#ifndef CONFIG_CUBE_APPROACH_NOISE_PERCENT
+#define CONFIG_CUBE_APPROACH_NOISE_PERCENT 40
+#endif
+#ifndef CONFIG_CUBE_APPROACH_ACCEL_CMS2
+#define CONFIG_CUBE_APPROACH_ACCEL_CMS2 50
+#endif
+#ifndef CONFIG_CUBE_APPROACH_MIN_SPEED_CMS
+#define CONFIG_CUBE_APPROACH_MIN_SPEED_CMS 30
+#endif
+#ifndef CONFIG_CUBE_APPROACH_TTC_S
+#define CONFIG_CUBE_APPROACH_TTC_S 3
+#endif
+
+#ifndef CONFIG_CUBE_ZONE_IMMEDIATE_CM
+#define CONFIG_CUBE_ZONE_IMMEDIATE_CM 100
+#endif
+#ifndef CONFIG_CUBE_ZONE_NEAR_CM
+#define CONFIG_CUBE_ZONE_NEAR_CM 300
+#endif
+#ifndef CONFIG_CUBE_ZONE_HYSTERESIS_CM
+#define CONFIG_CUBE_ZONE_HYSTERESIS_CM 30
+#endif
+#ifndef CONFIG_CUBE_ZONE_DWELL_MS
+#define CONFIG_CUBE_ZONE_DWELL_MS 500
+#endif
+
+#ifndef CONFIG_CUBE_TIMESYNC
+#define CONFIG_CUBE_TIMESYNC 1
+#endif
+#ifndef CONFIG_CUBE_TIMESYNC_PERIOD_MS
+#define CONFIG_CUBE_TIMESYNC_PERIOD_MS 1000
+#endif
+
+#ifndef CONFIG_CUBE_FTM_SCAN_MAX_APS
+#define CONFIG_CUBE_FTM_SCAN_MAX_APS 8
+#endif
+
+#ifndef CONFIG_CUBE_POWER_SAVE
+#define CONFIG_CUBE_POWER_SAVE 0
+#endif
+#ifndef CONFIG_CUBE_POWER_SAVE_WINDOW_MS
+#define CONFIG_CUBE_POWER_SAVE_WINDOW_MS 10
+#endif
+#ifndef CONFIG_CUBE_POWER_SAVE_GUARD_MS
+#define CONFIG_CUBE_POWER_SAVE_GUARD_MS 5
+#endif
+#ifndef CONFIG_CUBE_POWER_SAVE_MAX_MISSED
+#define CONFIG_CUBE_POWER_SAVE_MAX_MISSED 5
+#endif
+#ifndef CONFIG_CUBE_POWER_SAVE_REPORT_S
+#define CONFIG_CUBE_POWER_SAVE_REPORT_S 60
+#endif
+
+#ifndef CONFIG_CUBE_TRACE
+#define CONFIG_CUBE_TRACE 0
+#endif
+#ifndef CONFIG_CUBE_TRACE_RECORDS
+#define CONFIG_CUBE_TRACE_RECORDS 256
+#endif
+#ifndef CONFIG_CUBE_TRACE_FLUSH_MS
+#define CONFIG_CUBE_TRACE_FLUSH_MS 200
+#endif
+
+#ifndef CONFIG_CUBE_DIAG
+#define CONFIG_CUBE_DIAG 0
+#endif
+#ifndef CONFIG_CUBE_CSI
+#define CONFIG_CUBE_CSI 0
+#endif
+#ifndef CONFIG_CUBE_FINGERPRINT
+#define CONFIG_CUBE_FINGERPRINT 0
+#endif
+#ifndef CONFIG_CUBE_LED_STRIP
+#define CONFIG_CUBE_LED_STRIP 0
+#endif
+#ifndef CONFIG_CUBE_PERF
+#define CONFIG_CUBE_PERF 0
+#endif
@@ -0,0 +1,860 @@
+#include <dlfcn.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_now.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "fake.h"
+#include "history.h"
+#include "sim_node.h"
+
+/*
+ * Many ESP-NOW and FTM nodes in one room, running the firmware on the host.
+ *
+ * Every node is a copy of the node module with EspNowReceiver.c,
+ * EspNowSender.c or FtmClient.c and the fakes of its radio. Its tasks are
+ * threads on the shared virtual clock of the fakes. Sent frames go to the air
+ * model below: carrier sense with random backoff, collisions with capture,
+ * log-distance path loss with shadowing, random loss and receiver
+ * sensitivity. Each node has a Wi-Fi task thread that runs the receive and
+ * send callbacks, and receivers and FTM clients a UI task that drains the
+ * update queue like ui_update_task() in main.c.
+ *
+ * Example:
+ *   radio_sim --senders 30 --duration 60
+ */
+
+#define SIM_MAX_NODES           (255)
+#define SIM_MAX_GROUP           (32)
+#define SIM_MAX_WAITING         (SIM_MAX_NODES)
+#define SIM_RX_QUEUE_LEN        (32)
+
+// Same values as the firmware
+#define SIM_RSSI_AT_1_METER     (-51.0)     // EspNowReceiver.c
+#define SIM_FTM_PERIOD_MS       (3000)      // FTM_MEASURE_PERIOD_MS in main.c
+
+// 802.11b DSSS timing at 1 Mbps, the ESP-NOW default rate
+#define SIM_SLOT_US             (20)
+#define SIM_DIFS_US             (50)
+#define SIM_CW_MIN              (31)
+
+typedef enum {
+    SIM_ROLE_RECEIVER = 0,
+    SIM_ROLE_SENDER,
+    SIM_ROLE_FTM_CLIENT,
+} sim_role_t;
+
+typedef enum {
+    SIM_EVENT_FRAME = 0,
+    SIM_EVENT_SEND_DONE,
+    SIM_EVENT_FTM_REPORT,
+} sim_event_type_t;
+
+// Input of the Wi-Fi task of a node
+typedef struct {
+    uint8_t type;                   // sim_event_type_t
+    uint8_t mac[ESP_NOW_ETH_ALEN];  // Source of a frame, destination of a send done
+    int8_t rssi;
+    uint8_t len;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+    wifi_event_ftm_report_t report;
+} sim_event_t;
+
+typedef struct {
+    double *values;
+    uint32_t count;
+    uint32_t size;
+} sim_samples_t;
+
+typedef struct {
+    uint32_t heard;                 // Sender frames decoded by the radio
+    uint32_t collided;
+    uint32_t too_weak;
+    uint32_t lost;
+    uint32_t rx_full;               // Wi-Fi task did not keep up
+    uint32_t redraws;
+    uint32_t ftm_sessions;
+    uint32_t ftm_failed;
+    uint8_t senders_heard[SIM_MAX_NODES / 8 + 1];
+    sim_samples_t abs_err;
+    sim_samples_t rel_err;
+} sim_stats_t;
+
+typedef struct {
+    uint32_t index;
+    sim_role_t role;
+    double x;
+    double y;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    const sim_node_api_t *api;
+    QueueHandle_t rx;
+    esp_timer_handle_t ftm_timer;
+    wifi_event_ftm_report_t ftm_report;
+    uint32_t sent;
+    sim_stats_t stats;
+} sim_node_t;
+
+typedef struct {
+    sim_node_t *src;
+    uint8_t dst[ESP_NOW_ETH_ALEN];
+    uint8_t len;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+} sim_frame_t;
+
+typedef struct {
+    uint32_t senders;
+    uint32_t receivers;
+    uint32_t ftm_clients;
+    double duration_s;
+    double room_m;
+    uint64_t seed;
+    double path_loss_exponent;
+    double shadowing_db;
+    double loss;
+    double sensitivity_dbm;
+    double capture_db;
+    uint32_t airtime_us;
+    uint32_t refresh_ms;
+    uint32_t redraw_ms;
+    double ftm_sigma_cm;
+    uint32_t ftm_session_ms;
+    const char *node_path;
+} sim_args_t;
+
+static sim_args_t s_args = {
+    .senders = 30,
+    .receivers = 1,
+    .ftm_clients = 0,
+    .duration_s = 60.0,
+    .room_m = 20.0,
+    .seed = 1,
+    .path_loss_exponent = 2.2,
+    .shadowing_db = 4.0,
+    .loss = 0.01,
+    .sensitivity_dbm = -97.0,
+    .capture_db = 10.0,
+    .airtime_us = 850,
+    .refresh_ms = 33,
+    .redraw_ms = 15,
+    .ftm_sigma_cm = 100.0,
+    .ftm_session_ms = 100,
+    .node_path = CUBE_SIM_NODE_PATH,
+};
+
+static sim_node_t s_nodes[3 * SIM_MAX_NODES];
+static uint32_t s_node_count = 0;
+static double s_ftm_x = 0.0;
+static double s_ftm_y = 0.0;
+
+// Air state, the random numbers are only drawn under the lock as well
+static pthread_mutex_t s_air_lock = PTHREAD_MUTEX_INITIALIZER;
+static esp_timer_handle_t s_air_timer = NULL;
+static sim_frame_t s_group[SIM_MAX_GROUP];
+static uint32_t s_group_count = 0;
+static int64_t s_group_start_us = 0;
+static sim_frame_t s_waiting[SIM_MAX_WAITING];
+static uint32_t s_waiting_count = 0;
+static uint64_t s_on_air_us = 0;            // Channel busy time
+static uint32_t s_air_dropped = 0;
+static uint64_t s_rng;
+
+// --- Random numbers, xorshift64* ---
+
+static double sim_uniform(void)
+{
+    s_rng ^= s_rng >> 12;
+    s_rng ^= s_rng << 25;
+    s_rng ^= s_rng >> 27;
+    return (double)((s_rng * 0x2545F4914F6CDD1DULL) >> 11) / (double)(1ULL << 53);
+}
+
+static double sim_gauss(double sigma)
+{
+    const double u = 1.0 - sim_uniform();
+    const double v = sim_uniform();
+    return sigma * sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// --- Statistics ---
+
+static void sim_samples_add(sim_samples_t *s, double value)
+{
+    if (s->count == s->size) {
+        s->size = (s->size == 0) ? 1024 : 2 * s->size;
+        s->values = realloc(s->values, s->size * sizeof(double));
+        if (s->values == NULL) {
+            abort();
+        }
+    }
+    s->values[s->count++] = value;
+}
+
+static int sim_compare(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double sim_percentile(sim_samples_t *s, double pct)
+{
+    if (s->count == 0) {
+        return NAN;
+    }
+
+    qsort(s->values, s->count, sizeof(double), sim_compare);
+    uint32_t i = (uint32_t)(s->count * pct / 100.0);
+    return s->values[(i < s->count) ? i : s->count - 1];
+}
+
+static void sim_samples_merge(sim_samples_t *to, const sim_samples_t *from)
+{
+    for (uint32_t i = 0; i < from->count; i++) {
+        sim_samples_add(to, from->values[i]);
+    }
+}
+
+// --- Air model ---
+
+static double sim_distance(const sim_node_t *a, double x, double y)
+{
+    const double d = hypot(a->x - x, a->y - y);
+    return (d < 0.1) ? 0.1 : d;
+}
+
+static double sim_path_rssi(double distance_m)
+{
+    return SIM_RSSI_AT_1_METER - 10.0 * s_args.path_loss_exponent * log10(distance_m) +
+           sim_gauss(s_args.shadowing_db);
+}
+
+static sim_node_t *sim_find_node(const uint8_t *mac)
+{
+    for (uint32_t i = 0; i < s_node_count; i++) {
+        if (memcmp(s_nodes[i].mac, mac, ESP_NOW_ETH_ALEN) == 0) {
+            return &s_nodes[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void sim_post(sim_node_t *node, const sim_event_t *event)
+{
+    if (xQueueSend(node->rx, event, 0) != pdTRUE) {
+        node->stats.rx_full++;
+    }
+}
+
+// Decodes the frames of one transmission at every receiver, with s_air_lock held
+static void sim_air_resolve(void)
+{
+    sim_event_t event = { .type = SIM_EVENT_FRAME };
+
+    for (uint32_t r = 0; r < s_node_count; r++) {
+        sim_node_t *node = &s_nodes[r];
+        double best = -1000.0;
+        double second = -1000.0;
+        uint32_t best_i = 0;
+
+        if (node->role != SIM_ROLE_RECEIVER) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < s_group_count; i++) {
+            const double rssi = sim_path_rssi(sim_distance(node, s_group[i].src->x, s_group[i].src->y));
+            if (rssi > best) {
+                second = best;
+                best = rssi;
+                best_i = i;
+            } else if (rssi > second) {
+                second = rssi;
+            }
+        }
+
+        if (s_group_count > 1) {
+            node->stats.collided += s_group_count - 1;
+            if (best - second < s_args.capture_db) {
+                node->stats.collided++;
+                continue;
+            }
+        }
+
+        if (best < s_args.sensitivity_dbm) {
+            node->stats.too_weak++;
+        } else if (sim_uniform() < s_args.loss) {
+            node->stats.lost++;
+        } else {
+            const sim_frame_t *frame = &s_group[best_i];
+            memcpy(event.mac, frame->src->mac, ESP_NOW_ETH_ALEN);
+            event.rssi = (int8_t)lround((best > 0.0) ? 0.0 : best);
+            event.len = frame->len;
+            memcpy(event.data, frame->data, frame->len);
+            node->stats.heard++;
+            sim_post(node, &event);
+        }
+    }
+
+    // Broadcasts are not acknowledged, the send callback reports the end of the transmission
+    for (uint32_t i = 0; i < s_group_count; i++) {
+        sim_event_t done = { .type = SIM_EVENT_SEND_DONE };
+        memcpy(done.mac, s_group[i].dst, ESP_NOW_ETH_ALEN);
+        sim_post(s_group[i].src, &done);
+    }
+
+    s_on_air_us += s_args.airtime_us;
+    s_group_count = 0;
+}
+
+// Starts the waiting frames with the lowest backoff, equal backoffs collide. With s_air_lock held
+static void sim_air_contend(int64_t now_us)
+{
+    uint8_t draws[SIM_MAX_WAITING];
+    uint8_t low = UINT8_MAX;
+
+    for (uint32_t i = 0; i < s_waiting_count; i++) {
+        draws[i] = (uint8_t)(sim_uniform() * (SIM_CW_MIN + 1));
+        if (draws[i] < low) {
+            low = draws[i];
+        }
+    }
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < s_waiting_count; i++) {
+        if (draws[i] == low && s_group_count < SIM_MAX_GROUP) {
+            s_group[s_group_count++] = s_waiting[i];
+        } else {
+            s_waiting[kept++] = s_waiting[i];
+        }
+    }
+    s_waiting_count = kept;
+
+    s_group_start_us = now_us + SIM_DIFS_US + (int64_t)low * SIM_SLOT_US;
+    esp_timer_start_once(s_air_timer, s_group_start_us + s_args.airtime_us - now_us);
+}
+
+// esp_timer task, the transmission in the air ended
+static void sim_air_timer_cb(void *arg)
+{
+    pthread_mutex_lock(&s_air_lock);
+
+    sim_air_resolve();
+    if (s_waiting_count > 0) {
+        sim_air_contend(esp_timer_get_time());
+    }
+
+    pthread_mutex_unlock(&s_air_lock);
+}
+
+// esp_now_send() of a node, runs in its sender task
+static void sim_air_send(void *ctx, const uint8_t *dst, const uint8_t *data, int len)
+{
+    sim_node_t *node = ctx;
+    const int64_t now_us = esp_timer_get_time();
+    sim_frame_t frame = { .src = node, .len = (uint8_t)len };
+
+    memcpy(frame.dst, dst, ESP_NOW_ETH_ALEN);
+    memcpy(frame.data, data, (size_t)len);
+
+    pthread_mutex_lock(&s_air_lock);
+
+    node->sent++;
+
+    if (s_group_count > 0 && now_us >= s_group_start_us && now_us < s_group_start_us + SIM_SLOT_US) {
+        // Carrier sense cannot see a transmission that started less than a slot ago
+        if (s_group_count < SIM_MAX_GROUP) {
+            s_group[s_group_count++] = frame;
+        } else {
+            s_air_dropped++;
+        }
+    } else if (s_group_count > 0) {
+        if (s_waiting_count < SIM_MAX_WAITING) {
+            s_waiting[s_waiting_count++] = frame;
+        } else {
+            s_air_dropped++;
+        }
+    } else {
+        s_group[0] = frame;
+        s_group_count = 1;
+        s_group_start_us = now_us;
+        esp_timer_start_once(s_air_timer, s_args.airtime_us);
+    }
+
+    pthread_mutex_unlock(&s_air_lock);
+}
+
+// --- FTM ---
+
+// esp_wifi_ftm_initiate_session() of a client, runs in its main task
+static void sim_ftm_session(void *ctx, const wifi_ftm_initiator_cfg_t *cfg)
+{
+    sim_node_t *node = ctx;
+    const double distance_m = sim_distance(node, s_ftm_x, s_ftm_y);
+
+    pthread_mutex_lock(&s_air_lock);
+
+    wifi_event_ftm_report_t report = {
+        .status = FTM_STATUS_SUCCESS,
+        .ftm_report_num_entries = cfg->frm_count,
+    };
+    memcpy(report.peer_mac, cfg->resp_mac, sizeof(report.peer_mac));
+
+    if (sim_path_rssi(distance_m) < s_args.sensitivity_dbm) {
+        report.status = FTM_STATUS_NO_RESPONSE;
+        report.ftm_report_num_entries = 0;
+        node->stats.ftm_failed++;
+    } else {
+        const double dist_cm = distance_m * 100.0 + sim_gauss(s_args.ftm_sigma_cm);
+        report.dist_est = (dist_cm > 0.0) ? (uint32_t)lround(dist_cm) : 0;
+        report.rtt_est = (uint32_t)lround(2.0 * report.dist_est / 29.98);
+        report.rtt_raw = report.rtt_est;
+    }
+    node->stats.ftm_sessions++;
+
+    pthread_mutex_unlock(&s_air_lock);
+
+    if (!esp_timer_is_active(node->ftm_timer)) {
+        node->ftm_report = report;
+        esp_timer_start_once(node->ftm_timer, (uint64_t)s_args.ftm_session_ms * 1000);
+    }
+}
+
+static void sim_ftm_timer_cb(void *arg)
+{
+    sim_node_t *node = arg;
+    sim_event_t event = { .type = SIM_EVENT_FTM_REPORT, .report = node->ftm_report };
+
+    sim_post(node, &event);
+}
+
+// --- Tasks of a node ---
+
+static void sim_wifi_task(void *arg)
+{
+    sim_node_t *node = arg;
+    static __thread sim_event_t event;
+
+    while (1) {
+        if (xQueueReceive(node->rx, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        switch (event.type) {
+            case SIM_EVENT_FRAME: {
+                node->api->deliver(event.mac, event.rssi, event.data, event.len);
+
+                const sim_node_t *src = sim_find_node(event.mac);
+                if (src != NULL && node->role == SIM_ROLE_RECEIVER) {
+                    const double true_m = sim_distance(node, src->x, src->y);
+                    const double err = fabs(node->api->get_distance() - true_m);
+                    sim_samples_add(&node->stats.abs_err, err);
+                    sim_samples_add(&node->stats.rel_err, err / true_m);
+                    node->stats.senders_heard[src->index / 8] |= (uint8_t)(1u << (src->index % 8));
+                }
+                break;
+            }
+            case SIM_EVENT_SEND_DONE:
+                node->api->send_done(event.mac, true);
+                break;
+            case SIM_EVENT_FTM_REPORT:
+                node->api->ftm_report(&event.report);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void sim_ui_handle(sim_node_t *node, const ui_update_msg_t *msg)
+{
+    if (msg->type == UI_UPDATE_FTM_REPORT && node->role == SIM_ROLE_FTM_CLIENT) {
+        const double true_m = sim_distance(node, s_ftm_x, s_ftm_y);
+        const double err = fabs(msg->distance_cm / 100.0 - true_m);
+        sim_samples_add(&node->stats.abs_err, err);
+        sim_samples_add(&node->stats.rel_err, err / true_m);
+    }
+}
+
+// Same coalescing as ui_update_task() in main.c, a redraw blocks the task while the queue fills
+static void sim_ui_task(void *arg)
+{
+    sim_node_t *node = arg;
+    const TickType_t refresh = pdMS_TO_TICKS(s_args.refresh_ms);
+    const TickType_t redraw = pdMS_TO_TICKS(s_args.redraw_ms);
+    TickType_t next_apply = xTaskGetTickCount();
+    ui_update_msg_t msg;
+
+    while (1) {
+        if (!node->api->ui_receive(&msg, portMAX_DELAY)) {
+            continue;
+        }
+        sim_ui_handle(node, &msg);
+
+        TickType_t now = xTaskGetTickCount();
+        while ((int32_t)(next_apply - now) > 0 && node->api->ui_receive(&msg, next_apply - now)) {
+            sim_ui_handle(node, &msg);
+            now = xTaskGetTickCount();
+        }
+        while (node->api->ui_receive(&msg, 0)) {
+            sim_ui_handle(node, &msg);
+        }
+
+        node->stats.redraws++;
+        if (redraw > 0) {
+            vTaskDelay(redraw);
+        }
+        next_apply = xTaskGetTickCount() + refresh;
+    }
+}
+
+// Stands in for the main task of an FTM client
+static void sim_ftm_task(void *arg)
+{
+    sim_node_t *node = arg;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(SIM_FTM_PERIOD_MS));
+        node->api->ftm_measure();
+    }
+}
+
+// --- Setup ---
+
+// A copy of the module per node, dlopen() of the same file would share its static variables
+static const sim_node_api_t *sim_load_node(const char *path)
+{
+    char name[] = "/tmp/radio_sim_node_XXXXXX";
+    const int out = mkstemp(name);
+    FILE *in = fopen(path, "rb");
+    char buf[65536];
+    size_t n;
+
+    if (out < 0 || in == NULL) {
+        fprintf(stderr, "Cannot copy the node module %s\n", path);
+        exit(1);
+    }
+
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (write(out, buf, n) != (ssize_t)n) {
+            fprintf(stderr, "Cannot write %s\n", name);
+            exit(1);
+        }
+    }
+    fclose(in);
+    close(out);
+
+    void *handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+    unlink(name);
+    if (handle == NULL) {
+        fprintf(stderr, "%s\n", dlerror());
+        exit(1);
+    }
+
+    const sim_node_api_t *api = dlsym(handle, SIM_NODE_API_SYMBOL);
+    if (api == NULL) {
+        fprintf(stderr, "%s\n", dlerror());
+        exit(1);
+    }
+
+    return api;
+}
+
+static sim_node_t *sim_add_node(sim_role_t role, uint32_t index, double x, double y)
+{
+    sim_node_t *node = &s_nodes[s_node_count++];
+
+    node->index = index;
+    node->role = role;
+    node->x = x;
+    node->y = y;
+    node->mac[0] = 0x02;
+    node->mac[4] = (uint8_t)role;
+    node->mac[5] = (uint8_t)index;
+    node->api = sim_load_node(s_args.node_path);
+    node->rx = xQueueCreate(SIM_RX_QUEUE_LEN, sizeof(sim_event_t));
+
+    node->api->set_air(sim_air_send, node);
+    node->api->set_ftm(sim_ftm_session, node);
+    xTaskCreate(sim_wifi_task, "wifi", 4096, node, 23, NULL);
+
+    return node;
+}
+
+static double sim_room_coordinate(void)
+{
+    return (sim_uniform() - 0.5) * s_args.room_m;
+}
+
+static void sim_start(void)
+{
+    const esp_timer_create_args_t air_args = {
+        .callback = sim_air_timer_cb,
+        .name = "air",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&air_args, &s_air_timer));
+
+    // The first receiver and the FTM responder in the middle of the room
+    for (uint32_t i = 0; i < s_args.receivers; i++) {
+        const double x = (i == 0) ? 0.0 : sim_room_coordinate();
+        const double y = (i == 0) ? 0.0 : sim_room_coordinate();
+        sim_node_t *node = sim_add_node(SIM_ROLE_RECEIVER, i, x, y);
+
+        node->api->start_receiver(node->mac);
+        xTaskCreate(sim_ui_task, "ui", 4096, node, 2, NULL);
+    }
+
+    const wifi_ap_record_t responder = {
+        .bssid = {0x02, 0x00, 0x00, 0x00, 0x03, 0x01},
+        .ssid = "FTM",
+        .primary = 1,
+        .ftm_responder = true,
+    };
+    for (uint32_t i = 0; i < s_args.ftm_clients; i++) {
+        sim_node_t *node = sim_add_node(SIM_ROLE_FTM_CLIENT, i, sim_room_coordinate(), sim_room_coordinate());
+        const esp_timer_create_args_t ftm_args = {
+            .callback = sim_ftm_timer_cb,
+            .arg = node,
+            .name = "ftm",
+        };
+
+        ESP_ERROR_CHECK(esp_timer_create(&ftm_args, &node->ftm_timer));
+        node->api->start_ftm_client(node->mac, &responder);
+        xTaskCreate(sim_ui_task, "ui", 4096, node, 2, NULL);
+        xTaskCreate(sim_ftm_task, "ftm_main", 4096, node, 1, NULL);
+    }
+
+    // Senders start at random phases within one period, each then keeps its own slot grid
+    sim_node_t *senders[SIM_MAX_NODES];
+    int64_t phases[SIM_MAX_NODES];
+    for (uint32_t i = 0; i < s_args.senders; i++) {
+        senders[i] = sim_add_node(SIM_ROLE_SENDER, i, sim_room_coordinate(), sim_room_coordinate());
+        phases[i] = (int64_t)(sim_uniform() * CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000);
+    }
+
+    FAKE_settle();
+    const int64_t start_us = esp_timer_get_time();
+
+    for (uint32_t done = 0; done < s_args.senders; done++) {
+        uint32_t next = 0;
+        for (uint32_t i = 1; i < s_args.senders; i++) {
+            if (senders[next] == NULL || (senders[i] != NULL && phases[i] < phases[next])) {
+                next = i;
+            }
+        }
+
+        FAKE_clock_advance(start_us + phases[next] - esp_timer_get_time());
+        senders[next]->api->start_sender(senders[next]->mac);
+        senders[next] = NULL;
+    }
+}
+
+// --- Report ---
+
+static void sim_report(double duration_s, double wall_s)
+{
+    sim_stats_t rx = { 0 };
+    sim_stats_t ftm = { 0 };
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+    uint32_t heard_min = UINT32_MAX;
+
+    for (uint32_t i = 0; i < s_node_count; i++) {
+        sim_node_t *node = &s_nodes[i];
+        sim_stats_t *to = (node->role == SIM_ROLE_FTM_CLIENT) ? &ftm : &rx;
+
+        sent += node->sent;
+        if (node->role == SIM_ROLE_SENDER) {
+            continue;
+        }
+
+        to->heard += node->stats.heard;
+        to->collided += node->stats.collided;
+        to->too_weak += node->stats.too_weak;
+        to->lost += node->stats.lost;
+        to->rx_full += node->stats.rx_full;
+        to->redraws += node->stats.redraws;
+        to->ftm_sessions += node->stats.ftm_sessions;
+        to->ftm_failed += node->stats.ftm_failed;
+        sim_samples_merge(&to->abs_err, &node->stats.abs_err);
+        sim_samples_merge(&to->rel_err, &node->stats.rel_err);
+        dropped += node->api->ui_dropped();
+
+        if (node->role == SIM_ROLE_RECEIVER) {
+            uint32_t heard = 0;
+            for (uint32_t s = 0; s < s_args.senders; s++) {
+                heard += (node->stats.senders_heard[s / 8] >> (s % 8)) & 1u;
+            }
+            if (heard < heard_min) {
+                heard_min = heard;
+            }
+        }
+    }
+
+    const double copies = (double)sent * s_args.receivers;
+    const double pct = (copies > 0) ? 100.0 / copies : 0.0;
+
+    printf("Senders %lu at %.1f Hz, %lu receivers, %lu FTM clients, %.0f s simulated in %.1f s\n",
+           (unsigned long)s_args.senders, 1000.0 / CONFIG_CUBE_ESPNOW_PERIOD_MS, (unsigned long)s_args.receivers,
+           (unsigned long)s_args.ftm_clients, duration_s, wall_s);
+    printf("Sent        %7lu frames, channel busy %.0f %%, %lu dropped by the air model\n", (unsigned long)sent,
+           100.0 * s_on_air_us / (duration_s * 1e6), (unsigned long)s_air_dropped);
+
+    if (s_args.receivers > 0) {
+        printf("Delivered   %7lu  %6.1f frames/s per receiver  %5.1f %%\n", (unsigned long)rx.abs_err.count,
+               rx.abs_err.count / duration_s / s_args.receivers, rx.abs_err.count * pct);
+        printf("Collided    %7lu  %5.1f %%\n", (unsigned long)rx.collided, rx.collided * pct);
+        printf("Too weak    %7lu  %5.1f %%\n", (unsigned long)rx.too_weak, rx.too_weak * pct);
+        printf("Lost        %7lu  %5.1f %%\n", (unsigned long)rx.lost, rx.lost * pct);
+        printf("Rx full     %7lu  %5.1f %%\n", (unsigned long)rx.rx_full, rx.rx_full * pct);
+        printf("UI dropped  %7lu  %5.1f %%\n", (unsigned long)dropped, dropped * pct);
+        printf("UI redraws  %7lu  %6.1f per s per receiver\n", (unsigned long)rx.redraws,
+               rx.redraws / duration_s / s_args.receivers);
+        printf("History     %lu of %lu senders get a slot\n",
+               (unsigned long)((heard_min < HISTORY_PEERS) ? heard_min : HISTORY_PEERS),
+               (unsigned long)s_args.senders);
+        if (rx.abs_err.count > 0) {
+            printf("Estimate    abs error median %.2f m p90 %.2f m, relative median %.0f %% p90 %.0f %%\n",
+                   sim_percentile(&rx.abs_err, 50), sim_percentile(&rx.abs_err, 90),
+                   100 * sim_percentile(&rx.rel_err, 50), 100 * sim_percentile(&rx.rel_err, 90));
+        }
+    }
+
+    if (s_args.ftm_clients > 0) {
+        printf("FTM         %7lu sessions, %lu failed, %lu reports shown\n", (unsigned long)ftm.ftm_sessions,
+               (unsigned long)ftm.ftm_failed, (unsigned long)ftm.abs_err.count);
+        if (ftm.abs_err.count > 0) {
+            printf("FTM error   abs median %.2f m p90 %.2f m, relative median %.0f %% p90 %.0f %%\n",
+                   sim_percentile(&ftm.abs_err, 50), sim_percentile(&ftm.abs_err, 90),
+                   100 * sim_percentile(&ftm.rel_err, 50), 100 * sim_percentile(&ftm.rel_err, 90));
+        }
+    }
+
+    free(rx.abs_err.values);
+    free(rx.rel_err.values);
+    free(ftm.abs_err.values);
+    free(ftm.rel_err.values);
+}
+
+static void sim_usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --senders N            ESP-NOW senders, %lu\n"
+            "  --receivers N          ESP-NOW receivers, %lu\n"
+            "  --ftm-clients N        FTM clients of one responder in the middle, %lu\n"
+            "  --duration S           simulated seconds, %.0f\n"
+            "  --room M               side of the square room, %.0f\n"
+            "  --seed N               %llu\n"
+            "  --path-loss-exponent X of the simulated room, %.2f\n"
+            "  --shadowing-db X       standard deviation per frame, %.1f\n"
+            "  --loss X               random frame loss probability, %.2f\n"
+            "  --sensitivity-dbm X    %.0f\n"
+            "  --capture-db X         margin to decode the stronger of two frames, %.0f\n"
+            "  --airtime-us N         ESP-NOW frame with preamble at 1 Mbps, %lu\n"
+            "  --refresh-ms N         UI refresh period, %lu\n"
+            "  --redraw-ms N          time of one UI update and flush, %lu\n"
+            "  --ftm-sigma-cm X       FTM distance error, %.0f\n"
+            "  --ftm-session-ms N     %lu\n"
+            "  --node PATH            node module, %s\n"
+            "The send rate is CONFIG_CUBE_ESPNOW_PERIOD_MS of the node module, set with -DCUBE_SIM_PERIOD_MS.\n",
+            name, (unsigned long)s_args.senders, (unsigned long)s_args.receivers, (unsigned long)s_args.ftm_clients,
+            s_args.duration_s, s_args.room_m, (unsigned long long)s_args.seed, s_args.path_loss_exponent,
+            s_args.shadowing_db, s_args.loss, s_args.sensitivity_dbm, s_args.capture_db,
+            (unsigned long)s_args.airtime_us, (unsigned long)s_args.refresh_ms, (unsigned long)s_args.redraw_ms,
+            s_args.ftm_sigma_cm, (unsigned long)s_args.ftm_session_ms, s_args.node_path);
+}
+
+static void sim_parse(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "senders", required_argument, NULL, 's' },
+        { "receivers", required_argument, NULL, 'r' },
+        { "ftm-clients", required_argument, NULL, 'f' },
+        { "duration", required_argument, NULL, 'd' },
+        { "room", required_argument, NULL, 'm' },
+        { "seed", required_argument, NULL, 'S' },
+        { "path-loss-exponent", required_argument, NULL, 'n' },
+        { "shadowing-db", required_argument, NULL, 'w' },
+        { "loss", required_argument, NULL, 'l' },
+        { "sensitivity-dbm", required_argument, NULL, 'e' },
+        { "capture-db", required_argument, NULL, 'c' },
+        { "airtime-us", required_argument, NULL, 'a' },
+        { "refresh-ms", required_argument, NULL, 'R' },
+        { "redraw-ms", required_argument, NULL, 'D' },
+        { "ftm-sigma-cm", required_argument, NULL, 'F' },
+        { "ftm-session-ms", required_argument, NULL, 'T' },
+        { "node", required_argument, NULL, 'N' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+            case 's': s_args.senders = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': s_args.receivers = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'f': s_args.ftm_clients = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'd': s_args.duration_s = strtod(optarg, NULL); break;
+            case 'm': s_args.room_m = strtod(optarg, NULL); break;
+            case 'S': s_args.seed = strtoull(optarg, NULL, 0); break;
+            case 'n': s_args.path_loss_exponent = strtod(optarg, NULL); break;
+            case 'w': s_args.shadowing_db = strtod(optarg, NULL); break;
+            case 'l': s_args.loss = strtod(optarg, NULL); break;
+            case 'e': s_args.sensitivity_dbm = strtod(optarg, NULL); break;
+            case 'c': s_args.capture_db = strtod(optarg, NULL); break;
+            case 'a': s_args.airtime_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'R': s_args.refresh_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'D': s_args.redraw_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'F': s_args.ftm_sigma_cm = strtod(optarg, NULL); break;
+            case 'T': s_args.ftm_session_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'N': s_args.node_path = optarg; break;
+            default:
+                sim_usage(argv[0]);
+                exit(opt == 'h' ? 0 : 2);
+        }
+    }
+
+    if (s_args.senders > SIM_MAX_NODES || s_args.receivers > SIM_MAX_NODES || s_args.ftm_clients > SIM_MAX_NODES) {
+        fprintf(stderr, "At most %d nodes per role\n", SIM_MAX_NODES);
+        exit(2);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct timespec start, end;
+
+    sim_parse(argc, argv);
+    s_rng = s_args.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    FAKE_log_set_level(ESP_LOG_ERROR);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    sim_start();
+
+    // In steps of one second, the clock only moves here
+    const int64_t end_us = esp_timer_get_time() + (int64_t)(s_args.duration_s * 1e6);
+    while (esp_timer_get_time() < end_us) {
+        const int64_t step_us = end_us - esp_timer_get_time();
+        FAKE_clock_advance((step_us < 1000 * 1000) ? step_us : 1000 * 1000);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sim_report(s_args.duration_s, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9);
+
+    // The node tasks block forever, exit() ends them
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,76 @@
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "EspNowCommon.h"
+#include "EspNowReceiver.h"
+#include "EspNowSender.h"
+#include "FtmClient.h"
+#include "FtmCommon.h"
+#include "UiUpdate.h"
+#include "linkmon.h"
+#include "proximity.h"
+
+#include "sim_node.h"
+
+static void sim_start_receiver(const uint8_t *mac)
+{
+    FAKE_wifi_set_mac(mac);
+    UIUPDATE_init();
+    LINKMON_init(NULL);
+    PROXIMITY_init();
+
+    LINKMON_start();
+    ESP_ERROR_CHECK(esp_now_wifi_init());
+    RECEIVER_init();
+    PROXIMITY_start();
+}
+
+static void sim_start_sender(const uint8_t *mac)
+{
+    FAKE_wifi_set_mac(mac);
+    UIUPDATE_init();
+    LINKMON_init(NULL);
+
+    LINKMON_start();
+    ESP_ERROR_CHECK(esp_now_wifi_init());
+    SENDER_init();
+}
+
+static void sim_start_ftm_client(const uint8_t *mac, const wifi_ap_record_t *responder)
+{
+    FAKE_wifi_set_mac(mac);
+    FAKE_wifi_set_scan(responder, 1);
+    UIUPDATE_init();
+    LINKMON_init(NULL);
+
+    LINKMON_start();
+    ESP_ERROR_CHECK(ftm_wifi_init());
+    FTMCLIENT_init();
+}
+
+static void sim_ftm_measure(void)
+{
+    FTMCLIENT_measure();
+}
+
+// Event bases are per copy, the executable cannot name them
+static void sim_ftm_report(wifi_event_ftm_report_t *report)
+{
+    FAKE_event_post(WIFI_EVENT, WIFI_EVENT_FTM_REPORT, report);
+}
+
+const sim_node_api_t SIM_node_api = {
+    .start_receiver = sim_start_receiver,
+    .start_sender = sim_start_sender,
+    .start_ftm_client = sim_start_ftm_client,
+    .ftm_measure = sim_ftm_measure,
+    .set_air = FAKE_esp_now_set_air,
+    .set_ftm = FAKE_wifi_set_ftm,
+    .deliver = FAKE_esp_now_deliver,
+    .send_done = FAKE_esp_now_send_done,
+    .ftm_report = sim_ftm_report,
+    .get_distance = RECEIVER_getDistance,
+    .ui_receive = UIUPDATE_receive,
+    .ui_dropped = UIUPDATE_get_dropped,
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "fake.h"
+#include "UiUpdate.h"
+
+/*
+ * One node of radio_sim. The firmware modules keep their state in static
+ * variables, so radio_sim loads a separate copy of the node module per node.
+ * The scheduler and the clock come from the executable and are shared.
+ */
+
+typedef struct {
+    // Roles, started the way radio.c does
+    void (*start_receiver)(const uint8_t *mac);
+    void (*start_sender)(const uint8_t *mac);
+    void (*start_ftm_client)(const uint8_t *mac, const wifi_ap_record_t *responder);
+
+    // The main task of an FTM client calls this once per period
+    void (*ftm_measure)(void);
+
+    // Hooks of the radio model, see fake.h
+    void (*set_air)(fake_air_send_t send, void *ctx);
+    void (*set_ftm)(fake_ftm_session_t session, void *ctx);
+
+    // Called from the Wi-Fi task of the node
+    void (*deliver)(const uint8_t *src, int8_t rssi, const void *data, int len);
+    void (*send_done)(const uint8_t *dst, bool success);
+    void (*ftm_report)(wifi_event_ftm_report_t *report);
+
+    // Distance of the last received ESP-NOW frame
+    float (*get_distance)(void);
+
+    bool (*ui_receive)(ui_update_msg_t *msg, TickType_t timeout);
+    uint32_t (*ui_dropped)(void);
+} sim_node_api_t;
+
+#define SIM_NODE_API_SYMBOL     "SIM_node_api"
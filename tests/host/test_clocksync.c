@@ -0,0 +1,178 @@
+#include <stdint.h>
+
+#include "check.h"
+#include "clocksync.h"
+
+// Master clock of the exchanges: offset plus drift against the local clock
+typedef struct {
+    int64_t offset_us;
+    double drift_ppm;
+} master_t;
+
+static int64_t master_time(const master_t *m, int64_t local_us)
+{
+    return local_us + m->offset_us + (int64_t)(local_us * m->drift_ppm * 1e-6);
+}
+
+// One exchange at local time t1 with the given one-way delays and turnaround
+static bool exchange(clocksync_t *c, const master_t *m, int64_t t1, int64_t up_us, int64_t down_us)
+{
+    const int64_t t2 = master_time(m, t1 + up_us);
+    const int64_t t3 = t2 + 100;
+    const int64_t t4 = t1 + up_us + 100 + down_us;
+
+    return CLOCKSYNC_exchange(c, t1, t2, t3, t4);
+}
+
+static void test_no_estimate_without_exchange(void)
+{
+    clocksync_t c;
+    int64_t shared_us;
+    uint32_t error_us;
+
+    CLOCKSYNC_init(&c);
+    CHECK(!CLOCKSYNC_to_shared(&c, 1000000, &shared_us, &error_us));
+}
+
+static void test_single_exchange_offset(void)
+{
+    const master_t m = { .offset_us = 5000 };
+    clocksync_t c;
+    int64_t shared_us;
+    uint32_t error_us;
+
+    CLOCKSYNC_init(&c);
+    CHECK(exchange(&c, &m, 1000000, 400, 400));
+
+    CHECK(CLOCKSYNC_to_shared(&c, 1000900, &shared_us, &error_us));
+    CHECK_INT(shared_us, 1000900 + 5000);
+
+    // Half the round trip, no residual, no holdover at the exchange itself
+    CHECK_INT(c.best_rtt_us, 800);
+    CHECK_INT(error_us, 400);
+
+    // The holdover grows with the time since the exchange
+    CHECK(CLOCKSYNC_to_shared(&c, 1000900 + 10000000, &shared_us, &error_us));
+    CHECK_INT(error_us, 400 + 200);
+}
+
+static void test_drift_fit(void)
+{
+    const master_t m = { .offset_us = -20000, .drift_ppm = 50.0 };
+    clocksync_t c;
+    int64_t shared_us;
+    uint32_t error_us;
+
+    CLOCKSYNC_init(&c);
+    for (int i = 0; i < CLOCKSYNC_SAMPLES; i++) {
+        CHECK(exchange(&c, &m, 1000000 + i * 1000000LL, 500, 500));
+    }
+
+    CHECK_NEAR(c.drift_ppb, 50000, 1000);
+    CHECK(c.residual_us <= 2);
+
+    // Ten seconds after the last exchange the drift is still followed
+    const int64_t local_us = 20000000;
+    CHECK(CLOCKSYNC_to_shared(&c, local_us, &shared_us, &error_us));
+    CHECK_NEAR(shared_us, master_time(&m, local_us), 15);
+    CHECK(error_us >= 500);
+}
+
+static void test_asymmetric_delay_bounded(void)
+{
+    const master_t m = { .offset_us = 3000 };
+    clocksync_t c;
+    int64_t shared_us;
+    uint32_t error_us;
+
+    CLOCKSYNC_init(&c);
+    CHECK(exchange(&c, &m, 1000000, 200, 600));
+
+    // The asymmetry is invisible, but within the error bound
+    CHECK(CLOCKSYNC_to_shared(&c, 1001000, &shared_us, &error_us));
+    const int64_t error = shared_us - master_time(&m, 1001000);
+    CHECK((error < 0 ? -error : error) <= (int64_t)error_us);
+}
+
+static void test_slow_exchanges_rejected(void)
+{
+    const master_t m = { .offset_us = 1000 };
+    clocksync_t c;
+
+    CLOCKSYNC_init(&c);
+    CHECK(exchange(&c, &m, 1000000, 400, 400));
+    CHECK(exchange(&c, &m, 2000000, 400, 400));
+
+    // Queued behind other traffic, far beyond twice the best round trip
+    int64_t t1 = 3000000;
+    for (int i = 0; i < 7; i++, t1 += 1000000) {
+        CHECK(!exchange(&c, &m, t1, 400, 5000));
+    }
+    CHECK_INT(c.count, 2);
+
+    // After too many rejections in a row the reference is reset, the link got slower
+    CHECK(exchange(&c, &m, t1, 400, 5000));
+    CHECK_INT(c.count, 3);
+    CHECK_INT(c.rejected, 0);
+
+    // Impossible timestamps
+    CHECK(!CLOCKSYNC_exchange(&c, 1000, 0, 5000, 2000));
+}
+
+static void test_sample_ring(void)
+{
+    const master_t m = { .offset_us = 1000 };
+    clocksync_t c;
+
+    CLOCKSYNC_init(&c);
+    for (int i = 0; i < CLOCKSYNC_SAMPLES + 3; i++) {
+        CHECK(exchange(&c, &m, 1000000 + i * 1000000LL, 400, 400));
+    }
+
+    CHECK_INT(c.count, CLOCKSYNC_SAMPLES);
+    CHECK_INT(c.next, 3);
+}
+
+static void test_rx_time_removes_delivery_jitter(void)
+{
+    clocksync_rxstamp_t s;
+    const int64_t epoch_us = 777;
+
+    CLOCKSYNC_rxstamp_init(&s);
+
+    // First frame delivered 300 us after reception
+    CHECK_INT(CLOCKSYNC_rx_time(&s, (uint32_t)(1000000 - 300 + epoch_us), 1000000), 1000000);
+
+    // 200 us slower than the fastest so far
+    CHECK_INT(CLOCKSYNC_rx_time(&s, (uint32_t)(2000000 - 500 + epoch_us), 2000000), 2000000 - 200);
+
+    // A faster frame becomes the new reference
+    CHECK_INT(CLOCKSYNC_rx_time(&s, (uint32_t)(3000000 - 100 + epoch_us), 3000000), 3000000);
+    CHECK_INT(CLOCKSYNC_rx_time(&s, (uint32_t)(4000000 - 300 + epoch_us), 4000000), 4000000 - 200);
+}
+
+static void test_rx_time_wraps(void)
+{
+    clocksync_rxstamp_t s;
+
+    CLOCKSYNC_rxstamp_init(&s);
+
+    // The rx_ctrl clock wraps between the two frames
+    const uint32_t before = UINT32_MAX - 1000;
+    CHECK_INT(CLOCKSYNC_rx_time(&s, before, 5000000), 5000000);
+    CHECK_INT(CLOCKSYNC_rx_time(&s, before + 3000, 5003000 + 50), 5003000);
+}
+
+int main(void)
+{
+    RUN_TEST(test_no_estimate_without_exchange);
+    RUN_TEST(test_single_exchange_offset);
+    RUN_TEST(test_drift_fit);
+    RUN_TEST(test_asymmetric_delay_bounded);
+    RUN_TEST(test_slow_exchanges_rejected);
+    RUN_TEST(test_sample_ring);
+    RUN_TEST(test_rx_time_removes_delivery_jitter);
+    RUN_TEST(test_rx_time_wraps);
+
+    return CHECK_RESULT();
+}
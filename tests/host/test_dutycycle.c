@@ -0,0 +1,134 @@
+#include <stdint.h>
+
+#include "check.h"
+#include "dutycycle.h"
+
+static const dutycycle_config_t s_config = {
+    .period_us = 100000,
+    .window_us = 10000,
+    .guard_us = 5000,
+    .max_missed = 2,
+};
+
+static void test_unsynced_listens(void)
+{
+    dutycycle_t dc;
+    int64_t open_us, close_us;
+
+    DUTYCYCLE_init(&dc, &s_config);
+
+    CHECK(!dc.synced);
+    CHECK(!DUTYCYCLE_get_window(&dc, &open_us, &close_us));
+
+    // A missed window before the first frame changes nothing
+    DUTYCYCLE_window_missed(&dc);
+    CHECK(!dc.synced);
+    CHECK_INT(dc.missed, 0);
+}
+
+static void test_window_follows_frame(void)
+{
+    dutycycle_t dc;
+    int64_t open_us, close_us;
+
+    DUTYCYCLE_init(&dc, &s_config);
+    DUTYCYCLE_frame(&dc, 1000000);
+
+    CHECK(dc.synced);
+    CHECK_INT(dc.resyncs, 1);
+    CHECK_INT(dc.expected_us, 1100000);
+
+    // Half the window plus one guard on each side
+    CHECK(DUTYCYCLE_get_window(&dc, &open_us, &close_us));
+    CHECK_INT(open_us, 1090000);
+    CHECK_INT(close_us, 1110000);
+
+    // A late frame anchors the next window on itself
+    DUTYCYCLE_frame(&dc, 1103000);
+    CHECK_INT(dc.expected_us, 1203000);
+    CHECK_INT(dc.resyncs, 1);
+}
+
+static void test_missed_windows_widen_then_resync(void)
+{
+    dutycycle_t dc;
+    int64_t open_us, close_us;
+
+    DUTYCYCLE_init(&dc, &s_config);
+    DUTYCYCLE_frame(&dc, 1000000);
+
+    DUTYCYCLE_window_missed(&dc);
+    CHECK_INT(dc.missed, 1);
+    CHECK(DUTYCYCLE_get_window(&dc, &open_us, &close_us));
+    CHECK_INT(open_us, 1200000 - 15000);
+    CHECK_INT(close_us, 1200000 + 15000);
+
+    DUTYCYCLE_window_missed(&dc);
+    CHECK(dc.synced);
+    CHECK(DUTYCYCLE_get_window(&dc, &open_us, &close_us));
+    CHECK_INT(close_us - open_us, 2 * 20000);
+
+    // One more than max_missed drops the phase, the receiver listens continuously again
+    DUTYCYCLE_window_missed(&dc);
+    CHECK(!dc.synced);
+    CHECK_INT(dc.missed, 0);
+    CHECK(!DUTYCYCLE_get_window(&dc, &open_us, &close_us));
+
+    DUTYCYCLE_frame(&dc, 2000000);
+    CHECK(dc.synced);
+    CHECK_INT(dc.resyncs, 2);
+}
+
+static void test_window_clamped_to_period(void)
+{
+    const dutycycle_config_t config = {
+        .period_us = 100000,
+        .window_us = 10000,
+        .guard_us = 40000,
+        .max_missed = 5,
+    };
+    dutycycle_t dc;
+    int64_t open_us, close_us;
+
+    DUTYCYCLE_init(&dc, &config);
+    DUTYCYCLE_frame(&dc, 0);
+    DUTYCYCLE_window_missed(&dc);
+
+    CHECK(DUTYCYCLE_get_window(&dc, &open_us, &close_us));
+    CHECK_INT(close_us - open_us, 100000);
+}
+
+static void test_next_slot_grid(void)
+{
+    const dutycycle_config_t config = { .period_us = 100 };
+
+    CHECK_INT(DUTYCYCLE_next_slot(&config, 1000, 900), 1000);
+    CHECK_INT(DUTYCYCLE_next_slot(&config, 1000, 1000), 1100);
+    CHECK_INT(DUTYCYCLE_next_slot(&config, 1000, 1099), 1100);
+    CHECK_INT(DUTYCYCLE_next_slot(&config, 1000, 1100), 1200);
+
+    // A late call skips the missed slots instead of sending a burst
+    CHECK_INT(DUTYCYCLE_next_slot(&config, 1000, 1550), 1600);
+}
+
+static void test_duty(void)
+{
+    const dutycycle_config_t always = { .period_us = 10000, .window_us = 8000, .guard_us = 2000 };
+    const dutycycle_config_t none = { .period_us = 0, .window_us = 1000 };
+
+    CHECK_INT(DUTYCYCLE_get_duty_permille(&s_config), 200);
+    CHECK_INT(DUTYCYCLE_get_duty_permille(&always), 1000);
+    CHECK_INT(DUTYCYCLE_get_duty_permille(&none), 1000);
+}
+
+int main(void)
+{
+    RUN_TEST(test_unsynced_listens);
+    RUN_TEST(test_window_follows_frame);
+    RUN_TEST(test_missed_windows_widen_then_resync);
+    RUN_TEST(test_window_clamped_to_period);
+    RUN_TEST(test_next_slot_grid);
+    RUN_TEST(test_duty);
+
+    return CHECK_RESULT();
+}
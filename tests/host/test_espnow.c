@@ -0,0 +1,378 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_now.h"
+#include "esp_timer.h"
+
+#include "check.h"
+#include "fake.h"
+
+#include "EspNowCommon.h"
+#include "EspNowReceiver.h"
+#include "EspNowSender.h"
+#include "UiUpdate.h"
+#include "linkmon.h"
+#include "proximity.h"
+#include "report.h"
+#include "timesync.h"
+#include "trace.h"
+
+#define MAX_FRAMES      (64)
+
+typedef struct {
+    uint8_t dst[ESP_NOW_ETH_ALEN];
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+    int len;
+    int64_t time_us;
+} frame_t;
+
+static const uint8_t s_own_mac[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x10};
+static const uint8_t s_collector_mac[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0xC0};
+
+static frame_t s_frames[MAX_FRAMES];
+static uint32_t s_frame_count;
+
+static void sender_mac(uint8_t *mac, uint8_t n)
+{
+    const uint8_t base[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x01, 0x00};
+
+    memcpy(mac, base, ESP_NOW_ETH_ALEN);
+    mac[5] = n;
+}
+
+static void send_ping(uint8_t n, int8_t rssi)
+{
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    const char text[] = "Ping 1";
+
+    sender_mac(mac, n);
+    FAKE_esp_now_deliver(mac, rssi, text, (int)strlen(text));
+}
+
+static uint32_t drain_ui(ui_update_msg_t *last)
+{
+    ui_update_msg_t msg;
+    uint32_t count = 0;
+
+    while (UIUPDATE_receive(&msg, 0)) {
+        if (last != NULL) {
+            *last = msg;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+// Captures the frames instead of completing them at once, the send callback still runs
+static void capture(void *ctx, const uint8_t *dst, const uint8_t *data, int len)
+{
+    (void)ctx;
+
+    if (s_frame_count < MAX_FRAMES) {
+        frame_t *f = &s_frames[s_frame_count];
+        memcpy(f->dst, dst, ESP_NOW_ETH_ALEN);
+        memcpy(f->data, data, (size_t)len);
+        f->len = len;
+        f->time_us = esp_timer_get_time();
+    }
+    s_frame_count++;
+
+    FAKE_esp_now_send_done(dst, true);
+}
+
+static const frame_t *find_frame(uint32_t from, uint8_t type)
+{
+    for (uint32_t i = from; i < s_frame_count && i < MAX_FRAMES; i++) {
+        const report_header_t *header = (const report_header_t *)s_frames[i].data;
+        if (type == 0 ? header->magic != REPORT_MAGIC : (header->magic == REPORT_MAGIC && header->type == type)) {
+            return &s_frames[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void test_receiver_frame(void)
+{
+    ui_update_msg_t msg;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    const uint32_t heartbeats = LINKMON_get_heartbeats();
+
+    drain_ui(NULL);
+    send_ping(0, -51);
+
+    CHECK_INT(drain_ui(&msg), 1);
+    CHECK_INT(msg.type, UI_UPDATE_ESPNOW_RX);
+    CHECK_INT(msg.peer, 0);
+    CHECK_INT(msg.rssi, -51);
+    CHECK_INT(msg.distance_cm, 100);
+
+    CHECK_NEAR(RECEIVER_getDistance(), 1.0, 1e-4);
+    CHECK_INT(RECEIVER_getRSSI(), -51);
+    CHECK_INT(LINKMON_get_heartbeats(), heartbeats + 1);
+
+    sender_mac(mac, 0);
+    CHECK_INT(RECEIVER_lookup_peer(mac), 0);
+
+    FAKE_clock_advance(250 * 1000);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 0), LINKMON_STATE_ALIVE);
+}
+
+static void test_receiver_peer_slots(void)
+{
+    ui_update_msg_t msg;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+
+    for (uint8_t n = 0; n < HISTORY_PEERS; n++) {
+        send_ping(n, -60);
+        drain_ui(&msg);
+        CHECK_INT(msg.peer, n);
+    }
+
+    // Beyond the tracked slots the frame is still shown, but not tracked
+    const uint32_t heartbeats = LINKMON_get_heartbeats();
+    send_ping(HISTORY_PEERS, -60);
+    CHECK_INT(drain_ui(&msg), 1);
+    CHECK_INT(msg.peer, HISTORY_NO_PEER);
+    CHECK_INT(LINKMON_get_heartbeats(), heartbeats);
+
+    sender_mac(mac, HISTORY_PEERS);
+    CHECK_INT(RECEIVER_lookup_peer(mac), HISTORY_NO_PEER);
+}
+
+static void test_receiver_skips_reports(void)
+{
+    const report_header_t beacon = {
+        .magic = REPORT_MAGIC,
+        .version = REPORT_VERSION,
+        .type = REPORT_FRAME_BEACON,
+    };
+    const uint32_t heartbeats = LINKMON_get_heartbeats();
+
+    drain_ui(NULL);
+    FAKE_esp_now_deliver(s_collector_mac, -40, &beacon, sizeof(beacon));
+
+    CHECK_INT(drain_ui(NULL), 0);
+    CHECK_INT(LINKMON_get_heartbeats(), heartbeats);
+    CHECK_INT(RECEIVER_lookup_peer(s_collector_mac), HISTORY_NO_PEER);
+
+    // Broken frames are dropped
+    FAKE_esp_now_deliver(s_collector_mac, -40, &beacon, 0);
+    CHECK_INT(drain_ui(NULL), 0);
+}
+
+static void test_receiver_approach(void)
+{
+    approach_result_t result;
+
+    // Walking in from about 10 m to 1 m at 2 m/s, 10 frames per second
+    for (int i = 0; i <= 45; i++) {
+        const float distance = 10.0f - 0.2f * i;
+        const int8_t rssi = (int8_t)lrintf(-51.0f - 16.4f * log10f(distance));
+        send_ping(1, rssi);
+        drain_ui(NULL);
+        FAKE_clock_advance(100 * 1000);
+    }
+
+    RECEIVER_get_approach(1, esp_timer_get_time(), &result);
+    CHECK(result.rate_mps < -1.0f);
+    CHECK(result.state == APPROACH_CLOSING || result.state == APPROACH_CLOSING_FAST);
+
+    // Unknown after the frames stop
+    RECEIVER_get_approach(1, esp_timer_get_time() + 5000 * 1000, &result);
+    CHECK_INT(result.state, APPROACH_UNKNOWN);
+
+    RECEIVER_get_approach(HISTORY_NO_PEER, esp_timer_get_time(), &result);
+    CHECK_INT(result.state, APPROACH_UNKNOWN);
+}
+
+static void test_receiver_zone(void)
+{
+    // Half a meter, immediate once the dwell time passed
+    for (int i = 0; i < 20; i++) {
+        send_ping(2, -46);
+        drain_ui(NULL);
+        FAKE_clock_advance(100 * 1000);
+    }
+
+    CHECK_INT(PROXIMITY_get_zone(2), ZONE_IMMEDIATE);
+}
+
+static void test_receiver_calibration(void)
+{
+    send_ping(3, -60);
+    RECEIVER_setRssiAt1Meter();
+    CHECK_NEAR(RECEIVER_getRssiAt1Meter(), -60.0, 0.0);
+
+    send_ping(3, -60);
+    CHECK_NEAR(RECEIVER_getDistance(), 1.0, 1e-4);
+
+    // Back to the default for the other tests
+    send_ping(3, -51);
+    RECEIVER_setRssiAt1Meter();
+}
+
+static void test_receiver_deinit(void)
+{
+    RECEIVER_deinit();
+    CHECK(!FAKE_esp_now_is_init());
+
+    drain_ui(NULL);
+    send_ping(0, -51);
+    CHECK_INT(drain_ui(NULL), 0);
+}
+
+static void test_sender_slots(void)
+{
+    ui_update_msg_t msg;
+    uint8_t dst[ESP_NOW_ETH_ALEN];
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+    const uint8_t broadcast[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    const uint32_t tasks = FAKE_get_task_count();
+    const uint32_t sent = FAKE_esp_now_get_sent();
+    const uint32_t heartbeats = LINKMON_get_heartbeats();
+
+    drain_ui(NULL);
+    SENDER_init();
+    FAKE_settle();
+
+    // The first frame goes out at once
+    CHECK(FAKE_esp_now_is_init());
+    CHECK_INT(FAKE_esp_now_get_sent(), sent + 1);
+    const int len = FAKE_esp_now_get_last(dst, data, sizeof(data));
+    CHECK_INT(len, 6);
+    CHECK(memcmp(data, "Ping 0", 6) == 0);
+    CHECK(memcmp(dst, broadcast, sizeof(dst)) == 0);
+
+    // The acknowledgement reaches the link monitor and the UI
+    CHECK_INT(LINKMON_get_heartbeats(), heartbeats + 1);
+    CHECK_INT(drain_ui(&msg), 1);
+    CHECK_INT(msg.type, UI_UPDATE_ESPNOW_TX_ACK);
+
+    // One frame per period on a fixed grid
+    FAKE_clock_advance(CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000 - 1);
+    CHECK_INT(FAKE_esp_now_get_sent(), sent + 1);
+    FAKE_clock_advance(1);
+    CHECK_INT(FAKE_esp_now_get_sent(), sent + 2);
+    FAKE_clock_advance(10 * CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000);
+    CHECK_INT(FAKE_esp_now_get_sent(), sent + 12);
+    FAKE_esp_now_get_last(NULL, data, sizeof(data));
+    CHECK(memcmp(data, "Ping 11", 7) == 0);
+
+    SENDER_deinit();
+    CHECK(!FAKE_esp_now_is_init());
+    CHECK_INT(FAKE_get_task_count(), tasks);
+
+    FAKE_clock_advance(5 * CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000);
+    CHECK_INT(FAKE_esp_now_get_sent(), sent + 12);
+}
+
+// The sender only listens for the time exchange, its frames carry the shared time afterwards
+static void test_sender_timesync(void)
+{
+    const report_header_t beacon = {
+        .magic = REPORT_MAGIC,
+        .version = REPORT_VERSION,
+        .type = REPORT_FRAME_BEACON,
+    };
+    const int64_t offset_us = 250000;
+
+    s_frame_count = 0;
+    FAKE_esp_now_set_air(capture, NULL);
+    TIMESYNC_start(false);
+    SENDER_init();
+    FAKE_settle();
+
+    // Not synchronized yet, plain text
+    const frame_t *ping = find_frame(0, 0);
+    CHECK(ping != NULL && ping->len == 6);
+
+    FAKE_esp_now_deliver(s_collector_mac, -40, &beacon, sizeof(beacon));
+    FAKE_clock_advance(CONFIG_CUBE_TIMESYNC_PERIOD_MS * 1000);
+
+    const frame_t *req_frame = find_frame(0, REPORT_FRAME_SYNC_REQ);
+    CHECK(req_frame != NULL);
+    if (req_frame == NULL) {
+        return;
+    }
+
+    // Answer as the collector, 400 us each way
+    report_sync_req_t req;
+    memcpy(&req, req_frame->data, sizeof(req));
+    CHECK(memcmp(req.master, s_collector_mac, sizeof(req.master)) == 0);
+
+    report_sync_resp_t resp = {
+        .header = beacon,
+        .t1 = req.t1,
+        .t2 = req.t1 + 400 + offset_us,
+        .t3 = req.t1 + 450 + offset_us,
+    };
+    resp.header.type = REPORT_FRAME_SYNC_RESP;
+    memcpy(resp.node, s_own_mac, sizeof(resp.node));
+
+    FAKE_clock_advance(req.t1 + 850 - esp_timer_get_time());
+    FAKE_esp_now_deliver(s_collector_mac, -40, &resp, sizeof(resp));
+
+    int64_t shared_us;
+    uint32_t error_us;
+    CHECK(TIMESYNC_to_shared(esp_timer_get_time(), &shared_us, &error_us));
+    CHECK_NEAR(shared_us - esp_timer_get_time(), offset_us, 1);
+
+    // The next ping is NUL terminated and stamped
+    const uint32_t from = s_frame_count;
+    FAKE_clock_advance(CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000);
+    ping = find_frame(from, 0);
+    CHECK(ping != NULL);
+    if (ping != NULL) {
+        report_stamp_t stamp;
+        const size_t text = strlen((const char *)ping->data) + 1;
+        CHECK_INT(ping->len, text + sizeof(stamp));
+        memcpy(&stamp, &ping->data[text], sizeof(stamp));
+        CHECK_NEAR(stamp.time_us, ping->time_us + offset_us, stamp.error_us);
+    }
+
+    SENDER_deinit();
+    TIMESYNC_stop();
+    FAKE_esp_now_set_air(NULL, NULL);
+}
+
+// Without peers nothing wakes the CPU periodically, the trace and zone tasks wait for work
+static void test_idle_no_wakeup(void)
+{
+    TRACE_init();
+    FAKE_clock_advance(10 * 1000 * 1000);
+
+    const uint32_t wakeups = FAKE_clock_get_wakeups();
+    FAKE_clock_advance(10 * 1000 * 1000);
+    CHECK_INT(FAKE_clock_get_wakeups() - wakeups, 0);
+}
+
+int main(void)
+{
+    FAKE_wifi_set_mac(s_own_mac);
+
+    UIUPDATE_init();
+    LINKMON_init(NULL);
+    PROXIMITY_init();
+    ESP_ERROR_CHECK(esp_now_wifi_init());
+
+    LINKMON_start();
+    PROXIMITY_start();
+    RECEIVER_init();
+
+    RUN_TEST(test_receiver_frame);
+    RUN_TEST(test_receiver_peer_slots);
+    RUN_TEST(test_receiver_skips_reports);
+    RUN_TEST(test_receiver_approach);
+    RUN_TEST(test_receiver_zone);
+    RUN_TEST(test_receiver_calibration);
+    RUN_TEST(test_receiver_deinit);
+
+    RUN_TEST(test_sender_slots);
+    RUN_TEST(test_sender_timesync);
+    RUN_TEST(test_idle_no_wakeup);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_wifi.h"
+
+#include "check.h"
+#include "fake.h"
+
+#include "FtmClient.h"
+#include "FtmCommon.h"
+#include "UiUpdate.h"
+#include "linkmon.h"
+
+extern wifi_ftm_initiator_cfg_t ftmi_cfg;
+
+static void test_init_registers_handler(void)
+{
+    CHECK_INT(ftm_wifi_init(), ESP_OK);
+    CHECK_INT(FAKE_event_get_handlers(), 1);
+    CHECK(FAKE_wifi_is_started());
+    CHECK_INT(FAKE_wifi_get_mode(), WIFI_MODE_AP);
+
+    CHECK_INT(ftm_wifi_deinit(), ESP_OK);
+    CHECK_INT(FAKE_event_get_handlers(), 0);
+    CHECK(!FAKE_wifi_is_started());
+}
+
+static void test_init_failure_unregisters(void)
+{
+    FAKE_wifi_set_start_error(ESP_ERR_NO_MEM);
+    CHECK_INT(ftm_wifi_init(), ESP_ERR_NO_MEM);
+    CHECK_INT(FAKE_event_get_handlers(), 0);
+    FAKE_wifi_set_start_error(ESP_OK);
+
+    // The next start works and the deinit finds nothing left over
+    CHECK_INT(ftm_wifi_init(), ESP_OK);
+    CHECK_INT(FAKE_event_get_handlers(), 1);
+    CHECK_INT(ftm_wifi_deinit(), ESP_OK);
+    CHECK_INT(FAKE_event_get_handlers(), 0);
+}
+
+static void test_report(void)
+{
+    wifi_event_ftm_report_t report = {
+        .dist_est = 250,
+        .rtt_est = 16,
+        .status = FTM_STATUS_SUCCESS,
+    };
+    ui_update_msg_t msg;
+    const uint32_t heartbeats = LINKMON_get_heartbeats();
+
+    CHECK_INT(ftm_wifi_init(), ESP_OK);
+    FAKE_event_post(WIFI_EVENT, WIFI_EVENT_FTM_REPORT, &report);
+
+    CHECK(UIUPDATE_receive(&msg, 0));
+    CHECK_INT(msg.type, UI_UPDATE_FTM_REPORT);
+    CHECK_INT(msg.peer, 0);
+    CHECK_INT(msg.distance_cm, 250);
+    CHECK_INT(LINKMON_get_heartbeats(), heartbeats + 1);
+
+    // Whole meters, the centimeters are cut off
+    CHECK_NEAR(FTMCOMMON_getDistance(), 2.0, 0.0);
+
+    CHECK_INT(ftm_wifi_deinit(), ESP_OK);
+}
+
+static void test_client_finds_responder(void)
+{
+    const wifi_ap_record_t aps[] = {
+        { .bssid = {0x02, 0x00, 0x00, 0x00, 0x02, 0x01}, .ssid = "Other", .primary = 1 },
+        { .bssid = {0x02, 0x00, 0x00, 0x00, 0x02, 0x02}, .ssid = "FTM", .primary = 6, .ftm_responder = true },
+    };
+    const uint8_t expected[6] = {0x02, 0x00, 0x00, 0x00, 0x02, 0x02};
+
+    FAKE_wifi_set_scan(aps, 2);
+    CHECK_INT(ftm_wifi_init(), ESP_OK);
+
+    FTMCLIENT_init();
+    CHECK(memcmp(ftmi_cfg.resp_mac, expected, sizeof(expected)) == 0);
+    CHECK_INT(ftmi_cfg.channel, 6);
+    CHECK_INT(FAKE_wifi_get_mode(), WIFI_MODE_APSTA);
+
+    const uint32_t sessions = FAKE_wifi_get_ftm_sessions();
+    FTMCLIENT_measure();
+    CHECK_INT(FAKE_wifi_get_ftm_sessions(), sessions + 1);
+
+    FTMCLIENT_deinit();
+    CHECK_INT(ftm_wifi_deinit(), ESP_OK);
+}
+
+static void test_client_without_responder(void)
+{
+    const wifi_ap_record_t aps[] = {
+        { .bssid = {0x02, 0x00, 0x00, 0x00, 0x02, 0x01}, .ssid = "Other", .primary = 1 },
+    };
+
+    memset(ftmi_cfg.resp_mac, 0, sizeof(ftmi_cfg.resp_mac));
+    FAKE_wifi_set_scan(aps, 1);
+    CHECK_INT(ftm_wifi_init(), ESP_OK);
+
+    FTMCLIENT_init();
+    const uint8_t zero[6] = {0};
+    CHECK(memcmp(ftmi_cfg.resp_mac, zero, sizeof(zero)) == 0);
+
+    FTMCLIENT_deinit();
+    CHECK_INT(ftm_wifi_deinit(), ESP_OK);
+    FAKE_wifi_set_scan(NULL, 0);
+}
+
+int main(void)
+{
+    UIUPDATE_init();
+    LINKMON_init(NULL);
+    LINKMON_start();
+
+    RUN_TEST(test_init_registers_handler);
+    RUN_TEST(test_init_failure_unregisters);
+    RUN_TEST(test_report);
+    RUN_TEST(test_client_finds_responder);
+    RUN_TEST(test_client_without_responder);
+
+    return CHECK_RESULT();
+}
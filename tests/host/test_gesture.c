@@ -0,0 +1,274 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "check.h"
+#include "gesture.h"
+
+#define MAX_EVENTS  (32)
+
+typedef struct {
+    uint8_t button;
+    gesture_type_t type;
+    uint32_t time_ms;
+} event_t;
+
+static event_t s_events[MAX_EVENTS];
+static uint8_t s_count;
+static uint32_t s_now_ms;
+
+static void record(uint8_t button, gesture_type_t type, void *ctx)
+{
+    (void)ctx;
+    if (s_count < MAX_EVENTS) {
+        s_events[s_count++] = (event_t){ .button = button, .type = type, .time_ms = s_now_ms };
+    }
+}
+
+static void start(gesture_engine_t *engine, const gesture_config_t *configs, uint8_t count, uint32_t now_ms)
+{
+    s_count = 0;
+    s_now_ms = now_ms;
+    GESTURE_init(engine, configs, count, record, NULL);
+}
+
+static void input(gesture_engine_t *engine, uint8_t button, bool pressed, uint32_t now_ms)
+{
+    s_now_ms = now_ms;
+    GESTURE_input(engine, button, pressed, now_ms);
+}
+
+static void tick(gesture_engine_t *engine, uint32_t now_ms)
+{
+    s_now_ms = now_ms;
+    GESTURE_tick(engine, now_ms);
+}
+
+static void test_click(void)
+{
+    const gesture_config_t config = { 0 };
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, 0);
+    input(&engine, 0, true, 100);
+    input(&engine, 0, false, 180);
+
+    CHECK_INT(s_count, 3);
+    CHECK_INT(s_events[0].type, GESTURE_PRESS);
+    CHECK_INT(s_events[1].type, GESTURE_RELEASE);
+    CHECK_INT(s_events[2].type, GESTURE_CLICK);
+    CHECK_INT(s_events[2].time_ms, 180);
+    CHECK_INT(GESTURE_get_timeout(&engine, 200), GESTURE_NO_TIMEOUT);
+}
+
+static void test_long_press_suppresses_click(void)
+{
+    const gesture_config_t config = { .long_press_ms = 1000 };
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, 0);
+    input(&engine, 0, true, 100);
+    CHECK_INT(GESTURE_get_timeout(&engine, 100), 1000);
+
+    tick(&engine, 1099);
+    CHECK_INT(s_count, 1);
+
+    tick(&engine, 1100);
+    CHECK_INT(s_count, 2);
+    CHECK_INT(s_events[1].type, GESTURE_LONG_PRESS);
+
+    input(&engine, 0, false, 1500);
+    CHECK_INT(s_count, 3);
+    CHECK_INT(s_events[2].type, GESTURE_RELEASE);
+}
+
+static void test_buttons_independent(void)
+{
+    const gesture_config_t configs[2] = { { 0 }, { .long_press_ms = 500 } };
+    gesture_engine_t engine;
+
+    start(&engine, configs, 2, 0);
+    input(&engine, 1, true, 0);
+    input(&engine, 0, true, 100);
+    input(&engine, 0, false, 150);
+    tick(&engine, 500);
+
+    CHECK_INT(s_count, 5);
+    CHECK_INT(s_events[3].button, 0);
+    CHECK_INT(s_events[3].type, GESTURE_CLICK);
+    CHECK_INT(s_events[4].button, 1);
+    CHECK_INT(s_events[4].type, GESTURE_LONG_PRESS);
+
+    // Out of range buttons are ignored
+    input(&engine, 2, true, 600);
+    CHECK_INT(s_count, 5);
+}
+
+static void test_double_click(void)
+{
+    const gesture_config_t config = { .double_click_ms = 300 };
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, 0);
+    input(&engine, 0, true, 0);
+    input(&engine, 0, false, 50);
+    CHECK_INT(s_count, 2);
+    CHECK_INT(GESTURE_get_timeout(&engine, 100), 250);
+
+    input(&engine, 0, true, 200);
+    input(&engine, 0, false, 260);
+    CHECK_INT(s_count, 5);
+    CHECK_INT(s_events[4].type, GESTURE_DOUBLE_CLICK);
+    CHECK_INT(s_events[4].time_ms, 260);
+    CHECK_INT(GESTURE_get_timeout(&engine, 260), GESTURE_NO_TIMEOUT);
+
+    // No click follows the double click
+    tick(&engine, 1000);
+    CHECK_INT(s_count, 5);
+}
+
+static void test_click_after_window(void)
+{
+    const gesture_config_t config = { .double_click_ms = 300 };
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, 0);
+    input(&engine, 0, true, 0);
+    input(&engine, 0, false, 50);
+
+    tick(&engine, 349);
+    CHECK_INT(s_count, 2);
+    tick(&engine, 350);
+    CHECK_INT(s_count, 3);
+    CHECK_INT(s_events[2].type, GESTURE_CLICK);
+    CHECK_INT(s_events[2].time_ms, 350);
+
+    // A late second press without a tick in between still gives the click first
+    input(&engine, 0, true, 400);
+    input(&engine, 0, false, 450);
+    input(&engine, 0, true, 900);
+    CHECK_INT(s_count, 7);
+    CHECK_INT(s_events[5].type, GESTURE_CLICK);
+    CHECK_INT(s_events[6].type, GESTURE_PRESS);
+
+    input(&engine, 0, false, 950);
+    tick(&engine, 1250);
+    CHECK_INT(s_count, 9);
+    CHECK_INT(s_events[8].type, GESTURE_CLICK);
+}
+
+static void test_repeat(void)
+{
+    const gesture_config_t config = { .repeat_delay_ms = 600, .repeat_period_ms = 250 };
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, 0);
+    input(&engine, 0, true, 0);
+    CHECK_INT(GESTURE_get_timeout(&engine, 0), 600);
+
+    tick(&engine, 599);
+    CHECK_INT(s_count, 1);
+    tick(&engine, 600);
+    CHECK_INT(s_count, 2);
+    CHECK_INT(s_events[1].type, GESTURE_REPEAT);
+    CHECK_INT(GESTURE_get_timeout(&engine, 600), 250);
+
+    // A slightly late tick keeps the grid
+    tick(&engine, 900);
+    CHECK_INT(s_count, 3);
+    CHECK_INT(GESTURE_get_timeout(&engine, 900), 200);
+
+    // No click after a repeat
+    input(&engine, 0, false, 1000);
+    CHECK_INT(s_count, 4);
+    CHECK_INT(s_events[3].type, GESTURE_RELEASE);
+}
+
+// A tick several periods late gives one repeat, not the missed ones in a burst
+static void test_repeat_catch_up(void)
+{
+    const gesture_config_t config = { .repeat_delay_ms = 600, .repeat_period_ms = 250 };
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, 0);
+    input(&engine, 0, true, 0);
+    tick(&engine, 600);
+    CHECK_INT(s_count, 2);
+
+    tick(&engine, 2000);
+    CHECK_INT(s_count, 3);
+    CHECK_INT(s_events[2].type, GESTURE_REPEAT);
+
+    // The next one is a full period after the late tick
+    CHECK_INT(GESTURE_get_timeout(&engine, 2000), 250);
+    tick(&engine, 2249);
+    CHECK_INT(s_count, 3);
+    tick(&engine, 2250);
+    CHECK_INT(s_count, 4);
+
+    // Without a repeat period the delay repeats
+    const gesture_config_t delay_only = { .repeat_delay_ms = 400 };
+    start(&engine, &delay_only, 1, 0);
+    input(&engine, 0, true, 0);
+    tick(&engine, 400);
+    CHECK_INT(GESTURE_get_timeout(&engine, 400), 400);
+}
+
+// Deadlines across the 32 bit millisecond wrap, after about 49 days
+static void test_wrap(void)
+{
+    const gesture_config_t config = { .long_press_ms = 1000 };
+    const uint32_t pressed_at = UINT32_MAX - 299;
+    gesture_engine_t engine;
+
+    start(&engine, &config, 1, pressed_at);
+    input(&engine, 0, true, pressed_at);
+    CHECK_INT(GESTURE_get_timeout(&engine, pressed_at), 1000);
+    CHECK_INT(GESTURE_get_timeout(&engine, UINT32_MAX), 701);
+    CHECK_INT(GESTURE_get_timeout(&engine, 100), 600);
+
+    tick(&engine, UINT32_MAX);
+    tick(&engine, 699);
+    CHECK_INT(s_count, 1);
+    tick(&engine, 700);
+    CHECK_INT(s_count, 2);
+    CHECK_INT(s_events[1].type, GESTURE_LONG_PRESS);
+}
+
+static void test_timeout(void)
+{
+    const gesture_config_t configs[2] = { { .long_press_ms = 1000 }, { .double_click_ms = 300 } };
+    gesture_engine_t engine;
+
+    start(&engine, configs, 2, 0);
+    CHECK_INT(GESTURE_get_timeout(&engine, 0), GESTURE_NO_TIMEOUT);
+
+    // The nearest deadline of all buttons
+    input(&engine, 0, true, 0);
+    input(&engine, 1, true, 50);
+    input(&engine, 1, false, 100);
+    CHECK_INT(GESTURE_get_timeout(&engine, 200), 200);
+
+    // An overdue deadline asks for a tick at once
+    CHECK_INT(GESTURE_get_timeout(&engine, 450), 0);
+    tick(&engine, 450);
+    CHECK_INT(GESTURE_get_timeout(&engine, 450), 550);
+
+    // The long press does not repeat, nothing is left while held
+    tick(&engine, 1000);
+    CHECK_INT(GESTURE_get_timeout(&engine, 1000), GESTURE_NO_TIMEOUT);
+}
+
+int main(void)
+{
+    RUN_TEST(test_click);
+    RUN_TEST(test_long_press_suppresses_click);
+    RUN_TEST(test_buttons_independent);
+    RUN_TEST(test_double_click);
+    RUN_TEST(test_click_after_window);
+    RUN_TEST(test_repeat);
+    RUN_TEST(test_repeat_catch_up);
+    RUN_TEST(test_wrap);
+    RUN_TEST(test_timeout);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,209 @@
+#include <stdint.h>
+
+#include "check.h"
+#include "fake.h"
+
+#include "gpio.h"
+
+#define GPIO_ENTER      (8)
+#define GPIO_SET        (10)
+
+static uint32_t drain(gpio_button_event_t *events, uint32_t size)
+{
+    gpio_button_event_t event;
+    uint32_t count = 0;
+
+    while (GPIO_receive_event(&event, 0)) {
+        if (count < size) {
+            events[count] = event;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+#if !CONFIG_CUBE_POWER_SAVE
+// Contact bounce within the debounce time gives a single press
+static void test_bounce(void)
+{
+    gpio_button_event_t events[8];
+
+    FAKE_gpio_input(GPIO_ENTER, 0);
+    FAKE_clock_advance(5 * 1000);
+    FAKE_gpio_input(GPIO_ENTER, 1);
+    FAKE_clock_advance(5 * 1000);
+    FAKE_gpio_input(GPIO_ENTER, 0);
+
+    FAKE_clock_advance(29 * 1000);
+    CHECK(!GPIO_get_button_enter());
+    CHECK_INT(drain(events, 8), 0);
+
+    FAKE_clock_advance(1 * 1000);
+    CHECK(GPIO_get_button_enter());
+    CHECK_INT(drain(events, 8), 1);
+    CHECK_INT(events[0].button, GPIO_BUTTON_ENTER);
+    CHECK_INT(events[0].gesture, GESTURE_PRESS);
+
+    FAKE_gpio_input(GPIO_ENTER, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK(!GPIO_get_button_enter());
+    CHECK_INT(drain(events, 8), 2);
+    CHECK_INT(events[0].gesture, GESTURE_RELEASE);
+    CHECK_INT(events[1].gesture, GESTURE_CLICK);
+}
+
+#else
+// Level triggered: sampled once, the debounce time after the first edge
+static void test_bounce(void)
+{
+    gpio_button_event_t events[8];
+
+    FAKE_gpio_input(GPIO_ENTER, 0);
+    FAKE_clock_advance(5 * 1000);
+    FAKE_gpio_input(GPIO_ENTER, 1);
+    FAKE_clock_advance(5 * 1000);
+    FAKE_gpio_input(GPIO_ENTER, 0);
+
+    FAKE_clock_advance(19 * 1000);
+    CHECK(!GPIO_get_button_enter());
+    CHECK_INT(drain(events, 8), 0);
+
+    FAKE_clock_advance(1 * 1000);
+    CHECK(GPIO_get_button_enter());
+    CHECK_INT(drain(events, 8), 1);
+    CHECK_INT(events[0].gesture, GESTURE_PRESS);
+
+    FAKE_gpio_input(GPIO_ENTER, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK(!GPIO_get_button_enter());
+    CHECK_INT(drain(events, 8), 2);
+    CHECK_INT(events[0].gesture, GESTURE_RELEASE);
+    CHECK_INT(events[1].gesture, GESTURE_CLICK);
+}
+
+// Released buttons wake the chip on the low level, pressed ones on the high level
+static void test_wakeup_level(void)
+{
+    gpio_button_event_t events[8];
+
+    CHECK_INT(FAKE_gpio_get_wakeup(GPIO_ENTER), GPIO_INTR_LOW_LEVEL);
+    CHECK_INT(FAKE_gpio_get_wakeup(GPIO_SET), GPIO_INTR_LOW_LEVEL);
+
+    FAKE_gpio_input(GPIO_SET, 0);
+    FAKE_clock_advance(30 * 1000);
+    CHECK_INT(FAKE_gpio_get_wakeup(GPIO_SET), GPIO_INTR_HIGH_LEVEL);
+
+    FAKE_gpio_input(GPIO_SET, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK_INT(FAKE_gpio_get_wakeup(GPIO_SET), GPIO_INTR_LOW_LEVEL);
+    drain(events, 8);
+}
+
+// Edges are lost in light sleep, the levels still wake the chip and arrive
+static void test_sleep_press(void)
+{
+    gpio_button_event_t events[8];
+
+    FAKE_gpio_set_sleep(true);
+    FAKE_gpio_input(GPIO_SET, 0);
+    FAKE_clock_advance(100 * 1000);
+    CHECK(GPIO_get_button_set());
+    CHECK_INT(drain(events, 8), 1);
+    CHECK_INT(events[0].gesture, GESTURE_PRESS);
+
+    FAKE_gpio_set_sleep(true);
+    FAKE_gpio_input(GPIO_SET, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK(!GPIO_get_button_set());
+    CHECK_INT(drain(events, 8), 2);
+    CHECK_INT(events[0].gesture, GESTURE_RELEASE);
+    CHECK_INT(events[1].gesture, GESTURE_CLICK);
+
+    // A short tap while asleep, the level is gone before the debounce sample
+    FAKE_gpio_set_sleep(true);
+    FAKE_gpio_input(GPIO_ENTER, 0);
+    FAKE_clock_advance(100 * 1000);
+    CHECK_INT(drain(events, 8), 1);
+    FAKE_gpio_input(GPIO_ENTER, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK_INT(drain(events, 8), 2);
+}
+#endif
+
+// A bounce back to the old level within the debounce time is no edge
+static void test_glitch(void)
+{
+    gpio_button_event_t events[8];
+
+    FAKE_gpio_input(GPIO_SET, 0);
+    FAKE_clock_advance(2 * 1000);
+    FAKE_gpio_input(GPIO_SET, 1);
+    FAKE_clock_advance(100 * 1000);
+
+    CHECK(!GPIO_get_button_set());
+    CHECK_INT(drain(events, 8), 0);
+}
+
+static void test_long_press(void)
+{
+    gpio_button_event_t events[8];
+
+    FAKE_gpio_input(GPIO_ENTER, 0);
+    FAKE_clock_advance(1000 * 1000);
+    CHECK_INT(drain(events, 8), 1);
+
+    // The task sleeps until the deadline, 30 ms debounce plus the long press time
+    FAKE_clock_advance(50 * 1000);
+    CHECK_INT(drain(events, 8), 1);
+    CHECK_INT(events[0].gesture, GESTURE_LONG_PRESS);
+
+    FAKE_gpio_input(GPIO_ENTER, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK_INT(drain(events, 8), 1);
+    CHECK_INT(events[0].gesture, GESTURE_RELEASE);
+}
+
+static void test_repeat(void)
+{
+    gpio_button_event_t events[16];
+
+    FAKE_gpio_input(GPIO_SET, 0);
+    FAKE_clock_advance(30 * 1000);
+    CHECK_INT(drain(events, 16), 1);
+
+    // Repeats after 600 ms, then every 250 ms
+    FAKE_clock_advance(620 * 1000);
+    CHECK_INT(drain(events, 16), 1);
+    CHECK_INT(events[0].button, GPIO_BUTTON_SET);
+    CHECK_INT(events[0].gesture, GESTURE_REPEAT);
+
+    FAKE_clock_advance(500 * 1000);
+    CHECK_INT(drain(events, 16), 2);
+
+    FAKE_gpio_input(GPIO_SET, 1);
+    FAKE_clock_advance(100 * 1000);
+    CHECK_INT(drain(events, 16), 1);
+    CHECK_INT(events[0].gesture, GESTURE_RELEASE);
+
+    // Nothing pending, the task sleeps without a timeout
+    FAKE_clock_advance(2000 * 1000);
+    CHECK_INT(drain(events, 16), 0);
+}
+
+int main(void)
+{
+    GPIO_button_init();
+    FAKE_settle();
+
+    RUN_TEST(test_bounce);
+    RUN_TEST(test_glitch);
+    RUN_TEST(test_long_press);
+    RUN_TEST(test_repeat);
+#if CONFIG_CUBE_POWER_SAVE
+    RUN_TEST(test_wakeup_level);
+    RUN_TEST(test_sleep_press);
+#endif
+
+    return CHECK_RESULT();
+}
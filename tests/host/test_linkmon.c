@@ -0,0 +1,210 @@
+#include <stdint.h>
+
+#include "esp_timer.h"
+
+#include "check.h"
+#include "fake.h"
+#include "linkmon.h"
+
+#define MAX_EVENTS      (64)
+#define CHECK_MS        (250)
+
+static linkmon_event_t s_events[MAX_EVENTS];
+static uint32_t s_count;
+
+// esp_timer task
+static void record(const linkmon_event_t *event)
+{
+    if (s_count < MAX_EVENTS) {
+        s_events[s_count] = *event;
+    }
+    s_count++;
+}
+
+static void advance_ms(uint32_t ms)
+{
+    FAKE_clock_advance((int64_t)ms * 1000);
+}
+
+// Restart with the monitor timer stopped, the first heartbeat arms it
+static void restart(void)
+{
+    LINKMON_stop();
+    LINKMON_start();
+    s_count = 0;
+}
+
+static void test_none_until_heard(void)
+{
+    restart();
+    advance_ms(5 * CHECK_MS);
+
+    CHECK_INT(s_count, 0);
+    CHECK_INT(LINKMON_get_summary(), LINKMON_STATE_NONE);
+    CHECK_INT(LINKMON_get_heartbeats(), 0);
+}
+
+static void test_alive_degraded_lost(void)
+{
+    restart();
+    LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, 1);
+    CHECK_INT(LINKMON_get_heartbeats(), 1);
+
+    // States only change in the monitor timer
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 1), LINKMON_STATE_NONE);
+    advance_ms(CHECK_MS);
+    CHECK_INT(s_count, 1);
+    CHECK_INT(s_events[0].source, LINKMON_SOURCE_ESPNOW_RX);
+    CHECK_INT(s_events[0].peer, 1);
+    CHECK_INT(s_events[0].state, LINKMON_STATE_ALIVE);
+    CHECK_INT(LINKMON_get_summary(), LINKMON_STATE_ALIVE);
+
+    // Degraded after 2.5 nominal intervals of CONFIG_CUBE_ESPNOW_PERIOD_MS
+    advance_ms(2500 - 2 * CHECK_MS);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 1), LINKMON_STATE_ALIVE);
+    advance_ms(CHECK_MS);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 1), LINKMON_STATE_DEGRADED);
+
+    // Lost after 8
+    advance_ms(8000 - 2500 - CHECK_MS);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 1), LINKMON_STATE_DEGRADED);
+    advance_ms(CHECK_MS);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 1), LINKMON_STATE_LOST);
+    CHECK_INT(LINKMON_get_summary(), LINKMON_STATE_LOST);
+
+    // Every transition is reported exactly once
+    advance_ms(10 * CHECK_MS);
+    CHECK_INT(s_count, 3);
+    CHECK_INT(s_events[1].state, LINKMON_STATE_DEGRADED);
+    CHECK_INT(s_events[2].state, LINKMON_STATE_LOST);
+
+    // A heartbeat after the loss revives the link
+    LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, 1);
+    advance_ms(CHECK_MS);
+    CHECK_INT(s_count, 4);
+    CHECK_INT(s_events[3].state, LINKMON_STATE_ALIVE);
+}
+
+static void test_interval_follows_heartbeats(void)
+{
+    restart();
+
+    // Faster than the nominal period, the filter converges to 200 ms
+    for (int i = 0; i < 50; i++) {
+        LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_TX_ACK, 0);
+        advance_ms(200);
+    }
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_TX_ACK, 0), LINKMON_STATE_ALIVE);
+
+    // Quiet for about 2.5 and 8 intervals of 200 ms instead of the nominal second
+    advance_ms(600);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_TX_ACK, 0), LINKMON_STATE_DEGRADED);
+    advance_ms(1200);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_TX_ACK, 0), LINKMON_STATE_LOST);
+    CHECK(s_events[s_count - 1].interval_ms < 220);
+}
+
+static void test_interval_lower_bound(void)
+{
+    restart();
+
+    // Bursts faster than 100 ms do not make the link look lost after a short pause
+    for (int i = 0; i < 100; i++) {
+        LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, 2);
+        advance_ms(10);
+    }
+    advance_ms(200);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 2), LINKMON_STATE_ALIVE);
+}
+
+static void test_untracked_ignored(void)
+{
+    restart();
+
+    LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, LINKMON_PEERS);
+    LINKMON_heartbeat(LINKMON_SOURCE_COUNT, 0);
+    advance_ms(CHECK_MS);
+
+    CHECK_INT(LINKMON_get_heartbeats(), 0);
+    CHECK_INT(s_count, 0);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, LINKMON_PEERS), LINKMON_STATE_NONE);
+}
+
+static void test_summary_is_best(void)
+{
+    restart();
+
+    LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, 0);
+    advance_ms(2000);
+    LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, 3);
+    advance_ms(1000);
+
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 0), LINKMON_STATE_DEGRADED);
+    CHECK_INT(LINKMON_get_summary(), LINKMON_STATE_ALIVE);
+}
+
+static void test_stop_resets(void)
+{
+    restart();
+
+    LINKMON_heartbeat(LINKMON_SOURCE_FTM_REPORT, 0);
+    advance_ms(CHECK_MS);
+    CHECK_INT(LINKMON_get_summary(), LINKMON_STATE_ALIVE);
+
+    LINKMON_stop();
+    s_count = 0;
+    CHECK_INT(LINKMON_get_summary(), LINKMON_STATE_NONE);
+    CHECK_INT(LINKMON_get_heartbeats(), 0);
+
+    // The timer is stopped, nothing is reported for the old role
+    advance_ms(20 * CHECK_MS);
+    CHECK_INT(s_count, 0);
+}
+
+// The monitor timer only runs for due state changes, a quiet or steady link lets the CPU sleep
+static void test_no_periodic_wakeup(void)
+{
+    restart();
+
+    uint32_t wakeups = FAKE_clock_get_wakeups();
+    advance_ms(10 * 1000);
+    CHECK_INT(FAKE_clock_get_wakeups() - wakeups, 0);
+
+    // One heartbeat per nominal interval, checked every 2.5 s instead of every 250 ms
+    for (int i = 0; i < 10; i++) {
+        LINKMON_heartbeat(LINKMON_SOURCE_ESPNOW_RX, 0);
+        advance_ms(1000);
+    }
+    wakeups = FAKE_clock_get_wakeups() - wakeups;
+    CHECK(wakeups >= 1);
+    CHECK(wakeups <= 5);
+    CHECK_INT(s_count, 1);
+
+    // Degraded and lost exactly on time, then nothing until the next heartbeat
+    advance_ms(1500 - 1);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 0), LINKMON_STATE_ALIVE);
+    advance_ms(1);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 0), LINKMON_STATE_DEGRADED);
+    advance_ms(8000 - 2500);
+    CHECK_INT(LINKMON_get_state(LINKMON_SOURCE_ESPNOW_RX, 0), LINKMON_STATE_LOST);
+    wakeups = FAKE_clock_get_wakeups();
+    advance_ms(10 * 1000);
+    CHECK_INT(FAKE_clock_get_wakeups() - wakeups, 0);
+    CHECK_INT(s_count, 3);
+}
+
+int main(void)
+{
+    LINKMON_init(record);
+
+    RUN_TEST(test_none_until_heard);
+    RUN_TEST(test_alive_degraded_lost);
+    RUN_TEST(test_interval_follows_heartbeats);
+    RUN_TEST(test_interval_lower_bound);
+    RUN_TEST(test_untracked_ignored);
+    RUN_TEST(test_summary_is_best);
+    RUN_TEST(test_stop_resets);
+    RUN_TEST(test_no_periodic_wakeup);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,175 @@
+#include <stdint.h>
+
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "check.h"
+#include "fake.h"
+
+#include "power.h"
+
+// The defaults, 10 ms window and 5 ms guard per side every 1000 ms
+#define PERIOD_US       (CONFIG_CUBE_ESPNOW_PERIOD_MS * 1000)
+#define HALF_US         (CONFIG_CUBE_POWER_SAVE_WINDOW_MS * 1000 / 2 + CONFIG_CUBE_POWER_SAVE_GUARD_MS * 1000)
+
+// Forced wake ups held by the power task, 1 while the radio is on
+static int32_t radio_on(void)
+{
+    FAKE_settle();
+    return FAKE_wifi_get_wakeups();
+}
+
+static void advance_to(int64_t time_us)
+{
+    FAKE_clock_advance(time_us - esp_timer_get_time());
+}
+
+static void frame(uint8_t peer)
+{
+    POWER_frame_received(peer);
+    FAKE_settle();
+}
+
+static void test_init(void)
+{
+    CHECK(FAKE_pm_get_light_sleep());
+    CHECK_INT(FAKE_get_task_count(), 1);
+    CHECK_INT(radio_on(), 0);
+}
+
+static void test_receiver_windows(void)
+{
+    POWER_receiver_start();
+    CHECK_INT(FAKE_wifi_get_ps(), WIFI_PS_MIN_MODEM);
+    CHECK_INT(FAKE_esp_now_get_wake_window(), 0);
+
+    // Listens until the sender is heard
+    CHECK_INT(radio_on(), 1);
+    FAKE_clock_advance(300 * 1000);
+    CHECK_INT(radio_on(), 1);
+
+    // Other senders do not move the schedule
+    frame(1);
+    CHECK_INT(radio_on(), 1);
+
+    frame(0);
+    CHECK_INT(radio_on(), 0);
+
+    // Window around the next expected frame
+    FAKE_clock_advance(PERIOD_US - HALF_US - 1);
+    CHECK_INT(radio_on(), 0);
+    FAKE_clock_advance(1);
+    CHECK_INT(radio_on(), 1);
+
+    // The frame closes the window at once and anchors the next one
+    FAKE_clock_advance(HALF_US);
+    frame(0);
+    CHECK_INT(radio_on(), 0);
+    FAKE_clock_advance(PERIOD_US - HALF_US);
+    CHECK_INT(radio_on(), 1);
+    frame(0);
+    CHECK_INT(radio_on(), 0);
+
+    POWER_stop();
+    CHECK_INT(radio_on(), 0);
+    CHECK_INT(FAKE_wifi_get_ps(), WIFI_PS_NONE);
+}
+
+static void test_receiver_missed_windows(void)
+{
+    POWER_receiver_start();
+    frame(0);
+
+    // Every missed window is one guard time wider on each side
+    int64_t expected_us = esp_timer_get_time() + PERIOD_US;
+    for (uint32_t missed = 0; missed <= CONFIG_CUBE_POWER_SAVE_MAX_MISSED; missed++) {
+        const int64_t half_us = HALF_US + (int64_t)missed * CONFIG_CUBE_POWER_SAVE_GUARD_MS * 1000;
+
+        advance_to(expected_us - half_us - 1);
+        CHECK_INT(radio_on(), 0);
+        advance_to(expected_us - half_us);
+        CHECK_INT(radio_on(), 1);
+        advance_to(expected_us + half_us - 1);
+        CHECK_INT(radio_on(), 1);
+        advance_to(expected_us + half_us);
+        expected_us += PERIOD_US;
+    }
+
+    // Lost, listens continuously until the next frame
+    CHECK_INT(radio_on(), 1);
+    FAKE_clock_advance(5 * PERIOD_US);
+    CHECK_INT(radio_on(), 1);
+
+    frame(0);
+    CHECK_INT(radio_on(), 0);
+
+    POWER_stop();
+}
+
+// A listen request keeps the radio on past the window and in the sender role
+static void test_listen(void)
+{
+    POWER_sender_start();
+    CHECK_INT(FAKE_wifi_get_ps(), WIFI_PS_MIN_MODEM);
+    CHECK_INT(radio_on(), 0);
+
+    POWER_listen(20 * 1000);
+    CHECK_INT(radio_on(), 1);
+    FAKE_clock_advance(19 * 1000);
+    CHECK_INT(radio_on(), 1);
+
+    // Overlapping requests extend each other, a shorter one does not cut it
+    POWER_listen(50 * 1000);
+    POWER_listen(10 * 1000);
+    FAKE_clock_advance(49 * 1000);
+    CHECK_INT(radio_on(), 1);
+    FAKE_clock_advance(1 * 1000);
+    CHECK_INT(radio_on(), 0);
+
+    // Frames of a sender role are not tracked
+    frame(0);
+    CHECK_INT(radio_on(), 0);
+
+    POWER_stop();
+    CHECK_INT(FAKE_wifi_get_ps(), WIFI_PS_NONE);
+}
+
+static void test_listen_in_window(void)
+{
+    POWER_receiver_start();
+    frame(0);
+
+    // The listen ends inside the window, the window still closes on time
+    FAKE_clock_advance(PERIOD_US - HALF_US - 5 * 1000);
+    POWER_listen(10 * 1000);
+    CHECK_INT(radio_on(), 1);
+    FAKE_clock_advance(10 * 1000);
+    CHECK_INT(radio_on(), 1);
+    FAKE_clock_advance(2 * HALF_US - 5 * 1000);
+    CHECK_INT(radio_on(), 0);
+
+    // Stopped in the middle of a listen request, the radio is released
+    POWER_listen(100 * 1000);
+    CHECK_INT(radio_on(), 1);
+    POWER_stop();
+    CHECK_INT(radio_on(), 0);
+    FAKE_clock_advance(200 * 1000);
+    CHECK_INT(radio_on(), 0);
+}
+
+int main(void)
+{
+    const uint8_t own_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x20};
+
+    FAKE_wifi_set_mac(own_mac);
+    ESP_ERROR_CHECK(esp_wifi_start());
+    POWER_init();
+
+    RUN_TEST(test_init);
+    RUN_TEST(test_receiver_windows);
+    RUN_TEST(test_receiver_missed_windows);
+    RUN_TEST(test_listen);
+    RUN_TEST(test_listen_in_window);
+
+    return CHECK_RESULT();
+}
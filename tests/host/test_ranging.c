@@ -0,0 +1,76 @@
+#include <math.h>
+
+#include "check.h"
+#include "ranging.h"
+
+static ranging_model_t s_model;
+
+static void test_reference_distance(void)
+{
+    RANGING_build(&s_model, -51.0f, 1.64f);
+
+    CHECK_NEAR(s_model.rssi_at_1m, -51.0f, 0.0);
+    CHECK_NEAR(RANGING_estimate(&s_model, -51), 1.0, 1e-6);
+}
+
+static void test_decade_per_10n_db(void)
+{
+    RANGING_build(&s_model, -40.0f, 2.0f);
+
+    CHECK_NEAR(RANGING_estimate(&s_model, -60), 10.0, 1e-4);
+    CHECK_NEAR(RANGING_estimate(&s_model, -80), 100.0, 1e-3);
+    CHECK_NEAR(RANGING_estimate(&s_model, -20), 0.1, 1e-6);
+}
+
+static void test_table_matches_formula(void)
+{
+    RANGING_build(&s_model, -51.0f, 1.64f);
+
+    for (int rssi = RANGING_RSSI_MIN; rssi <= RANGING_RSSI_MAX; rssi++) {
+        const double expected = pow(10.0, (-51.0 - rssi) / (10.0 * 1.64));
+        CHECK_NEAR(RANGING_estimate(&s_model, rssi), expected, expected * 1e-5);
+    }
+}
+
+static void test_monotonic(void)
+{
+    RANGING_build(&s_model, -51.0f, 1.64f);
+
+    for (int rssi = RANGING_RSSI_MIN; rssi < RANGING_RSSI_MAX; rssi++) {
+        CHECK(RANGING_estimate(&s_model, rssi) > RANGING_estimate(&s_model, rssi + 1));
+    }
+}
+
+static void test_clamped(void)
+{
+    RANGING_build(&s_model, -51.0f, 1.64f);
+
+    CHECK_NEAR(RANGING_estimate(&s_model, -200), RANGING_estimate(&s_model, RANGING_RSSI_MIN), 0.0);
+    CHECK_NEAR(RANGING_estimate(&s_model, 20), RANGING_estimate(&s_model, RANGING_RSSI_MAX), 0.0);
+}
+
+// A rebuilt model for the calibration does not depend on the previous content
+static void test_rebuild(void)
+{
+    ranging_model_t other;
+
+    RANGING_build(&s_model, -51.0f, 1.64f);
+    RANGING_build(&other, -60.0f, 3.0f);
+    RANGING_build(&other, -51.0f, 1.64f);
+
+    for (int rssi = RANGING_RSSI_MIN; rssi <= RANGING_RSSI_MAX; rssi++) {
+        CHECK_NEAR(RANGING_estimate(&other, rssi), RANGING_estimate(&s_model, rssi), 0.0);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_reference_distance);
+    RUN_TEST(test_decade_per_10n_db);
+    RUN_TEST(test_table_matches_formula);
+    RUN_TEST(test_monotonic);
+    RUN_TEST(test_clamped);
+    RUN_TEST(test_rebuild);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,264 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "check.h"
+#include "fb.h"
+#include "history.h"
+#include "ui.h"
+
+/*
+ * Golden snapshots of the screens in tests/host/ui/golden. A missing or
+ * different golden image fails the test, the rendered image is written to
+ * CUBE_SNAPSHOT_DIR in the build directory. After an intended UI change run
+ * with CUBE_UPDATE_GOLDEN=1, which passes and writes every image there, and
+ * copy the reviewed images to tests/host/ui/golden.
+ */
+
+#define MAC_STRING      "02:00:00:00:00:01"
+
+static ui_model_t s_model;
+static bool s_update_golden = false;
+
+static void snapshot(const char *name)
+{
+    char golden[512];
+    char rendered[512];
+
+    FB_render(NULL);
+
+    snprintf(golden, sizeof(golden), "%s/%s.ppm", CUBE_GOLDEN_DIR, name);
+    snprintf(rendered, sizeof(rendered), "%s/%s.ppm", CUBE_SNAPSHOT_DIR, name);
+
+    if (s_update_golden) {
+        CHECK(FB_save_ppm(rendered));
+        printf("Recorded %s\n", rendered);
+        return;
+    }
+
+    const int diff = FB_compare_ppm(golden);
+    if (diff != 0) {
+        FB_save_ppm(rendered);
+        if (diff < 0) {
+            fprintf(stderr, "%s: no golden image %s, rendered %s\n", name, golden, rendered);
+        } else {
+            fprintf(stderr, "%s: %d pixels differ from %s, rendered %s\n", name, diff, golden, rendered);
+        }
+        s_check_failures++;
+    }
+}
+
+// The distance label, the first child of the main screen
+static bool label_color_is(lv_color_t color)
+{
+    lv_obj_t *label = lv_obj_get_child(lv_screen_active(), 0);
+
+    return lv_color_eq(lv_obj_get_style_text_color(label, LV_PART_MAIN), color);
+}
+
+static void model_reset(DeviceMode_t mode)
+{
+    memset(&s_model, 0, sizeof(s_model));
+    s_model.mode = mode;
+    s_model.link_state = LINKMON_STATE_NONE;
+    s_model.approach_peer = HISTORY_NO_PEER;
+    s_model.zone_peer = HISTORY_NO_PEER;
+    s_model.history_peer = 0;
+}
+
+static void show_main(DeviceMode_t mode)
+{
+    model_reset(mode);
+    UI_show_main(&s_model);
+}
+
+static void test_selection(void)
+{
+    model_reset(EspNowReceiver);
+    UI_show_selection(&s_model);
+    snapshot("selection_receiver");
+
+    s_model.mode = FtmResponder;
+    UI_update(UI_DIRTY_INPUT, &s_model);
+    snapshot("selection_ftm_responder");
+}
+
+static void test_receiver(void)
+{
+    show_main(EspNowReceiver);
+    snapshot("receiver_mac");
+
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.rssi = -63;
+    s_model.distance = 3.4f;
+    s_model.distance_valid = true;
+    UI_update(UI_DIRTY_RADIO | UI_DIRTY_LINK, &s_model);
+    snapshot("receiver_alive");
+
+    s_model.link_state = LINKMON_STATE_DEGRADED;
+    UI_update(UI_DIRTY_LINK, &s_model);
+    snapshot("receiver_degraded");
+
+    s_model.link_state = LINKMON_STATE_LOST;
+    UI_update(UI_DIRTY_LINK, &s_model);
+    snapshot("receiver_lost");
+}
+
+static void test_receiver_alerts(void)
+{
+    show_main(EspNowReceiver);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.rssi = -52;
+    s_model.distance = 1.2f;
+    s_model.distance_valid = true;
+    s_model.approach.state = APPROACH_CLOSING;
+    s_model.approach.rate_mps = -0.8f;
+    s_model.approach_peer = 1;
+    UI_update(UI_DIRTY_RADIO, &s_model);
+    snapshot("receiver_closing");
+
+    s_model.zone = ZONE_IMMEDIATE;
+    s_model.zone_peer = 0;
+    UI_update(UI_DIRTY_ZONE, &s_model);
+    snapshot("receiver_too_close");
+}
+
+// The red alert color ends with the alert, on a new screen too
+static void test_receiver_alert_color(void)
+{
+    show_main(EspNowReceiver);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.distance = 0.4f;
+    s_model.distance_valid = true;
+    s_model.zone = ZONE_IMMEDIATE;
+    s_model.zone_peer = 0;
+    UI_update(UI_DIRTY_RADIO | UI_DIRTY_LINK | UI_DIRTY_ZONE, &s_model);
+    CHECK(label_color_is(lv_palette_main(LV_PALETTE_RED)));
+
+    s_model.link_state = LINKMON_STATE_DEGRADED;
+    UI_update(UI_DIRTY_LINK, &s_model);
+    CHECK(label_color_is(lv_color_hex(0x000000)));
+
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    UI_update(UI_DIRTY_LINK, &s_model);
+    CHECK(label_color_is(lv_palette_main(LV_PALETTE_RED)));
+
+    show_main(EspNowReceiver);
+    CHECK(label_color_is(lv_color_hex(0x000000)));
+}
+
+// The blue recording color ends with the recording or the link
+static void test_receiver_record_color(void)
+{
+    show_main(EspNowReceiver);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.fingerprint.recording = true;
+    s_model.fingerprint.record_spot = 2;
+    s_model.fingerprint.recorded = 3;
+    s_model.fingerprint.record_target = 8;
+    UI_update(UI_DIRTY_RADIO | UI_DIRTY_LINK, &s_model);
+    CHECK(label_color_is(lv_palette_main(LV_PALETTE_BLUE)));
+
+    s_model.link_state = LINKMON_STATE_LOST;
+    UI_update(UI_DIRTY_LINK, &s_model);
+    CHECK(label_color_is(lv_color_hex(0x000000)));
+
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    UI_update(UI_DIRTY_LINK, &s_model);
+    CHECK(label_color_is(lv_palette_main(LV_PALETTE_BLUE)));
+
+    s_model.fingerprint.recording = false;
+    UI_update(UI_DIRTY_RADIO, &s_model);
+    CHECK(label_color_is(lv_color_hex(0x000000)));
+}
+
+static void test_receiver_calibration(void)
+{
+    show_main(EspNowReceiver);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.rssi = -48;
+    s_model.calib_step = 1;
+    UI_update(UI_DIRTY_INPUT | UI_DIRTY_RADIO, &s_model);
+    snapshot("receiver_calibration");
+}
+
+static void test_sender(void)
+{
+    show_main(EspNowSender);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.time_ms = 1000;
+    UI_update(UI_DIRTY_RADIO | UI_DIRTY_LINK, &s_model);
+    snapshot("sender_broadcasting");
+}
+
+static void test_ftm_client(void)
+{
+    show_main(FtmClient);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    s_model.distance = 7.6f;
+    s_model.distance_valid = true;
+    UI_update(UI_DIRTY_RADIO | UI_DIRTY_LINK, &s_model);
+    snapshot("ftm_client");
+}
+
+static void test_history(void)
+{
+    HISTORY_reset();
+    for (uint32_t i = 0; i < HISTORY_LENGTH; i++) {
+        HISTORY_push(0, 2.0f + (float)(i % 16) * 0.5f);
+    }
+
+    show_main(EspNowReceiver);
+    s_model.history_view = true;
+    UI_update(UI_DIRTY_INPUT, &s_model);
+    snapshot("history");
+}
+
+// The UI only invalidates what changed, a status LED toggle must not redraw the screen
+static void test_partial_redraw(void)
+{
+    fb_frame_t frame;
+
+    show_main(EspNowSender);
+    s_model.link_state = LINKMON_STATE_ALIVE;
+    UI_update(UI_DIRTY_RADIO | UI_DIRTY_LINK, &s_model);
+    FB_render(&frame);
+
+    FB_advance(33);
+    UI_update(UI_DIRTY_RADIO, &s_model);
+    FB_render(&frame);
+    CHECK(frame.pixels > 0);
+    CHECK(frame.pixels < FB_WIDTH * FB_HEIGHT / 2);
+
+    // Nothing changed, nothing to flush
+    FB_advance(33);
+    FB_render(&frame);
+    CHECK_INT(frame.pixels, 0);
+}
+
+int main(void)
+{
+    const char *update = getenv("CUBE_UPDATE_GOLDEN");
+
+    s_update_golden = (update != NULL) && (strcmp(update, "1") == 0);
+    mkdir(CUBE_SNAPSHOT_DIR, 0755);
+
+    FB_start();
+    model_reset(EspNowReceiver);
+    UI_create(&s_model, MAC_STRING);
+
+    RUN_TEST(test_selection);
+    RUN_TEST(test_receiver);
+    RUN_TEST(test_receiver_alerts);
+    RUN_TEST(test_receiver_alert_color);
+    RUN_TEST(test_receiver_record_color);
+    RUN_TEST(test_receiver_calibration);
+    RUN_TEST(test_sender);
+    RUN_TEST(test_ftm_client);
+    RUN_TEST(test_history);
+    RUN_TEST(test_partial_redraw);
+
+    return CHECK_RESULT();
+}
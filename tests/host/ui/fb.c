@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lvgl.h"
+
+#include "fb.h"
+
+#define FB_STRIP_PIXELS         (FB_WIDTH * FB_STRIP_LINES)
+#define FB_PPM_BYTES            (FB_WIDTH * FB_HEIGHT * 3)
+
+static uint16_t s_pixels[FB_WIDTH * FB_HEIGHT];
+static uint16_t s_strips[2][FB_STRIP_PIXELS] __attribute__((aligned(64)));
+static lv_display_t *s_disp = NULL;
+static uint32_t s_tick_ms = 0;
+
+// Counted by the flush callback during FB_render()
+static uint32_t s_pixels_flushed = 0;
+static uint32_t s_flushes = 0;
+
+static uint32_t fb_tick_cb(void)
+{
+    return s_tick_ms;
+}
+
+static void fb_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    const int32_t width = lv_area_get_width(area);
+    const uint16_t *src = (const uint16_t *)px_map;
+
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&s_pixels[y * FB_WIDTH + area->x1], src, width * sizeof(uint16_t));
+        src += width;
+    }
+
+    s_pixels_flushed += (uint32_t)(width * lv_area_get_height(area));
+    s_flushes++;
+    lv_display_flush_ready(disp);
+}
+
+static void fb_to_rgb888(uint8_t *rgb)
+{
+    for (uint32_t i = 0; i < FB_WIDTH * FB_HEIGHT; i++) {
+        const uint16_t p = s_pixels[i];
+        const uint8_t r = (p >> 11) & 0x1F;
+        const uint8_t g = (p >> 5) & 0x3F;
+        const uint8_t b = p & 0x1F;
+
+        rgb[3 * i + 0] = (uint8_t)((r << 3) | (r >> 2));
+        rgb[3 * i + 1] = (uint8_t)((g << 2) | (g >> 4));
+        rgb[3 * i + 2] = (uint8_t)((b << 3) | (b >> 2));
+    }
+}
+
+lv_display_t *FB_start(void)
+{
+    lv_init();
+    lv_tick_set_cb(fb_tick_cb);
+
+    s_disp = lv_display_create(FB_WIDTH, FB_HEIGHT);
+    lv_display_set_color_format(s_disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(s_disp, s_strips[0], s_strips[1], sizeof(s_strips[0]), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(s_disp, fb_flush_cb);
+
+    return s_disp;
+}
+
+void FB_advance(uint32_t ms)
+{
+    s_tick_ms += ms;
+}
+
+void FB_render(fb_frame_t *frame)
+{
+    struct timespec start, end;
+
+    s_pixels_flushed = 0;
+    s_flushes = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    lv_refr_now(s_disp);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (frame != NULL) {
+        frame->render_ns = (int64_t)(end.tv_sec - start.tv_sec) * 1000000000 + (end.tv_nsec - start.tv_nsec);
+        frame->pixels = s_pixels_flushed;
+        frame->flushes = s_flushes;
+    }
+}
+
+const uint16_t *FB_get_pixels(void)
+{
+    return s_pixels;
+}
+
+bool FB_save_ppm(const char *path)
+{
+    static uint8_t rgb[FB_PPM_BYTES];
+    FILE *f = fopen(path, "wb");
+
+    if (f == NULL) {
+        return false;
+    }
+
+    fb_to_rgb888(rgb);
+    fprintf(f, "P6\n%d %d\n255\n", FB_WIDTH, FB_HEIGHT);
+    const bool ok = (fwrite(rgb, 1, sizeof(rgb), f) == sizeof(rgb));
+
+    return (fclose(f) == 0) && ok;
+}
+
+int FB_compare_ppm(const char *path)
+{
+    static uint8_t rgb[FB_PPM_BYTES];
+    static uint8_t golden[FB_PPM_BYTES];
+    int width = 0, height = 0, max = 0;
+    int diff = 0;
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL) {
+        return -1;
+    }
+
+    // Header as written by FB_save_ppm(), a single whitespace before the pixels
+    if (fscanf(f, "P6 %d %d %d", &width, &height, &max) != 3 || fgetc(f) == EOF ||
+        width != FB_WIDTH || height != FB_HEIGHT || max != 255 ||
+        fread(golden, 1, sizeof(golden), f) != sizeof(golden)) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    fb_to_rgb888(rgb);
+    for (uint32_t i = 0; i < FB_WIDTH * FB_HEIGHT; i++) {
+        if (memcmp(&rgb[3 * i], &golden[3 * i], 3) != 0) {
+            diff++;
+        }
+    }
+
+    return diff;
+}
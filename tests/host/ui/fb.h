@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl.h"
+
+/*
+ * In-memory display of the host UI build. Same geometry and render mode as
+ * the firmware: 128x128 RGB565, partial rendering into two strips of
+ * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT lines. The flush callback copies each strip
+ * into the frame buffer instead of sending it over SPI.
+ *
+ * Time is virtual, LVGL only sees the milliseconds passed to FB_advance().
+ */
+
+#define FB_WIDTH                (128)
+#define FB_HEIGHT               (128)
+#define FB_STRIP_LINES          (16)    // CONFIG_BSP_LCD_DRAW_BUF_HEIGHT in sdkconfig.defaults
+
+typedef struct {
+    int64_t render_ns;          // Wall time of lv_refr_now(), rendering and flushes
+    uint32_t pixels;            // Pixels flushed, 0 if nothing was invalid
+    uint32_t flushes;           // Strips handed to the flush callback
+} fb_frame_t;
+
+/**
+ * @brief Initialize LVGL and create the display, the frame buffer starts black
+ *
+ * @return lv_display_t* The display, also the default display
+ */
+extern lv_display_t *FB_start(void);
+
+// Move the LVGL tick
+extern void FB_advance(uint32_t ms);
+
+/**
+ * @brief Render the invalid areas now, like one refresh period of the LVGL task
+ *
+ * @param frame Time and pixels of this refresh, may be NULL
+ */
+extern void FB_render(fb_frame_t *frame);
+
+// RGB565, FB_WIDTH * FB_HEIGHT pixels row by row
+extern const uint16_t *FB_get_pixels(void);
+
+/**
+ * @brief Write the frame buffer as binary PPM, expanded to 8 bits per channel
+ *
+ * @return true on success
+ */
+extern bool FB_save_ppm(const char *path);
+
+/**
+ * @brief Compare the frame buffer with a PPM written by FB_save_ppm()
+ *
+ * @return int Pixels that differ, -1 if the file is missing or no FB_WIDTH x FB_HEIGHT PPM
+ */
+extern int FB_compare_ppm(const char *path);
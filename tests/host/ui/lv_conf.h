@@ -0,0 +1,22 @@
+#pragma once
+
+// LVGL configuration of the host UI build, the options of sdkconfig.defaults.
+// Everything not set here keeps the LVGL default, as in the firmware.
+
+#define LV_COLOR_DEPTH                  16
+
+#define LV_USE_OS                       LV_OS_NONE
+#define LV_USE_LOG                      0
+
+#define LV_DRAW_SW_SUPPORT_RGB565       1
+#define LV_DRAW_SW_SUPPORT_A8           1
+#define LV_DRAW_SW_SUPPORT_RGB565A8     0
+#define LV_DRAW_SW_SUPPORT_RGB888       0
+#define LV_DRAW_SW_SUPPORT_XRGB8888     0
+#define LV_DRAW_SW_SUPPORT_ARGB8888     0
+#define LV_DRAW_SW_SUPPORT_L8           0
+#define LV_DRAW_SW_SUPPORT_AL88         0
+#define LV_DRAW_SW_SUPPORT_I1           0
+
+#define LV_FONT_MONTSERRAT_12           1
+#define LV_FONT_MONTSERRAT_14           1
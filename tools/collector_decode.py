@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Decode the binary range stream of the collector role.
+
+The collector writes COBS framed records over USB-Serial-JTAG, between 0x00
+delimiters and mixed with the normal log lines (see main/report.h). This
+script prints one CSV line per range and keeps the log text apart.
+
+Example:
+    tools/collector_decode.py /dev/ttyACM0 > ranges.csv
+    tools/collector_decode.py capture.bin --stats
+"""
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import tty
+
+# Same layouts as main/report.h
+HOST_HEADER = struct.Struct("<BBH")
+HOST_RECORD = struct.Struct("<IIIHbB")
+HOST_STATS = struct.Struct("<6I")
+STATS_FIELDS = ("frames", "records", "duplicates", "unknown", "ring_full", "usb_short")
+
+HOST_RANGES = 1
+HOST_STATS_TYPE = 2
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            raise ValueError("bad COBS code")
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code < 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, same as COBS_crc16()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def parse_frame(chunk):
+    """Returns (type, count, seq, payload) or None if the chunk is no valid frame."""
+    try:
+        frame = cobs_decode(chunk)
+    except ValueError:
+        return None
+    if len(frame) < HOST_HEADER.size + 2:
+        return None
+    body, crc = frame[:-2], struct.unpack("<H", frame[-2:])[0]
+    if crc16(body) != crc:
+        return None
+    kind, count, seq = HOST_HEADER.unpack_from(body)
+    return kind, count, seq, body[HOST_HEADER.size:]
+
+
+def open_source(path):
+    if path is None:
+        return sys.stdin.buffer
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        # USB-Serial-JTAG ignores the baud rate, only raw mode matters
+        tty.setraw(fd)
+        attrs = termios.tcgetattr(fd)
+        attrs[3] &= ~termios.ECHO
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return os.fdopen(fd, "rb", buffering=0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", nargs="?", help="serial port or captured file, stdin if omitted")
+    parser.add_argument("--stats", action="store_true", help="print the collector counters to stderr")
+    parser.add_argument("--log", action="store_true", help="print the log text to stderr")
+    args = parser.parse_args()
+
+    out = sys.stdout
+    out.write("time_ms,receiver,sender,distance_cm,rssi,flags\n")
+    pending = bytearray()
+    last_seq = None
+    lost = 0
+
+    with open_source(args.source) as source:
+        while True:
+            data = source.read(4096)
+            if not data:
+                break
+            pending += data
+            *chunks, pending = pending.split(b"\x00")
+            pending = bytearray(pending)
+
+            for chunk in chunks:
+                if not chunk:
+                    continue
+                parsed = parse_frame(chunk)
+                if parsed is None:
+                    if args.log:
+                        sys.stderr.write(chunk.decode(errors="replace"))
+                    continue
+
+                kind, count, seq, payload = parsed
+                if last_seq is not None:
+                    # A jump backwards is a collector restart, not a loss
+                    gap = (seq - last_seq - 1) & 0xFFFF
+                    lost += gap if gap < 0x8000 else 0
+                last_seq = seq
+
+                if kind == HOST_RANGES and len(payload) == count * HOST_RECORD.size:
+                    for record in HOST_RECORD.iter_unpack(payload):
+                        out.write("%d,%08X,%08X,%d,%d,%d\n" % record)
+                    out.flush()
+                elif kind == HOST_STATS_TYPE and len(payload) >= HOST_STATS.size and args.stats:
+                    stats = dict(zip(STATS_FIELDS, HOST_STATS.unpack_from(payload)))
+                    stats["host_frames_lost"] = lost
+                    sys.stderr.write(" ".join("%s=%d" % item for item in stats.items()) + "\n")
+
+
+if __name__ == "__main__":
+    main()
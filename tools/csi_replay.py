@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Replay recorded CSI through the firmware feature extractor on the host.
+
+With CONFIG_CUBE_CSI_DUMP the receiver prints every processed frame as a
+"CSI:<peer>,<rssi>,<hex>" line. This script builds main/csifeat.c with the
+host C compiler and runs the same code on a captured log. Different thresholds
+can then be compared without a board.
+
+Example:
+    idf.py monitor | tee csi.log
+    tools/csi_replay.py csi.log --motion-permille 30
+"""
+
+import argparse
+import ctypes
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+
+SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "main", "csifeat.c")
+
+# Larger than csifeat_t, the state is opaque to this script
+STATE_SIZE = 4096
+
+LINE = re.compile(r"CSI:(\d+),(-?\d+),([0-9a-fA-F]+)")
+
+
+class Config(ctypes.Structure):
+    _fields_ = [("motion_permille", ctypes.c_uint16), ("decorrelation_permille", ctypes.c_uint16)]
+
+
+class Result(ctypes.Structure):
+    _fields_ = [("motion_score", ctypes.c_int32), ("correlation", ctypes.c_int32),
+                ("rssi_q4", ctypes.c_int32), ("motion", ctypes.c_bool)]
+
+
+def build(workdir):
+    lib = os.path.join(workdir, "libcsifeat.so")
+    cc = os.environ.get("CC", "cc")
+    subprocess.run([cc, "-O2", "-shared", "-fPIC", "-o", lib, SOURCE], check=True)
+    csifeat = ctypes.CDLL(lib)
+    csifeat.CSIFEAT_init.argtypes = [ctypes.c_void_p, ctypes.POINTER(Config)]
+    csifeat.CSIFEAT_process.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int8), ctypes.c_uint16,
+                                        ctypes.c_int8, ctypes.POINTER(Result)]
+    csifeat.CSIFEAT_process.restype = ctypes.c_bool
+    return csifeat
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", nargs="?", help="captured serial log, stdin if omitted")
+    parser.add_argument("--motion-permille", type=int, default=20, help="CONFIG_CUBE_CSI_MOTION_PERMILLE")
+    parser.add_argument("--decorrelation-permille", type=int, default=50,
+                        help="CONFIG_CUBE_CSI_DECORRELATION_PERMILLE")
+    parser.add_argument("--frames", action="store_true", help="print the features of every frame")
+    args = parser.parse_args()
+
+    config = Config(args.motion_permille, args.decorrelation_permille)
+    states = {}
+    peers = {}
+
+    with tempfile.TemporaryDirectory() as workdir:
+        csifeat = build(workdir)
+        source = open(args.log, errors="replace") if args.log else sys.stdin
+
+        with source:
+            for line in source:
+                match = LINE.search(line)
+                if match is None:
+                    continue
+                peer, rssi, payload = int(match.group(1)), int(match.group(2)), bytes.fromhex(match.group(3))
+
+                if peer not in states:
+                    states[peer] = ctypes.create_string_buffer(STATE_SIZE)
+                    csifeat.CSIFEAT_init(states[peer], ctypes.byref(config))
+                    peers[peer] = {"raw": [], "stable": [], "motion": 0, "changes": 0, "last": False}
+
+                buf = (ctypes.c_int8 * len(payload)).from_buffer_copy(payload)
+                result = Result()
+                if not csifeat.CSIFEAT_process(states[peer], buf, len(payload), rssi, ctypes.byref(result)):
+                    print("Short CSI line for peer %d" % peer, file=sys.stderr)
+                    continue
+
+                p = peers[peer]
+                p["raw"].append(rssi)
+                p["stable"].append(result.rssi_q4 / 16)
+                p["motion"] += result.motion
+                p["changes"] += result.motion != p["last"]
+                p["last"] = result.motion
+
+                if args.frames:
+                    print("peer %d rssi %4d stable %6.1f score %4d corr %4d %s"
+                          % (peer, rssi, result.rssi_q4 / 16, result.motion_score, result.correlation,
+                             "motion" if result.motion else ""))
+
+    for peer in sorted(peers):
+        p = peers[peer]
+        n = len(p["raw"])
+        spread = lambda v: statistics.pstdev(v) if len(v) > 1 else 0.0
+        print("Peer %d: %d frames, motion in %.0f %% with %d changes, RSSI spread %.2f dB raw %.2f dB stabilized"
+              % (peer, n, 100 * p["motion"] / n, p["changes"], spread(p["raw"]), spread(p["stable"])))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,348 @@
+#!/usr/bin/env python3
+"""Build and benchmark RSSI fingerprint indices for the receiver.
+
+With CONFIG_CUBE_FINGERPRINT_RECORD the receiver appends fingerprints to the
+"fingerprint" partition, one spot per press of Set (see main/fpindex.h for
+the layout). This script reads such a partition image, adds names and
+positions to the spots, condenses the fingerprints per spot and writes an
+image to flash back. The benchmark builds main/fpindex.c with the host C
+compiler and runs the same search as the firmware.
+
+Example:
+    parttool.py read_partition --partition-name fingerprint --output survey.bin
+    tools/fingerprint.py dump survey.bin
+    tools/fingerprint.py build survey.bin --labels spots.csv --per-spot 8 -o index.bin
+    tools/fingerprint.py bench index.bin --queries survey.bin
+    parttool.py write_partition --partition-name fingerprint --input index.bin
+
+    tools/fingerprint.py synth synth.bin --spots 64 --samples 150
+    tools/fingerprint.py bench synth.bin
+
+The labels file has one "spot,name,x_m,y_m" line per spot. An erased
+partition for a new survey is written by "parttool.py erase_partition".
+"""
+
+import argparse
+import csv
+import ctypes
+import math
+import os
+import random
+import statistics
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "main", "fpindex.c")
+
+# Same layout as main/fpindex.h
+MAGIC = 0x31585046
+VERSION = 1
+MAX_ANCHORS = 8
+MAX_SPOTS = 64
+MAX_K = 8
+NO_SPOT = 0xFF
+RSSI_MIN = -110
+HEADER = struct.Struct("<IBB2x8I24x")
+SPOT = struct.Struct("<hh12s")
+SPOTS_OFFSET = HEADER.size
+ENTRIES_OFFSET = SPOTS_OFFSET + MAX_SPOTS * SPOT.size
+
+PARTITION_SIZE = 64 * 1024      # partitions.csv
+
+# Larger than fpindex_t, the state is opaque to this script
+INDEX_SIZE = 256
+
+
+class Result(ctypes.Structure):
+    _fields_ = [("spot", ctypes.c_uint8), ("votes", ctypes.c_uint8), ("k", ctypes.c_uint8),
+                ("has_position", ctypes.c_bool), ("x_dm", ctypes.c_int16), ("y_dm", ctypes.c_int16),
+                ("distance", ctypes.c_uint32), ("scanned", ctypes.c_uint32)]
+
+
+class Image:
+    """Parsed partition image: anchors, spot labels and the fingerprints in flash order."""
+
+    def __init__(self, anchors, spots=None, entries=None, size=PARTITION_SIZE):
+        self.anchors = list(anchors)
+        self.spots = spots if spots is not None else {}     # spot -> (name, x_m, y_m)
+        self.entries = entries if entries is not None else []   # (spot, [q per anchor])
+        self.size = size
+
+    @classmethod
+    def load(cls, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if len(data) <= ENTRIES_OFFSET:
+            sys.exit("%s: too short for an index" % path)
+
+        magic, version, count, *rest = HEADER.unpack_from(data)
+        if magic != MAGIC or version != VERSION or not 1 <= count <= MAX_ANCHORS:
+            sys.exit("%s: no fingerprint index" % path)
+
+        spots = {}
+        for spot in range(MAX_SPOTS):
+            raw = data[SPOTS_OFFSET + spot * SPOT.size:SPOTS_OFFSET + (spot + 1) * SPOT.size]
+            if raw[4] == 0xFF:
+                continue
+            x_dm, y_dm, name = SPOT.unpack(raw)
+            spots[spot] = (name.rstrip(b"\0").decode(errors="replace"), x_dm / 10, y_dm / 10)
+
+        entries = []
+        size = 1 + count
+        for pos in range(ENTRIES_OFFSET, len(data) - size + 1, size):
+            if data[pos] == NO_SPOT:
+                break
+            entries.append((data[pos], list(data[pos + 1:pos + size])))
+
+        return cls(rest[:count], spots, entries, len(data))
+
+    def pack(self):
+        if (len(self.entries) * (1 + len(self.anchors))) > self.size - ENTRIES_OFFSET:
+            sys.exit("%d fingerprints do not fit into %d bytes" % (len(self.entries), self.size))
+
+        out = bytearray(b"\xff" * self.size)
+        anchors = (self.anchors + [0xFFFFFFFF] * MAX_ANCHORS)[:MAX_ANCHORS]
+        HEADER.pack_into(out, 0, MAGIC, VERSION, len(self.anchors), *anchors)
+        for spot, (name, x_m, y_m) in self.spots.items():
+            SPOT.pack_into(out, SPOTS_OFFSET + spot * SPOT.size, round(x_m * 10), round(y_m * 10),
+                           name.encode()[:SPOT.size - 4].ljust(SPOT.size - 4, b"\0"))
+
+        pos = ENTRIES_OFFSET
+        for spot, q in self.entries:
+            out[pos] = spot
+            out[pos + 1:pos + 1 + len(q)] = bytes(q)
+            pos += 1 + len(q)
+        return bytes(out)
+
+    def by_spot(self):
+        groups = {}
+        for spot, q in self.entries:
+            groups.setdefault(spot, []).append(q)
+        return groups
+
+
+def quantize(rssi):
+    return min(max(round(rssi) - RSSI_MIN, 1), 255)
+
+
+def distance2(a, b):
+    return sum((x - y) ** 2 for x, y in zip(a, b))
+
+
+def centroid(vectors):
+    """Mean per anchor over the fingerprints that heard it, 0 if most did not."""
+    out = []
+    for values in zip(*vectors):
+        heard = [v for v in values if v]
+        out.append(round(statistics.fmean(heard)) if 2 * len(heard) >= len(values) else 0)
+    return out
+
+
+def condense(vectors, count, iterations=10):
+    """k-means over the fingerprints of one spot, starting from evenly spread samples."""
+    if len(vectors) <= count:
+        return list(vectors)
+
+    centers = [vectors[i * len(vectors) // count] for i in range(count)]
+    for _ in range(iterations):
+        clusters = [[] for _ in centers]
+        for v in vectors:
+            clusters[min(range(len(centers)), key=lambda c: distance2(v, centers[c]))].append(v)
+        centers = [centroid(c) if c else centers[i] for i, c in enumerate(clusters)]
+    return centers
+
+
+def load_labels(path):
+    spots = {}
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].strip().startswith("#") or not row[0].strip().isdigit():
+                continue
+            spot, name, x_m, y_m = int(row[0]), row[1].strip(), float(row[2]), float(row[3])
+            if spot >= MAX_SPOTS:
+                sys.exit("spot %d out of range" % spot)
+            spots[spot] = (name, x_m, y_m)
+    return spots
+
+
+class Index:
+    """main/fpindex.c over an image in host memory."""
+
+    def __init__(self, lib, data):
+        self.lib = lib
+        self.data = ctypes.create_string_buffer(data, len(data))
+        self.state = ctypes.create_string_buffer(INDEX_SIZE)
+        if not lib.FPINDEX_open(self.state, self.data, len(data)):
+            sys.exit("FPINDEX_open() rejected the image")
+
+    def query(self, q, k):
+        vector = (ctypes.c_uint8 * MAX_ANCHORS)(*q)
+        result = Result()
+        self.lib.FPINDEX_query(self.state, vector, k, ctypes.byref(result))
+        return result
+
+
+def build_lib(workdir):
+    lib = os.path.join(workdir, "libfpindex.so")
+    cc = os.environ.get("CC", "cc")
+    subprocess.run([cc, "-O2", "-shared", "-fPIC", "-o", lib, SOURCE], check=True)
+    fpindex = ctypes.CDLL(lib)
+    fpindex.FPINDEX_open.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+    fpindex.FPINDEX_open.restype = ctypes.c_bool
+    fpindex.FPINDEX_query.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint8), ctypes.c_uint8,
+                                      ctypes.POINTER(Result)]
+    fpindex.FPINDEX_query.restype = ctypes.c_bool
+    return fpindex
+
+
+def cmd_dump(args):
+    image = Image.load(args.image)
+    out = sys.stdout
+    out.write("spot,name,x_m,y_m," + ",".join("%08X" % a for a in image.anchors) + "\n")
+    for spot, q in image.entries:
+        name, x_m, y_m = image.spots.get(spot, ("", "", ""))
+        out.write("%d,%s,%s,%s," % (spot, name, x_m, y_m)
+                  + ",".join(str(v + RSSI_MIN) if v else "" for v in q) + "\n")
+
+
+def cmd_build(args):
+    survey = Image.load(args.image)
+    image = Image(survey.anchors, dict(survey.spots), size=args.size or survey.size)
+    if args.labels:
+        image.spots.update(load_labels(args.labels))
+
+    for spot, vectors in sorted(survey.by_spot().items()):
+        for q in (condense(vectors, args.per_spot) if args.per_spot else vectors):
+            image.entries.append((spot, q))
+
+    with open(args.output, "wb") as f:
+        f.write(image.pack())
+    print("%d spots, %d of %d fingerprints, %d labelled" % (len(survey.by_spot()), len(image.entries),
+                                                           len(survey.entries), len(image.spots)))
+
+
+def cmd_synth(args):
+    """Log-distance path loss with shadowing, spots on a grid and anchors along the walls."""
+    rng = random.Random(args.seed)
+    side = math.ceil(math.sqrt(args.spots))
+    anchors = [(args.room * (0.5 + 0.5 * math.cos(a)), args.room * (0.5 + 0.5 * math.sin(a)))
+               for a in (2 * math.pi * i / args.anchors for i in range(args.anchors))]
+    image = Image([0x10000000 + i for i in range(args.anchors)], size=args.size)
+
+    for spot in range(args.spots):
+        x = args.room * (spot % side + 0.5) / side
+        y = args.room * (spot // side + 0.5) / side
+        image.spots[spot] = ("S%d" % spot, x, y)
+        # Bodies and furniture shift the mean per spot and anchor, the frames add fast fading
+        offset = [rng.gauss(0, args.shadowing_db) for _ in anchors]
+        for _ in range(args.samples):
+            q = []
+            for (ax, ay), shadow in zip(anchors, offset):
+                d = max(math.hypot(x - ax, y - ay), 0.3)
+                rssi = args.rssi_1m - 10 * args.exponent * math.log10(d) + shadow + rng.gauss(0, args.fading_db)
+                q.append(quantize(rssi) if rssi > args.sensitivity_dbm else 0)
+            image.entries.append((spot, q))
+
+    with open(args.output, "wb") as f:
+        f.write(image.pack())
+    print("%d spots with %d fingerprints of %d anchors, %d bytes used"
+          % (args.spots, len(image.entries), args.anchors, ENTRIES_OFFSET + len(image.entries) * (1 + args.anchors)))
+
+
+def cmd_bench(args):
+    image = Image.load(args.index)
+    if args.queries:
+        queries = Image.load(args.queries)
+        if queries.anchors != image.anchors:
+            sys.exit("the query image has other anchors")
+        index_image = image
+        tests = queries.entries
+    else:
+        # Every fourth fingerprint of each spot is held out as a query
+        index_image = Image(image.anchors, image.spots, size=image.size)
+        tests = []
+        for spot, vectors in sorted(image.by_spot().items()):
+            for i, q in enumerate(vectors):
+                (tests if i % 4 == 3 else index_image.entries).append((spot, q))
+
+    with tempfile.TemporaryDirectory() as workdir:
+        index = Index(build_lib(workdir), index_image.pack())
+
+        hits = 0
+        errors = []
+        scanned = []
+        start = time.perf_counter()
+        for spot, q in tests:
+            result = index.query(q, args.k)
+            hits += result.spot == spot
+            scanned.append(result.scanned)
+            if result.has_position and spot in image.spots:
+                _, x_m, y_m = image.spots[spot]
+                errors.append(math.hypot(result.x_dm / 10 - x_m, result.y_dm / 10 - y_m))
+        elapsed = time.perf_counter() - start
+
+    entries = len(index_image.entries)
+    entry_size = 1 + len(image.anchors)
+    print("Index %d fingerprints of %d anchors, %d bytes searched per query"
+          % (entries, len(image.anchors), entries * entry_size))
+    print("Queries %d, k %d, spot correct %.1f %%, %.0f %% of the entries compared completely"
+          % (len(tests), args.k, 100 * hits / max(len(tests), 1),
+             100 * statistics.fmean(scanned) / max(entries, 1) if scanned else 0))
+    if errors:
+        errors.sort()
+        print("Position error median %.2f m p90 %.2f m" % (statistics.median(errors),
+                                                          errors[min(len(errors) - 1, len(errors) * 9 // 10)]))
+    # Includes the ctypes call, the firmware logs its own query time
+    print("Host %.1f us per query" % (1e6 * elapsed / max(len(tests), 1)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("dump", help="print the fingerprints of an image as CSV, RSSI in dBm")
+    p.add_argument("image")
+    p.set_defaults(func=cmd_dump)
+
+    p = sub.add_parser("build", help="label and condense a recorded image")
+    p.add_argument("image", help="partition read back after a survey")
+    p.add_argument("--labels", help="CSV with spot,name,x_m,y_m")
+    p.add_argument("--per-spot", type=int, default=0, help="k-means centroids per spot, 0 keeps all")
+    p.add_argument("--size", type=int, default=0, help="image size, the size of the input if 0")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser("synth", help="generate a survey of a simulated room")
+    p.add_argument("output")
+    p.add_argument("--anchors", type=int, default=4)
+    p.add_argument("--spots", type=int, default=16)
+    p.add_argument("--samples", type=int, default=20, help="fingerprints per spot")
+    p.add_argument("--room", type=float, default=10.0, help="side of the square room in m")
+    p.add_argument("--rssi-1m", type=float, default=-51.0, help="RSSI_AT_1_METER of EspNowReceiver.c")
+    p.add_argument("--exponent", type=float, default=2.2, help="path loss exponent of the room")
+    p.add_argument("--shadowing-db", type=float, default=4.0, help="fixed offset per spot and anchor")
+    p.add_argument("--fading-db", type=float, default=2.0, help="after the smoothing of the receiver")
+    p.add_argument("--sensitivity-dbm", type=float, default=-97.0)
+    p.add_argument("--size", type=int, default=PARTITION_SIZE)
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_synth)
+
+    p = sub.add_parser("bench", help="accuracy and speed of main/fpindex.c on the host")
+    p.add_argument("index")
+    p.add_argument("--queries", help="separate survey, otherwise every fourth fingerprint is held out")
+    p.add_argument("-k", type=int, default=3, help="CONFIG_CUBE_FINGERPRINT_K")
+    p.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    if args.command in ("synth",) and not 1 <= args.anchors <= MAX_ANCHORS:
+        parser.error("1 to %d anchors" % MAX_ANCHORS)
+    if args.command == "bench" and not 1 <= args.k <= MAX_K:
+        parser.error("k from 1 to %d" % MAX_K)
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
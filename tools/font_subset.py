@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Generate LVGL fonts that only contain the glyphs the UI actually uses.
+
+All string literals of the given C sources are collected, printf conversions
+are removed and the remaining characters are passed to lv_font_conv together
+with the digits, hex digits and punctuation that formatted values can produce.
+
+Example:
+    tools/font_subset.py --font Montserrat-Medium.ttf --out build/fonts main/ui.c
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+# Characters that only show up through printf conversions (%d, %.0f, %02X, ...)
+ALWAYS = "0123456789ABCDEF.-+:() <>"
+
+STRING_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+CONVERSION_RE = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?[diouxXfFeEgGcsp%]")
+COMMENT_RE = re.compile(r"//[^\n]*|/\*.*?\*/", re.S)
+
+SIZES = (12, 14)
+
+
+def collect_symbols(sources, extra=""):
+    symbols = set(ALWAYS) | set(extra)
+    for path in sources:
+        with open(path, encoding="utf-8") as f:
+            text = COMMENT_RE.sub("", f.read())
+        for line in text.splitlines():
+            # Preprocessor lines only carry include paths
+            if line.lstrip().startswith("#"):
+                continue
+            for literal in STRING_RE.findall(line):
+                literal = literal.encode("utf-8").decode("unicode_escape").encode("latin-1").decode("utf-8")
+                symbols.update(c for c in CONVERSION_RE.sub("", literal) if c.isprintable())
+    return "".join(sorted(symbols))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--font", help="TTF/WOFF font to convert")
+    parser.add_argument("--out", default=".", help="Output directory for font_ui_<size>.c")
+    parser.add_argument("--bpp", type=int, default=4, help="Bits per pixel of the glyph bitmaps")
+    parser.add_argument("--extra", default="", help="Additional characters, e.g. for text known only at run time")
+    parser.add_argument("--print-symbols", action="store_true", help="Only print the collected characters")
+    parser.add_argument("sources", nargs="+", help="C sources with the UI strings")
+    args = parser.parse_args()
+
+    symbols = collect_symbols(args.sources, args.extra)
+    if args.print_symbols:
+        print(symbols)
+        return 0
+
+    if not args.font:
+        parser.error("--font is required")
+
+    converter = shutil.which("lv_font_conv")
+    if converter is None:
+        sys.stderr.write("lv_font_conv not found, install it with 'npm install -g lv_font_conv'\n")
+        return 1
+
+    os.makedirs(args.out, exist_ok=True)
+    for size in SIZES:
+        name = "font_ui_{}".format(size)
+        subprocess.run([converter,
+                        "--font", args.font,
+                        "--symbols", symbols,
+                        "--size", str(size),
+                        "--bpp", str(args.bpp),
+                        "--format", "lvgl",
+                        "--no-compress",
+                        "--lv-include", "lvgl.h",
+                        "--lv-font-name", name,
+                        "-o", os.path.join(args.out, name + ".c")],
+                       check=True)
+
+    print("{} glyphs: {}".format(len(symbols), symbols))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
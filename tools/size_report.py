@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Report flash and static RAM usage of the firmware and track it over time.
+
+Reads the section sizes of build/firmware.elf with the toolchain's size tool,
+prints a summary and, with --record, appends it to doc/size_history.csv so
+changes like the subset fonts or the trimmed LVGL draw formats can be compared.
+
+Example:
+    idf.py build && tools/size_report.py --record "subset fonts"
+"""
+
+import argparse
+import csv
+import datetime
+import os
+import shutil
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_ELF = os.path.join(ROOT, "build", "firmware.elf")
+HISTORY = os.path.join(ROOT, "doc", "size_history.csv")
+FIELDS = ("date", "label", "flash_code", "flash_rodata", "iram", "dram_data", "dram_bss", "flash_total", "ram_total")
+
+
+def read_sections(elf, size_tool):
+    out = subprocess.run([size_tool, "-A", elf], check=True, capture_output=True, text=True).stdout
+    sections = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sections[parts[0]] = int(parts[1])
+    return sections
+
+
+def summarize(sections):
+    def total(*prefixes):
+        return sum(size for name, size in sections.items() if name.startswith(prefixes))
+
+    row = {
+        "flash_code": total(".flash.text"),
+        "flash_rodata": total(".flash.rodata", ".flash.appdesc"),
+        "iram": total(".iram0.text", ".iram0.vectors"),
+        "dram_data": total(".dram0.data"),
+        "dram_bss": total(".dram0.bss"),
+    }
+    # IRAM code and initialised data are stored in flash as well
+    row["flash_total"] = row["flash_code"] + row["flash_rodata"] + row["iram"] + row["dram_data"]
+    row["ram_total"] = row["iram"] + row["dram_data"] + row["dram_bss"]
+    return row
+
+
+def last_recorded():
+    if not os.path.exists(HISTORY):
+        return None
+    with open(HISTORY, newline="") as f:
+        rows = list(csv.DictReader(f))
+    return rows[-1] if rows else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--elf", default=DEFAULT_ELF, help="Firmware ELF file")
+    parser.add_argument("--size-tool", default="riscv32-esp-elf-size", help="Toolchain size binary")
+    parser.add_argument("--record", metavar="LABEL", help="Append the result to doc/size_history.csv")
+    args = parser.parse_args()
+
+    if shutil.which(args.size_tool) is None:
+        sys.stderr.write("{} not found, run this from an ESP-IDF shell\n".format(args.size_tool))
+        return 1
+
+    row = summarize(read_sections(args.elf, args.size_tool))
+    previous = last_recorded()
+
+    for key in FIELDS[2:]:
+        delta = ""
+        if previous is not None:
+            delta = " ({:+d} since '{}')".format(row[key] - int(previous[key]), previous["label"])
+        print("{:<13} {:>8} bytes{}".format(key, row[key], delta))
+
+    if args.record:
+        row["date"] = datetime.date.today().isoformat()
+        row["label"] = args.record
+        new_file = not os.path.exists(HISTORY)
+        with open(HISTORY, "a", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=FIELDS)
+            if new_file:
+                writer.writeheader()
+            writer.writerow(row)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Decode the binary radio trace in a captured serial log.
+
+The firmware prints batches of 16 byte records as "TRC:<hex>" lines (see
+main/trace.h). This script replaces them with readable lines and passes all
+other log lines through unchanged, so the result reads like the old text log.
+
+Example:
+    idf.py monitor | tee cube.log
+    tools/trace_decode.py cube.log
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+RECORD = struct.Struct("<IHHII")
+NO_VALUE = 0xFFFFFFFF
+
+# Same ids as trace_event_t in main/trace.h
+ESPNOW_RX = 1
+ESPNOW_TX_OK = 2
+ESPNOW_TX_FAIL = 3
+FTM_REPORT = 4
+DROPPED = 5
+CSI_MOTION = 6
+ESPNOW_LATENCY = 7
+ZONE = 8
+
+# idf.py monitor may color the lines
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def mac_tail(value):
+    return ":".join("%02X" % ((value >> shift) & 0xFF) for shift in (24, 16, 8, 0))
+
+
+def distance(cm):
+    return "-" if cm == NO_VALUE else "%d.%02d m" % (cm // 100, cm % 100)
+
+
+def describe(event, a, b, c):
+    if event == ESPNOW_RX:
+        rssi = struct.unpack("<b", bytes([a >> 8]))[0]
+        peer = a & 0xFF
+        peer = "-" if peer == 0xFF else str(peer)
+        return "espnow rx   ..:%s peer %s rssi %d distance %s" % (mac_tail(b), peer, rssi, distance(c))
+    if event == ESPNOW_TX_OK:
+        return "espnow tx   ..:%s ok" % mac_tail(b)
+    if event == ESPNOW_TX_FAIL:
+        return "espnow tx   ..:%s failed, status %d" % (mac_tail(b), a)
+    if event == FTM_REPORT:
+        return "ftm report  rtt %d ns distance %s (%d entries)" % (b, distance(c), a)
+    if event == DROPPED:
+        return "trace       %d records dropped, ring full" % b
+    if event == CSI_MOTION:
+        return "csi motion  peer %d %s, score %d" % (a, "started" if b else "ended", c)
+    if event == ESPNOW_LATENCY:
+        latency = struct.unpack("<i", struct.pack("<I", b))[0]
+        return "espnow lat  peer %d one-way %d us +- %d us" % (a, latency, c)
+    if event == ZONE:
+        zones = ("none", "immediate", "near", "far")
+        name = lambda zone: zones[zone] if zone < len(zones) else str(zone)
+        return "zone        peer %d %s -> %s at %s" % (a & 0xFF, name(b), name(a >> 8), distance(c))
+    return "unknown event %d: %d %d %d" % (event, a, b, c)
+
+
+class Clock:
+    """Unwraps the 32 bit microsecond timestamps of the records."""
+
+    def __init__(self):
+        self.last = None
+        self.offset = 0
+
+    def seconds(self, time_us):
+        if self.last is not None and time_us < self.last:
+            self.offset += 1 << 32
+        self.last = time_us
+        return (self.offset + time_us) / 1e6
+
+
+def decode_line(payload, clock):
+    data = bytes.fromhex(payload)
+    for pos in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        time_us, event, a, b, c = RECORD.unpack_from(data, pos)
+        yield "[%12.6f] %s" % (clock.seconds(time_us), describe(event, a, b, c))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", nargs="?", help="captured serial log, stdin if omitted")
+    parser.add_argument("--trace-only", action="store_true", help="drop the non-trace log lines")
+    args = parser.parse_args()
+
+    source = open(args.log, errors="replace") if args.log else sys.stdin
+    clock = Clock()
+
+    with source:
+        for line in source:
+            plain = ANSI.sub("", line).rstrip("\r\n")
+            start = plain.find("TRC:")
+            if start < 0:
+                if not args.trace_only:
+                    print(plain)
+                continue
+            try:
+                for text in decode_line(plain[start + 4:].strip(), clock):
+                    print(text)
+            except ValueError:
+                # Line cut off or mixed with other output
+                print("%s  <- undecodable trace line" % plain, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()